@@ -57,6 +57,18 @@ namespace openpeer
                         );
       static void clear(const char *cookieNamePath);
 
+      //-----------------------------------------------------------------------
+      // PURPOSE: Obtain the cache usage statistics grouped by cookie name
+      //          prefix (hits, misses, stores, clears, bytes and latency
+      //          histograms of the calls into the cache delegate).
+      static ElementPtr getStatistics();
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: Reset all cache usage statistics back to zero.
+      static void resetStatistics();
+
+      static ElementPtr toDebug();
+
       virtual ~ICache() {}  // needed to make polymorphic
     };
 
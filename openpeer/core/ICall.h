@@ -113,6 +113,10 @@ namespace openpeer
       virtual Time getAnswerTime() const = 0;
       virtual Time getClosedTime() const = 0;
 
+      // rolling jitter, RTT, loss and bitrate histograms (with live
+      // percentiles) sampled while the call has media, NULL if none yet
+      virtual ElementPtr getMediaQuality() const = 0;
+
       virtual void ring() = 0;          // tell the caller that the call is ringing
       virtual void answer() = 0;        // answer the call
       virtual void hold(bool hold) = 0; // place the call on hold (or remove from hold)
@@ -135,6 +139,13 @@ namespace openpeer
                                       ICallPtr call,
                                       CallStates state
                                       ) = 0;
+
+      // delivered once as the call closes (before CallState_Closed) if the
+      // call ever had media
+      virtual void onCallMediaQualitySummary(
+                                             ICallPtr call,
+                                             ElementPtr summaryEl
+                                             ) {}
     };
   }
 }
@@ -142,5 +153,7 @@ namespace openpeer
 ZS_DECLARE_PROXY_BEGIN(openpeer::core::ICallDelegate)
 ZS_DECLARE_PROXY_TYPEDEF(openpeer::core::ICallPtr, ICallPtr)
 ZS_DECLARE_PROXY_TYPEDEF(openpeer::core::ICall::CallStates, CallStates)
+ZS_DECLARE_PROXY_TYPEDEF(openpeer::core::ElementPtr, ElementPtr)
 ZS_DECLARE_PROXY_METHOD_2(onCallStateChanged, ICallPtr, CallStates)
+ZS_DECLARE_PROXY_METHOD_2(onCallMediaQualitySummary, ICallPtr, ElementPtr)
 ZS_DECLARE_PROXY_END()
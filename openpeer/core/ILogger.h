@@ -65,6 +65,18 @@ namespace openpeer
         Insane    // most detailed log level
       };
 
+      struct CustomLoggerStatistics
+      {
+        size_t mBufferSize;       // 0 when log messages are delivered synchronously
+        ULONG mQueued;            // messages placed into the buffer
+        ULONG mDelivered;         // messages delivered to the delegate
+        ULONG mDropped;           // messages discarded because the buffer was full
+        ULONG mOverflows;         // number of times the buffer became full
+        ULONG mHighWaterMark;     // most messages ever waiting in the buffer
+
+        CustomLoggerStatistics();
+      };
+
       static const char *toString(Severity severity);
       static const char *toString(Level level);
 
@@ -86,6 +98,36 @@ namespace openpeer
       //          the file and output all logging to the file.
       static void installFileLogger(const char *fileName, bool colorizeOutput);
 
+      //-----------------------------------------------------------------------
+      // PURPOSE: Install a logger that writes a compact binary record per
+      //          log event (subsystem, severity, level, interned message and
+      //          typed parameters) instead of formatted text.
+      // NOTE:    Messages, function names, file names and parameter names
+      //          are written only once and referenced by ID afterwards.
+      //          Use the "core_BinaryLogDecoder" tool to convert the file
+      //          back into text or JSON.
+      static void installBinaryFileLogger(const char *fileName);
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: Install a text file logger which rotates its output file.
+      // NOTE:    Once the file reaches "maxFileSizeInBytes" (or is older than
+      //          "maxAgeInSeconds") it is renamed to
+      //          "<fileName>.<yyyymmdd-hhmmss>.<n>" and a new file is
+      //          started. Rotation and gzip compression (if
+      //          "compressRotatedFiles" is true) happen on a background
+      //          thread. Only the newest "maxFiles" rotated files are kept
+      //          and rotated files older than "maxAgeInSeconds" are deleted,
+      //          including those left behind by previous runs. Pass 0 for any
+      //          limit to disable it. Output is buffered and written once per
+      //          second or immediately for severity Error and above.
+      static void installRotatingFileLogger(
+                                            const char *fileName,
+                                            size_t maxFileSizeInBytes,
+                                            ULONG maxFiles,
+                                            ULONG maxAgeInSeconds,
+                                            bool compressRotatedFiles = true
+                                            );
+
       //-----------------------------------------------------------------------
       // PURPOSE: Install a logger to output to a telnet prompt.
       // NOTE:    If listen port 59999 is used, then from the system type:
@@ -116,13 +158,30 @@ namespace openpeer
       //-----------------------------------------------------------------------
       // PURPOSE: Install a logger to monitor the functioning of the application
       //          internally.
-      static void installCustomLogger(ILoggerDelegatePtr delegate = ILoggerDelegatePtr());
+      // NOTE:    If "asyncBufferSize" is non-zero, log messages are written
+      //          into a lock-free ring buffer of (at least) that many entries
+      //          and a dedicated logging thread delivers them to
+      //          "ILoggerDelegate::onLog". The thread logging the message
+      //          never waits on the delegate. If the buffer is full the
+      //          message is dropped and counted (see
+      //          "getCustomLoggerStatistics"). The buffer size is fixed the
+      //          first time an asynchronous logger is installed.
+      static void installCustomLogger(
+                                      ILoggerDelegatePtr delegate = ILoggerDelegatePtr(),
+                                      size_t asyncBufferSize = 0
+                                      );
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: Obtain the delivery/drop counters of the custom logger.
+      static CustomLoggerStatistics getCustomLoggerStatistics();
 
       //-----------------------------------------------------------------------
       // PURPOSE: Mirror methods to install routines to uninstall various
       //          types of loggers.
       static void uninstallStdOutLogger();
       static void uninstallFileLogger();
+      static void uninstallBinaryFileLogger();
+      static void uninstallRotatingFileLogger();
       static void uninstallTelnetLogger();
       static void uninstallOutgoingTelnetLogger();
       static void uninstallDebuggerLogger();
@@ -175,6 +234,36 @@ namespace openpeer
                               Level level
                               );
 
+      //-----------------------------------------------------------------------
+      // PURPOSE: Limits how often the high frequency (e.g. per media packet)
+      //          log statements of a subsystem are output.
+      // NOTE:    "maxPerSecond" caps the messages output per second and
+      //          "sampleOneInEvery" only outputs every Nth message (e.g. 1000
+      //          outputs one in a thousand packets). Pass 0 for both to
+      //          remove the limit. The next message output after messages
+      //          were suppressed carries a "suppressed" count. Only log
+      //          statements the SDK marks as rate limited are affected.
+      static void setLogRateLimit(
+                                  const char *subsystemName,
+                                  ULONG maxPerSecond,
+                                  ULONG sampleOneInEvery
+                                  );
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: Same as "setLogRateLimit" but for an individual rate
+      //          limited call site (e.g.
+      //          "core::CallTransport::notifyReceivedRTPPacket"). A call site
+      //          limit takes precedence over the subsystem limit.
+      static void setLogCallSiteRateLimit(
+                                          const char *callSiteName,
+                                          ULONG maxPerSecond,
+                                          ULONG sampleOneInEvery
+                                          );
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: Removes all subsystem and call site rate limits.
+      static void clearLogRateLimits();
+
       //-----------------------------------------------------------------------
       // PURPOSE: Sends a message to the logger(s) for a particular subsystem.
       static void log(
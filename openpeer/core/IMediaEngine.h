@@ -95,6 +95,17 @@ namespace openpeer
       
       ZS_DECLARE_TYPEDEF_PTR(std::list<CaptureCapability>, CaptureCapabilityList)
 
+      struct ConferenceLevel
+      {
+        PUID mCallID;           // call the participant is talking over
+        ULONG mLevel;           // 0 = silence, 100 = full scale
+        bool mActiveSpeaker;
+
+        ConferenceLevel() : mCallID(0), mLevel(0), mActiveSpeaker(false) {}
+      };
+
+      typedef std::list<ConferenceLevel> ConferenceLevelList;
+
       static IMediaEnginePtr singleton();
 
       virtual void setDefaultVideoOrientation(VideoOrientations orientation) = 0;
@@ -155,6 +166,19 @@ namespace openpeer
       virtual int getVoiceTransportStatistics(RtpRtcpStatistics &stat) = 0;
         
         virtual void pauseVoice(bool pause = true) = 0;
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: when enabled this device hosts an audio conference between
+      //          every call with audio (the call in focus and all calls
+      //          holding media without focus), each participant receives the
+      //          host microphone mixed with all other participants
+      virtual void setConferenceEnabled(bool enabled) = 0;
+      virtual bool getConferenceEnabled() = 0;
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: current receive level of each conference participant
+      // NOTE:    empty when conference is not enabled
+      virtual ConferenceLevelList getConferenceLevels() = 0;
     };
 
     interaction IMediaEngineDelegate
@@ -79,6 +79,18 @@ namespace openpeer
       static bool apply(const char *jsonSettings);
       static void applyDefaults();
 
+      //-----------------------------------------------------------------------
+      // PURPOSE: Applies a JSON settings file (same format as "apply") and
+      //          keeps watching it. Whenever the file is modified only the
+      //          changed settings are applied and settings removed from the
+      //          file are restored to their core default (or cleared when
+      //          the core has no default for them).
+      // NOTE:    Uses inotify on Linux, otherwise the file's modification
+      //          time is checked once per second. Only one file can be
+      //          watched at a time.
+      static bool watchFile(const char *jsonFileName);
+      static void unwatchFile();
+
       virtual ~ISettings() {} // to make settings polymorphic
     };
 
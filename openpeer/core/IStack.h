@@ -64,8 +64,24 @@ namespace openpeer
       //          "IStackDelegate::onStackShutdown" will be notified when it
       //          has completed. After it has completed, the application
       //          can be safely exited.
+      //
+      //          Any account still alive is told to shutdown (all accounts
+      //          at once). Accounts that have not completed by the
+      //          "openpeer/core/shutdown-deadline-in-seconds" setting are
+      //          forced to shutdown and logged as holding up the shutdown.
       virtual void shutdown() = 0;
 
+      //-----------------------------------------------------------------------
+      // PURPOSE: Obtain live statistics for every message queue used by the
+      //          stack (depth, enqueue to dispatch wait time, handler time
+      //          and the slowest proxy methods).
+      // NOTE:    Times are reported in microseconds. If "resetAfterReading"
+      //          is true the histograms restart empty after this call.
+      //
+      //          The statistics can also be logged periodically by setting
+      //          "openpeer/core/queue-statistics-log-interval-in-seconds".
+      virtual ElementPtr getMessageQueueStatistics(bool resetAfterReading = false) = 0;
+
       //-----------------------------------------------------------------------
       // PURPOSE: Create an authorized application ID from an application ID.
       // WARNING:
@@ -149,10 +165,24 @@ namespace openpeer
       virtual void interceptProcessing(IStackMessageQueueDelegatePtr delegate) = 0;
 
       //-----------------------------------------------------------------------
-      // PURPOSE: Notify that a message can be processed from the custom thread.
+      // PURPOSE: Notify that messages can be processed from the custom thread.
       // NOTE:    Only call this routine from within the context of running from
       //          the custom thread.
-      virtual void notifyProcessMessageFromCustomThread() = 0;
+      //
+      //          Messages are processed until "maxMessages" have run or the
+      //          "budget" time has elapsed (whichever comes first). A zero
+      //          budget or zero max messages means that limit is not
+      //          applied. The defaults process a single message.
+      //
+      //          If messages remain after the limit is reached the custom
+      //          thread is woken up again through
+      //          "IStackMessageQueueDelegate::onStackMessageQueueWakeUpCustomThreadAndProcessOnCustomThread".
+      //          Per batch counters are available from
+      //          "IStack::getMessageQueueStatistics" to tune the limits.
+      virtual void notifyProcessMessageFromCustomThread(
+                                                        Duration budget = Duration(),
+                                                        ULONG maxMessages = 1
+                                                        ) = 0;
     };
 
     //-------------------------------------------------------------------------
@@ -38,6 +38,7 @@
 #include <openpeer/services/IHelper.h>
 
 #include <zsLib/Log.h>
+#include <zsLib/Stringize.h>
 #include <zsLib/XML.h>
 
 namespace openpeer { namespace core { ZS_IMPLEMENT_SUBSYSTEM(openpeer_core) } }
@@ -125,6 +126,125 @@ namespace openpeer
       {
         return !((*this) == rValue);
       }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark Histogram
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      const ULONG Histogram::sBucketLimits[Histogram::Buckets_Total] =
+      {
+        1, 2, 5,
+        10, 20, 50,
+        100, 200, 500,
+        1000, 2000, 5000,
+        10000, 20000, 50000,
+        100000, 200000, 500000,
+        1000000,
+        ULONG(-1)
+      };
+
+      //-----------------------------------------------------------------------
+      Histogram::Histogram()
+      {
+        reset();
+      }
+
+      //-----------------------------------------------------------------------
+      bool Histogram::hasData() const
+      {
+        return 0 != mTotal;
+      }
+
+      //-----------------------------------------------------------------------
+      void Histogram::record(ULONG value)
+      {
+        for (size_t index = 0; index < Buckets_Total; ++index) {
+          if (value > sBucketLimits[index]) continue;
+          ++(mBuckets[index]);
+          break;
+        }
+
+        if ((0 == mTotal) || (value < mMin)) mMin = value;
+        if ((0 == mTotal) || (value > mMax)) mMax = value;
+
+        ++mTotal;
+        mSum += value;
+      }
+
+      //-----------------------------------------------------------------------
+      void Histogram::reset()
+      {
+        for (size_t index = 0; index < Buckets_Total; ++index) {
+          mBuckets[index] = 0;
+        }
+        mTotal = 0;
+        mMin = 0;
+        mMax = 0;
+        mSum = 0;
+      }
+
+      //-----------------------------------------------------------------------
+      ULONG Histogram::average() const
+      {
+        if (0 == mTotal) return 0;
+        return static_cast<ULONG>(mSum / mTotal);
+      }
+
+      //-----------------------------------------------------------------------
+      ULONG Histogram::percentile(ULONG percent) const
+      {
+        if (0 == mTotal) return 0;
+        if (percent > 100) percent = 100;
+
+        zsLib::ULONGLONG wanted = ((static_cast<zsLib::ULONGLONG>(mTotal) * percent) + 99) / 100;
+        if (0 == wanted) wanted = 1;
+
+        zsLib::ULONGLONG found = 0;
+        for (size_t index = 0; index < Buckets_Total; ++index) {
+          found += mBuckets[index];
+          if (found < wanted) continue;
+
+          // never report beyond what was actually observed
+          ULONG limit = sBucketLimits[index];
+          return (limit > mMax ? mMax : limit);
+        }
+        return mMax;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr Histogram::toDebug(
+                                    const char *name,
+                                    const char *units
+                                    ) const
+      {
+        ElementPtr resultEl = Element::create(name);
+
+        UseServicesHelper::debugAppend(resultEl, "units", units);
+        UseServicesHelper::debugAppend(resultEl, "total", mTotal);
+        if (0 == mTotal) return resultEl;
+
+        UseServicesHelper::debugAppend(resultEl, "min", mMin);
+        UseServicesHelper::debugAppend(resultEl, "max", mMax);
+        UseServicesHelper::debugAppend(resultEl, "average", average());
+        UseServicesHelper::debugAppend(resultEl, "p50", percentile(50));
+        UseServicesHelper::debugAppend(resultEl, "p90", percentile(90));
+        UseServicesHelper::debugAppend(resultEl, "p99", percentile(99));
+
+        ElementPtr bucketsEl = Element::create("buckets");
+        for (size_t index = 0; index < Buckets_Total; ++index) {
+          if (0 == mBuckets[index]) continue;
+          String limitStr = (ULONG(-1) == sBucketLimits[index] ? String("more") : (String("<= ") + string(sBucketLimits[index])));
+          UseServicesHelper::debugAppend(bucketsEl, limitStr.c_str(), mBuckets[index]);
+        }
+        UseServicesHelper::debugAppend(resultEl, bucketsEl);
+
+        return resultEl;
+      }
     }
 
     //-------------------------------------------------------------------------
@@ -34,6 +34,8 @@
 #include <openpeer/core/internal/core_Identity.h>
 #include <openpeer/core/internal/core_Contact.h>
 #include <openpeer/core/internal/core_ConversationThread.h>
+#include <openpeer/core/internal/core_Settings.h>
+#include <openpeer/core/internal/core_ShutdownCoordinator.h>
 
 #include <openpeer/stack/IBootstrappedNetwork.h>
 #include <openpeer/stack/IPeerFiles.h>
@@ -107,6 +109,7 @@ namespace openpeer
         mDelegate(IAccountDelegateProxy::createWeak(UseStack::queueApplication(), delegate)),
         mConversationThreadDelegate(IConversationThreadDelegateProxy::createWeak(UseStack::queueApplication(), conversationThreadDelegate)),
         mCallDelegate(ICallDelegateProxy::createWeak(UseStack::queueApplication(), callDelegate)),
+        mForceShutdown(false),
         mCurrentState(AccountState_Pending),
         mLastErrorCode(0),
         mLockboxForceCreateNewAccount(false)
@@ -135,7 +138,12 @@ namespace openpeer
         mConversationThreadDelegate = IConversationThreadDelegateProxy::create(mDelegateFilter);
         mCallDelegate = ICallDelegateProxy::create(mDelegateFilter);
 
-        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), services::ISettings::getUInt(OPENPEER_CORE_SETTING_ACCOUNT_BACKGROUNDING_PHASE));
+        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), ISettingsForInternal::snapshot()->mAccountBackgroundingPhase);
+
+        ShutdownCoordinatorPtr coordinator = UseStack::shutdownCoordinator();
+        if (coordinator) {
+          coordinator->registerAccount(mThisWeak.lock());
+        }
 
         step();
       }
@@ -176,6 +184,12 @@ namespace openpeer
         return dynamic_pointer_cast<Account>(account);
       }
 
+      //-----------------------------------------------------------------------
+      AccountPtr Account::convert(ForShutdownCoordinatorPtr account)
+      {
+        return dynamic_pointer_cast<Account>(account);
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -206,7 +220,8 @@ namespace openpeer
         ZS_THROW_INVALID_ARGUMENT_IF(!grantID)
         ZS_THROW_INVALID_ARGUMENT_IF(!lockboxServiceDomain)
 
-        AccountPtr pThis(new Account(UseStack::queueCore(), delegate, conversationThreadDelegate, callDelegate));
+        // all objects belonging to the account are pinned to the account's core queue
+        AccountPtr pThis(new Account(UseStack::queueCore(grantID), delegate, conversationThreadDelegate, callDelegate));
         pThis->mThisWeak = pThis;
 
         AutoRecursiveLock lock(*pThis);
@@ -242,7 +257,14 @@ namespace openpeer
         ZS_THROW_INVALID_ARGUMENT_IF(!namespaceGrantOuterFrameURLUponReload)
         ZS_THROW_INVALID_ARGUMENT_IF(!reloginInformation)
 
-        AccountPtr pThis(new Account(UseStack::queueCore(), delegate, conversationThreadDelegate, callDelegate));
+        // shard by the grant ID (same as "login") so a relogin of an account
+        // lands on the same core queue as the original login
+        String shardKey;
+        ElementPtr grantIDEl = reloginInformation->findFirstChildElement("grantID");
+        if (grantIDEl) shardKey = grantIDEl->getTextDecoded();
+
+        // all objects belonging to the account are pinned to the account's core queue
+        AccountPtr pThis(new Account(UseStack::queueCore(shardKey), delegate, conversationThreadDelegate, callDelegate));
         pThis->mThisWeak = pThis;
 
         AutoRecursiveLock lock(*pThis);
@@ -445,7 +467,7 @@ namespace openpeer
             continue;
           }
 
-          UseIdentityPtr identity = IIdentityForAccount::createFromExistingSession(session);
+          UseIdentityPtr identity = IIdentityForAccount::createFromExistingSession(getAssociatedMessageQueue(), session);
           ZS_LOG_DEBUG(log("new identity found") + UseIdentity::toDebug(identity))
           mIdentities[identity->getSession()->getID()] = identity;
           result->push_back(Identity::convert(identity));
@@ -754,7 +776,7 @@ namespace openpeer
 
         ZS_LOG_DEBUG(log("notified conversation thread state changed"))
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -803,7 +825,7 @@ namespace openpeer
           mLockboxSession.get()->associateIdentities(add, remove);
         }
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -814,6 +836,50 @@ namespace openpeer
       #pragma mark Account => IAccountForIdentityLookup
       #pragma mark
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark Account => IAccountForShutdownCoordinator
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      String Account::getShutdownBlocker() const
+      {
+        AutoRecursiveLock lock(*this);
+        return mShutdownBlocker;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark Account => IAccountAsync
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void Account::onShutdown()
+      {
+        AutoRecursiveLock lock(*this);
+        ZS_LOG_DEBUG(debug("shutdown requested by shutdown coordinator"))
+        cancel();
+      }
+
+      //-----------------------------------------------------------------------
+      void Account::onForceShutdown()
+      {
+        AccountPtr pThis = mThisWeak.lock();  // keep alive while the graceful reference is dropped
+
+        AutoRecursiveLock lock(*this);
+        ZS_LOG_WARNING(Detail, debug("forced shutdown requested by shutdown coordinator"))
+
+        mForceShutdown = true;
+        mGracefulShutdownReference.reset();
+        cancel();
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -1102,8 +1168,10 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void Account::onWake()
       {
+        mWake.notifyWoken();
+
         AutoRecursiveLock lock(*this);
-        ZS_LOG_DEBUG(log("on wake"))
+        ZS_LOG_DEBUG(log("on wake") + ZS_PARAM("coalesced", mWake.getTotalCoalesced()))
         step();
       }
 
@@ -1227,9 +1295,13 @@ namespace openpeer
         ElementPtr resultEl = Element::create("core::Account");
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "coalesced wakes", mWake.getTotalCoalesced());
         UseServicesHelper::debugAppend(resultEl, "state", toString(mCurrentState));
         UseServicesHelper::debugAppend(resultEl, "error code", mLastErrorCode);
         UseServicesHelper::debugAppend(resultEl, "error reason", mLastErrorReason);
+        UseServicesHelper::debugAppend(resultEl, "graceful shutdown", (bool)mGracefulShutdownReference);
+        UseServicesHelper::debugAppend(resultEl, "force shutdown", mForceShutdown);
+        UseServicesHelper::debugAppend(resultEl, "shutdown blocker", mShutdownBlocker);
 
         UseServicesHelper::debugAppend(resultEl, "delegate", (bool)mDelegate);
 
@@ -1270,7 +1342,8 @@ namespace openpeer
         ZS_LOG_DEBUG(debug("cancel called"))
 
         if (isShutdown()) return;
-        if (!mGracefulShutdownReference) mGracefulShutdownReference = mThisWeak.lock();
+        if ((!mGracefulShutdownReference) &&
+            (!mForceShutdown)) mGracefulShutdownReference = mThisWeak.lock();
 
         setState(AccountState_ShuttingDown);
 
@@ -1306,6 +1379,7 @@ namespace openpeer
 
             if (!thread->isShutdown()) {
               ZS_LOG_DEBUG(log("waiting for conversation thread to shutdown") + ZS_PARAM("base thread id", threadI))
+              mShutdownBlocker = String("conversation thread ") + threadI;
               return;
             }
           }
@@ -1313,6 +1387,7 @@ namespace openpeer
           if (mStackAccount.get()) {
             if (stack::IAccount::AccountState_Shutdown != mStackAccount.get()->getState()) {
               ZS_LOG_DEBUG(log("waiting for stack account to shutdown"))
+              mShutdownBlocker = "stack account";
               return;
             }
           }
@@ -1320,11 +1395,14 @@ namespace openpeer
           if (mCallTransport.get()) {
             if (ICallTransport::CallTransportState_Shutdown != mCallTransport.get()->getState()) {
               ZS_LOG_DEBUG(log("waiting for call transport to shutdown"))
+              mShutdownBlocker = "call transport";
               return;
             }
           }
         }
 
+        mShutdownBlocker.clear();
+
         setState(AccountState_Shutdown);
 
         if (mBackgroundingSubscription) {
@@ -1346,6 +1424,11 @@ namespace openpeer
 
         mConversationThreads.clear();
 
+        ShutdownCoordinatorPtr coordinator = UseStack::shutdownCoordinator();
+        if (coordinator) {
+          coordinator->notifyAccountShutdown(mID);
+        }
+
         ZS_LOG_DEBUG(log("shutdown complete"))
       }
 
@@ -241,6 +241,8 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void Account::ContactSubscription::onWake()
       {
+        mWake.notifyWoken();
+
         AutoRecursiveLock lock(*this);
         step();
       }
@@ -362,7 +364,7 @@ namespace openpeer
         ZS_LOG_DEBUG(log("erasing location subscription") + ZS_PARAM("location ID", locationID))
         mLocations.erase(found);
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -390,6 +392,7 @@ namespace openpeer
         ElementPtr resultEl = Element::create("core::Account::ContactSubscription");
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "coalesced wakes", mWake.getTotalCoalesced());
         UseServicesHelper::debugAppend(resultEl, "state", toString(mCurrentState));
         UseServicesHelper::debugAppend(resultEl, UseContact::toDebug(mContact));
         UseServicesHelper::debugAppend(resultEl, IPeerSubscription::toDebug(mPeerSubscription));
@@ -308,6 +308,25 @@ namespace openpeer
 
       }
 
+      //-----------------------------------------------------------------------
+      void Account::DelegateFilter::onCallMediaQualitySummary(
+                                                              ICallPtr call,
+                                                              ElementPtr summaryEl
+                                                              )
+      {
+        AutoRecursiveLock lock(*this);
+
+        if (!mCallDelegate) return;
+
+        ZS_LOG_TRACE(log("call media quality summary") + ZS_PARAM("call", call->getID()))
+
+        try {
+          mCallDelegate->onCallMediaQualitySummary(call, summaryEl);
+        } catch(ICallDelegateProxy::Exceptions::DelegateGone &) {
+          ZS_LOG_WARNING(Detail, log("delegate gone"))
+        }
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
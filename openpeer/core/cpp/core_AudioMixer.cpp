@@ -0,0 +1,544 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+
+#include <openpeer/core/internal/core_AudioMixer.h>
+
+#include <openpeer/services/IHelper.h>
+
+#include <zsLib/XML.h>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OPENPEER_CORE_AUDIO_MIXER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define OPENPEER_CORE_AUDIO_MIXER_NEON
+#include <arm_neon.h>
+#endif
+
+#define OPENPEER_CORE_AUDIO_MIXER_MAX_FRAME_AGE_IN_MILLISECONDS (30)
+#define OPENPEER_CORE_AUDIO_MIXER_LEVEL_RANGE_IN_DB (60)
+#define OPENPEER_CORE_AUDIO_MIXER_SPEECH_LEVEL (40)
+#define OPENPEER_CORE_AUDIO_MIXER_ACTIVE_SPEAKER_HOLD_FRAMES (30)
+#define OPENPEER_CORE_AUDIO_MIXER_NO_ACTIVE_SPEAKER (-1)
+
+namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_webrtc) } }
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      using zsLib::Milliseconds;
+
+      ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AudioMixer::Participant
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      AudioMixer::Participant::Participant() :
+        mCallID(0),
+        mFrameLength(0),
+        mFrameFrequency(0),
+        mLevel(0),
+        mLouderFrames(0)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AudioMixer
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      AudioMixer::AudioMixer() :
+        mID(zsLib::createPUID()),
+        mActiveSpeaker(OPENPEER_CORE_AUDIO_MIXER_NO_ACTIVE_SPEAKER),
+        mActiveSpeakerCallID(0),
+        mActiveSpeakerLevel(0),
+        mMixedFrames(0),
+        mResampledFrames(0),
+        mSkippedFrames(0),
+        mRejectedFrames(0),
+        mSpeakerChanges(0),
+        mReportedSkippedFrames(0),
+        mReportedRejectedFrames(0),
+        mReportedSpeakerChanges(0)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      AudioMixer::~AudioMixer()
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AudioMixer => (kernels)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::accumulate(
+                                  int32_t *mix,
+                                  const int16_t *samples,
+                                  size_t total
+                                  )
+      {
+        size_t index = 0;
+
+#if defined(OPENPEER_CORE_AUDIO_MIXER_SSE2)
+        for (; index + 8 <= total; index += 8) {
+          __m128i input = _mm_loadu_si128((const __m128i *)(samples + index));
+          __m128i sign = _mm_srai_epi16(input, 15);   // sign extend 16 -> 32 bits
+          __m128i *output = (__m128i *)(mix + index);
+
+          _mm_storeu_si128(output, _mm_add_epi32(_mm_loadu_si128(output), _mm_unpacklo_epi16(input, sign)));
+          _mm_storeu_si128(output + 1, _mm_add_epi32(_mm_loadu_si128(output + 1), _mm_unpackhi_epi16(input, sign)));
+        }
+#elif defined(OPENPEER_CORE_AUDIO_MIXER_NEON)
+        for (; index + 8 <= total; index += 8) {
+          int16x8_t input = vld1q_s16(samples + index);
+
+          vst1q_s32(mix + index, vaddw_s16(vld1q_s32(mix + index), vget_low_s16(input)));
+          vst1q_s32(mix + index + 4, vaddw_s16(vld1q_s32(mix + index + 4), vget_high_s16(input)));
+        }
+#endif
+
+        for (; index < total; ++index) {
+          mix[index] += samples[index];
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::saturate(
+                                int16_t *out,
+                                const int32_t *mix,
+                                size_t total
+                                )
+      {
+        size_t index = 0;
+
+#if defined(OPENPEER_CORE_AUDIO_MIXER_SSE2)
+        for (; index + 8 <= total; index += 8) {
+          __m128i low = _mm_loadu_si128((const __m128i *)(mix + index));
+          __m128i high = _mm_loadu_si128((const __m128i *)(mix + index + 4));
+
+          _mm_storeu_si128((__m128i *)(out + index), _mm_packs_epi32(low, high));
+        }
+#elif defined(OPENPEER_CORE_AUDIO_MIXER_NEON)
+        for (; index + 8 <= total; index += 8) {
+          vst1q_s16(out + index, vcombine_s16(vqmovn_s32(vld1q_s32(mix + index)), vqmovn_s32(vld1q_s32(mix + index + 4))));
+        }
+#endif
+
+        for (; index < total; ++index) {
+          int32_t value = mix[index];
+          if (value > 32767) value = 32767;
+          if (value < -32768) value = -32768;
+          out[index] = (int16_t)value;
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      ULONG AudioMixer::level(
+                              const int16_t *samples,
+                              size_t total
+                              )
+      {
+        if (0 == total) return 0;
+
+        zsLib::ULONGLONG sum = 0;
+        for (size_t index = 0; index < total; ++index) {
+          int32_t value = samples[index];
+          sum += (zsLib::ULONGLONG)(value * value);
+        }
+
+        double rms = sqrt(((double)sum) / ((double)total));
+        if (rms < 1.0) return 0;
+
+        double db = 20.0 * log10(rms / 32768.0);   // dBov, 0 at full scale
+        double result = ((db + OPENPEER_CORE_AUDIO_MIXER_LEVEL_RANGE_IN_DB) * 100.0) / OPENPEER_CORE_AUDIO_MIXER_LEVEL_RANGE_IN_DB;
+
+        if (result <= 0.0) return 0;
+        if (result >= 100.0) return 100;
+        return (ULONG)result;
+      }
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::resample(
+                                int16_t *out,
+                                size_t outTotal,
+                                const int16_t *samples,
+                                size_t total
+                                )
+      {
+        if ((0 == outTotal) || (0 == total)) return;
+
+        if (outTotal == total) {
+          memcpy(out, samples, sizeof(int16_t) * total);
+          return;
+        }
+
+        // 16.16 fixed point position within the input frame
+        zsLib::ULONGLONG step = (((zsLib::ULONGLONG)(total - 1)) << 16) / (outTotal > 1 ? outTotal - 1 : 1);
+        zsLib::ULONGLONG position = 0;
+
+        for (size_t index = 0; index < outTotal; ++index, position += step) {
+          size_t whole = (size_t)(position >> 16);
+          if (whole + 1 >= total) {
+            out[index] = samples[total - 1];
+            continue;
+          }
+
+          int64_t fraction = (int64_t)(position & 0xFFFF);
+          int32_t first = samples[whole];
+          int32_t second = samples[whole + 1];
+          out[index] = (int16_t)(first + (int32_t)((((int64_t)(second - first)) * fraction) >> 16));
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AudioMixer => friend MediaEngine
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::addParticipant(
+                                      int channel,
+                                      PUID callID
+                                      )
+      {
+        {
+          AutoLock lock(mLock);
+
+          Participant &participant = mParticipants[channel];
+          participant = Participant();
+          participant.mCallID = callID;
+        }
+
+        ZS_LOG_DEBUG(log("conference participant added") + ZS_PARAM("channel", channel) + ZS_PARAM("call", callID))
+      }
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::removeParticipant(int channel)
+      {
+        {
+          AutoLock lock(mLock);
+
+          ParticipantMap::iterator found = mParticipants.find(channel);
+          if (found == mParticipants.end()) return;
+
+          mParticipants.erase(found);
+
+          if (channel == mActiveSpeaker) {
+            mActiveSpeaker = OPENPEER_CORE_AUDIO_MIXER_NO_ACTIVE_SPEAKER;
+            mActiveSpeakerCallID = 0;
+            mActiveSpeakerLevel = 0;
+          }
+        }
+
+        ZS_LOG_DEBUG(log("conference participant removed") + ZS_PARAM("channel", channel))
+      }
+
+      //-----------------------------------------------------------------------
+      AudioMixer::ConferenceLevelList AudioMixer::getLevels() const
+      {
+        ConferenceLevelList result;
+
+        Time tick = zsLib::now();
+
+        AutoLock lock(mLock);
+
+        for (ParticipantMap::const_iterator iter = mParticipants.begin(); iter != mParticipants.end(); ++iter)
+        {
+          const Participant &participant = (*iter).second;
+
+          ConferenceLevel level;
+          level.mCallID = participant.mCallID;
+          level.mActiveSpeaker = ((*iter).first == mActiveSpeaker);
+
+          // a participant no longer being played out is silent
+          if ((0 != participant.mFrameLength) &&
+              ((tick - participant.mFrameTime) <= Milliseconds(OPENPEER_CORE_AUDIO_MIXER_MAX_FRAME_AGE_IN_MILLISECONDS))) {
+            level.mLevel = participant.mLevel;
+          }
+
+          result.push_back(level);
+        }
+
+        return result;
+      }
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::logStatistics()
+      {
+        ULONG speakerChanges = mSpeakerChanges.load(boost::memory_order_relaxed);
+        if (speakerChanges != mReportedSpeakerChanges) {
+          ChannelID speaker = OPENPEER_CORE_AUDIO_MIXER_NO_ACTIVE_SPEAKER;
+          PUID speakerCallID = 0;
+          ULONG speakerLevel = 0;
+
+          {
+            AutoLock lock(mLock);
+            speaker = mActiveSpeaker;
+            speakerCallID = mActiveSpeakerCallID;
+            speakerLevel = mActiveSpeakerLevel;
+          }
+
+          ZS_LOG_DEBUG(log("active speaker changed") + ZS_PARAM("channel", speaker) + ZS_PARAM("call", speakerCallID) + ZS_PARAM("level", speakerLevel) + ZS_PARAM("changes", speakerChanges - mReportedSpeakerChanges))
+          mReportedSpeakerChanges = speakerChanges;
+        }
+
+        ULONG skipped = mSkippedFrames.load(boost::memory_order_relaxed);
+        ULONG rejected = mRejectedFrames.load(boost::memory_order_relaxed);
+
+        if ((skipped == mReportedSkippedFrames) &&
+            (rejected == mReportedRejectedFrames)) return;
+
+        ZS_LOG_DEBUG(log("conference frames left out of the mix") + ZS_PARAM("skipped", skipped - mReportedSkippedFrames) + ZS_PARAM("rejected", rejected - mReportedRejectedFrames) + ZS_PARAM("total skipped", skipped) + ZS_PARAM("total rejected", rejected) + ZS_PARAM("mixed", mMixedFrames.load(boost::memory_order_relaxed)) + ZS_PARAM("resampled", mResampledFrames.load(boost::memory_order_relaxed)))
+
+        mReportedSkippedFrames = skipped;
+        mReportedRejectedFrames = rejected;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr AudioMixer::toDebug() const
+      {
+        AutoLock lock(mLock);
+
+        ElementPtr resultEl = Element::create("core::AudioMixer");
+
+        UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "participants", mParticipants.size());
+        UseServicesHelper::debugAppend(resultEl, "active speaker", mActiveSpeaker);
+        UseServicesHelper::debugAppend(resultEl, "mixed frames", mMixedFrames.load());
+        UseServicesHelper::debugAppend(resultEl, "resampled frames", mResampledFrames.load());
+        UseServicesHelper::debugAppend(resultEl, "skipped frames", mSkippedFrames.load());
+        UseServicesHelper::debugAppend(resultEl, "rejected frames", mRejectedFrames.load());
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AudioMixer => webrtc::VoEMediaProcess
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::Process(
+                               int channel,
+                               webrtc::ProcessingTypes type,
+                               int16_t audio10ms[],
+                               int length,
+                               int samplingFreq,
+                               bool isStereo
+                               )
+      {
+        if ((isStereo) ||
+            (length <= 0) ||
+            (length > Limit_MaxSamplesPer10ms)) {
+          // audio thread: counted only, reported by logStatistics()
+          mRejectedFrames.fetch_add(1, boost::memory_order_relaxed);
+          return;
+        }
+
+        switch (type) {
+          case webrtc::kPlaybackPerChannel:   receivedFrame(channel, audio10ms, length, samplingFreq); break;
+          case webrtc::kRecordingPerChannel:  mixMinus(channel, audio10ms, length, samplingFreq); break;
+          default:                            break;
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AudioMixer => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::receivedFrame(
+                                     int channel,
+                                     const int16_t *samples,
+                                     int length,
+                                     int samplingFreq
+                                     )
+      {
+        ULONG frameLevel = level(samples, length);
+        Time tick = zsLib::now();
+
+        // scope: keep the participant frame for the mix-minus of the others
+        {
+          AutoLock lock(mLock);
+
+          ParticipantMap::iterator found = mParticipants.find(channel);
+          if (found == mParticipants.end()) return;
+
+          Participant &participant = (*found).second;
+
+          memcpy(&(participant.mFrame[0]), samples, sizeof(int16_t) * length);
+          participant.mFrameLength = length;
+          participant.mFrameFrequency = samplingFreq;
+          participant.mFrameTime = tick;
+
+          // rise immediately, fall off slowly so pauses between words do not drop the level
+          participant.mLevel = (frameLevel >= participant.mLevel ? frameLevel : ((participant.mLevel * 7) + frameLevel) / 8);
+
+          if (channel == mActiveSpeaker) {
+            participant.mLouderFrames = 0;
+            return;
+          }
+
+          ULONG speakerLevel = 0;
+          ParticipantMap::iterator speaker = mParticipants.find(mActiveSpeaker);
+          if (speaker != mParticipants.end()) {
+            speakerLevel = (*speaker).second.mLevel;
+          }
+
+          if ((participant.mLevel < OPENPEER_CORE_AUDIO_MIXER_SPEECH_LEVEL) ||
+              (participant.mLevel <= speakerLevel)) {
+            participant.mLouderFrames = 0;
+            return;
+          }
+
+          // hysteresis: must stay the loudest for a while before taking over
+          ++participant.mLouderFrames;
+          if (participant.mLouderFrames < OPENPEER_CORE_AUDIO_MIXER_ACTIVE_SPEAKER_HOLD_FRAMES) return;
+
+          participant.mLouderFrames = 0;
+
+          mActiveSpeaker = channel;
+          mActiveSpeakerCallID = participant.mCallID;
+          mActiveSpeakerLevel = frameLevel;
+        }
+
+        // audio thread: counted only, reported by logStatistics()
+        mSpeakerChanges.fetch_add(1, boost::memory_order_relaxed);
+      }
+
+      //-----------------------------------------------------------------------
+      void AudioMixer::mixMinus(
+                                int channel,
+                                int16_t *samples,
+                                int length,
+                                int samplingFreq
+                                )
+      {
+        int32_t mix[Limit_MaxSamplesPer10ms];
+        int16_t resampled[Limit_MaxSamplesPer10ms];
+        bool mixed = false;
+        ULONG skipped = 0;
+        ULONG resampledTotal = 0;
+
+        Time tick = zsLib::now();
+
+        // scope: add every other participant on top of the host microphone
+        {
+          AutoLock lock(mLock);
+
+          if (mParticipants.end() == mParticipants.find(channel)) return;
+
+          for (ParticipantMap::const_iterator iter = mParticipants.begin(); iter != mParticipants.end(); ++iter)
+          {
+            if ((*iter).first == channel) continue;   // never send participants their own audio
+
+            const Participant &participant = (*iter).second;
+            if (0 == participant.mFrameLength) continue;
+
+            if ((tick - participant.mFrameTime) > Milliseconds(OPENPEER_CORE_AUDIO_MIXER_MAX_FRAME_AGE_IN_MILLISECONDS)) {
+              ++skipped;
+              continue;
+            }
+
+            const int16_t *frame = &(participant.mFrame[0]);
+
+            // each participant is played out at its own codec's rate which
+            // may differ from the rate the recording is sent at
+            if ((participant.mFrameLength != length) ||
+                (participant.mFrameFrequency != samplingFreq)) {
+              resample(&(resampled[0]), length, frame, participant.mFrameLength);
+              frame = &(resampled[0]);
+              ++resampledTotal;
+            }
+
+            if (!mixed) {
+              memset(&(mix[0]), 0, sizeof(int32_t) * length);
+              accumulate(&(mix[0]), samples, length);
+              mixed = true;
+            }
+
+            accumulate(&(mix[0]), frame, length);
+          }
+        }
+
+        // audio thread: counted only, reported by logStatistics()
+        if (0 != skipped) mSkippedFrames.fetch_add(skipped, boost::memory_order_relaxed);
+        if (0 != resampledTotal) mResampledFrames.fetch_add(resampledTotal, boost::memory_order_relaxed);
+
+        if (!mixed) return;
+
+        mMixedFrames.fetch_add(1, boost::memory_order_relaxed);
+
+        saturate(samples, &(mix[0]), length);
+      }
+
+      //-----------------------------------------------------------------------
+      Log::Params AudioMixer::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("core::AudioMixer");
+        UseServicesHelper::debugAppend(objectEl, "id", mID);
+        return Log::Params(message, objectEl);
+      }
+    }
+  }
+}
@@ -57,7 +57,8 @@ namespace openpeer
 
       //-----------------------------------------------------------------------
       Cache::Cache() :
-        mID(zsLib::createPUID())
+        mID(zsLib::createPUID()),
+        mStatisticsSince(zsLib::now())
       {
         ZS_LOG_DETAIL(log("created"))
       }
@@ -127,10 +128,14 @@ namespace openpeer
 
         if (!delegate) {
           ZS_LOG_WARNING(Debug, log("no cache installed (thus cannot fetch cookie)") + ZS_PARAM("cookie name", cookieNamePath))
+          recordNoDelegate(cookieNamePath);
           return String();
         }
 
+        Time start = zsLib::now();
         String result = delegate->fetch(cookieNamePath);
+        recordFetch(cookieNamePath, start, result.length());
+
         if (result.hasData()) {
           ZS_LOG_TRACE(log("fetched from cache") + ZS_PARAM("cookie name", cookieNamePath) + ZS_PARAM("result", result))
         }
@@ -157,11 +162,15 @@ namespace openpeer
 
         if (!delegate) {
           ZS_LOG_WARNING(Debug, log("no cache installed (thus cannot store cookie)") + ZS_PARAM("cookie name", cookieNamePath) + ZS_PARAM("expires", expires) + ZS_PARAM("value", str))
+          recordNoDelegate(cookieNamePath);
           return;
         }
 
         ZS_LOG_TRACE(log("storing in cache") + ZS_PARAM("cookie name", cookieNamePath) + ZS_PARAM("expires", expires) + ZS_PARAM("value", str))
+
+        Time start = zsLib::now();
         delegate->store(cookieNamePath, expires, str);
+        recordStore(cookieNamePath, start, strlen(str));
       }
 
       //-----------------------------------------------------------------------
@@ -178,13 +187,52 @@ namespace openpeer
 
         if (!delegate) {
           ZS_LOG_WARNING(Debug, log("no cache installed (thus cannot clear cookie)") + ZS_PARAM("cookie name", cookieNamePath))
+          recordNoDelegate(cookieNamePath);
           return;
         }
 
         ZS_LOG_TRACE(log("clearing from cache") + ZS_PARAM("cookie name", cookieNamePath))
+
+        Time start = zsLib::now();
         delegate->clear(cookieNamePath);
+        recordClear(cookieNamePath, start);
       }
-      
+
+      //-----------------------------------------------------------------------
+      ElementPtr Cache::getStatistics() const
+      {
+        ElementPtr resultEl = Element::create("core::Cache::Statistics");
+
+        AutoLock lock(mStatisticsLock);
+
+        UseServicesHelper::debugAppend(resultEl, "since", mStatisticsSince);
+
+        for (PrefixStatisticsMap::const_iterator iter = mStatistics.begin(); iter != mStatistics.end(); ++iter) {
+          const CookiePrefix &prefix = (*iter).first;
+          const PrefixStatistics &stats = (*iter).second;
+          UseServicesHelper::debugAppend(resultEl, stats.toDebug(prefix));
+        }
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      void Cache::resetStatistics()
+      {
+        ZS_LOG_DEBUG(log("resetting statistics"))
+
+        AutoLock lock(mStatisticsLock);
+        mStatistics.clear();
+        mStatisticsSince = zsLib::now();
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr Cache::toDebug(CachePtr cache)
+      {
+        if (!cache) return ElementPtr();
+        return cache->toDebug();
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -215,6 +263,133 @@ namespace openpeer
         return Log::Params(message, "core::Cache");
       }
 
+      //-----------------------------------------------------------------------
+      ElementPtr Cache::toDebug() const
+      {
+        ElementPtr resultEl = Element::create("core::Cache");
+
+        {
+          AutoRecursiveLock lock(mLock);
+          UseServicesHelper::debugAppend(resultEl, "id", mID);
+          UseServicesHelper::debugAppend(resultEl, "delegate", (bool)mDelegate);
+        }
+
+        UseServicesHelper::debugAppend(resultEl, getStatistics());
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      Cache::CookiePrefix Cache::toPrefix(const char *cookieNamePath)
+      {
+        // "/thread/message/cached-1234" is counted as "/thread/message/"
+        String name(cookieNamePath);
+        String::size_type pos = name.rfind('/');
+        if (String::npos == pos) return CookiePrefix("/");
+        return name.substr(0, pos + 1);
+      }
+
+      //-----------------------------------------------------------------------
+      void Cache::recordFetch(
+                              const char *cookieNamePath,
+                              const Time &start,
+                              size_t bytes
+                              ) const
+      {
+        ULONG latency = static_cast<ULONG>((zsLib::now() - start).total_microseconds());
+
+        AutoLock lock(mStatisticsLock);
+        PrefixStatistics &stats = mStatistics[toPrefix(cookieNamePath)];
+
+        if (0 != bytes) {
+          ++stats.mHits;
+        } else {
+          ++stats.mMisses;
+        }
+        stats.mBytesFetched += bytes;
+        stats.mFetchLatency.record(latency);
+      }
+
+      //-----------------------------------------------------------------------
+      void Cache::recordStore(
+                              const char *cookieNamePath,
+                              const Time &start,
+                              size_t bytes
+                              )
+      {
+        ULONG latency = static_cast<ULONG>((zsLib::now() - start).total_microseconds());
+
+        AutoLock lock(mStatisticsLock);
+        PrefixStatistics &stats = mStatistics[toPrefix(cookieNamePath)];
+
+        ++stats.mStores;
+        stats.mBytesStored += bytes;
+        stats.mStoreLatency.record(latency);
+      }
+
+      //-----------------------------------------------------------------------
+      void Cache::recordClear(
+                              const char *cookieNamePath,
+                              const Time &start
+                              )
+      {
+        ULONG latency = static_cast<ULONG>((zsLib::now() - start).total_microseconds());
+
+        AutoLock lock(mStatisticsLock);
+        PrefixStatistics &stats = mStatistics[toPrefix(cookieNamePath)];
+
+        ++stats.mClears;
+        stats.mClearLatency.record(latency);
+      }
+
+      //-----------------------------------------------------------------------
+      void Cache::recordNoDelegate(const char *cookieNamePath) const
+      {
+        AutoLock lock(mStatisticsLock);
+        ++(mStatistics[toPrefix(cookieNamePath)].mNoDelegate);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark Cache::PrefixStatistics
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Cache::PrefixStatistics::PrefixStatistics() :
+        mHits(0),
+        mMisses(0),
+        mStores(0),
+        mClears(0),
+        mNoDelegate(0),
+        mBytesFetched(0),
+        mBytesStored(0)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr Cache::PrefixStatistics::toDebug(const String &prefix) const
+      {
+        ElementPtr resultEl = Element::create("prefix");
+
+        UseServicesHelper::debugAppend(resultEl, "cookie prefix", prefix);
+        UseServicesHelper::debugAppend(resultEl, "hits", mHits);
+        UseServicesHelper::debugAppend(resultEl, "misses", mMisses);
+        UseServicesHelper::debugAppend(resultEl, "stores", mStores);
+        UseServicesHelper::debugAppend(resultEl, "clears", mClears);
+        UseServicesHelper::debugAppend(resultEl, "no delegate", mNoDelegate);
+        UseServicesHelper::debugAppend(resultEl, "bytes fetched", mBytesFetched);
+        UseServicesHelper::debugAppend(resultEl, "bytes stored", mBytesStored);
+
+        if (mFetchLatency.hasData()) UseServicesHelper::debugAppend(resultEl, mFetchLatency.toDebug("fetch latency", "us"));
+        if (mStoreLatency.hasData()) UseServicesHelper::debugAppend(resultEl, mStoreLatency.toDebug("store latency", "us"));
+        if (mClearLatency.hasData()) UseServicesHelper::debugAppend(resultEl, mClearLatency.toDebug("clear latency", "us"));
+
+        return resultEl;
+      }
+
     }
 
     //-------------------------------------------------------------------------
@@ -261,5 +436,27 @@ namespace openpeer
       singleton->clear(cookieNamePath);
     }
 
+    //-------------------------------------------------------------------------
+    ElementPtr ICache::getStatistics()
+    {
+      internal::CachePtr singleton = internal::Cache::singleton();
+      if (!singleton) return ElementPtr();
+      return singleton->getStatistics();
+    }
+
+    //-------------------------------------------------------------------------
+    void ICache::resetStatistics()
+    {
+      internal::CachePtr singleton = internal::Cache::singleton();
+      if (!singleton) return;
+      singleton->resetStatistics();
+    }
+
+    //-------------------------------------------------------------------------
+    ElementPtr ICache::toDebug()
+    {
+      return internal::Cache::toDebug(internal::Cache::singleton());
+    }
+
   }
 }
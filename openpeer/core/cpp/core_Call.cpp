@@ -35,6 +35,7 @@
 #include <openpeer/core/internal/core_Account.h>
 #include <openpeer/core/internal/core_Contact.h>
 #include <openpeer/core/internal/core_Helper.h>
+#include <openpeer/core/internal/core_Logger.h>
 
 #include <openpeer/stack/IHelper.h>
 #include <openpeer/services/IHelper.h>
@@ -54,7 +55,9 @@
 #define OPENPEER_CALL_RTCP_ICE_KEEP_ALIVE_INDICATIONS_SENT_IN_SECONDS (20)
 #define OPENPEER_CALL_RTCP_ICE_EXPECTING_DATA_WITHIN_IN_SECONDS (45)
 
-#define OPENPEER_CALL_RECHECK_MEDIA_TIMER_IN_MILLISECONDS (100)
+// RTCP packet types occupy 192..223 in the second octet (RFC 5761)
+#define OPENPEER_CALL_BUNDLE_IS_RTCP(secondByte) (((secondByte) >= 192) && ((secondByte) <= 223))
+// default video engine payload types (VP8, RED, ULPFEC)
 
 namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_core) } }
 namespace openpeer { namespace core { ZS_DECLARE_FORWARD_SUBSYSTEM(openpeer_media) } }
@@ -224,7 +227,7 @@ namespace openpeer
                  ) :
         mLock(*conversationThread),
         mStepLock(SharedRecursiveLock::create()),
-        mQueue(UseStack::queueCore()),
+        mQueue(account->getAssociatedMessageQueue()),
         mMediaQueue(UseStack::queueMedia()),
         mDelegate(delegate),
         mCallID(callID ? string(callID) : services::IHelper::randomString(32)),
@@ -243,7 +246,8 @@ namespace openpeer
         mRingCalled(false),
         mAnswerCalled(false),
         mLocalOnHold(false),
-        mCreationTime(zsLib::now())
+        mCreationTime(zsLib::now()),
+        mSendLocation(NULL)
       {
         ZS_LOG_BASIC(log("created"))
 
@@ -267,7 +271,7 @@ namespace openpeer
         setCurrentState(ICall::CallState_Preparing);
 
         ZS_LOG_DEBUG(log("call init called thus invoking step"))
-        IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+        mWake.wake(mThisWakeDelegate);
       }
 
       //-----------------------------------------------------------------------
@@ -430,6 +434,12 @@ namespace openpeer
         return mClosedTime;
       }
 
+      //-----------------------------------------------------------------------
+      ElementPtr Call::getMediaQuality() const
+      {
+        return mTransport->getMediaQuality(mID);
+      }
+
       //-----------------------------------------------------------------------
       void Call::ring()
       {
@@ -441,7 +451,7 @@ namespace openpeer
         mRingCalled = true;
 
         ZS_LOG_DEBUG(log("ring called thus invoking step"))
-        IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+        mWake.wake(mThisWakeDelegate);
       }
 
       //-----------------------------------------------------------------------
@@ -456,7 +466,7 @@ namespace openpeer
         mAnswerCalled = true;
 
         ZS_LOG_DEBUG(log("answer called thus invoking step"))
-        IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+        mWake.wake(mThisWakeDelegate);
       }
 
       //-----------------------------------------------------------------------
@@ -468,7 +478,7 @@ namespace openpeer
         mLocalOnHold = hold;
 
         ZS_LOG_DEBUG(log("hold called thus invoking step"))
-        IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+        mWake.wake(mThisWakeDelegate);
       }
 
       //-----------------------------------------------------------------------
@@ -495,6 +505,13 @@ namespace openpeer
         hold(true);
       }
 
+      //-----------------------------------------------------------------------
+      void Call::notifyTransportSocketsAvailable()
+      {
+        ZS_LOG_DEBUG(log("transport sockets are available thus invoking step"))
+        mWake.wake(mThisWakeDelegate);
+      }
+
       //-----------------------------------------------------------------------
       bool Call::sendRTPPacket(
                                PUID toLocationID,
@@ -506,14 +523,16 @@ namespace openpeer
         // NOTE: Intentionally disallow picking of the early location since
         //       local would never send RTP media during early.
 
-        CallLocationPtr callLocation = mPickedLocation.get();
+        // the caller holds a reference to this call thus every location
+        // published in "mSendLocation" outlives this send
+        CallLocation *callLocation = mSendLocation.load(boost::memory_order_acquire);
 
         if (!callLocation) {
-          ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("unable to send RTP packet as there is no picked/early location to communicate"))
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::sendRTPPacket", log("unable to send RTP packet as there is no picked/early location to communicate"))
           return false;
         }
         if (callLocation->getID() != toLocationID) {
-          ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("unable to send RTP packet as the picked/early location does not match the to location"))
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::sendRTPPacket", log("unable to send RTP packet as the picked/early location does not match the to location"))
           return false;
         }
         return callLocation->sendRTPPacket(type, packet, packetLengthInBytes);
@@ -612,7 +631,7 @@ namespace openpeer
       void Call::notifyConversationThreadUpdated()
       {
         ZS_LOG_DEBUG(log("notified conversation thread updated thus invoking step"))
-        IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+        mWake.wake(mThisWakeDelegate);
       }
 
       //-----------------------------------------------------------------------
@@ -629,25 +648,37 @@ namespace openpeer
         if (!on) {
           ZS_LOG_DEBUG(log("this call should not have focus"))
           mTransport->loseFocus(mID);
+
+          CallLocationPtr picked = mPickedLocation.get();
+          if (picked) {
+            // keep media flowing while another call has focus (or on hold)
+            mTransport->attachMedia(mThisWeakNoQueue.lock(), picked->getID(), picked->getVoiceCodec());
+          } else {
+            mTransport->detachMedia(mID);
+          }
           return;
         }
 
         PUID focusLocationID = 0;
+        VoiceCodecInfo focusVoiceCodec;
 
         {
-          if (mPickedLocation.get()) {
-            focusLocationID = mPickedLocation.get()->getID();
-          } else if (mEarlyLocation.get()) {
-            focusLocationID = mEarlyLocation.get()->getID();
+          CallLocationPtr focusLocation = mPickedLocation.get();
+          if (!focusLocation) focusLocation = mEarlyLocation.get();
+
+          if (focusLocation) {
+            focusLocationID = focusLocation->getID();
+            focusVoiceCodec = focusLocation->getVoiceCodec();
           }
         }
 
         // tell the transport to focus on this call/location...
         if (0 != focusLocationID) {
-          mTransport->focus(mThisWeakNoQueue.lock(), focusLocationID);
+          mTransport->focus(mThisWeakNoQueue.lock(), focusLocationID, focusVoiceCodec);
         } else {
           ZS_LOG_WARNING(Detail, log("told to set focus but there is no location to focus"))
           mTransport->loseFocus(mID);
+          mTransport->detachMedia(mID);
         }
       }
 
@@ -684,14 +715,14 @@ namespace openpeer
         }
 
         ZS_LOG_DEBUG(log("ICE socket state change thus invoking step"))
-        IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+        mWake.wake(mThisWakeDelegate);
       }
 
       //-----------------------------------------------------------------------
       void Call::onICESocketCandidatesChanged(IICESocketPtr inSocket)
       {
         ZS_LOG_DEBUG(log("ICE socket candidates change thus invoking step"))
-        IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+        mWake.wake(mThisWakeDelegate);
       }
 
       //-----------------------------------------------------------------------
@@ -735,10 +766,6 @@ namespace openpeer
 
             thread->notifyCallCleanup(mThisWeakNoQueue.lock());
           }
-          if (timer == mMediaCheckTimer.get()) {
-            ZS_LOG_DEBUG(log("rechecking media now"))
-            goto call_step;
-          }
           return;
         }
 
@@ -762,26 +789,9 @@ namespace openpeer
                                          size_t bufferLengthInBytes
                                          )
       {
-        // scope:
-        {
-          CallLocationPtr picked = mPickedLocation.get();
-          CallLocationPtr early = mEarlyLocation.get();
-
-          if (!picked) {
-            if (!early) {
-              ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("ignoring received RTP packet as no call location was chosen"))
-              return;
-            }
-            if (early->getID() != locationID) {
-              ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("ignoring received RTP packet as packet did not come from chosen early location"))
-              return;
-            }
-          } else if (picked->getID() != locationID) {
-            ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("ignoring received RTP packet as location specified is not chosen location") + ZS_PARAM("chosen", mPickedLocation.get()->getID()) + ZS_PARAM("specified", locationID))
-            return;
-          }
-        }
-
+        // the transport only routes packets from the call/location it was
+        // told to focus on (the picked or early location) so no locked
+        // location check is needed on this path
         mTransport->notifyReceivedRTPPacket(mID, locationID, internal::convert(type), buffer, bufferLengthInBytes);
       }
 
@@ -811,7 +821,7 @@ namespace openpeer
               if (picked->getLocationID() == location->getLocationID()) {
                 // the picked location is shutting down...
                 ZS_LOG_WARNING(Detail, log("picked location shutdown") + ZS_PARAM("object ID", location->getID()) + ZS_PARAM("location ID", location->getLocationID()))
-                mPickedLocation.set(CallLocationPtr());
+                setPickedLocation(CallLocationPtr());
                 pickedRemoved = true;
               }
             }
@@ -828,7 +838,7 @@ namespace openpeer
         CallPtr pThis = mThisWeakNoQueue.lock();
         if (pThis) {
           ZS_LOG_DEBUG(log("call location state changed thus invoking step"))
-          IWakeDelegateProxy::create(getQueue(), pThis)->onWake();
+          mWake.wake(getQueue(), pThis);
         }
       }
 
@@ -866,6 +876,7 @@ namespace openpeer
         ElementPtr resultEl = Element::create("core::Call");
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "coalesced wakes", mWake.getTotalCoalesced());
         UseServicesHelper::debugAppend(resultEl, "call id (s)", mCallID);
         UseServicesHelper::debugAppend(resultEl, "has audio", mHasAudio);
         UseServicesHelper::debugAppend(resultEl, "has video", mHasVideo);
@@ -892,7 +903,6 @@ namespace openpeer
           UseServicesHelper::debugAppend(resultEl, "first closed", mFirstClosedRemoteCallTime);
         }
 
-        UseServicesHelper::debugAppend(resultEl, "media check timer", (bool)mMediaCheckTimer.get());
 
         UseServicesHelper::debugAppend(resultEl, "audio socket", (bool)mAudioSocket.get());
         UseServicesHelper::debugAppend(resultEl, "video socket", (bool)mVideoSocket.get());
@@ -964,9 +974,14 @@ namespace openpeer
           callLocation->close();
         }
 
+        ElementPtr qualityEl;
+
         // scope: media
         {
           mTransport->loseFocus(mID);
+          mTransport->detachMedia(mID);
+
+          qualityEl = mTransport->finalizeMediaQuality(mID);
 
           ZS_LOG_DEBUG(log("shutting down audio/video socket subscriptions"))
 
@@ -984,6 +999,19 @@ namespace openpeer
         {
           AutoRecursiveLock lock(mLock);
 
+          CallPtr pThis = mThisWeakNoQueue.lock();
+          if ((qualityEl) &&
+              (mDelegate) &&
+              (pThis)) {
+            ZS_LOG_DEBUG(log("notifying delegate of media quality summary"))
+            try {
+              mDelegate->onCallMediaQualitySummary(pThis, qualityEl);
+            } catch (ICallDelegateProxy::Exceptions::DelegateGone &) {
+              ZS_LOG_WARNING(Detail, log("delegate gone"))
+              mDelegate.reset();
+            }
+          }
+
           setCurrentState(ICall::CallState_Closed);
 
           mDelegate.reset();
@@ -1016,7 +1044,7 @@ namespace openpeer
 
         // scope: final media shutdown
         {
-          mPickedLocation.set(CallLocationPtr());
+          setPickedLocation(CallLocationPtr());
           mEarlyLocation.set(CallLocationPtr());
 
           if (!mNotifiedCallTransportDestroyed.get()) {
@@ -1189,9 +1217,12 @@ namespace openpeer
             if (!mVideoSocket.get()) {
               mVideoSocket.set(mTransport->getSocket(internal::convert(SocketType_Video)));
             }
-            if (!mVideoSocket.get()) return false;
+            if (!mVideoSocket.get()) goto media_not_ready;
+
+            bool bundled = (hasAudio() && (mVideoSocket.get() == mAudioSocket.get()));
 
-            if (!mVideoRTPSocketSubscription.get()) {
+            if ((!bundled) &&
+                (!mVideoRTPSocketSubscription.get())) {
               ZS_LOG_DEBUG(log("subscripting video RTP socket"))
               mVideoRTPSocketSubscription.set(mVideoSocket.get()->subscribe(mThisICESocketDelegate));
               ZS_THROW_CUSTOM_IF(Exceptions::StepFailure, !mVideoRTPSocketSubscription.get())
@@ -1210,24 +1241,15 @@ namespace openpeer
       media_ready:
         {
           ZS_LOG_TRACE(log("audio and/or video sockets are all told to wake") + ZS_PARAM("has audio", hasAudio()) + ZS_PARAM("has video", hasVideo()))
-
-          TimerPtr timer = mMediaCheckTimer.get();
-          if (timer) {
-            timer->cancel();
-            mMediaCheckTimer.set(TimerPtr());
-          }
-
           return true;
         }
 
       media_not_ready:
         {
-          ZS_LOG_TRACE(log("media is not ready"))
-          TimerPtr timer = mMediaCheckTimer.get();
-          if (!timer) {
-            timer = Timer::create(mThisTimerDelegate, Milliseconds(OPENPEER_CALL_RECHECK_MEDIA_TIMER_IN_MILLISECONDS));
-            mMediaCheckTimer.set(timer);
-          }
+          // socket readiness is reported through the socket subscriptions;
+          // the transport wakes this call once its sockets exist
+          ZS_LOG_TRACE(log("media is not ready (waiting on transport sockets)"))
+          ZS_THROW_CUSTOM_IF(Exceptions::StepFailure, !mTransport->notifyWhenSocketsAvailable(mThisWeakNoQueue.lock()))
         }
         return false;
       }
@@ -1345,7 +1367,7 @@ namespace openpeer
             if (mIncomingCall) {
               ZS_LOG_DEBUG(log("incoming call must pick the remote location") + ZS_PARAM("remote location ID", locationID) + CallLocation::toDebug(callLocation, true, false))
               // we *must* pick this location
-              mPickedLocation.set(callLocation);
+              setPickedLocation(callLocation);
               picked = callLocation;
             }
             continue;
@@ -1537,7 +1559,7 @@ namespace openpeer
             case CallState_Hold:      {
               if (ICallLocation::CallLocationState_Ready == callLocation->getState()) {
                 ZS_LOG_DEBUG(log("picked location") + CallLocation::toDebug(callLocation, true, false))
-                mPickedLocation.set(callLocation);
+                setPickedLocation(callLocation);
                 picked = callLocation;
               }
               break;
@@ -1559,7 +1581,7 @@ namespace openpeer
           setCurrentState(CallState_Open, true);
 
           ZS_LOG_DEBUG(log("call state changed to open thus forcing step to force close unchosen locations"))
-          IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+          mWake.wake(mThisWakeDelegate);
         } else if (early) {
           setCurrentState(CallState_Early);
         } else if (ringing) {
@@ -1725,7 +1747,7 @@ namespace openpeer
       {
         if (locationsToClose.size() > 0) {
           ZS_LOG_DEBUG(log("since locations were closed we must invoke a step to cleanup properly"))
-          IWakeDelegateProxy::create(mThisWakeDelegate)->onWake();
+          mWake.wake(mThisWakeDelegate);
         }
 
         // force a closing of all these call locations...
@@ -2028,6 +2050,34 @@ namespace openpeer
             desc->mDescriptionID = services::IHelper::randomString(20);
             desc->mType = "audio";
             desc->mSSRC = 0;
+
+            // offered in order of preference, the legacy codec last
+            VoiceCodecInfoList codecs = UseMediaEngine::getVoiceCodecs();
+            for (VoiceCodecInfoList::iterator codecIter = codecs.begin(); codecIter != codecs.end(); ++codecIter)
+            {
+              const VoiceCodecInfo &info = (*codecIter);
+
+              Dialog::Codec codec;
+              codec.mCodecID = info.mPayloadType;
+              codec.mName = info.mName;
+              codec.mPTime = info.mPTime;
+              codec.mRate = info.mClockRate;
+              codec.mChannels = info.mChannels;
+              desc->mCodecs.push_back(codec);
+            }
+
+            // redundancy is offered so the remote party may enable voice FEC
+            {
+              VoiceCodecInfo info = UseMediaEngine::getVoiceRedundancyCodec();
+
+              Dialog::Codec codec;
+              codec.mCodecID = info.mPayloadType;
+              codec.mName = info.mName;
+              codec.mRate = info.mClockRate;
+              codec.mChannels = info.mChannels;
+              desc->mCodecs.push_back(codec);
+            }
+
             desc->mICEUsernameFrag = mAudioSocket.get()->getUsernameFrag();
             desc->mICEPassword = mAudioSocket.get()->getPassword();
             descriptions.push_back(desc);
@@ -2045,10 +2095,34 @@ namespace openpeer
             desc->mDescriptionID = services::IHelper::randomString(20);
             desc->mType = "video";
             desc->mSSRC = 0;
+
+            // advertised so a bundling peer can demux by payload type
+            VideoCodecInfoList codecs = UseMediaEngine::getVideoCodecs();
+            for (VideoCodecInfoList::iterator codecIter = codecs.begin(); codecIter != codecs.end(); ++codecIter)
+            {
+              const VideoCodecInfo &info = (*codecIter);
+
+              Dialog::Codec codec;
+              codec.mCodecID = info.mPayloadType;
+              codec.mName = info.mName;
+              codec.mRate = info.mClockRate;
+              desc->mCodecs.push_back(codec);
+            }
+
             desc->mICEUsernameFrag = mVideoSocket.get()->getUsernameFrag();
             desc->mICEPassword = mVideoSocket.get()->getPassword();
             descriptions.push_back(desc);
           }
+
+          // bundled video shares the audio socket (and thus its ICE credentials)
+          if ((hasAudio()) &&
+              (hasVideo()) &&
+              (mAudioSocket.get() == mVideoSocket.get())) {
+            const DescriptionPtr &audioDesc = descriptions.front();
+            const DescriptionPtr &videoDesc = descriptions.back();
+            videoDesc->mBundleID = audioDesc->mDescriptionID;
+            ZS_LOG_DEBUG(log("video description is bundled with audio description") + ZS_PARAM("bundle", audioDesc->mDescriptionID))
+          }
         } else {
           descriptions = mDialog->descriptions();
         }
@@ -2132,6 +2206,22 @@ namespace openpeer
         mClosedReason = reason;
       }
 
+      //-----------------------------------------------------------------------
+      void Call::setPickedLocation(CallLocationPtr location)
+      {
+        mPickedLocation.set(location);
+
+        if (location) {
+          AutoLock lock(mSendLocationsLock);
+          if ((mSendLocations.size() < 1) ||
+              (mSendLocations.back() != location)) {
+            mSendLocations.push_back(location);
+          }
+        }
+
+        mSendLocation.store(location.get(), boost::memory_order_release);
+      }
+
       //-----------------------------------------------------------------------
       IICESocketSubscriptionPtr Call::findSubscription(
                                                        IICESocketPtr socket,
@@ -2210,7 +2300,16 @@ namespace openpeer
         mHasAudio((bool)audioSocket),
         mHasVideo((bool)videoSocket),
         mAudioSocket(audioSocket),
-        mVideoSocket(videoSocket)
+        mVideoSocket(videoSocket),
+        mBundled(false),
+        mRemoteAudioSSRC(0),
+        mRemoteVideoSSRC(0),
+        mBundledAudioSSRC(0),
+        mBundledVideoSSRC(0),
+        mLocalAudioSSRC(0),
+        mLocalVideoSSRC(0),
+        mAudioSendSession(NULL),
+        mVideoSendSession(NULL)
       {
         mCurrentState.set(CallLocationState_Pending);
         ZS_THROW_INVALID_ARGUMENT_IF(!remoteDialog)
@@ -2230,54 +2329,152 @@ namespace openpeer
         bool audioFinal = false;
         bool videoFinal = false;
 
+        DescriptionPtr audioDescription;
+        DescriptionPtr videoDescription;
+
         DescriptionList descriptions = mRemoteDialog->descriptions();
         for (DescriptionList::iterator iter = descriptions.begin(); iter != descriptions.end(); ++iter)
         {
           DescriptionPtr &description = (*iter);
 
-          bool isAudio = false;
-          bool isVideo = false;
-
           if ("audio" == description->mType) {
-            isAudio = hasAudio();
-            audioFinal = description->mFinal;
+            if ((hasAudio()) && (mAudioSocket)) {
+              audioDescription = description;
+              audioFinal = description->mFinal;
+              continue;
+            }
           } else if ("video" == description->mType) {
-            isVideo = hasVideo();
-            videoFinal = description->mFinal;
+            if ((hasVideo()) && (mVideoSocket)) {
+              videoDescription = description;
+              videoFinal = description->mFinal;
+              continue;
+            }
           }
 
-          if ((!isAudio) && (!isVideo)) {
-            ZS_LOG_WARNING(Detail, log("call location media type is not supported") + ZS_PARAM("type", description->mType))
-            continue;
+          ZS_LOG_WARNING(Detail, log("call location media type is not supported") + ZS_PARAM("type", description->mType))
+        }
+
+        IICESocket::ICEControls control = (outer->isIncoming() ? IICESocket::ICEControl_Controlled : IICESocket::ICEControl_Controlling);
+
+        if (audioDescription) {
+          IICESocket::CandidateList tempCandidates;
+          stack::IHelper::convert(audioDescription->mCandidates, tempCandidates);
+
+          mAudioRTPSocketSession.set(IICESocketSession::create(mThisICESocketSessionDelegate, mAudioSocket, audioDescription->mICEUsernameFrag, audioDescription->mICEPassword, tempCandidates, control));
+
+          // pick the most preferred local codec the remote party also offered
+          VoiceCodecInfoList localCodecs = UseMediaEngine::getVoiceCodecs();
+          for (VoiceCodecInfoList::iterator localIter = localCodecs.begin(); localIter != localCodecs.end(); ++localIter)
+          {
+            const VoiceCodecInfo &local = (*localIter);
+
+            for (Dialog::CodecList::iterator remoteIter = audioDescription->mCodecs.begin(); remoteIter != audioDescription->mCodecs.end(); ++remoteIter)
+            {
+              const Dialog::Codec &remote = (*remoteIter);
+              if (0 != local.mName.compareNoCase(remote.mName)) continue;
+              if (local.mClockRate != remote.mRate) continue;
+
+              mVoiceCodec = local;
+              mVoiceCodec.mPayloadType = remote.mCodecID;   // send using the payload type the remote party expects
+              if (0 != remote.mPTime) mVoiceCodec.mPTime = remote.mPTime;
+              break;
+            }
+
+            if (mVoiceCodec.hasData()) break;
           }
 
-          IICESocketPtr rtpSocket = isAudio ? mAudioSocket : mVideoSocket;
-          if (!rtpSocket) {
-            ZS_LOG_WARNING(Detail, log("failed to object transport's sockets for media type") + ZS_PARAM("type", description->mType))
-            continue;
+          if ((!mVoiceCodec.hasData()) &&
+              (localCodecs.size() > 0)) {
+            // peers that predate codec negotiation do not list codecs and only speak the legacy codec
+            mVoiceCodec = localCodecs.back();
+            ZS_LOG_WARNING(Detail, log("no common voice codec offered (thus using legacy codec)") + ZS_PARAM("remote codecs", audioDescription->mCodecs.size()) + ZS_PARAM("codec", mVoiceCodec.mName))
           }
 
-          IICESocket::CandidateList tempCandidates;
-          stack::IHelper::convert(description->mCandidates, tempCandidates);
+          // FEC sends redundancy using the RED payload type the remote party offered
+          VoiceCodecInfo red = UseMediaEngine::getVoiceRedundancyCodec();
+          for (Dialog::CodecList::iterator remoteIter = audioDescription->mCodecs.begin(); remoteIter != audioDescription->mCodecs.end(); ++remoteIter)
+          {
+            const Dialog::Codec &remote = (*remoteIter);
+            if (0 != red.mName.compareNoCase(remote.mName)) continue;
+
+            mVoiceCodec.mRedPayloadType = remote.mCodecID;
+            break;
+          }
+        }
+
+        if (videoDescription) {
+          // both sides must have bundled for the video to share the audio session
+          mBundled = ((audioDescription) &&
+                      (mAudioSocket == mVideoSocket) &&
+                      (videoDescription->mBundleID == audioDescription->mDescriptionID) &&
+                      (videoDescription->mICEUsernameFrag == audioDescription->mICEUsernameFrag) &&
+                      (videoDescription->mICEPassword == audioDescription->mICEPassword));
+
+          if (mBundled) {
+            mVideoRTPSocketSession.set(mAudioRTPSocketSession.get());
+
+            // demux by what was negotiated in the descriptions
+            mRemoteAudioSSRC = audioDescription->mSSRC;
+            mRemoteVideoSSRC = videoDescription->mSSRC;
 
-          if (isAudio) {
-            if (!mAudioRTPSocketSession.get()) {
-              mAudioRTPSocketSession.set(IICESocketSession::create(mThisICESocketSessionDelegate, rtpSocket, description->mICEUsernameFrag, description->mICEPassword, tempCandidates, outer->isIncoming() ? IICESocket::ICEControl_Controlled : IICESocket::ICEControl_Controlling));
+            for (Dialog::CodecList::iterator iter = audioDescription->mCodecs.begin(); iter != audioDescription->mCodecs.end(); ++iter)
+            {
+              mBundledAudioPayloadTypes.insert((BYTE)(*iter).mCodecID);
+            }
+            if (mVoiceCodec.hasData()) {
+              mBundledAudioPayloadTypes.insert(mVoiceCodec.mPayloadType);
+            }
+            if (mBundledAudioPayloadTypes.size() < 1) {
+              VoiceCodecInfoList localCodecs = UseMediaEngine::getVoiceCodecs();
+              for (VoiceCodecInfoList::iterator iter = localCodecs.begin(); iter != localCodecs.end(); ++iter)
+              {
+                mBundledAudioPayloadTypes.insert((*iter).mPayloadType);
+              }
+            }
+
+            for (Dialog::CodecList::iterator iter = videoDescription->mCodecs.begin(); iter != videoDescription->mCodecs.end(); ++iter)
+            {
+              mBundledVideoPayloadTypes.insert((BYTE)(*iter).mCodecID);
             }
-          } else if (isVideo) {
-            if (!mVideoRTPSocketSession.get()) {
-              mVideoRTPSocketSession.set(IICESocketSession::create(mThisICESocketSessionDelegate, rtpSocket, description->mICEUsernameFrag, description->mICEPassword, tempCandidates, outer->isIncoming() ? IICESocket::ICEControl_Controlled : IICESocket::ICEControl_Controlling));
+            if (mBundledVideoPayloadTypes.size() < 1) {
+              // peers that predate codec negotiation use the video engine's default payload types
+              VideoCodecInfoList localCodecs = UseMediaEngine::getVideoCodecs();
+              for (VideoCodecInfoList::iterator iter = localCodecs.begin(); iter != localCodecs.end(); ++iter)
+              {
+                mBundledVideoPayloadTypes.insert((*iter).mPayloadType);
+              }
+            }
+
+            // a payload type claimed by both streams cannot be used to demux
+            for (PayloadTypeSet::iterator iter = mBundledVideoPayloadTypes.begin(); iter != mBundledVideoPayloadTypes.end(); ++iter)
+            {
+              PayloadTypeSet::iterator found = mBundledAudioPayloadTypes.find(*iter);
+              if (found == mBundledAudioPayloadTypes.end()) continue;
+
+              ZS_LOG_WARNING(Detail, log("bundled payload type negotiated for both audio and video (thus demuxing it by SSRC only)") + ZS_PARAM("payload type", (*iter)))
+              mBundledAudioPayloadTypes.erase(found);
             }
+          } else {
+            IICESocket::CandidateList tempCandidates;
+            stack::IHelper::convert(videoDescription->mCandidates, tempCandidates);
+
+            mVideoRTPSocketSession.set(IICESocketSession::create(mThisICESocketSessionDelegate, mVideoSocket, videoDescription->mICEUsernameFrag, videoDescription->mICEPassword, tempCandidates, control));
           }
         }
 
+        // the RTP socket session values are never reset thus the send path
+        // may read these without a lock
+        mAudioSendSession.store(mAudioRTPSocketSession.get().get(), boost::memory_order_release);
+        mVideoSendSession.store(mVideoRTPSocketSession.get().get(), boost::memory_order_release);
+
         if (mAudioRTPSocketSession.get()) {
           mAudioRTPSocketSession.get()->setKeepAliveProperties(Seconds(OPENPEER_CALL_RTP_ICE_KEEP_ALIVE_INDICATIONS_SENT_IN_SECONDS), Seconds(OPENPEER_CALL_RTP_ICE_EXPECTING_DATA_WITHIN_IN_SECONDS), Seconds(OPENPEER_CALL_RTP_MAX_KEEP_ALIVE_REQUEST_TIMEOUT_IN_SECONDS));
           if (audioFinal) {
             mAudioRTPSocketSession.get()->endOfRemoteCandidates();
           }
         }
-        if (mVideoRTPSocketSession.get()) {
+        if ((mVideoRTPSocketSession.get()) &&
+            (!mBundled)) {
           mVideoRTPSocketSession.get()->setKeepAliveProperties(Seconds(OPENPEER_CALL_RTP_ICE_KEEP_ALIVE_INDICATIONS_SENT_IN_SECONDS), Seconds(OPENPEER_CALL_RTP_ICE_EXPECTING_DATA_WITHIN_IN_SECONDS), Seconds(OPENPEER_CALL_RTP_MAX_KEEP_ALIVE_REQUEST_TIMEOUT_IN_SECONDS));
           if (videoFinal) {
             mVideoRTPSocketSession.get()->endOfRemoteCandidates();
@@ -2288,7 +2485,9 @@ namespace openpeer
                      ZS_PARAM("audio RTP session ID", mAudioRTPSocketSession.get() ? mAudioRTPSocketSession.get()->getID() : 0) +
                      ZS_PARAM("video RTP session ID", mVideoRTPSocketSession.get() ? mVideoRTPSocketSession.get()->getID() : 0) +
                      ZS_PARAM("audio final", audioFinal) +
-                     ZS_PARAM("video final", videoFinal))
+                     ZS_PARAM("video final", videoFinal) +
+                     ZS_PARAM("bundled", mBundled) +
+                     ZS_PARAM("voice codec", mVoiceCodec.mName))
       }
 
       //-----------------------------------------------------------------------
@@ -2376,20 +2575,27 @@ namespace openpeer
                                              size_t packetLengthInBytes
                                              )
       {
-        IICESocketSessionPtr session;
+        IICESocketSession *session = NULL;
 
-        // scope: media
-        {
-          switch (type) {
-            case SocketType_Audio: session = mAudioRTPSocketSession.get(); break;
-            case SocketType_Video: session = mVideoRTPSocketSession.get(); break;
-          }
+        switch (type) {
+          case SocketType_Audio: session = mAudioSendSession.load(boost::memory_order_acquire); break;
+          case SocketType_Video: session = mVideoSendSession.load(boost::memory_order_acquire); break;
         }
 
         if (!session) {
-          ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("unable to send RTP packet as there is no ICE session object"))
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::CallLocation::sendRTPPacket", log("unable to send RTP packet as there is no ICE session object"))
           return false;
         }
+
+        if ((mBundled) &&
+            (packetLengthInBytes >= (sizeof(DWORD)*3)) &&
+            (!OPENPEER_CALL_BUNDLE_IS_RTCP(packet[1]))) {
+          // remember our own send SSRCs so bundled RTCP can be routed by its report blocks
+          DWORD ssrc = (((DWORD)packet[8]) << 24) | (((DWORD)packet[9]) << 16) | (((DWORD)packet[10]) << 8) | ((DWORD)packet[11]);
+          boost::atomic<DWORD> &localSSRC = (SocketType_Video == type ? mLocalVideoSSRC : mLocalAudioSSRC);
+          if (ssrc != localSSRC.load()) localSSRC.store(ssrc);
+        }
+
         return session->sendPacket(packet, packetLengthInBytes);
       }
 
@@ -2450,7 +2656,7 @@ namespace openpeer
         CallPtr outer = mOuter.lock();
 
         if (!outer) {
-          ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("ignoring ICE socket packet as call object is gone"))
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::CallLocation::handleICESocketSessionReceivedPacket", log("ignoring ICE socket packet as call object is gone"))
           return;
         }
 
@@ -2461,15 +2667,19 @@ namespace openpeer
         // scope: media
         {
           if (isClosed()) {
-            ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Detail, log("received packet but already closed (probably okay)"))
+            OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Detail, "core::Call::CallLocation::handleICESocketSessionReceivedPacket", log("received packet but already closed (probably okay)"))
             return;
           }
 
           findSession(inSession, found, &type, &wasRTP);
           if (!found) {
-            ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("ignoring ICE socket packet from obsolete session"))
+            OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::CallLocation::handleICESocketSessionReceivedPacket", log("ignoring ICE socket packet from obsolete session"))
             return;
           }
+
+          if (mBundled) {
+            if (!demuxBundledPacket(buffer, bufferLengthInBytes, type)) return;
+          }
         }
 
         outer->notifyReceivedRTPPacket(mID, type, buffer, bufferLengthInBytes);
@@ -2529,8 +2739,18 @@ namespace openpeer
         }
         if (media)
         {
+          UseServicesHelper::debugAppend(resultEl, "voice codec", mVoiceCodec.hasData() ? mVoiceCodec.toDebug() : ElementPtr());
           UseServicesHelper::debugAppend(resultEl, "audio rtp socket session", mAudioRTPSocketSession.get() ? mAudioRTPSocketSession.get()->getID() : 0);
           UseServicesHelper::debugAppend(resultEl, "video rtp socket session", mVideoRTPSocketSession.get() ? mVideoRTPSocketSession.get()->getID() : 0);
+          UseServicesHelper::debugAppend(resultEl, "bundled", mBundled);
+          UseServicesHelper::debugAppend(resultEl, "bundled audio payload types", mBundledAudioPayloadTypes.size());
+          UseServicesHelper::debugAppend(resultEl, "bundled video payload types", mBundledVideoPayloadTypes.size());
+          UseServicesHelper::debugAppend(resultEl, "remote audio ssrc", mRemoteAudioSSRC);
+          UseServicesHelper::debugAppend(resultEl, "remote video ssrc", mRemoteVideoSSRC);
+          UseServicesHelper::debugAppend(resultEl, "bundled audio ssrc", mBundledAudioSSRC.load());
+          UseServicesHelper::debugAppend(resultEl, "bundled video ssrc", mBundledVideoSSRC.load());
+          UseServicesHelper::debugAppend(resultEl, "local audio ssrc", mLocalAudioSSRC.load());
+          UseServicesHelper::debugAppend(resultEl, "local video ssrc", mLocalVideoSSRC.load());
         }
 
         return resultEl;
@@ -2560,7 +2780,8 @@ namespace openpeer
             mAudioRTPSocketSession.get()->close();
             // do not reset
           }
-          if (mVideoRTPSocketSession.get()) {
+          if ((mVideoRTPSocketSession.get()) &&
+              (!mBundled)) {
             mVideoRTPSocketSession.get()->close();
             // do not reset
           }
@@ -2655,7 +2876,8 @@ namespace openpeer
             }
           }
 
-          if (hasVideo()) {
+          if ((hasVideo()) &&
+              (!mBundled)) {
             IICESocket::CandidateList tempCandidates;
             stack::IHelper::convert(videoCandidates, tempCandidates);
 
@@ -2754,13 +2976,126 @@ namespace openpeer
           }
         }
 
-        ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("did not find socket session thus returning bogus session") + ZS_PARAM("socket session ID", session->getID()))
+        OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::CallLocation::findSession", log("did not find socket session thus returning bogus session") + ZS_PARAM("socket session ID", session->getID()))
 
         outFound = false;
         if (outType) *outType = SocketType_Audio;
         if (outIsRTP) *outIsRTP = false;
         return bogus;
       }
+
+      //-----------------------------------------------------------------------
+      bool Call::CallLocation::demuxBundledPacket(
+                                                  const BYTE *buffer,
+                                                  size_t bufferLengthInBytes,
+                                                  SocketTypes &outType
+                                                  )
+      {
+        if (bufferLengthInBytes < (sizeof(DWORD)*2)) {
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::CallLocation::demuxBundledPacket", log("ignoring bundled packet too short to demux") + ZS_PARAM("length", bufferLengthInBytes))
+          return false;
+        }
+
+        if (OPENPEER_CALL_BUNDLE_IS_RTCP(buffer[1])) return demuxBundledRTCPPacket(buffer, bufferLengthInBytes, outType);
+
+        if (bufferLengthInBytes < (sizeof(DWORD)*3)) {
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::Call::CallLocation::demuxBundledPacket", log("ignoring bundled RTP packet too short to demux") + ZS_PARAM("length", bufferLengthInBytes))
+          return false;
+        }
+
+        BYTE payloadType = (buffer[1] & 0x7F);
+        DWORD ssrc = (((DWORD)buffer[8]) << 24) | (((DWORD)buffer[9]) << 16) | (((DWORD)buffer[10]) << 8) | ((DWORD)buffer[11]);
+
+        // an SSRC declared in the descriptions (or already learned) wins
+        DWORD videoSSRC = (0 != mRemoteVideoSSRC ? mRemoteVideoSSRC : mBundledVideoSSRC.load());
+        DWORD audioSSRC = (0 != mRemoteAudioSSRC ? mRemoteAudioSSRC : mBundledAudioSSRC.load());
+
+        if ((0 != videoSSRC) &&
+            (ssrc == videoSSRC)) {
+          outType = SocketType_Video;
+          return true;
+        }
+        if ((0 != audioSSRC) &&
+            (ssrc == audioSSRC)) {
+          outType = SocketType_Audio;
+          return true;
+        }
+
+        if (mBundledVideoPayloadTypes.end() != mBundledVideoPayloadTypes.find(payloadType)) {
+          outType = SocketType_Video;
+          if (0 == mRemoteVideoSSRC) mBundledVideoSSRC.store(ssrc);
+          return true;
+        }
+        if (mBundledAudioPayloadTypes.end() != mBundledAudioPayloadTypes.find(payloadType)) {
+          outType = SocketType_Audio;
+          if (0 == mRemoteAudioSSRC) mBundledAudioSSRC.store(ssrc);
+          return true;
+        }
+
+        OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::Call::CallLocation::demuxBundledPacket", log("dropping bundled RTP packet with payload type and SSRC not negotiated") + ZS_PARAM("payload type", payloadType) + ZS_PARAM("ssrc", ssrc))
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      bool Call::CallLocation::demuxBundledRTCPPacket(
+                                                      const BYTE *buffer,
+                                                      size_t bufferLengthInBytes,
+                                                      SocketTypes &outType
+                                                      )
+      {
+        // RTCP is first routed by the sender SSRC of the remote streams
+        DWORD ssrc = (((DWORD)buffer[4]) << 24) | (((DWORD)buffer[5]) << 16) | (((DWORD)buffer[6]) << 8) | ((DWORD)buffer[7]);
+
+        DWORD videoSSRC = (0 != mRemoteVideoSSRC ? mRemoteVideoSSRC : mBundledVideoSSRC.load());
+        DWORD audioSSRC = (0 != mRemoteAudioSSRC ? mRemoteAudioSSRC : mBundledAudioSSRC.load());
+
+        if ((0 != videoSSRC) &&
+            (ssrc == videoSSRC)) {
+          outType = SocketType_Video;
+          return true;
+        }
+        if ((0 != audioSSRC) &&
+            (ssrc == audioSSRC)) {
+          outType = SocketType_Audio;
+          return true;
+        }
+
+        // otherwise by the report blocks about our own send streams (e.g. a
+        // receive only peer or RTCP arriving before its RTP)
+        BYTE packetType = buffer[1];
+        size_t offset = 0;
+        switch (packetType) {
+          case 200: offset = (sizeof(DWORD)*7); break;  // SR: header, sender SSRC, 20 byte sender info
+          case 201: offset = (sizeof(DWORD)*2); break;  // RR: header, sender SSRC
+          default:  break;
+        }
+
+        if (0 != offset) {
+          DWORD localVideoSSRC = mLocalVideoSSRC.load();
+          DWORD localAudioSSRC = mLocalAudioSSRC.load();
+
+          size_t totalBlocks = (buffer[0] & 0x1F);
+          for (size_t index = 0; index < totalBlocks; ++index, offset += (sizeof(DWORD)*6)) {
+            if ((offset + (sizeof(DWORD)*6)) > bufferLengthInBytes) break;
+
+            DWORD sourceSSRC = (((DWORD)buffer[offset]) << 24) | (((DWORD)buffer[offset+1]) << 16) | (((DWORD)buffer[offset+2]) << 8) | ((DWORD)buffer[offset+3]);
+
+            if ((0 != localVideoSSRC) &&
+                (sourceSSRC == localVideoSSRC)) {
+              outType = SocketType_Video;
+              return true;
+            }
+            if ((0 != localAudioSSRC) &&
+                (sourceSSRC == localAudioSSRC)) {
+              outType = SocketType_Audio;
+              return true;
+            }
+          }
+        }
+
+        OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::Call::CallLocation::demuxBundledRTCPPacket", log("dropping bundled RTCP packet from unknown SSRC") + ZS_PARAM("ssrc", ssrc))
+        return false;
+      }
     }
 
     //-------------------------------------------------------------------------
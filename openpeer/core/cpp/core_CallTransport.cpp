@@ -35,6 +35,8 @@
 #include <openpeer/core/internal/core_Call.h>
 #include <openpeer/core/internal/core_MediaEngine.h>
 #include <openpeer/core/internal/core_Helper.h>
+#include <openpeer/core/internal/core_Logger.h>
+#include <openpeer/core/internal/core_Settings.h>
 
 #include <openpeer/services/IHelper.h>
 
@@ -43,6 +45,8 @@
 #include <zsLib/XML.h>
 
 #define OPENPEER_CALLTRANSPORT_CLOSE_UNUSED_SOCKETS_AFTER_IN_SECONDS (90)
+#define OPENPEER_CALLTRANSPORT_WARM_SOCKETS_REFRESH_IN_SECONDS (60*5)
+#define OPENPEER_CALLTRANSPORT_RECLAIM_MEDIA_ROUTES_RETRY_IN_MILLISECONDS (100)
 
 namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_core) } }
 namespace openpeer { namespace core { ZS_DECLARE_FORWARD_SUBSYSTEM(openpeer_media) } }
@@ -53,12 +57,13 @@ namespace openpeer
   {
     namespace internal
     {
-      ZS_DECLARE_TYPEDEF_PTR(IMediaEngineForCallTransport, UseMediaEngine)
+      using zsLib::Milliseconds;
 
       typedef IStackForInternal UseStack;
       typedef ICallTransportForAccount::ForAccountPtr ForAccountPtr;
 
       ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+      ZS_DECLARE_TYPEDEF_PTR(ISettingsForInternal, UseSettings)
 
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -136,6 +141,50 @@ namespace openpeer
         return ICallTransportFactory::singleton().create(delegate, turnServers, stunServers);
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CallTransport_MediaRouteReader
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: marks the send/receive path as reading the published route
+      //          so a retired route is not freed while it may still be in use
+      // NOTE:    the reader is counted as a loader until "enter" counts it in
+      //          the route it loaded (a few instructions) and then only in
+      //          that route, thus a busy route never delays freeing another
+      class CallTransport_MediaRouteReader
+      {
+      public:
+        CallTransport_MediaRouteReader(boost::atomic<ULONG> &loaders) :
+          mLoaders(&loaders),
+          mReaders(NULL)
+        {
+          mLoaders->fetch_add(1, boost::memory_order_seq_cst);
+        }
+
+        ~CallTransport_MediaRouteReader()
+        {
+          if (mLoaders) mLoaders->fetch_sub(1, boost::memory_order_seq_cst);
+          if (mReaders) mReaders->fetch_sub(1, boost::memory_order_seq_cst);
+        }
+
+        void enter(boost::atomic<ULONG> *readers)
+        {
+          mReaders = readers;
+          if (mReaders) mReaders->fetch_add(1, boost::memory_order_seq_cst);
+
+          mLoaders->fetch_sub(1, boost::memory_order_seq_cst);
+          mLoaders = NULL;
+        }
+
+      private:
+        boost::atomic<ULONG> *mLoaders;
+        boost::atomic<ULONG> *mReaders;
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -163,7 +212,9 @@ namespace openpeer
         mStarted(false),
         mHasAudio(false),
         mHasVideo(false),
-        mBlockUntilStartStopCompleted(0)
+        mBlockUntilStartStopCompleted(0),
+        mMediaRoute(NULL),
+        mMediaRouteLoaders(0)
       {
         ZS_LOG_BASIC(log("created"))
       }
@@ -171,7 +222,7 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void CallTransport::init()
       {
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -202,6 +253,12 @@ namespace openpeer
         return dynamic_pointer_cast<CallTransport>(transport);
       }
 
+      //-----------------------------------------------------------------------
+      CallTransportPtr CallTransport::convert(ForConversationThreadPtr transport)
+      {
+        return dynamic_pointer_cast<CallTransport>(transport);
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -226,7 +283,6 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void CallTransport::shutdown()
       {
-        AutoRecursiveLock lock(*this);
         cancel();
       }
 
@@ -262,33 +318,49 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void CallTransport::notifyCallDestruction(PUID idCall)
       {
-        AutoRecursiveLock lock(*this);
-        if ((isShuttingDown()) ||
-            (isShutdown())) {
-          ZS_LOG_DEBUG(log("ignoring call destructionn during shutdown"))
-          return;
-        }
+        MediaSessionPtr session;
 
-        ZS_THROW_BAD_STATE_IF(mTotalCalls < 1)
+        // scope: media sessions must be stopped outside the lock
+        {
+          AutoRecursiveLock lock(*this);
+          if ((isShuttingDown()) ||
+              (isShutdown())) {
+            ZS_LOG_DEBUG(log("ignoring call destructionn during shutdown"))
+            return;
+          }
 
-        --mTotalCalls;
+          ZS_THROW_BAD_STATE_IF(mTotalCalls < 1)
 
-        if (mSocketCleanupTimer) {
-          mSocketCleanupTimer->cancel();
-          mSocketCleanupTimer.reset();
+          --mTotalCalls;
+
+          mSocketWaiters.erase(idCall);
+
+          session = removeMediaSession(idCall);
+
+          if (mSocketCleanupTimer) {
+            mSocketCleanupTimer->cancel();
+            mSocketCleanupTimer.reset();
+          }
+
+          mSocketCleanupTimer = Timer::create(mThisWeak.lock(), Seconds(OPENPEER_CALLTRANSPORT_CLOSE_UNUSED_SOCKETS_AFTER_IN_SECONDS), false);
         }
 
-        mSocketCleanupTimer = Timer::create(mThisWeak.lock(), Seconds(OPENPEER_CALLTRANSPORT_CLOSE_UNUSED_SOCKETS_AFTER_IN_SECONDS), false);
+        if (session) {
+          ZS_LOG_WARNING(Detail, log("call destroyed while its media session was still attached") + ZS_PARAM("call ID", idCall))
+          session->stop();
+        }
       }
 
       //-----------------------------------------------------------------------
       void CallTransport::focus(
                                 CallPtr inCall,
-                                PUID locationID
+                                PUID locationID,
+                                const VoiceCodecInfo &voiceCodec
                                 )
       {
         UseCallPtr call = inCall;
         UseCallPtr oldFocus;
+        MediaSessionPtr focusedSession;
 
         // scope: do not want to call notifyLostFocus from inside a lock (possible deadlock)
         {
@@ -297,6 +369,9 @@ namespace openpeer
           if (call) {
             ZS_THROW_BAD_STATE_IF(mTotalCalls < 1)
 
+            // the focused call's media moves to the primary channels
+            focusedSession = removeMediaSession(call->getID());
+
             if (mFocusCallID != call->getID()) {
               // focus has changed...
 
@@ -307,9 +382,11 @@ namespace openpeer
               mFocus = call;
               mFocusCallID = call->getID();
               mFocusLocationID = locationID;
+              mFocusVoiceCodec = voiceCodec;
 
               // must restart the media
               ++mBlockUntilStartStopCompleted;
+              publishMediaRoute();
               ICallTransportAsyncProxy::create(mThisWeak.lock())->onStart();
             } else {
               if (locationID != mFocusLocationID) {
@@ -317,19 +394,28 @@ namespace openpeer
 
                 // must restart the media
                 ++mBlockUntilStartStopCompleted;
-                ICallTransportAsyncProxy::create(mThisWeak.lock())->onStart();
                 mFocusLocationID = locationID;
+                mFocusVoiceCodec = voiceCodec;
+                publishMediaRoute();
+                ICallTransportAsyncProxy::create(mThisWeak.lock())->onStart();
               }
             }
           } else {
             ZS_LOG_DEBUG(log("no focus at all") + ZS_PARAM("was", mFocusLocationID) + ZS_PARAM("now", locationID) + ZS_PARAM("block count", mBlockUntilStartStopCompleted))
             mFocusCallID = 0;
             mFocusLocationID = 0;
+            mFocusVoiceCodec = VoiceCodecInfo();
             ++mBlockUntilStartStopCompleted;
+            publishMediaRoute();
             ICallTransportAsyncProxy::create(mThisWeak.lock())->onStop();
           }
         }
 
+        if (focusedSession) {
+          ZS_LOG_DEBUG(log("stopping media session of call now in focus") + ZS_PARAM("call ID", focusedSession->getCallID()))
+          focusedSession->stop();
+        }
+
         if (oldFocus) {
           ZS_LOG_DEBUG(log("telling old focus to go on hold..."))
           oldFocus->notifyLostFocus();
@@ -351,7 +437,88 @@ namespace openpeer
           return;
         }
 
-        focus(CallPtr(), 0);
+        focus(CallPtr(), 0, VoiceCodecInfo());
+      }
+
+      //-----------------------------------------------------------------------
+      void CallTransport::attachMedia(
+                                      CallPtr inCall,
+                                      PUID locationID,
+                                      const VoiceCodecInfo &voiceCodec
+                                      )
+      {
+        UseCallPtr call = inCall;
+        ZS_THROW_INVALID_ARGUMENT_IF(!call)
+
+        MediaSessionPtr obsoleteSession;
+
+        // scope: media sessions must be stopped outside the lock
+        {
+          AutoRecursiveLock lock(*this);
+
+          if ((isShuttingDown()) ||
+              (isShutdown())) {
+            ZS_LOG_WARNING(Detail, log("cannot attach media during shutdown") + ZS_PARAM("call ID", call->getID()))
+            return;
+          }
+
+          if (call->getID() == mFocusCallID) {
+            ZS_LOG_DEBUG(log("call has focus thus its media is already flowing") + ZS_PARAM("call ID", call->getID()))
+            return;
+          }
+
+          if (!call->hasAudio()) {
+            ZS_LOG_DEBUG(log("call has no audio thus no media session is needed") + ZS_PARAM("call ID", call->getID()))
+            return;
+          }
+
+          MediaSessionMap::iterator found = mMediaSessions.find(call->getID());
+          if (found != mMediaSessions.end()) {
+            if (locationID == found->second->getLocationID()) {
+              OPENPEER_CORE_LOG_HOT_TRACE(log("media session is already attached") + ZS_PARAM("call ID", call->getID()) + ZS_PARAM("location ID", locationID))
+              return;
+            }
+            ZS_LOG_DEBUG(log("media session location changed") + ZS_PARAM("call ID", call->getID()) + ZS_PARAM("was", found->second->getLocationID()) + ZS_PARAM("now", locationID))
+            obsoleteSession = found->second;
+            mMediaSessions.erase(found);
+          }
+
+          UseMediaEnginePtr engine = UseMediaEngine::singleton();
+
+          size_t maxSessions = UseSettings::snapshot()->mCallTransportMaxConcurrentMediaSessions;
+
+          if (0 == maxSessions) {
+            ZS_LOG_DEBUG(log("concurrent media sessions are off (call media will not flow until it has focus)") + ZS_PARAM("call ID", call->getID()))
+          } else if (mMediaSessions.size() >= maxSessions) {
+            ZS_LOG_WARNING(Detail, log("too many concurrent media sessions (call media will not flow until it has focus)") + ZS_PARAM("call ID", call->getID()) + ZS_PARAM("sessions", mMediaSessions.size()) + ZS_PARAM("max", maxSessions))
+          } else if (engine) {
+            MediaSessionPtr session = MediaSession::create(call, locationID, voiceCodec, engine);
+            mMediaSessions[call->getID()] = session;
+            ZS_LOG_DETAIL(log("attached media session") + ZS_PARAM("call ID", call->getID()) + ZS_PARAM("location ID", locationID) + ZS_PARAM("sessions", mMediaSessions.size()))
+          }
+
+          publishMediaRoute();
+        }
+
+        if (obsoleteSession) {
+          obsoleteSession->stop();
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void CallTransport::detachMedia(PUID callID)
+      {
+        MediaSessionPtr session;
+
+        {
+          AutoRecursiveLock lock(*this);
+          session = removeMediaSession(callID);
+        }
+
+        if (!session) return;
+
+        ZS_LOG_DETAIL(log("detached media session") + ZS_PARAM("call ID", callID))
+        session->stop();
       }
 
       //-----------------------------------------------------------------------
@@ -368,6 +535,50 @@ namespace openpeer
         return IICESocketPtr();
       }
 
+      //-----------------------------------------------------------------------
+      bool CallTransport::notifyWhenSocketsAvailable(CallPtr inCall)
+      {
+        UseCallPtr call = inCall;
+        ZS_THROW_INVALID_ARGUMENT_IF(!call)
+
+        AutoRecursiveLock lock(*this);
+
+        if ((isShuttingDown()) ||
+            (isShutdown())) {
+          ZS_LOG_WARNING(Detail, log("sockets will never be available as call transport is shutting down") + ZS_PARAM("call ID", call->getID()))
+          return false;
+        }
+
+        if ((mAudioSocket) &&
+            (mVideoSocket)) {
+          ZS_LOG_DEBUG(log("sockets are already available") + ZS_PARAM("call ID", call->getID()))
+          call->notifyTransportSocketsAvailable();
+          return true;
+        }
+
+        ZS_LOG_DEBUG(log("call is waiting for sockets") + ZS_PARAM("call ID", call->getID()))
+        mSocketWaiters[call->getID()] = call;
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr CallTransport::getMediaQuality(PUID callID) const
+      {
+        UseMediaEnginePtr engine = UseMediaEngine::singleton();
+        if (!engine) return ElementPtr();
+
+        return engine->getMediaQuality(callID);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr CallTransport::finalizeMediaQuality(PUID callID)
+      {
+        UseMediaEnginePtr engine = UseMediaEngine::singleton();
+        if (!engine) return ElementPtr();
+
+        return engine->finalizeMediaQuality(callID);
+      }
+
       //-----------------------------------------------------------------------
       void CallTransport::notifyReceivedRTPPacket(
                                                   PUID callID,
@@ -385,55 +596,65 @@ namespace openpeer
         BYTE filterType = (payloadType & 0x7F);
         bool isRTP = ((filterType < 64) || (filterType > 96));
 
-        ZS_LOG_SUBSYSTEM_TRACE(mediaSubsystem(), log("notified of packet") + ZS_PARAM("type", (isRTP ? "RTP" : "RTCP")) + ZS_PARAM("from call ID", callID) + ZS_PARAM("from location ID", locationID) + ZS_PARAM("socket type", ICallTransportForCall::toString(type)) + ZS_PARAM("payload type", payloadType) + ZS_PARAM("length", bufferLengthInBytes))
+        OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::notifyReceivedRTPPacket", log("notified of packet") + ZS_PARAM("type", (isRTP ? "RTP" : "RTCP")) + ZS_PARAM("from call ID", callID) + ZS_PARAM("from location ID", locationID) + ZS_PARAM("socket type", ICallTransportForCall::toString(type)) + ZS_PARAM("payload type", payloadType) + ZS_PARAM("length", bufferLengthInBytes))
 
-        // scope - get locked variable
-        {
-          AutoRecursiveLock lock(*this);
+        // the route is republished (under the lock) whenever focus, sockets or
+        // the started media changes; the receive path only reads the
+        // published record and never takes the transport lock
+        CallTransport_MediaRouteReader reader(mMediaRouteLoaders);
 
-          if (0 != mBlockUntilStartStopCompleted) {
-            ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Debug, log("ignoring RTP/RTCP packet as media is blocked until the start/stop routine complete") + ZS_PARAM("blocked count", mBlockUntilStartStopCompleted))
-            return;
-          }
+        const MediaRoute *route = mMediaRoute.load(boost::memory_order_seq_cst);
+        reader.enter(route ? &(route->mReaders) : NULL);
+        if (!route) {
+          OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::notifyReceivedRTPPacket", log("ignoring RTP/RTCP packet as media is not started (or start/stop routine is pending)"))
+          return;
+        }
 
-          if (!mStarted) {
-            ZS_LOG_TRACE(log("ignoring RTP/RTCP packet as media is not started"))
+        if ((0 == route->mCallID) ||
+            (callID != route->mCallID) ||
+            (locationID != route->mLocationID)) {
+          MediaSessionMap::const_iterator found = route->mSessions.find(callID);
+          if ((found == route->mSessions.end()) ||
+              (locationID != found->second->getLocationID())) {
+            OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::notifyReceivedRTPPacket", log("ignoring RTP/RTCP packet as not from call/location ID in focus or with attached media") + ZS_PARAM("focus call ID", route->mCallID) + ZS_PARAM("focus location ID", route->mLocationID))
             return;
           }
 
-          if ((callID != mFocusCallID) ||
-              (locationID != mFocusLocationID)) {
-            ZS_LOG_SUBSYSTEM_TRACE(mediaSubsystem(), log("ignoring RTP/RTCP packet as not from call/location ID in focus") + ZS_PARAM("focus call ID", mFocusCallID) + ZS_PARAM("focus location ID", mFocusLocationID))
+          if (SocketType_Audio != type) {
+            OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::notifyReceivedRTPPacket", log("ignoring video RTP/RTCP packet as only the focused call has video"))
             return;
           }
 
-          if ((SocketType_Audio == type) &&
-              (!mHasAudio)) {
-            ZS_LOG_SUBSYSTEM_TRACE(mediaSubsystem(), log("ignoring RTP/RTCP packet as audio was not started for this call"))
-            return;
-          }
+          const MediaSession &session = *(found->second);
+          if (!session.mVoiceSession) return;
 
-          if ((SocketType_Video == type) &&
-              (!mHasVideo)) {
-            ZS_LOG_SUBSYSTEM_TRACE(mediaSubsystem(), log("ignoring RTP/RTCP packet as video was not started for this call"))
-            return;
+          if (isRTP) {
+            session.mEngine->receivedVoiceSessionRTPPacket(*(session.mVoiceSession), buffer, bufferLengthInBytes);
+          } else {
+            session.mEngine->receivedVoiceSessionRTCPPacket(*(session.mVoiceSession), buffer, bufferLengthInBytes);
           }
+          return;
         }
 
-        UseMediaEnginePtr engine = UseMediaEngine::singleton();
-        if (!engine) return;
-
         if (SocketType_Audio == type) {
+          if (!route->mHasAudio) {
+            OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::notifyReceivedRTPPacket", log("ignoring RTP/RTCP packet as audio was not started for this call"))
+            return;
+          }
           if (isRTP) {
-            engine->receivedVoiceRTPPacket(buffer, bufferLengthInBytes);
+            route->mEngine->receivedVoiceRTPPacket(buffer, bufferLengthInBytes);
           } else {
-            engine->receivedVoiceRTCPPacket(buffer, bufferLengthInBytes);
+            route->mEngine->receivedVoiceRTCPPacket(buffer, bufferLengthInBytes);
           }
         } else {
+          if (!route->mHasVideo) {
+            OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::notifyReceivedRTPPacket", log("ignoring RTP/RTCP packet as video was not started for this call"))
+            return;
+          }
           if (isRTP) {
-            engine->receivedVideoRTPPacket(buffer, bufferLengthInBytes);
+            route->mEngine->receivedVideoRTPPacket(buffer, bufferLengthInBytes);
           } else {
-            engine->receivedVideoRTCPPacket(buffer, bufferLengthInBytes);
+            route->mEngine->receivedVideoRTCPPacket(buffer, bufferLengthInBytes);
           }
         }
       }
@@ -442,6 +663,49 @@ namespace openpeer
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CallTransport => ICallTransportForConversationThread
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void CallTransport::warmUp()
+      {
+        AutoRecursiveLock lock(*this);
+        if ((isShuttingDown()) ||
+            (isShutdown())) {
+          ZS_LOG_DEBUG(log("ignoring warm up hint during shutdown"))
+          return;
+        }
+
+        Duration warmTime = UseSettings::snapshot()->mCallTransportWarmUpTime;
+        if (Duration() == warmTime) {
+          OPENPEER_CORE_LOG_HOT_TRACE(log("warm up hints are disabled"))
+          return;
+        }
+
+        mWarmUntil = zsLib::now() + warmTime;
+
+        ZS_LOG_DEBUG(log("warming up call sockets") + ZS_PARAM("until", mWarmUntil))
+
+        fixSockets();
+
+        if (mTotalCalls > 0) return;
+
+        // idle sockets close once the warm up window passes without a call
+        if (mSocketCleanupTimer) {
+          mSocketCleanupTimer->cancel();
+          mSocketCleanupTimer.reset();
+        }
+        mSocketCleanupTimer = Timer::create(mThisWeak.lock(), warmTime, false);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CallTransport => ITimerDelegate
+      #pragma mark
 
       //-----------------------------------------------------------------------
       void CallTransport::onTimer(TimerPtr timer)
@@ -449,6 +713,16 @@ namespace openpeer
         ZS_LOG_DEBUG(log("on timer") + ZS_PARAM("timer id", timer->getID()))
 
         AutoRecursiveLock lock(*this);
+        if (timer == mWarmRefreshTimer) {
+          refreshWarmSockets();
+          return;
+        }
+
+        if (timer == mReclaimMediaRoutesTimer) {
+          reclaimMediaRoutes();
+          return;
+        }
+
         if (timer != mSocketCleanupTimer) {
           ZS_LOG_WARNING(Detail, log("notification from obsolete timer") + ZS_PARAM("timer id", timer->getID()))
           return;
@@ -457,6 +731,14 @@ namespace openpeer
         mSocketCleanupTimer->cancel();
         mSocketCleanupTimer.reset();
 
+        Time tick = zsLib::now();
+        if ((0 == mTotalCalls) &&
+            (tick < mWarmUntil)) {
+          ZS_LOG_DEBUG(log("sockets are still within warm up window") + ZS_PARAM("until", mWarmUntil))
+          mSocketCleanupTimer = Timer::create(mThisWeak.lock(), mWarmUntil - tick, false);
+          return;
+        }
+
         fixSockets();
       }
 
@@ -471,7 +753,9 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void CallTransport::onWake()
       {
-        ZS_LOG_DEBUG(log("on wake"))
+        mWake.notifyWoken();
+
+        ZS_LOG_DEBUG(log("on wake") + ZS_PARAM("coalesced", mWake.getTotalCoalesced()))
         step();
       }
 
@@ -513,29 +797,26 @@ namespace openpeer
 
         ICallForCallTransport::SocketTypes type = ICallForCallTransport::SocketType_Audio;
 
-        // scope - find the call
+        // scope - find the call from the published route (no transport lock)
         {
-          AutoRecursiveLock lock(*this);
+          CallTransport_MediaRouteReader reader(mMediaRouteLoaders);
 
-          if (0 != mBlockUntilStartStopCompleted) {
-            ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Debug, log("ignoring request to send RTP packet as media is blocked until the start/stop routine complete") + ZS_PARAM("blocked count", mBlockUntilStartStopCompleted))
+          const MediaRoute *route = mMediaRoute.load(boost::memory_order_seq_cst);
+          reader.enter(route ? &(route->mReaders) : NULL);
+          if ((!route) ||
+              (0 == route->mCallID)) {
+            OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::CallTransport::sendRTPPacket", log("unable to send RTP packet as media isn't started, there is no focus object or the start/stop routine is pending"))
             return 0;
           }
 
-          if ((0 == mFocusCallID) ||
-              (!mStarted)) {
-            ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("unable to send RTP packet media isn't start or there is no focus object") + ZS_PARAM("started", mStarted) + ZS_PARAM("focus ID", mFocusCallID))
-            return 0;
-          }
-
-          call = mFocus.lock();
-          locationID = mFocusLocationID;
+          call = route->mCall.lock();
+          locationID = route->mLocationID;
           if (!call) {
-            ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("unable to send RTP packet as focused call object is gone"))
+            OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::CallTransport::sendRTPPacket", log("unable to send RTP packet as focused call object is gone"))
             return 0;
           }
 
-          if (socketID == mAudioSocketID) {
+          if (socketID == route->mAudioSocketID) {
             type = ICallForCallTransport::SocketType_Audio;
           } else {
             type = ICallForCallTransport::SocketType_Video;
@@ -569,15 +850,20 @@ namespace openpeer
         ElementPtr resultEl = Element::create("core::CallTransport");
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "coalesced wakes", mWake.getTotalCoalesced());
         UseServicesHelper::debugAppend(resultEl, "state", ICallTransport::toString(mCurrentState));
         UseServicesHelper::debugAppend(resultEl, "turn servers", mTURNServers.size());
         UseServicesHelper::debugAppend(resultEl, "stun", mSTUNServers.size());
         UseServicesHelper::debugAppend(resultEl, "total calls", mTotalCalls);
         UseServicesHelper::debugAppend(resultEl, "socket cleanup timer", (bool)mSocketCleanupTimer);
+        UseServicesHelper::debugAppend(resultEl, "warm until", mWarmUntil);
+        UseServicesHelper::debugAppend(resultEl, "warm refresh timer", (bool)mWarmRefreshTimer);
+        UseServicesHelper::debugAppend(resultEl, "reclaim media routes timer", (bool)mReclaimMediaRoutesTimer);
         UseServicesHelper::debugAppend(resultEl, "started", mStarted);
         UseServicesHelper::debugAppend(resultEl, UseCall::toDebug(mFocus.lock()));
         UseServicesHelper::debugAppend(resultEl, "focus call id", mFocusCallID);
         UseServicesHelper::debugAppend(resultEl, "focus location id", mFocusLocationID);
+        UseServicesHelper::debugAppend(resultEl, "focus voice codec", mFocusVoiceCodec.hasData() ? mFocusVoiceCodec.toDebug() : ElementPtr());
         UseServicesHelper::debugAppend(resultEl, "has audio", mHasAudio);
         UseServicesHelper::debugAppend(resultEl, "has video", mHasAudio);
         UseServicesHelper::debugAppend(resultEl, "blocked until", mBlockUntilStartStopCompleted);
@@ -586,6 +872,20 @@ namespace openpeer
         UseServicesHelper::debugAppend(resultEl, "audio socket id", mAudioSocketID);
         UseServicesHelper::debugAppend(resultEl, "video socket id", mVideoSocketID);
         UseServicesHelper::debugAppend(resultEl, "obsolete sockets", mObsoleteSockets.size());
+        UseServicesHelper::debugAppend(resultEl, "socket waiters", mSocketWaiters.size());
+
+        if (mMediaSessions.size() > 0) {
+          ElementPtr sessionsEl = Element::create("media sessions");
+          for (MediaSessionMap::const_iterator iter = mMediaSessions.begin(); iter != mMediaSessions.end(); ++iter)
+          {
+            UseServicesHelper::debugAppend(sessionsEl, MediaSession::toDebug(iter->second));
+          }
+          UseServicesHelper::debugAppend(resultEl, sessionsEl);
+        }
+
+        UseServicesHelper::debugAppend(resultEl, "media route", (bool)mCurrentMediaRoute);
+        UseServicesHelper::debugAppend(resultEl, "retired media routes", mRetiredMediaRoutes.size());
+        UseServicesHelper::debugAppend(resultEl, "media route loaders", mMediaRouteLoaders.load());
 
         return resultEl;
       }
@@ -623,6 +923,8 @@ namespace openpeer
 
         bool hasAudio = false;
         bool hasVideo = false;
+        PUID callID = 0;
+        VoiceCodecInfo voiceCodec;
         TransportSocketPtr audioSocket;
         TransportSocketPtr videoSocket;
 
@@ -649,6 +951,8 @@ namespace openpeer
 
           hasAudio = mHasAudio = call->hasAudio();
           hasVideo = mHasVideo = call->hasVideo();
+          callID = mFocusCallID;
+          voiceCodec = mFocusVoiceCodec;
           mStarted = true;
 
           audioSocket = mAudioSocket;
@@ -663,21 +967,24 @@ namespace openpeer
         if (hasAudio) {
           ZS_LOG_DETAIL(log("registering audio media engine transports"))
 
-          engine->registerVoiceExternalTransport(*(audioSocket.get()));
+          engine->registerVoiceExternalTransport(audioSocket);
         }
         if (hasVideo) {
           ZS_LOG_DETAIL(log("registering video media engine transports"))
-          engine->registerVideoExternalTransport(*(videoSocket.get()));
+          engine->registerVideoExternalTransport(videoSocket);
         }
 
         {
           AutoRecursiveLock lock(*this);
           if (hasAudio) {
-            engine->startVoice();
+            engine->startVoice(callID, voiceCodec);
           }
           if (hasVideo) {
             engine->startVideoChannel();
           }
+
+          mStartedEngine = engine;
+          publishMediaRoute();
         }
       }
 
@@ -702,6 +1009,9 @@ namespace openpeer
           mStarted = false;
           mHasAudio = false;
           mHasVideo = false;
+          mStartedEngine.reset();
+
+          publishMediaRoute();
         }
 
         UseMediaEnginePtr engine = UseMediaEngine::singleton();
@@ -730,11 +1040,28 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void CallTransport::cancel()
       {
-        AutoRecursiveLock lock(*this);
+        MediaSessionMap sessions;
+
+        // scope: media sessions must be stopped outside the lock
+        {
+          AutoRecursiveLock lock(*this);
+          sessions = internalCancel();
+        }
+
+        for (MediaSessionMap::iterator iter = sessions.begin(); iter != sessions.end(); ++iter)
+        {
+          iter->second->stop();
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      CallTransport::MediaSessionMap CallTransport::internalCancel()
+      {
+        MediaSessionMap sessions;
 
         if (isShutdown()) {
           ZS_LOG_DEBUG(log("cancel called but already shutdown"))
-          return;
+          return sessions;
         }
 
         if (!mGracefulShutdownReference) mGracefulShutdownReference = mThisWeak.lock();
@@ -742,6 +1069,25 @@ namespace openpeer
         setState(CallTransportState_ShuttingDown);
 
         mTotalCalls = 0;
+        mWarmUntil = Time();
+
+        // waiting calls re-step and learn the sockets will never arrive
+        notifySocketWaiters();
+
+        if (mSocketCleanupTimer) {
+          mSocketCleanupTimer->cancel();
+          mSocketCleanupTimer.reset();
+        }
+        if (mWarmRefreshTimer) {
+          mWarmRefreshTimer->cancel();
+          mWarmRefreshTimer.reset();
+        }
+
+        // the caller stops the sessions once the lock is released
+        sessions.swap(mMediaSessions);
+
+        mStartedEngine.reset();
+        publishMediaRoute();
 
         if (mAudioSocket) {
           mObsoleteSockets.push_back(mAudioSocket);
@@ -759,10 +1105,15 @@ namespace openpeer
         if (mGracefulShutdownReference) {
           if (!cleanObsoleteSockets()) {
             ZS_LOG_DEBUG(log("waiting for transport sockets to shutdown"))
-            return;
+            return sessions;
           }
         }
 
+        if (mReclaimMediaRoutesTimer) {
+          mReclaimMediaRoutesTimer->cancel();
+          mReclaimMediaRoutesTimer.reset();
+        }
+
         setState(CallTransportState_Shutdown);
 
         mGracefulShutdownReference.reset();
@@ -770,23 +1121,35 @@ namespace openpeer
         mDelegate.reset();
 
         mObsoleteSockets.clear();
+
+        return sessions;
       }
 
       //-----------------------------------------------------------------------
       void CallTransport::step()
       {
-        AutoRecursiveLock lock(*this);
-        ZS_LOG_DEBUG(log("step called"))
+        // scope: cancel stops media sessions thus must be called outside the lock
+        {
+          AutoRecursiveLock lock(*this);
+          ZS_LOG_DEBUG(log("step called"))
 
-        cleanObsoleteSockets();
+          cleanObsoleteSockets();
+          reclaimMediaRoutes();
 
-        if ((isShuttingDown()) ||
-            (isShutdown())) {
-          cancel();
-          return;
+          if ((!isShuttingDown()) &&
+              (!isShutdown())) {
+            setState(CallTransportState_Ready);
+
+            if ((needsSockets()) &&
+                ((!mAudioSocket) || (!mVideoSocket))) {
+              ZS_LOG_DEBUG(log("call sockets are wanted but not gathered"))
+              fixSockets();
+            }
+            return;
+          }
         }
 
-        setState(CallTransportState_Ready);
+        cancel();
       }
 
       //-----------------------------------------------------------------------
@@ -819,26 +1182,48 @@ namespace openpeer
         }
       }
 
+      //-----------------------------------------------------------------------
+      bool CallTransport::needsSockets() const
+      {
+        if (mTotalCalls > 0) return true;
+        if (UseSettings::snapshot()->mCallTransportKeepSocketsWarm) return true;
+        return zsLib::now() < mWarmUntil;
+      }
+
       //-----------------------------------------------------------------------
       void CallTransport::fixSockets()
       {
-        if (mTotalCalls > 0) {
+        if (needsSockets()) {
 
-          if (mSocketCleanupTimer) {
+          // a warm up window closes its sockets through the cleanup timer
+          if ((mSocketCleanupTimer) &&
+              ((mTotalCalls > 0) ||
+               (UseSettings::snapshot()->mCallTransportKeepSocketsWarm))) {
             mSocketCleanupTimer->cancel();
             mSocketCleanupTimer.reset();
           }
 
+          if (!mWarmRefreshTimer) {
+            mWarmRefreshTimer = Timer::create(mThisWeak.lock(), Seconds(OPENPEER_CALLTRANSPORT_WARM_SOCKETS_REFRESH_IN_SECONDS));
+          }
+
           if (!mAudioSocket) {
             ZS_LOG_DEBUG(log("creating audio sockets"))
             mAudioSocket = TransportSocket::create(getAssociatedMessageQueue(), mThisWeak.lock(), mTURNServers, mSTUNServers);
             mAudioSocketID = mAudioSocket->getID();
           }
           if (!mVideoSocket) {
-            ZS_LOG_DEBUG(log("creating video sockets"))
-            mVideoSocket = TransportSocket::create(getAssociatedMessageQueue(), mThisWeak.lock(), mTURNServers, mSTUNServers);
+            if (UseSettings::snapshot()->mCallTransportBundleMedia) {
+              ZS_LOG_DEBUG(log("bundling video onto audio sockets"))
+              mVideoSocket = TransportSocket::createBundled(getAssociatedMessageQueue(), mThisWeak.lock(), mAudioSocket);
+            } else {
+              ZS_LOG_DEBUG(log("creating video sockets"))
+              mVideoSocket = TransportSocket::create(getAssociatedMessageQueue(), mThisWeak.lock(), mTURNServers, mSTUNServers);
+            }
             mVideoSocketID = mVideoSocket->getID();
           }
+          publishMediaRoute();
+          notifySocketWaiters();
           return;
         }
 
@@ -852,6 +1237,11 @@ namespace openpeer
           return;
         }
 
+        if (mWarmRefreshTimer) {
+          mWarmRefreshTimer->cancel();
+          mWarmRefreshTimer.reset();
+        }
+
         if (mAudioSocket) {
           ZS_LOG_DEBUG(log("adding audio socket to obsolete socket list (for cleanup)"))
           mObsoleteSockets.push_back(mAudioSocket);
@@ -866,9 +1256,52 @@ namespace openpeer
           mVideoSocket.reset();
         }
 
+        publishMediaRoute();
+
         cleanObsoleteSockets();
       }
 
+      //-----------------------------------------------------------------------
+      void CallTransport::notifySocketWaiters()
+      {
+        if (mSocketWaiters.size() < 1) return;
+
+        ZS_LOG_DEBUG(log("notifying calls that sockets are available") + ZS_PARAM("waiting", mSocketWaiters.size()))
+
+        CallWeakMap waiters;
+        waiters.swap(mSocketWaiters);
+
+        for (CallWeakMap::iterator iter = waiters.begin(); iter != waiters.end(); ++iter)
+        {
+          UseCallPtr call = iter->second.lock();
+          if (!call) continue;
+          call->notifyTransportSocketsAvailable();
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void CallTransport::refreshWarmSockets()
+      {
+        if (mTotalCalls > 0) {
+          OPENPEER_CORE_LOG_HOT_TRACE(log("calls keep their own sockets awake"))
+          return;
+        }
+
+        // waking an idle socket keeps its TURN allocations refreshed (or
+        // re-gathers them) so the next call finds ready candidates
+        if (mAudioSocket) {
+          IICESocketPtr socket = mAudioSocket->getRTPSocket();
+          if (socket) socket->wakeup();
+        }
+        if ((mVideoSocket) &&
+            (!mVideoSocket->isBundled())) {
+          IICESocketPtr socket = mVideoSocket->getRTPSocket();
+          if (socket) socket->wakeup();
+        }
+
+        ZS_LOG_DEBUG(log("refreshed warm call sockets"))
+      }
+
       //-----------------------------------------------------------------------
       bool CallTransport::cleanObsoleteSockets()
       {
@@ -893,6 +1326,102 @@ namespace openpeer
         return mObsoleteSockets.size() < 1;
       }
 
+      //-----------------------------------------------------------------------
+      void CallTransport::publishMediaRoute()
+      {
+        AutoRecursiveLock lock(*this);
+
+        MediaRoutePtr route;
+
+        bool hasFocus = ((mStartedEngine) &&
+                         (mStarted) &&
+                         (0 == mBlockUntilStartStopCompleted) &&
+                         (0 != mFocusCallID));
+
+        if ((hasFocus) ||
+            (mMediaSessions.size() > 0)) {
+          route = MediaRoutePtr(new MediaRoute);
+          route->mSessions = mMediaSessions;
+        }
+
+        if (hasFocus) {
+          route->mCallID = mFocusCallID;
+          route->mLocationID = mFocusLocationID;
+          route->mCall = mFocus;
+          route->mHasAudio = mHasAudio;
+          route->mHasVideo = mHasVideo;
+          route->mAudioSocketID = mAudioSocketID;
+          route->mVideoSocketID = mVideoSocketID;
+          route->mEngine = mStartedEngine;
+        }
+
+        if ((!route) &&
+            (!mCurrentMediaRoute)) return;
+
+        ZS_LOG_DEBUG(log("publishing media route") + ZS_PARAM("route", (bool)route) + ZS_PARAM("focus", hasFocus) + ZS_PARAM("sessions", mMediaSessions.size()) + ZS_PARAM("focus call ID", mFocusCallID) + ZS_PARAM("focus location ID", mFocusLocationID) + ZS_PARAM("block count", mBlockUntilStartStopCompleted))
+
+        if (mCurrentMediaRoute) {
+          mRetiredMediaRoutes.push_back(mCurrentMediaRoute);
+        }
+        mCurrentMediaRoute = route;
+        mMediaRoute.store(route.get(), boost::memory_order_seq_cst);
+
+        reclaimMediaRoutes();
+      }
+
+      //-----------------------------------------------------------------------
+      void CallTransport::reclaimMediaRoutes()
+      {
+        if (mRetiredMediaRoutes.size() > 0) {
+          // any reader that loads after this check gets the newly published
+          // route; once no reader is between loading a route and counting
+          // itself in it, a retired route with no readers is unused
+          if (0 == mMediaRouteLoaders.load(boost::memory_order_seq_cst)) {
+            for (MediaRouteList::iterator iter = mRetiredMediaRoutes.begin(); iter != mRetiredMediaRoutes.end(); )
+            {
+              MediaRouteList::iterator current = iter;
+              ++iter;
+
+              if (0 != (*current)->mReaders.load(boost::memory_order_seq_cst)) continue;
+              mRetiredMediaRoutes.erase(current);
+            }
+          }
+        }
+
+        if (mRetiredMediaRoutes.size() > 0) {
+          OPENPEER_CORE_LOG_HOT_TRACE(log("media path is active, retired media routes will be freed later") + ZS_PARAM("retired", mRetiredMediaRoutes.size()))
+
+          // a busy media path may never coincide with a publish or step so
+          // keep retrying until the readers drain
+          if ((!mReclaimMediaRoutesTimer) &&
+              (!isShutdown())) {
+            CallTransportPtr pThis = mThisWeak.lock();
+            if (pThis) {
+              mReclaimMediaRoutesTimer = Timer::create(pThis, Milliseconds(OPENPEER_CALLTRANSPORT_RECLAIM_MEDIA_ROUTES_RETRY_IN_MILLISECONDS));
+            }
+          }
+          return;
+        }
+
+        if (mReclaimMediaRoutesTimer) {
+          mReclaimMediaRoutesTimer->cancel();
+          mReclaimMediaRoutesTimer.reset();
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      CallTransport::MediaSessionPtr CallTransport::removeMediaSession(PUID callID)
+      {
+        MediaSessionMap::iterator found = mMediaSessions.find(callID);
+        if (found == mMediaSessions.end()) return MediaSessionPtr();
+
+        MediaSessionPtr session = found->second;
+        mMediaSessions.erase(found);
+
+        publishMediaRoute();
+        return session;
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -921,10 +1450,23 @@ namespace openpeer
         mRTPSocket = IICESocket::create(getAssociatedMessageQueue(), mThisWeak.lock(), turnServers, stunServers, 0, true);
       }
 
+      //-----------------------------------------------------------------------
+      void CallTransport::TransportSocket::init(TransportSocketPtr sharedSocket)
+      {
+        // the shared transport socket remains the ICE socket delegate and
+        // owner, this transport socket only gives the engine a distinct ID
+        mSharedSocket = sharedSocket;
+        mRTPSocket = sharedSocket->getRTPSocket();
+      }
+
       //-----------------------------------------------------------------------
       CallTransport::TransportSocket::~TransportSocket()
       {
         mThisWeak.reset();
+        if (mSharedSocket) {
+          mRTPSocket.reset();
+          mSharedSocket.reset();
+        }
         if (mRTPSocket) {
           mRTPSocket->shutdown();
           mRTPSocket.reset();
@@ -960,9 +1502,29 @@ namespace openpeer
         return pThis;
       }
 
+      //-----------------------------------------------------------------------
+      CallTransport::TransportSocketPtr CallTransport::TransportSocket::createBundled(
+                                                                                      IMessageQueuePtr queue,
+                                                                                      CallTransportPtr outer,
+                                                                                      TransportSocketPtr sharedSocket
+                                                                                      )
+      {
+        TransportSocketPtr pThis(new TransportSocket(queue, outer));
+        pThis->mThisWeak = pThis;
+        pThis->init(sharedSocket);
+        return pThis;
+      }
+
       //-----------------------------------------------------------------------
       void CallTransport::TransportSocket::shutdown()
       {
+        if (mSharedSocket) {
+          // the owning transport socket shuts down the shared RTP socket
+          mRTPSocket.reset();
+          mSharedSocket.reset();
+          return;
+        }
+
         if (mRTPSocket) {
           mRTPSocket->shutdown();
           if (IICESocket::ICESocketState_Shutdown == mRTPSocket->getState()) {
@@ -1010,7 +1572,7 @@ namespace openpeer
         }
 
         ZS_LOG_DEBUG(log("on ice socket state changed"))
-        IWakeDelegateProxy::create(outer)->onWake();
+        outer->mWake.wake(outer);
       }
 
       //-----------------------------------------------------------------------
@@ -1023,7 +1585,7 @@ namespace openpeer
         }
 
         ZS_LOG_DEBUG(log("on ice socket candidates changed"))
-        IWakeDelegateProxy::create(outer)->onWake();
+        outer->mWake.wake(outer);
       }
       
       //-----------------------------------------------------------------------
@@ -1037,14 +1599,14 @@ namespace openpeer
       //-----------------------------------------------------------------------
       int CallTransport::TransportSocket::SendPacket(int channel, const void *data, int len)
       {
-        if (len < (sizeof(BYTE)*2)) return 0;
+        if (len < 2) return 0;
 
         BYTE payloadType = ((const BYTE *)data)[1];
-        ZS_LOG_SUBSYSTEM_TRACE(mediaSubsystem(), log("request to send RTP packet") + ZS_PARAM("payload type", payloadType) + ZS_PARAM("length", len))
+        OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::TransportSocket::SendPacket", log("request to send RTP packet") + ZS_PARAM("payload type", payloadType) + ZS_PARAM("length", len))
 
         CallTransportPtr outer = mOuter.lock();
         if (!outer) {
-          ZS_LOG_SUBSYSTEM_TRACE(mediaSubsystem(), log("cannot send RTP packet because call transport object is gone"))
+          OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::TransportSocket::SendPacket", log("cannot send RTP packet because call transport object is gone"))
           return 0;
         }
 
@@ -1054,14 +1616,14 @@ namespace openpeer
       //-----------------------------------------------------------------------
       int CallTransport::TransportSocket::SendRTCPPacket(int channel, const void *data, int len)
       {
-        if (len < (sizeof(BYTE)*2)) return 0;
+        if (len < 2) return 0;
 
         BYTE payloadType = ((const BYTE *)data)[1];
-        ZS_LOG_SUBSYSTEM_TRACE(mediaSubsystem(), log("request to send RTCP packet") + ZS_PARAM("payload type", payloadType) + ZS_PARAM("length", len))
+        OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::TransportSocket::SendRTCPPacket", log("request to send RTCP packet") + ZS_PARAM("payload type", payloadType) + ZS_PARAM("length", len))
 
         CallTransportPtr outer = mOuter.lock();
         if (!outer) {
-          ZS_LOG_SUBSYSTEM_WARNING(mediaSubsystem(), Trace, log("cannot send RTCP packet because call transport object is gone"))
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(mediaSubsystem(), Trace, "core::CallTransport::TransportSocket::SendRTCPPacket", log("cannot send RTCP packet because call transport object is gone"))
           return 0;
         }
 
@@ -1091,6 +1653,147 @@ namespace openpeer
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
         UseServicesHelper::debugAppend(resultEl, "rtp socket id", mRTPSocket ? mRTPSocket->getID() : 0);
+        UseServicesHelper::debugAppend(resultEl, "shared socket id", mSharedSocket ? mSharedSocket->getID() : 0);
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CallTransport::MediaSession
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      CallTransport::MediaSession::MediaSession(
+                                                UseCallPtr call,
+                                                PUID locationID,
+                                                UseMediaEnginePtr engine
+                                                ) :
+        mID(zsLib::createPUID()),
+        mCallID(call->getID()),
+        mCall(call),
+        mLocationID(locationID),
+        mEngine(engine),
+        mStopped(false)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      CallTransport::MediaSession::~MediaSession()
+      {
+        stop();
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr CallTransport::MediaSession::toDebug(MediaSessionPtr session)
+      {
+        if (!session) return ElementPtr();
+        return session->toDebug();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CallTransport::MediaSession => friend CallTransport
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      CallTransport::MediaSessionPtr CallTransport::MediaSession::create(
+                                                                         UseCallPtr call,
+                                                                         PUID locationID,
+                                                                         const VoiceCodecInfo &voiceCodec,
+                                                                         UseMediaEnginePtr engine
+                                                                         )
+      {
+        MediaSessionPtr pThis(new MediaSession(call, locationID, engine));
+        pThis->mVoiceSession = engine->startVoiceSession(pThis, pThis->mCallID, voiceCodec);
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      void CallTransport::MediaSession::stop()
+      {
+        // stop may race between detach, focus and shutdown paths
+        if (mStopped.exchange(true, boost::memory_order_acq_rel)) return;
+
+        if (!mVoiceSession) return;
+
+        ZS_LOG_DEBUG(log("stopping voice session"))
+
+        // the voice session keeps a reference to this object until the last
+        // sender left it, which also breaks the session reference cycle
+        // (mVoiceSession is left set as published routes read it)
+        mEngine->stopVoiceSession(mVoiceSession);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CallTransport::MediaSession => webrtc::Transport
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      int CallTransport::MediaSession::SendPacket(int channel, const void *data, int len)
+      {
+        if (len < 2) return 0;
+
+        UseCallPtr call = mCall.lock();
+        if (!call) {
+          OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::MediaSession::SendPacket", log("cannot send RTP packet because call object is gone"))
+          return 0;
+        }
+
+        return (call->sendRTPPacket(mLocationID, ICallForCallTransport::SocketType_Audio, (const BYTE *)data, (size_t)len) ? len : 0);
+      }
+
+      //-----------------------------------------------------------------------
+      int CallTransport::MediaSession::SendRTCPPacket(int channel, const void *data, int len)
+      {
+        if (len < 2) return 0;
+
+        UseCallPtr call = mCall.lock();
+        if (!call) {
+          OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(mediaSubsystem(), "core::CallTransport::MediaSession::SendRTCPPacket", log("cannot send RTCP packet because call object is gone"))
+          return 0;
+        }
+
+        return (call->sendRTPPacket(mLocationID, ICallForCallTransport::SocketType_Audio, (const BYTE *)data, (size_t)len) ? len : 0);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CallTransport::MediaSession => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Log::Params CallTransport::MediaSession::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("core::CallTransport::MediaSession");
+        UseServicesHelper::debugAppend(objectEl, "id", mID);
+        UseServicesHelper::debugAppend(objectEl, "call id", mCallID);
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr CallTransport::MediaSession::toDebug() const
+      {
+        ElementPtr resultEl = Element::create("core::CallTransport::MediaSession");
+
+        UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "call id", mCallID);
+        UseServicesHelper::debugAppend(resultEl, "location id", mLocationID);
+        UseServicesHelper::debugAppend(resultEl, "stopped", mStopped.load());
+        UseServicesHelper::debugAppend(resultEl, "voice session", mVoiceSession ? mVoiceSession->toDebug() : ElementPtr());
 
         return resultEl;
       }
@@ -36,8 +36,10 @@
 #include <openpeer/core/internal/core_Account.h>
 #include <openpeer/core/internal/core_Contact.h>
 #include <openpeer/core/internal/core_Call.h>
+#include <openpeer/core/internal/core_CallTransport.h>
 #include <openpeer/core/internal/core_Helper.h>
 #include <openpeer/core/internal/core_Stack.h>
+#include <openpeer/core/internal/core_Settings.h>
 
 #include <openpeer/core/ComposingStatus.h>
 
@@ -73,7 +75,7 @@ namespace openpeer
 
       ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
       ZS_DECLARE_TYPEDEF_PTR(IHelperForInternal, UseHelper)
-      ZS_DECLARE_TYPEDEF_PTR(services::ISettings, UseSettings)
+      ZS_DECLARE_TYPEDEF_PTR(ISettingsForInternal, UseSettings)
 
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -203,7 +205,7 @@ namespace openpeer
         mServerName(serverName),
         mCurrentState(ConversationThreadState_Pending),
         mMustNotifyAboutNewThread(false),
-        mOpenThreadInactivityTimeout(Seconds(UseSettings::getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_INACTIVE_CLOSE_TIME_IN_SECONDS))),
+        mOpenThreadInactivityTimeout(UseSettings::snapshot()->mConversationThreadHostInactiveCloseTime),
         mHandleContactsChangedCRC(0)
       {
         ZS_LOG_BASIC(log("created"))
@@ -216,7 +218,9 @@ namespace openpeer
 
         ZS_LOG_DEBUG(log("initialized"))
         mTimer = Timer::create(mThisWeak.lock(), mOpenThreadInactivityTimeout);
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
+
+        UseSettings::subscribeChanges(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -290,7 +294,7 @@ namespace openpeer
 
         UseAccountPtr account(inAccount);
 
-        ConversationThreadPtr pThis(new ConversationThread(UseStack::queueCore(), inAccount, NULL, NULL));
+        ConversationThreadPtr pThis(new ConversationThread(inAccount->getAssociatedMessageQueue(), inAccount, NULL, NULL));
         pThis->mThisWeak = pThis;
         pThis->mSelfIdentityContacts = identityContacts;
 
@@ -599,6 +603,19 @@ namespace openpeer
 
         ZS_LOG_DEBUG(log("changing contact status for self") + contactStatus.mStatus.toDebug())
 
+        ComposingStatusPtr composingStatus = ComposingStatus::extract(contactStatus.mStatus.mStatusEl);
+        if (composingStatus) {
+          if ((ComposingStatus::ComposingState_Active == composingStatus->mComposingStatus) ||
+              (ComposingStatus::ComposingState_Composing == composingStatus->mComposingStatus)) {
+            // user is active in this thread thus a call may follow shortly
+            UseCallTransportPtr transport = account->getCallTransport();
+            if (transport) {
+              ZS_LOG_TRACE(log("warming up call transport as self is active in thread"))
+              transport->warmUp();
+            }
+          }
+        }
+
         if (!mLastOpenThread) {
           ZS_LOG_WARNING(Detail, log("no conversation thread was ever openned"))
           return;
@@ -635,7 +652,7 @@ namespace openpeer
           return;
         }
 
-        MessagePtr message = Message::create(messageID, replacesMessageID, UseContactPtr(account->getSelfContact())->getPeerURI(), messageType, body, zsLib::now(), signMessage ? peerFiles : IPeerFilesPtr());
+        MessagePtr message = Message::create(getAssociatedMessageQueue(), messageID, replacesMessageID, UseContactPtr(account->getSelfContact())->getPeerURI(), messageType, body, zsLib::now(), signMessage ? peerFiles : IPeerFilesPtr());
         if (!message) {
           ZS_LOG_ERROR(Detail, log("failed to create message object") + ZS_PARAM("message ID", messageID))
           return;
@@ -738,7 +755,7 @@ namespace openpeer
                                                        const SplitMap &split
                                                        )
       {
-        ConversationThreadPtr pThis(new ConversationThread(UseStack::queueCore(), inAccount, services::IHelper::get(split, OPENPEER_CONVERSATION_THREAD_BASE_THREAD_ID_INDEX), NULL));
+        ConversationThreadPtr pThis(new ConversationThread(inAccount->getAssociatedMessageQueue(), inAccount, services::IHelper::get(split, OPENPEER_CONVERSATION_THREAD_BASE_THREAD_ID_INDEX), NULL));
         pThis->mThisWeak = pThis;
         pThis->mMustNotifyAboutNewThread = true;
 
@@ -1388,7 +1405,7 @@ namespace openpeer
 
         // force a step on the conversation thread to cleanup anything state wise...
         ZS_LOG_DEBUG(log("forcing step"))
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -1418,7 +1435,7 @@ namespace openpeer
         mPendingCalls[call->getCallID()] = call;
 
         ZS_LOG_DEBUG(log("forcing step"))
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
         return true;
       }
 
@@ -1492,6 +1509,40 @@ namespace openpeer
         thread->gatherDialogReplies(callID, outDialogs);
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ConversationThread => ISettingsChangedDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void ConversationThread::onSettingsChanged(SettingsSnapshotPtr snapshot)
+      {
+        AutoRecursiveLock lock(*this);
+
+        if ((isShuttingDown()) ||
+            (isShutdown())) {
+          ZS_LOG_DEBUG(log("settings changed while shutting down (thus ignoring)"))
+          return;
+        }
+
+        if (snapshot->mConversationThreadHostInactiveCloseTime == mOpenThreadInactivityTimeout) return;
+
+        ZS_LOG_DETAIL(log("inactivity timeout changed") + ZS_PARAM("old (s)", mOpenThreadInactivityTimeout) + ZS_PARAM("new (s)", snapshot->mConversationThreadHostInactiveCloseTime))
+
+        mOpenThreadInactivityTimeout = snapshot->mConversationThreadHostInactiveCloseTime;
+
+        if (mTimer) {
+          mTimer->cancel();
+          mTimer.reset();
+        }
+        mTimer = Timer::create(mThisWeak.lock(), mOpenThreadInactivityTimeout);
+
+        step();
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -1523,6 +1574,7 @@ namespace openpeer
         ElementPtr resultEl = Element::create("core::ConversationThread");
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "coalesced wakes", mWake.getTotalCoalesced());
         UseServicesHelper::debugAppend(resultEl, "graceful shutdown reference", (bool)mGracefulShutdownReference);
 
         UseServicesHelper::debugAppend(resultEl, "delegate", (bool)mDelegate);
@@ -1613,6 +1665,8 @@ namespace openpeer
           mTimer.reset();
         }
 
+        UseSettings::unsubscribeChanges(mThisWeak.lock());
+
         mThreads.clear();
 
         mReceivedOrPushedMessages.clear();
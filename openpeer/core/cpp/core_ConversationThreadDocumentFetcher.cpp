@@ -101,11 +101,12 @@ namespace openpeer
 
       //-----------------------------------------------------------------------
       IConversationThreadDocumentFetcherPtr IConversationThreadDocumentFetcher::create(
+                                                                                       IMessageQueuePtr queue,
                                                                                        IConversationThreadDocumentFetcherDelegatePtr delegate,
                                                                                        IPublicationRepositoryPtr repository
                                                                                        )
       {
-        return IConversationThreadDocumentFetcherFactory::singleton().create(delegate, repository);
+        return IConversationThreadDocumentFetcherFactory::singleton().create(queue, delegate, repository);
       }
 
       //-----------------------------------------------------------------------
@@ -169,11 +170,12 @@ namespace openpeer
 
       //-----------------------------------------------------------------------
       ConversationThreadDocumentFetcherPtr ConversationThreadDocumentFetcher::create(
+                                                                                     IMessageQueuePtr queue,
                                                                                      IConversationThreadDocumentFetcherDelegatePtr delegate,
                                                                                      IPublicationRepositoryPtr repository
                                                                                      )
       {
-        ConversationThreadDocumentFetcherPtr pThis(new ConversationThreadDocumentFetcher(UseStack::queueCore(), delegate, repository));
+        ConversationThreadDocumentFetcherPtr pThis(new ConversationThreadDocumentFetcher(queue, delegate, repository));
         pThis->mThisWeak = pThis;
         pThis->init();
         return pThis;
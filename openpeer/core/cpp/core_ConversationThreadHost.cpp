@@ -37,6 +37,7 @@
 #include <openpeer/core/internal/core_Call.h>
 #include <openpeer/core/internal/core_Helper.h>
 #include <openpeer/core/internal/core_Stack.h>
+#include <openpeer/core/internal/core_Settings.h>
 
 #include <openpeer/core/ComposingStatus.h>
 
@@ -71,7 +72,7 @@ namespace openpeer
 
       ZS_DECLARE_TYPEDEF_PTR(IHelperForInternal, UseHelper)
       ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
-      ZS_DECLARE_TYPEDEF_PTR(services::ISettings, UseSettings)
+      ZS_DECLARE_TYPEDEF_PTR(ISettingsForInternal, UseSettings)
 
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -180,7 +181,7 @@ namespace openpeer
         mHostThread->updateBegin();
         mHostThread->updateEnd(getPublicationRepostiory());
 
-        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), UseSettings::getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_BACKGROUNDING_PHASE));
+        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), UseSettings::snapshot()->mConversationThreadHostBackgroundingPhase);
 
         step();
       }
@@ -231,7 +232,7 @@ namespace openpeer
           return ConversationThreadHostPtr();
         }
 
-        ConversationThreadHostPtr pThis(new ConversationThreadHost(UseStack::queueCore(), account, inBaseThread, NULL, serverName));
+        ConversationThreadHostPtr pThis(new ConversationThreadHost(account->getAssociatedMessageQueue(), account, inBaseThread, NULL, serverName));
         pThis->mThisWeak = pThis;
         pThis->init(state);
         return pThis;
@@ -484,7 +485,7 @@ namespace openpeer
         mHostThread->setContacts(contactMap);
         mHostThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -514,7 +515,7 @@ namespace openpeer
         mHostThread->setContacts(contactMap);
         mHostThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -600,7 +601,7 @@ namespace openpeer
         mHostThread->updateDialogs(additions);
         mHostThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
         return true;
       }
 
@@ -630,7 +631,7 @@ namespace openpeer
         mHostThread->updateDialogs(updates);
         mHostThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -663,7 +664,7 @@ namespace openpeer
         mHostThread->removeDialogs(removals);
         mHostThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -690,7 +691,7 @@ namespace openpeer
         mLastActivity = zsLib::now();
 
         get(mMarkAllRead) = true;
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -733,7 +734,7 @@ namespace openpeer
 
         // kick the conversation thread step routine asynchronously to ensure
         // the thread has a subscription state to its peer
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -946,7 +947,7 @@ namespace openpeer
       {
         ZS_LOG_DEBUG(log("notified peer file loaded") + IPeer::toDebug(peer))
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -1085,6 +1086,7 @@ namespace openpeer
         ElementPtr resultEl = Element::create("core::ConversationThreadHost");
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "coalesced wakes", mWake.getTotalCoalesced());
         UseServicesHelper::debugAppend(resultEl, "graceful shutdown reference", (bool)mGracefulShutdownReference);
 
         UseServicesHelper::debugAppend(resultEl, "base thread id", base ? base->getThreadID() : String());
@@ -35,6 +35,7 @@
 #include <openpeer/core/internal/core_Account.h>
 #include <openpeer/core/internal/core_Contact.h>
 #include <openpeer/core/internal/core_Helper.h>
+#include <openpeer/core/internal/core_Settings.h>
 
 #include <openpeer/core/ComposingStatus.h>
 
@@ -56,7 +57,7 @@ namespace openpeer
       ZS_DECLARE_TYPEDEF_PTR(ConversationThreadHost::UseContact, UseContact)
       ZS_DECLARE_TYPEDEF_PTR(ConversationThreadHost::UseConversationThread, UseConversationThread)
 
-      ZS_DECLARE_TYPEDEF_PTR(services::ISettings, UseSettings)
+      ZS_DECLARE_TYPEDEF_PTR(ISettingsForInternal, UseSettings)
 
       using namespace core::internal::thread;
 
@@ -107,9 +108,9 @@ namespace openpeer
       {
         AutoRecursiveLock lock(*this);
 
-        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), UseSettings::getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_BACKGROUNDING_PHASE));
+        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), UseSettings::snapshot()->mConversationThreadHostBackgroundingPhase);
 
-        ULONG autoFindSeconds = services::ISettings::getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_PEER_CONTACT);
+        ULONG autoFindSeconds = UseSettings::snapshot()->mConversationThreadHostPeerContactAutoFindInSeconds;
 
         if (0 != autoFindSeconds) {
           Duration timeout = Seconds(autoFindSeconds);
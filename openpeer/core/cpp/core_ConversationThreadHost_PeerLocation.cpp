@@ -94,7 +94,7 @@ namespace openpeer
 
         IPublicationRepositoryPtr repo = outer->getRepository();
         if (repo) {
-          mFetcher = IConversationThreadDocumentFetcher::create(mThisWeak.lock(), repo);
+          mFetcher = IConversationThreadDocumentFetcher::create(getAssociatedMessageQueue(), mThisWeak.lock(), repo);
         }
       }
 
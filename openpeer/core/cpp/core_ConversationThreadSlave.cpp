@@ -37,6 +37,7 @@
 #include <openpeer/core/internal/core_Call.h>
 #include <openpeer/core/internal/core_Helper.h>
 #include <openpeer/core/internal/core_Stack.h>
+#include <openpeer/core/internal/core_Settings.h>
 
 #include <openpeer/stack/IPeerFilePublic.h>
 #include <openpeer/stack/IPublication.h>
@@ -66,7 +67,7 @@ namespace openpeer
 
       ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
 
-      ZS_DECLARE_TYPEDEF_PTR(services::ISettings, UseSettings)
+      ZS_DECLARE_TYPEDEF_PTR(ISettingsForInternal, UseSettings)
 
       using namespace core::internal::thread;
 
@@ -143,9 +144,9 @@ namespace openpeer
       void ConversationThreadSlave::init()
       {
         AutoRecursiveLock lock(*this);
-        mFetcher = IConversationThreadDocumentFetcher::create(mThisWeak.lock(), mAccount.lock()->getRepository());
+        mFetcher = IConversationThreadDocumentFetcher::create(getAssociatedMessageQueue(), mThisWeak.lock(), mAccount.lock()->getRepository());
 
-        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), UseSettings::getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_BACKGROUNDING_PHASE));
+        mBackgroundingSubscription = IBackgrounding::subscribe(mThisWeak.lock(), UseSettings::snapshot()->mConversationThreadHostBackgroundingPhase);
       }
 
       //-----------------------------------------------------------------------
@@ -274,7 +275,7 @@ namespace openpeer
 
         // kick the conversation thread step routine asynchronously to ensure
         // the thread has a subscription state to its peer
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
         return true;
       }
 
@@ -380,7 +381,7 @@ namespace openpeer
         mSlaveThread->setContactsToAdd(contactMap);
         mSlaveThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -400,7 +401,7 @@ namespace openpeer
         mSlaveThread->setContactsToRemove(contactIDList);
         mSlaveThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -463,7 +464,7 @@ namespace openpeer
         mSlaveThread->updateDialogs(additions);
         mSlaveThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
         return true;
       }
 
@@ -494,7 +495,7 @@ namespace openpeer
         mSlaveThread->updateDialogs(updates);
         mSlaveThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -527,7 +528,7 @@ namespace openpeer
         mSlaveThread->removeDialogs(removeCallIDs);
         mSlaveThread->updateEnd(getPublicationRepostiory());
 
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -595,7 +596,7 @@ namespace openpeer
 
         // kick the conversation thread step routine asynchronously to ensure
         // the thread has a subscription state to its peer
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -626,7 +627,7 @@ namespace openpeer
 
         // kick the conversation thread step routine asynchronously to ensure
         // the thread has a subscription state to its peer
-        IWakeDelegateProxy::create(mThisWeak.lock())->onWake();
+        mWake.wake(mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -654,7 +655,7 @@ namespace openpeer
         String hostThreadID = UseServicesHelper::get(split, OPENPEER_CONVERSATION_THREAD_HOST_THREAD_ID_INDEX);
         ZS_THROW_INVALID_ARGUMENT_IF(hostThreadID.size() < 1)
 
-        ConversationThreadSlavePtr pThis(new ConversationThreadSlave(UseStack::queueCore(), account, peerLocation, inBaseThread, hostThreadID, serverName));
+        ConversationThreadSlavePtr pThis(new ConversationThreadSlave(account->getAssociatedMessageQueue(), account, peerLocation, inBaseThread, hostThreadID, serverName));
         pThis->mThisWeak = pThis;
 
         AutoRecursiveLock lock(*pThis);
@@ -1096,7 +1097,9 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void ConversationThreadSlave::onWake()
       {
-        ZS_LOG_DEBUG(log("on wake"))
+        mWake.notifyWoken();
+
+        ZS_LOG_DEBUG(log("on wake") + ZS_PARAM("coalesced", mWake.getTotalCoalesced()))
         step();
       }
 
@@ -1287,6 +1290,7 @@ namespace openpeer
         ElementPtr resultEl = Element::create("core::ConversationThreadSlave");
 
         UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "coalesced wakes", mWake.getTotalCoalesced());
         UseServicesHelper::debugAppend(resultEl, "base thread id", base ? base->getThreadID() : String());
         UseServicesHelper::debugAppend(resultEl, "account id", (bool)account);
 
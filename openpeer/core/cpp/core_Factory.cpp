@@ -290,12 +290,13 @@ namespace openpeer
       }
 
       ConversationThreadDocumentFetcherPtr IConversationThreadDocumentFetcherFactory::create(
+                                                                                             IMessageQueuePtr queue,
                                                                                              IConversationThreadDocumentFetcherDelegatePtr delegate,
                                                                                              IPublicationRepositoryPtr repository
                                                                                              )
       {
         if (this) {}
-        return ConversationThreadDocumentFetcher::create(delegate, repository);
+        return ConversationThreadDocumentFetcher::create(queue, delegate, repository);
       }
 
       //-----------------------------------------------------------------------
@@ -393,10 +394,13 @@ namespace openpeer
       }
 
       //-----------------------------------------------------------------------
-      IdentityPtr IIdentityFactory::createFromExistingSession(IServiceIdentitySessionPtr session)
+      IdentityPtr IIdentityFactory::createFromExistingSession(
+                                                              IMessageQueuePtr queue,
+                                                              IServiceIdentitySessionPtr session
+                                                              )
       {
         if (this) {}
-        return Identity::createFromExistingSession(session);
+        return Identity::createFromExistingSession(queue, session);
       }
 
       //-----------------------------------------------------------------------
@@ -46,6 +46,28 @@ namespace openpeer
     {
       ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark (helpers)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      static boost::atomic<ULONG> &totalWakesPosted()
+      {
+        static boost::atomic<ULONG> total(0);
+        return total;
+      }
+
+      //-----------------------------------------------------------------------
+      static boost::atomic<ULONG> &totalWakesCoalesced()
+      {
+        static boost::atomic<ULONG> total(0);
+        return total;
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -181,6 +203,96 @@ namespace openpeer
           outContact.mAvatars.push_back(avatar);
         }
       }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CoalescedWake
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      CoalescedWake::CoalescedWake() :
+        mPending(false),
+        mTotalPosted(0),
+        mTotalCoalesced(0)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      bool CoalescedWake::wake(IWakeDelegatePtr delegate)
+      {
+        return post(IMessageQueuePtr(), delegate);
+      }
+
+      //-----------------------------------------------------------------------
+      bool CoalescedWake::wake(
+                               IMessageQueuePtr queue,
+                               IWakeDelegatePtr delegate
+                               )
+      {
+        return post(queue, delegate);
+      }
+
+      //-----------------------------------------------------------------------
+      void CoalescedWake::notifyWoken()
+      {
+        mPending.store(false, boost::memory_order_release);
+      }
+
+      //-----------------------------------------------------------------------
+      ULONG CoalescedWake::getTotalPosted() const
+      {
+        return mTotalPosted.load(boost::memory_order_relaxed);
+      }
+
+      //-----------------------------------------------------------------------
+      ULONG CoalescedWake::getTotalCoalesced() const
+      {
+        return mTotalCoalesced.load(boost::memory_order_relaxed);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr CoalescedWake::toDebugTotals()
+      {
+        ElementPtr resultEl = Element::create("wakes");
+
+        UseServicesHelper::debugAppend(resultEl, "posted", totalWakesPosted().load(boost::memory_order_relaxed));
+        UseServicesHelper::debugAppend(resultEl, "coalesced", totalWakesCoalesced().load(boost::memory_order_relaxed));
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      bool CoalescedWake::post(
+                               IMessageQueuePtr queue,
+                               IWakeDelegatePtr delegate
+                               )
+      {
+        if (!delegate) return false;
+
+        if (mPending.exchange(true, boost::memory_order_acq_rel)) {
+          mTotalCoalesced.fetch_add(1, boost::memory_order_relaxed);
+          totalWakesCoalesced().fetch_add(1, boost::memory_order_relaxed);
+          return false;
+        }
+
+        mTotalPosted.fetch_add(1, boost::memory_order_relaxed);
+        totalWakesPosted().fetch_add(1, boost::memory_order_relaxed);
+
+        try {
+          if (queue) {
+            IWakeDelegateProxy::create(queue, delegate)->onWake();
+          } else {
+            IWakeDelegateProxy::create(delegate)->onWake();
+          }
+        } catch(IWakeDelegateProxy::Exceptions::DelegateGone &) {
+          mPending.store(false, boost::memory_order_release);
+          return false;
+        }
+        return true;
+      }
     }
 
     //-------------------------------------------------------------------------
@@ -120,9 +120,12 @@ namespace openpeer
       }
 
       //-----------------------------------------------------------------------
-      ForAccountPtr IIdentityForAccount::createFromExistingSession(IServiceIdentitySessionPtr session)
+      ForAccountPtr IIdentityForAccount::createFromExistingSession(
+                                                                   IMessageQueuePtr queue,
+                                                                   IServiceIdentitySessionPtr session
+                                                                   )
       {
-        return IIdentityFactory::singleton().createFromExistingSession(session);
+        return IIdentityFactory::singleton().createFromExistingSession(queue, session);
       }
 
       //-----------------------------------------------------------------------
@@ -202,7 +205,8 @@ namespace openpeer
 
         UseAccountPtr account = Account::convert(inAccount);
 
-        IdentityPtr pThis(new Identity(UseStack::queueCore()));
+        // identities live on the same core queue as their account
+        IdentityPtr pThis(new Identity(Account::convert(inAccount)->getAssociatedMessageQueue()));
         pThis->mThisWeak = pThis;
 
         AutoRecursiveLock lock(pThis->mLock);
@@ -256,7 +260,8 @@ namespace openpeer
 
         UseAccountPtr account = Account::convert(inAccount);
 
-        IdentityPtr pThis(new Identity(UseStack::queueCore()));
+        // identities live on the same core queue as their account
+        IdentityPtr pThis(new Identity(Account::convert(inAccount)->getAssociatedMessageQueue()));
         pThis->mThisWeak = pThis;
         pThis->mDelegate = IIdentityDelegateProxy::createWeak(UseStack::queueApplication(), delegate);
 
@@ -500,11 +505,15 @@ namespace openpeer
       #pragma mark
 
       //-----------------------------------------------------------------------
-      IdentityPtr Identity::createFromExistingSession(IServiceIdentitySessionPtr session)
+      IdentityPtr Identity::createFromExistingSession(
+                                                      IMessageQueuePtr queue,
+                                                      IServiceIdentitySessionPtr session
+                                                      )
       {
+        ZS_THROW_INVALID_ARGUMENT_IF(!queue)
         ZS_THROW_INVALID_ARGUMENT_IF(!session)
 
-        IdentityPtr pThis(new Identity(UseStack::queueCore()));
+        IdentityPtr pThis(new Identity(queue));
         pThis->mThisWeak = pThis;
         pThis->mSession = session;
         pThis->init();
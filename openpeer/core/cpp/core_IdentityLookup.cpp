@@ -92,58 +92,61 @@ namespace openpeer
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       #pragma mark
-      #pragma mark IdentityLookup
+      #pragma mark IdentityLookup::PrepareIdentitiesTask
       #pragma mark
 
       //-----------------------------------------------------------------------
-      IdentityLookup::IdentityLookup(
-                                     IMessageQueuePtr queue,
-                                     AccountPtr account,
-                                     IIdentityLookupDelegatePtr delegate,
-                                     const char *identityServiceDomain
-                                     ) :
-        MessageQueueAssociator(queue),
-        SharedRecursiveLock(*account),
-        mAccount(account),
-        mDelegate(IIdentityLookupDelegateProxy::createWeak(UseStack::queueApplication(), delegate)),
-        mErrorCode(0),
-        mIdentityServiceDomain(identityServiceDomain),
-        mAlreadyIssuedForProviderDomain(false)
+      IdentityLookup::PrepareIdentitiesTask::PrepareIdentitiesTask(
+                                                                   const IdentityLookupInfoList &identities,
+                                                                   const char *identityServiceDomain
+                                                                   ) :
+        mIdentities(identities),
+        mIdentityServiceDomain(identityServiceDomain)
       {
-        ZS_LOG_BASIC(log("created"))
       }
 
       //-----------------------------------------------------------------------
-      void IdentityLookup::init(const IdentityLookupInfoList &identities)
+      void IdentityLookup::PrepareIdentitiesTask::run()
       {
-        AutoRecursiveLock lock(*this);
-
-        for (IdentityLookupInfoList::const_iterator iter = identities.begin(); iter != identities.end(); ++iter) {
+        for (IdentityLookupInfoList::const_iterator iter = mIdentities.begin(); iter != mIdentities.end(); ++iter) {
           const String &identityURI = (*iter).mIdentityURI;
           const Time &lastUpdated = (*iter).mLastUpdated;
 
           if (!IServiceIdentity::isValid(identityURI)) {
-            ZS_LOG_WARNING(Detail, log("identity not valid") + ZS_PARAM("identity", identityURI))
+            ZS_LOG_WARNING(Detail, Log::Params("identity not valid", "core::IdentityLookup::PrepareIdentitiesTask") + ZS_PARAM("identity", identityURI))
             continue;
           }
 
           String domainOrType;
           String identifier;
           if (!IServiceIdentity::splitURI(identityURI, domainOrType, identifier)) {
-            ZS_LOG_WARNING(Detail, log("failed to parse identity") + ZS_PARAM("identity", identityURI))
+            ZS_LOG_WARNING(Detail, Log::Params("failed to parse identity", "core::IdentityLookup::PrepareIdentitiesTask") + ZS_PARAM("identity", identityURI))
             continue;
           }
 
           if (identifier.isEmpty()) {
-            ZS_LOG_WARNING(Detail, log("failed to obtain identifier for identity") + ZS_PARAM("identity", identityURI))
+            ZS_LOG_WARNING(Detail, Log::Params("failed to obtain identifier for identity", "core::IdentityLookup::PrepareIdentitiesTask") + ZS_PARAM("identity", identityURI))
             continue;
           }
 
-          if (IServiceIdentity::isLegacy(identityURI)) {
-            prepareIdentity(mIdentityServiceDomain, domainOrType, identifier, lastUpdated);
-          } else {
-            prepareIdentity(domainOrType, domainOrType, identifier, lastUpdated);
+          const String &type = domainOrType;
+          const String &domain = (IServiceIdentity::isLegacy(identityURI) ? mIdentityServiceDomain : domainOrType);
+
+          IdentifierDomainOrLegacyTypeMap::iterator found = mDomainOrLegacyTypeIdentifiers.find(type);
+          if (found == mDomainOrLegacyTypeIdentifiers.end()) {
+            IdentifierMap empty;
+            mDomainOrLegacyTypeIdentifiers[type] = empty;
+            found = mDomainOrLegacyTypeIdentifiers.find(type);
+
+            mConcatDomains[type] = String();
+            mTypeToDomainMap[type] = domain;
           }
+
+          IdentifierMap &identifiers = (*found).second;
+          identifiers[identifier] = lastUpdated;
+
+          // append into one bit string (without any split char yet)
+          mConcatDomains[type] += identifier;
         }
 
         // all identities should be prepared so not figure out which character can safely be used to split the string into parts
@@ -152,14 +155,15 @@ namespace openpeer
           IdentifierSafeCharDomainLegacyTypeMap::iterator current = iter;
           ++iter;
 
-          const String &type = (*current).first;
+          const String type = (*current).first;
           String &concat = (*current).second;
 
           char safeChar = getSafeSplitChar(concat);
           if (0 == safeChar) {
-            ZS_LOG_WARNING(Detail, log("failed to obain a safe char to split for domain or legacy type") + ZS_PARAM("domain or type", type))
+            ZS_LOG_WARNING(Detail, Log::Params("failed to obain a safe char to split for domain or legacy type", "core::IdentityLookup::PrepareIdentitiesTask") + ZS_PARAM("domain or type", type))
             mConcatDomains.erase(current);
             mDomainOrLegacyTypeIdentifiers.erase(mDomainOrLegacyTypeIdentifiers.find(type));
+            mTypeToDomainMap.erase(type);
             continue;
           }
 
@@ -180,13 +184,46 @@ namespace openpeer
             concat += safeChar + identifier;
           }
 
-          ZS_LOG_DEBUG(log("adding safe char for type") + ZS_PARAM("type", type) + ZS_PARAM("safe char", (String() + safeChar)))
-
           mSafeCharDomains[type] = String() + safeChar;
         }
+      }
 
-        // we now have a list of domains and a list types/identifiers
-        step();
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IdentityLookup
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      IdentityLookup::IdentityLookup(
+                                     IMessageQueuePtr queue,
+                                     AccountPtr account,
+                                     IIdentityLookupDelegatePtr delegate,
+                                     const char *identityServiceDomain
+                                     ) :
+        MessageQueueAssociator(queue),
+        SharedRecursiveLock(*account),
+        mAccount(account),
+        mDelegate(IIdentityLookupDelegateProxy::createWeak(UseStack::queueApplication(), delegate)),
+        mErrorCode(0),
+        mIdentityServiceDomain(identityServiceDomain),
+        mAlreadyIssuedForProviderDomain(false),
+        mPreparing(false)
+      {
+        ZS_LOG_BASIC(log("created"))
+      }
+
+      //-----------------------------------------------------------------------
+      void IdentityLookup::init(const IdentityLookupInfoList &identities)
+      {
+        AutoRecursiveLock lock(*this);
+
+        // splitting and grouping the identities is pure CPU work, step() waits until the results are applied
+        mPreparing = true;
+
+        ITaskPoolForInternal::submit(PrepareIdentitiesTaskPtr(new PrepareIdentitiesTask(identities, mIdentityServiceDomain)), mThisWeak.lock());
       }
 
       //-----------------------------------------------------------------------
@@ -234,7 +271,10 @@ namespace openpeer
 
         ZS_THROW_INVALID_ARGUMENT_IF(!UseServicesHelper::isValidDomain(identityServiceDomain))
 
-        IdentityLookupPtr pThis(new IdentityLookup(UseStack::queueCore(), Account::convert(account), delegate, identityServiceDomain));
+        AccountPtr inAccount = Account::convert(account);
+        ZS_THROW_INVALID_ARGUMENT_IF(!inAccount)
+
+        IdentityLookupPtr pThis(new IdentityLookup(inAccount->getAssociatedMessageQueue(), inAccount, delegate, identityServiceDomain));
         pThis->mThisWeak = pThis;
         pThis->init(identities);
         return pThis;
@@ -498,6 +538,50 @@ namespace openpeer
         step();
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IdentityLookup => ITaskPoolTaskDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void IdentityLookup::onTaskPoolTaskCompleted(ITaskPoolTaskPtr task)
+      {
+        PrepareIdentitiesTaskPtr prepared = dynamic_pointer_cast<PrepareIdentitiesTask>(task);
+        ZS_THROW_INVALID_ARGUMENT_IF(!prepared)
+
+        AutoRecursiveLock lock(*this);
+
+        mPreparing = false;
+
+        if (!mDelegate) {
+          ZS_LOG_WARNING(Detail, log("identities prepared after lookup was cancelled (thus ignoring)"))
+          return;
+        }
+
+        ZS_LOG_DEBUG(log("identities prepared") + ZS_PARAM("types", prepared->mTypeToDomainMap.size()))
+
+        for (DomainOrLegacyTypeToDomainMap::iterator iter = prepared->mTypeToDomainMap.begin(); iter != prepared->mTypeToDomainMap.end(); ++iter)
+        {
+          const String &type = (*iter).first;
+          const String &domain = (*iter).second;
+
+          if (!prepareBootstrapper(domain)) continue;
+
+          ZS_LOG_DEBUG(log("adding contact type") + ZS_PARAM("type", type) + ZS_PARAM("domain", domain) + ZS_PARAM("safe char", prepared->mSafeCharDomains[type]))
+
+          mDomainOrLegacyTypeIdentifiers[type] = prepared->mDomainOrLegacyTypeIdentifiers[type];
+          mConcatDomains[type] = prepared->mConcatDomains[type];
+          mSafeCharDomains[type] = prepared->mSafeCharDomains[type];
+          mTypeToDomainMap[type] = domain;
+        }
+
+        // we now have a list of domains and a list types/identifiers
+        step();
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -811,6 +895,7 @@ namespace openpeer
         UseServicesHelper::debugAppend(resultEl, "error code", mErrorCode);
         UseServicesHelper::debugAppend(resultEl, "error reason", mErrorReason);
         UseServicesHelper::debugAppend(resultEl, "identity service domain", mIdentityServiceDomain);
+        UseServicesHelper::debugAppend(resultEl, "preparing", mPreparing);
         UseServicesHelper::debugAppend(resultEl, "bootstrapped networks", mBootstrappedNetworks.size());
         UseServicesHelper::debugAppend(resultEl, "monitors", mMonitors.size());
         UseServicesHelper::debugAppend(resultEl, "type identifiers", mDomainOrLegacyTypeIdentifiers.size());
@@ -823,55 +908,21 @@ namespace openpeer
       }
 
       //-----------------------------------------------------------------------
-      void IdentityLookup::prepareIdentity(
-                                           const String &domain,
-                                           const String &type,
-                                           const String &identifier,
-                                           const Time &lastUpdated
-                                           )
+      bool IdentityLookup::prepareBootstrapper(const String &domain)
       {
-        ZS_LOG_DEBUG(log("preparing domain") + ZS_PARAM("domain", domain) + ZS_PARAM("identifier", identifier))
-
-        // scope: prepare bootstrapper for domain
-        {
-          BootstrappedNetworkMap::iterator found = mBootstrappedNetworks.find(domain);
-          if (found == mBootstrappedNetworks.end()) {
-            ZS_LOG_DEBUG(log("domain not found, adding new bootstrapper") + ZS_PARAM("domain", domain))
-            IBootstrappedNetworkPtr network = IBootstrappedNetwork::prepare(domain, mThisWeak.lock());
-            if (!network) {
-              ZS_LOG_WARNING(Detail, log("failed to create bootstrapper for domain") + ZS_PARAM("domain", domain))
-              return;
-            }
+        BootstrappedNetworkMap::iterator found = mBootstrappedNetworks.find(domain);
+        if (found != mBootstrappedNetworks.end()) return true;
 
-            // bootstrapper was created for this domain
-            mBootstrappedNetworks[domain] = network;
-          }
+        ZS_LOG_DEBUG(log("domain not found, adding new bootstrapper") + ZS_PARAM("domain", domain))
+        IBootstrappedNetworkPtr network = IBootstrappedNetwork::prepare(domain, mThisWeak.lock());
+        if (!network) {
+          ZS_LOG_WARNING(Detail, log("failed to create bootstrapper for domain") + ZS_PARAM("domain", domain))
+          return false;
         }
 
-        // scope prepare identifiers for domain
-        {
-          IdentifierDomainOrLegacyTypeMap::iterator found = mDomainOrLegacyTypeIdentifiers.find(type);
-          if (found == mDomainOrLegacyTypeIdentifiers.end()) {
-            IdentifierMap empty;
-            mDomainOrLegacyTypeIdentifiers[type] = empty;
-            found = mDomainOrLegacyTypeIdentifiers.find(type);
-
-            ZS_LOG_DEBUG(log("adding contact type") + ZS_PARAM("type", type))
-
-            mConcatDomains[type] = String();
-            mTypeToDomainMap[type] = domain;
-          }
-
-          IdentifierMap &identifiers = (*found).second;
-          identifiers[identifier] = lastUpdated;
-
-          IdentifierSafeCharDomainLegacyTypeMap::iterator foundSafe = mConcatDomains.find(type);
-          ZS_THROW_BAD_STATE_IF(foundSafe == mConcatDomains.end())
-
-          // append into one bit string (without any split char yet)
-          String &concats = (*foundSafe).second;
-          concats += identifier;
-        }
+        // bootstrapper was created for this domain
+        mBootstrappedNetworks[domain] = network;
+        return true;
       }
 
       //-----------------------------------------------------------------------
@@ -879,6 +930,11 @@ namespace openpeer
       {
         ZS_LOG_DEBUG(log("step"))
 
+        if (mPreparing) {
+          ZS_LOG_DEBUG(log("waiting for identities to be prepared"))
+          return;
+        }
+
         if ((mMonitors.size() < 1) &&
             (mBootstrappedNetworks.size() < 1)) {
           ZS_LOG_DEBUG(log("identity lookup is finished"))
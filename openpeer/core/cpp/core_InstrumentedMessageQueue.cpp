@@ -0,0 +1,261 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+#include <openpeer/core/internal/core_InstrumentedMessageQueue.h>
+
+#include <openpeer/services/IHelper.h>
+
+#include <zsLib/XML.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_core) } }
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark (helpers)
+      #pragma mark
+
+      typedef std::pair<InstrumentedMessageQueue::MethodKey, InstrumentedMessageQueue::MethodStats> MethodStatsPair;
+
+      //-----------------------------------------------------------------------
+      static ULONG toMicroseconds(const Duration &duration)
+      {
+        if (duration.is_negative()) return 0;
+        zsLib::ULONGLONG value = static_cast<zsLib::ULONGLONG>(duration.total_microseconds());
+        if (value > static_cast<zsLib::ULONGLONG>(ULONG(-1))) return ULONG(-1);
+        return static_cast<ULONG>(value);
+      }
+
+      //-----------------------------------------------------------------------
+      static bool isSlower(
+                           const MethodStatsPair &left,
+                           const MethodStatsPair &right
+                           )
+      {
+        return left.second.mMax > right.second.mMax;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark InstrumentedMessageQueue::Message
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      InstrumentedMessageQueue::Message::Message(
+                                                 InstrumentedMessageQueuePtr outer,
+                                                 IMessageQueueMessagePtr message
+                                                 ) :
+        mOuter(outer),
+        mMessage(message),
+        mPosted(zsLib::now())
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      void InstrumentedMessageQueue::Message::processMessage()
+      {
+        Time started = zsLib::now();
+        mMessage->processMessage();
+        Time finished = zsLib::now();
+
+        InstrumentedMessageQueuePtr outer = mOuter.lock();
+        if (!outer) return;
+
+        outer->notifyProcessed(*this, mPosted, started, finished);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark InstrumentedMessageQueue
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      InstrumentedMessageQueue::InstrumentedMessageQueue(
+                                                         const char *name,
+                                                         IMessageQueuePtr queue
+                                                         ) :
+        mName(name),
+        mQueue(queue),
+        mPosted(0),
+        mProcessed(0),
+        mMaxDepth(0)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      InstrumentedMessageQueuePtr InstrumentedMessageQueue::create(
+                                                                   const char *name,
+                                                                   IMessageQueuePtr queue
+                                                                   )
+      {
+        ZS_THROW_INVALID_ARGUMENT_IF(!queue)
+
+        InstrumentedMessageQueuePtr pThis(new InstrumentedMessageQueue(name, queue));
+        pThis->mThisWeak = pThis;
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark InstrumentedMessageQueue => IMessageQueue
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void InstrumentedMessageQueue::post(IMessageQueueMessagePtr message)
+      {
+        ULONG depth = mPosted.fetch_add(1, boost::memory_order_relaxed) + 1 - mProcessed.load(boost::memory_order_relaxed);
+
+        ULONG maxDepth = mMaxDepth.load(boost::memory_order_relaxed);
+        while ((depth > maxDepth) &&
+               (!mMaxDepth.compare_exchange_weak(maxDepth, depth, boost::memory_order_relaxed))) {
+        }
+
+        mQueue->post(IMessageQueueMessagePtr(new Message(mThisWeak.lock(), message)));
+      }
+
+      //-----------------------------------------------------------------------
+      InstrumentedMessageQueue::size_type InstrumentedMessageQueue::getTotalUnprocessedMessages() const
+      {
+        return mQueue->getTotalUnprocessedMessages();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark InstrumentedMessageQueue => (for Stack)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      ElementPtr InstrumentedMessageQueue::getStatistics(bool resetAfterReading)
+      {
+        ElementPtr resultEl = Element::create("queue");
+
+        UseServicesHelper::debugAppend(resultEl, "name", mName);
+        UseServicesHelper::debugAppend(resultEl, "depth", static_cast<ULONG>(mQueue->getTotalUnprocessedMessages()));
+        UseServicesHelper::debugAppend(resultEl, "posted", mPosted.load(boost::memory_order_relaxed));
+        UseServicesHelper::debugAppend(resultEl, "processed", mProcessed.load(boost::memory_order_relaxed));
+        UseServicesHelper::debugAppend(resultEl, "max depth", mMaxDepth.load(boost::memory_order_relaxed));
+
+        AutoLock lock(mLock);
+
+        UseServicesHelper::debugAppend(resultEl, mWaitTime.toDebug("wait", "us"));
+        UseServicesHelper::debugAppend(resultEl, mHandlerTime.toDebug("handler", "us"));
+
+        std::vector<MethodStatsPair> methods(mMethods.begin(), mMethods.end());
+
+        size_t total = (methods.size() > Limit_SlowestMethods ? static_cast<size_t>(Limit_SlowestMethods) : methods.size());
+        std::partial_sort(methods.begin(), methods.begin() + total, methods.end(), isSlower);
+
+        ElementPtr slowestEl = Element::create("slowest methods");
+        for (size_t index = 0; index < total; ++index) {
+          const MethodStats &stats = methods[index].second;
+
+          const MethodKey &key = methods[index].first;
+
+          ElementPtr methodEl = Element::create("method");
+          UseServicesHelper::debugAppend(methodEl, "name", String(key.first ? key.first : "") + "::" + (key.second ? key.second : ""));
+          UseServicesHelper::debugAppend(methodEl, "total", stats.mTotal);
+          UseServicesHelper::debugAppend(methodEl, "average (us)", static_cast<ULONG>(stats.mSum / (stats.mTotal > 0 ? stats.mTotal : 1)));
+          UseServicesHelper::debugAppend(methodEl, "max (us)", stats.mMax);
+          UseServicesHelper::debugAppend(slowestEl, methodEl);
+        }
+        UseServicesHelper::debugAppend(resultEl, slowestEl);
+
+        if (resetAfterReading) {
+          mWaitTime.reset();
+          mHandlerTime.reset();
+          mMethods.clear();
+          mMaxDepth.store(0, boost::memory_order_relaxed);
+        }
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark InstrumentedMessageQueue => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void InstrumentedMessageQueue::notifyProcessed(
+                                                     const Message &message,
+                                                     const Time &posted,
+                                                     const Time &started,
+                                                     const Time &finished
+                                                     )
+      {
+        mProcessed.fetch_add(1, boost::memory_order_relaxed);
+
+        ULONG waitTime = toMicroseconds(started - posted);
+        ULONG handlerTime = toMicroseconds(finished - started);
+
+        MethodKey key(message.getDelegateName(), message.getMethodName());
+
+        AutoLock lock(mLock);
+
+        mWaitTime.record(waitTime);
+        mHandlerTime.record(handlerTime);
+
+        MethodStats &stats = mMethods[key];
+        ++(stats.mTotal);
+        stats.mSum += handlerTime;
+        if (handlerTime > stats.mMax) stats.mMax = handlerTime;
+      }
+    }
+  }
+}
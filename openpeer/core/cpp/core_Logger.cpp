@@ -30,7 +30,31 @@
  */
 
 #include <openpeer/core/internal/core_Logger.h>
+#include <openpeer/core/internal/core_LoggerBinaryFormat.h>
 #include <openpeer/services/ILogger.h>
+#include <openpeer/services/IHelper.h>
+
+#include <zsLib/Numeric.h>
+#include <zsLib/XML.h>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread.hpp>
+
+#include <list>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif //_WIN32
+
+#ifndef OPENPEER_CORE_ROTATING_LOGGER_NO_COMPRESSION
+#include <zlib.h>
+#endif //OPENPEER_CORE_ROTATING_LOGGER_NO_COMPRESSION
 
 namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_core) } }
 namespace openpeer { namespace core { namespace application { ZS_DECLARE_SUBSYSTEM(openpeer_application) } } }
@@ -44,6 +68,8 @@ namespace openpeer
 
     namespace internal
     {
+      ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+
       //-----------------------------------------------------------------------
       static zsLib::Log::Level levelToLevel(ILogger::Level level)
       {
@@ -100,6 +126,152 @@ namespace openpeer
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AsyncLogBuffer
+      #pragma mark
+
+      // Bounded multi-producer ring buffer (sequence numbered slots, see
+      // Dmitry Vyukov's bounded MPMC queue). Producers never block, a full
+      // buffer causes push() to fail. Only one thread may call pop().
+      ZS_DECLARE_CLASS_PTR(AsyncLogBuffer)
+
+      class AsyncLogBuffer : boost::noncopyable
+      {
+      public:
+        struct Entry
+        {
+          SubsystemID mSubsystemID;
+          const char *mSubsystemName;
+          ILogger::Severity mSeverity;
+          ILogger::Level mLevel;
+          String mMessage;
+          const char *mFunction;
+          const char *mFilePath;
+          ULONG mLineNumber;
+        };
+
+      protected:
+        struct Slot
+        {
+          boost::atomic<size_t> mSequence;
+          Entry mEntry;
+        };
+
+      public:
+        //---------------------------------------------------------------------
+        AsyncLogBuffer(size_t size) :
+          mSize(roundUpToPowerOfTwo(size)),
+          mMask(mSize - 1),
+          mSlots(new Slot[mSize]),
+          mEnqueuePos(0),
+          mDequeuePos(0)
+        {
+          for (size_t index = 0; index < mSize; ++index) {
+            mSlots[index].mSequence.store(index, boost::memory_order_relaxed);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        size_t size() const {return mSize;}
+
+        //---------------------------------------------------------------------
+        bool push(Entry &entry)
+        {
+          Slot *slot = NULL;
+          size_t pos = mEnqueuePos.load(boost::memory_order_relaxed);
+
+          while (true) {
+            slot = &(mSlots[pos & mMask]);
+            size_t sequence = slot->mSequence.load(boost::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos);
+            if (0 == diff) {
+              if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed)) break;
+              continue;
+            }
+            if (diff < 0) return false;  // buffer is full
+            pos = mEnqueuePos.load(boost::memory_order_relaxed);
+          }
+
+          slot->mEntry.mSubsystemID = entry.mSubsystemID;
+          slot->mEntry.mSubsystemName = entry.mSubsystemName;
+          slot->mEntry.mSeverity = entry.mSeverity;
+          slot->mEntry.mLevel = entry.mLevel;
+          slot->mEntry.mMessage.swap(entry.mMessage);
+          slot->mEntry.mFunction = entry.mFunction;
+          slot->mEntry.mFilePath = entry.mFilePath;
+          slot->mEntry.mLineNumber = entry.mLineNumber;
+
+          slot->mSequence.store(pos + 1, boost::memory_order_release);
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        bool pop(Entry &outEntry)
+        {
+          size_t pos = mDequeuePos.load(boost::memory_order_relaxed);
+          Slot &slot = mSlots[pos & mMask];
+
+          size_t sequence = slot.mSequence.load(boost::memory_order_acquire);
+          if (sequence != (pos + 1)) return false;  // nothing published yet
+
+          mDequeuePos.store(pos + 1, boost::memory_order_relaxed);
+
+          outEntry.mSubsystemID = slot.mEntry.mSubsystemID;
+          outEntry.mSubsystemName = slot.mEntry.mSubsystemName;
+          outEntry.mSeverity = slot.mEntry.mSeverity;
+          outEntry.mLevel = slot.mEntry.mLevel;
+          outEntry.mMessage.swap(slot.mEntry.mMessage);
+          outEntry.mFunction = slot.mEntry.mFunction;
+          outEntry.mFilePath = slot.mEntry.mFilePath;
+          outEntry.mLineNumber = slot.mEntry.mLineNumber;
+
+          slot.mEntry.mMessage.clear();
+          slot.mSequence.store(pos + mSize, boost::memory_order_release);
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        bool isEmpty() const
+        {
+          size_t pos = mDequeuePos.load(boost::memory_order_relaxed);
+          return mSlots[pos & mMask].mSequence.load(boost::memory_order_acquire) != (pos + 1);
+        }
+
+        //---------------------------------------------------------------------
+        size_t occupancy() const
+        {
+          // dequeue is read first since the enqueue position never falls behind it
+          size_t dequeuePos = mDequeuePos.load(boost::memory_order_relaxed);
+          size_t enqueuePos = mEnqueuePos.load(boost::memory_order_relaxed);
+          return (enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0);
+        }
+
+      protected:
+        //---------------------------------------------------------------------
+        static size_t roundUpToPowerOfTwo(size_t size)
+        {
+          size_t result = 2;
+          while (result < size) result <<= 1;
+          return result;
+        }
+
+      protected:
+        const size_t mSize;
+        const size_t mMask;
+        boost::scoped_array<Slot> mSlots;
+
+        boost::atomic<size_t> mEnqueuePos;
+        boost::atomic<size_t> mDequeuePos;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CustomLogger
+      #pragma mark
+
       ZS_DECLARE_CLASS_PTR(CustomLogger)
 
       class CustomLogger : public zsLib::ILogDelegate
@@ -110,11 +282,30 @@ namespace openpeer
         typedef zsLib::PTRNUMBER SubsystemID;
         typedef zsLib::Subsystem Subsystem;
         typedef std::map<SubsystemID, Subsystem *> SubsystemMap;
+        typedef ILogger::CustomLoggerStatistics CustomLoggerStatistics;
 
       protected:
-        CustomLogger() {}
+        CustomLogger() :
+          mAsync(false),
+          mRawBuffer(NULL),
+          mShouldShutdown(false),
+          mWakePending(false),
+          mQueueing(0),
+          mQueued(0),
+          mDelivered(0),
+          mDropped(0),
+          mOverflows(0),
+          mHighWaterMark(0),
+          mOverflowing(false)
+        {}
 
       public:
+        //---------------------------------------------------------------------
+        ~CustomLogger()
+        {
+          stopDeliveryThread();
+        }
+
         //---------------------------------------------------------------------
         static CustomLoggerPtr create() {
           CustomLoggerPtr pThis = CustomLoggerPtr(new CustomLogger);
@@ -134,15 +325,30 @@ namespace openpeer
         }
 
         //---------------------------------------------------------------------
-        virtual void installLogger(ILoggerDelegatePtr delegate)
+        virtual void installLogger(
+                                   ILoggerDelegatePtr delegate,
+                                   size_t asyncBufferSize
+                                   )
         {
           SubsystemMap subsystems;
 
+          bool async = (delegate) && (0 != asyncBufferSize);
+
+          // anything still queued belongs to the previous delegate thus it
+          // is delivered before the delegate or the delivery mode changes
+          drainAsync();
+
           // scope: remember the client logger delegate and get the subsystems
           {
             AutoRecursiveLock lock(mLock);
             mDelegate = delegate;
             subsystems = mSubsystems;
+
+            if (async) {
+              if (!mBuffer) {
+                mBuffer = AsyncLogBufferPtr(new AsyncLogBuffer(asyncBufferSize));
+              }
+            }
           }
 
           if (!delegate)
@@ -151,6 +357,29 @@ namespace openpeer
           for (SubsystemMap::iterator iter = subsystems.begin(); iter != subsystems.end(); ++iter) {
             delegate->onNewSubsystem((*iter).first, (*iter).second->getName());
           }
+
+          if (async) {
+            startDeliveryThread();
+            mAsync.store(true);
+          }
+        }
+
+        //---------------------------------------------------------------------
+        virtual CustomLoggerStatistics getStatistics() const
+        {
+          CustomLoggerStatistics result;
+
+          {
+            AutoRecursiveLock lock(mLock);
+            result.mBufferSize = (mBuffer && mAsync.load() ? mBuffer->size() : 0);
+          }
+
+          result.mQueued = mQueued.load();
+          result.mDelivered = mDelivered.load();
+          result.mDropped = mDropped.load();
+          result.mOverflows = mOverflows.load();
+          result.mHighWaterMark = mHighWaterMark.load();
+          return result;
         }
 
         //---------------------------------------------------------------------
@@ -182,6 +411,15 @@ namespace openpeer
                            const Log::Params &params
                            )
         {
+          // scope: announce a possible producer so a mode switch can wait for it
+          {
+            QueueingScope queueing(mQueueing);
+            if (mAsync.load(boost::memory_order_acquire)) {
+              queue(inSubsystem, inSeverity, inLevel, inFunction, inFilePath, inLineNumber, params);
+              return;
+            }
+          }
+
           ILoggerDelegatePtr delegate;
 
           // scope: get the delegate
@@ -204,158 +442,1720 @@ namespace openpeer
                           );
         }
 
+        //---------------------------------------------------------------------
+        // delivery thread
+        void operator()()
+        {
+          while (true) {
+            bool shouldShutdown = false;
+
+            {
+              boost::unique_lock<boost::mutex> lock(mWakeMutex);
+              while ((!mWakePending.load()) &&
+                     (!mShouldShutdown)) {
+                mWakeCondition.wait(lock);
+              }
+              mWakePending.store(false);
+              shouldShutdown = mShouldShutdown;
+            }
+
+            // pairs with the fence in queue() so an entry pushed before a
+            // producer saw the pending flag set is always drained below
+            boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+            ILoggerDelegatePtr delegate;
+            AsyncLogBufferPtr buffer;
+            {
+              AutoRecursiveLock lock(mLock);
+              delegate = mDelegate;
+              buffer = mBuffer;
+            }
+
+            if (0 != deliver(*buffer, delegate)) {
+              mOverflowing.store(false, boost::memory_order_relaxed);
+            }
+
+            if ((shouldShutdown) &&
+                (buffer->isEmpty())) break;
+          }
+        }
+
+        //---------------------------------------------------------------------
         static Log::Params slog(const char *message)
         {
           return Log::Params(message, "core::CustomLogger");
         }
 
       protected:
-        RecursiveLock      mLock;
-        SubsystemMap       mSubsystems;
-        ILoggerDelegatePtr mDelegate;
-      };
+        //---------------------------------------------------------------------
+        void queue(
+                   const Subsystem &inSubsystem,
+                   zsLib::Log::Severity inSeverity,
+                   zsLib::Log::Level inLevel,
+                   CSTR inFunction,
+                   CSTR inFilePath,
+                   ULONG inLineNumber,
+                   const Log::Params &params
+                   )
+        {
+          // the buffer is never released once created thus no lock is needed
+          AsyncLogBuffer::Entry entry;
+          entry.mSubsystemID = (PTRNUMBER)(&inSubsystem);
+          entry.mSubsystemName = inSubsystem.getName();
+          entry.mSeverity = severityToSeverity(inSeverity);
+          entry.mLevel = levelToLevel(inLevel);
+          entry.mMessage = params.message();
+          entry.mFunction = inFunction;
+          entry.mFilePath = inFilePath;
+          entry.mLineNumber = inLineNumber;
 
+          if (!mRawBuffer->push(entry)) {
+            mDropped.fetch_add(1, boost::memory_order_relaxed);
+            if (!mOverflowing.exchange(true, boost::memory_order_relaxed)) {
+              mOverflows.fetch_add(1, boost::memory_order_relaxed);
+            }
+            return;
+          }
 
-    }
+          mQueued.fetch_add(1, boost::memory_order_relaxed);
 
-    //-------------------------------------------------------------------------
-    void ILogger::installStdOutLogger(bool colorizeOutput)
-    {
-      services::ILogger::installStdOutLogger(colorizeOutput);
-    }
+          ULONG depth = static_cast<ULONG>(mRawBuffer->occupancy());
+          ULONG mark = mHighWaterMark.load(boost::memory_order_relaxed);
+          while ((depth > mark) &&
+                 (!mHighWaterMark.compare_exchange_weak(mark, depth, boost::memory_order_relaxed))) {
+          }
 
-    //-------------------------------------------------------------------------
-    void ILogger::installFileLogger(const char *fileName, bool colorizeOutput)
-    {
-      services::ILogger::installFileLogger(fileName, colorizeOutput);
-    }
+          // the pending flag is only ever set under the mutex the delivery
+          // thread waits upon thus the wake-up cannot be lost
+          boost::atomic_thread_fence(boost::memory_order_seq_cst);
+          if (!mWakePending.load(boost::memory_order_relaxed)) {
+            boost::lock_guard<boost::mutex> lock(mWakeMutex);
+            mWakePending.store(true);
+            mWakeCondition.notify_one();
+          }
+        }
 
-    //-------------------------------------------------------------------------
-    void ILogger::installTelnetLogger(
-                                      WORD listenPort,                             // what port to bind to on 0.0.0.0:port to listen for incoming telnet sessions
-                                      ULONG maxSecondsWaitForSocketToBeAvailable,  // since the port might still be in use for a period of time between runs (TCP timeout), how long to wait for the port to come alive (recommend 60)
-                                      bool colorizeOutput
-                                      )
-    {
-      services::ILogger::installTelnetLogger(listenPort, maxSecondsWaitForSocketToBeAvailable, colorizeOutput);
-    }
+        //---------------------------------------------------------------------
+        ULONG deliver(
+                      AsyncLogBuffer &buffer,
+                      ILoggerDelegatePtr delegate
+                      )
+        {
+          AsyncLogBuffer::Entry entry;
 
-    //-------------------------------------------------------------------------
-    void ILogger::installOutgoingTelnetLogger(
-                                              const char *serverToConnect,
-                                              bool colorizeOutput,
-                                              const char *stringToSendUponConnection
-                                              )
-    {
-      services::ILogger::installOutgoingTelnetLogger(serverToConnect, colorizeOutput, stringToSendUponConnection);
-    }
+          ULONG total = 0;
+          while (buffer.pop(entry)) {
+            ++total;
+            if (!delegate) continue;
 
-    //-------------------------------------------------------------------------
-    void ILogger::installDebuggerLogger()
-    {
-      services::ILogger::installDebuggerLogger();
-    }
+            delegate->onLog(
+                            entry.mSubsystemID,
+                            entry.mSubsystemName,
+                            entry.mSeverity,
+                            entry.mLevel,
+                            entry.mMessage.c_str(),
+                            entry.mFunction,
+                            entry.mFilePath,
+                            entry.mLineNumber
+                            );
+            mDelivered.fetch_add(1, boost::memory_order_relaxed);
+          }
+          return total;
+        }
 
-    //-------------------------------------------------------------------------
-    void ILogger::installCustomLogger(ILoggerDelegatePtr delegate)
-    {
-      internal::CustomLoggerPtr logger = internal::CustomLogger::singleton();
-      if (!logger) return;
-      logger->installLogger(delegate);
-    }
+        //---------------------------------------------------------------------
+        void drainAsync()
+        {
+          mAsync.store(false);
 
-    //-------------------------------------------------------------------------
-    bool ILogger::isTelnetLoggerListening()
-    {
-      return services::ILogger::isTelnetLoggerListening();
-    }
+          // producers that already saw async mode finish pushing first
+          while (0 != mQueueing.load()) {
+            boost::this_thread::yield();
+          }
 
-    //-------------------------------------------------------------------------
-    bool ILogger::isTelnetLoggerConnected()
-    {
-      return services::ILogger::isTelnetLoggerConnected();
-    }
+          stopDeliveryThread();
 
-    //-------------------------------------------------------------------------
-    bool ILogger::isOutgoingTelnetLoggerConnected()
-    {
-      return services::ILogger::isOutgoingTelnetLoggerConnected();
-    }
+          AsyncLogBufferPtr buffer;
+          ILoggerDelegatePtr delegate;
+          {
+            AutoRecursiveLock lock(mLock);
+            buffer = mBuffer;
+            delegate = mDelegate;
+          }
 
-    //-------------------------------------------------------------------------
-    void ILogger::uninstallStdOutLogger()
-    {
-      services::ILogger::uninstallStdOutLogger();
-    }
-      
-    //-------------------------------------------------------------------------
-    void ILogger::uninstallFileLogger()
-    {
-      services::ILogger::uninstallFileLogger();
-    }
+          // no other producer or consumer remains thus the rest is delivered here
+          if (buffer) deliver(*buffer, delegate);
+        }
 
-    //-------------------------------------------------------------------------
-    void ILogger::uninstallTelnetLogger()
-    {
-      services::ILogger::uninstallTelnetLogger();
-    }
+        //---------------------------------------------------------------------
+        void startDeliveryThread()
+        {
+          AutoRecursiveLock lock(mLock);
+          if (mThread) return;
 
-    //-------------------------------------------------------------------------
-    void ILogger::uninstallOutgoingTelnetLogger()
-    {
-      services::ILogger::uninstallOutgoingTelnetLogger();
-    }
+          mRawBuffer = mBuffer.get();
 
-    //-------------------------------------------------------------------------
-    void ILogger::uninstallDebuggerLogger()
-    {
-      services::ILogger::uninstallDebuggerLogger();
-    }
+          {
+            boost::lock_guard<boost::mutex> wakeLock(mWakeMutex);
+            mShouldShutdown = false;
+            mWakePending.store(false);
+          }
+          mThread = ThreadPtr(new boost::thread(boost::ref(*this)));
+        }
 
-    namespace application
-    {
-      //-----------------------------------------------------------------------
-      static PTRNUMBER getGUISubsystem()
-      {
-        Subsystem *subsystem = &(ZS_GET_SUBSYSTEM());
-        return (PTRNUMBER)(subsystem);
-      }
-    }
+        //---------------------------------------------------------------------
+        void stopDeliveryThread()
+        {
+          ThreadPtr thread;
+          {
+            AutoRecursiveLock lock(mLock);
+            thread = mThread;
+            mThread.reset();
+          }
 
-    //-------------------------------------------------------------------------
-    PTRNUMBER ILogger::getApplicationSubsystemID()
-    {
-      return application::getGUISubsystem();
-    }
+          if (!thread) return;
 
-    //-------------------------------------------------------------------------
-    ILogger::Level ILogger::getLogLevel(SubsystemID subsystemUniqueID)
-    {
-      return internal::levelToLevel(((Subsystem *)subsystemUniqueID)->getOutputLevel());
-    }
+          {
+            boost::lock_guard<boost::mutex> wakeLock(mWakeMutex);
+            mShouldShutdown = true;
+            mWakeCondition.notify_one();
+          }
 
-    //---------------------------------------------------------------------------
-    void ILogger::setLogLevel(ILogger::Level level)
-    {
-      services::ILogger::setLogLevel(internal::levelToLevel(level));
-    }
+          thread->join();
+        }
 
-    //-------------------------------------------------------------------------
-    void ILogger::setLogLevel(
-                              PTRNUMBER subsystemUniqueID,
-                              ILogger::Level level
-                              )
-    {
-      ((Subsystem *)subsystemUniqueID)->setOutputLevel(internal::levelToLevel(level));
-    }
+      protected:
+        typedef zsLib::ThreadPtr ThreadPtr;
 
-    //-------------------------------------------------------------------------
-    void ILogger::setLogLevel(
-                              const char *subsystemName,
-                              ILogger::Level level
-                              )
-    {
-      services::ILogger::setLogLevel(subsystemName, internal::levelToLevel(level));
+        struct QueueingScope
+        {
+          QueueingScope(boost::atomic<ULONG> &counter) : mCounter(counter) {mCounter.fetch_add(1);}
+          ~QueueingScope() {mCounter.fetch_sub(1);}
+
+          boost::atomic<ULONG> &mCounter;
+        };
+
+        mutable RecursiveLock mLock;
+        SubsystemMap       mSubsystems;
+        ILoggerDelegatePtr mDelegate;
+
+        boost::atomic<bool> mAsync;
+        AsyncLogBufferPtr mBuffer;
+        AsyncLogBuffer *mRawBuffer;
+        ThreadPtr mThread;
+
+        boost::mutex mWakeMutex;
+        boost::condition_variable mWakeCondition;
+        bool mShouldShutdown;
+        boost::atomic<bool> mWakePending;       // only set while holding mWakeMutex
+        boost::atomic<ULONG> mQueueing;         // producers currently inside onLog()
+
+        boost::atomic<ULONG> mQueued;
+        boost::atomic<ULONG> mDelivered;
+        boost::atomic<ULONG> mDropped;
+        boost::atomic<ULONG> mOverflows;
+        boost::atomic<ULONG> mHighWaterMark;
+        boost::atomic<bool> mOverflowing;
+      };
+
+
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark BinaryFileLogger
+      #pragma mark
+
+      ZS_DECLARE_CLASS_PTR(BinaryFileLogger)
+
+      class BinaryFileLogger : public zsLib::ILogDelegate
+      {
+      public:
+        typedef zsLib::PTRNUMBER SubsystemID;
+        typedef zsLib::Subsystem Subsystem;
+        typedef zsLib::ULONGLONG ULONGLONG;
+        typedef std::map<SubsystemID, ULONG> SubsystemIndexMap;
+        typedef std::map<String, ULONG> StringIDMap;
+        typedef std::map<const char *, ULONG> StaticStringIDMap;
+
+        enum Sizes
+        {
+          Size_FlushBuffer = 64 * 1024,
+          Size_MaxInternedStrings = 4096,
+        };
+
+      protected:
+        //---------------------------------------------------------------------
+        BinaryFileLogger() :
+          mFile(NULL),
+          mNextSubsystemIndex(0),
+          mNextStringID(1)
+        {}
+
+      public:
+        //---------------------------------------------------------------------
+        ~BinaryFileLogger()
+        {
+          close();
+        }
+
+        //---------------------------------------------------------------------
+        static void install(const char *fileName)
+        {
+          ZS_THROW_INVALID_ARGUMENT_IF(!fileName)
+
+          uninstall();
+
+          BinaryFileLoggerPtr pThis(new BinaryFileLogger);
+          if (!pThis->open(fileName)) {
+            ZS_LOG_ERROR(Basic, slog("unable to open binary log file") + ZS_PARAM("file", fileName))
+            return;
+          }
+
+          {
+            AutoRecursiveLock lock(installLock());
+            installed() = pThis;
+          }
+
+          Log::addListener(pThis);
+        }
+
+        //---------------------------------------------------------------------
+        static void uninstall()
+        {
+          BinaryFileLoggerPtr logger;
+
+          {
+            AutoRecursiveLock lock(installLock());
+            logger = installed();
+            installed().reset();
+          }
+
+          if (!logger) return;
+
+          Log::removeListener(logger);
+          logger->close();
+        }
+
+        //---------------------------------------------------------------------
+        virtual void onNewSubsystem(Subsystem &inSubsystem)
+        {
+          // subsystems are written upon their first log message
+        }
+
+        //---------------------------------------------------------------------
+        virtual void onLog(
+                           const Subsystem &inSubsystem,
+                           zsLib::Log::Severity inSeverity,
+                           zsLib::Log::Level inLevel,
+                           CSTR inFunction,
+                           CSTR inFilePath,
+                           ULONG inLineNumber,
+                           const Log::Params &params
+                           )
+        {
+          ULONGLONG offset = microsecondsSinceEpoch(zsLib::now());
+
+          AutoLock lock(mLock);
+          if (!mFile) return;
+
+          ULONG subsystemIndex = getSubsystemIndex(inSubsystem);
+          ULONG functionID = getStaticStringID(inFunction);
+          ULONG filePathID = getStaticStringID(inFilePath);
+
+          // the event is serialized in a single pass over the parameters into
+          // a scratch buffer as any newly interned strings must be defined
+          // (into the main buffer) before the event referencing them
+          mEvent.clear();
+          mEvent.push_back(static_cast<char>(BinaryLogFormat::RecordType_Event));
+          BinaryLogFormat::appendVarInt(mEvent, (offset > mBaseTime ? offset - mBaseTime : 0));
+          BinaryLogFormat::appendVarInt(mEvent, subsystemIndex);
+          mEvent.push_back(static_cast<char>((((int)severityToSeverity(inSeverity)) << 4) | ((int)levelToLevel(inLevel))));
+          appendStringRef(params.message());
+          BinaryLogFormat::appendVarInt(mEvent, functionID);
+          BinaryLogFormat::appendVarInt(mEvent, filePathID);
+          BinaryLogFormat::appendVarInt(mEvent, inLineNumber);
+
+          ElementPtr objectEl = params.object();
+          if (objectEl) {
+            appendStringRef(objectEl->getValue());
+          } else {
+            BinaryLogFormat::appendVarInt(mEvent, 0);
+          }
+          appendGroup(objectEl);
+          appendGroup(params.params());
+
+          mBuffer.append(mEvent);
+
+          if ((mBuffer.size() > Size_FlushBuffer) ||
+              (inSeverity >= Log::Error)) {
+            flush();
+          }
+        }
+
+        //---------------------------------------------------------------------
+        static Log::Params slog(const char *message)
+        {
+          return Log::Params(message, "core::BinaryFileLogger");
+        }
+
+      protected:
+        //---------------------------------------------------------------------
+        static RecursiveLock &installLock()
+        {
+          static RecursiveLock lock;
+          return lock;
+        }
+
+        //---------------------------------------------------------------------
+        static BinaryFileLoggerPtr &installed()
+        {
+          static BinaryFileLoggerPtr logger;
+          return logger;
+        }
+
+        //---------------------------------------------------------------------
+        static ULONGLONG microsecondsSinceEpoch(const Time &time)
+        {
+          static const Time epoch(boost::gregorian::date(1970, 1, 1));
+          return static_cast<ULONGLONG>((time - epoch).total_microseconds());
+        }
+
+        //---------------------------------------------------------------------
+        bool open(const char *fileName)
+        {
+          AutoLock lock(mLock);
+
+          mFile = fopen(fileName, "wb");
+          if (!mFile) return false;
+
+          mBaseTime = microsecondsSinceEpoch(zsLib::now());
+
+          mBuffer.append(OPENPEER_CORE_BINARY_LOG_MAGIC, OPENPEER_CORE_BINARY_LOG_MAGIC_LENGTH);
+          BinaryLogFormat::appendVarInt(mBuffer, mBaseTime);
+          flush();
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        void close()
+        {
+          AutoLock lock(mLock);
+          if (!mFile) return;
+
+          flush();
+          fclose(mFile);
+          mFile = NULL;
+        }
+
+        //---------------------------------------------------------------------
+        void flush()
+        {
+          if (mBuffer.empty()) return;
+          fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+          fflush(mFile);
+          mBuffer.clear();
+        }
+
+        //---------------------------------------------------------------------
+        ULONG getSubsystemIndex(const Subsystem &inSubsystem)
+        {
+          SubsystemIndexMap::iterator found = mSubsystems.find((SubsystemID)(&inSubsystem));
+          if (found != mSubsystems.end()) return (*found).second;
+
+          ULONG index = mNextSubsystemIndex;
+          ++mNextSubsystemIndex;
+          mSubsystems[(SubsystemID)(&inSubsystem)] = index;
+
+          const char *name = inSubsystem.getName();
+          mBuffer.push_back(static_cast<char>(BinaryLogFormat::RecordType_Subsystem));
+          BinaryLogFormat::appendVarInt(mBuffer, index);
+          BinaryLogFormat::appendString(mBuffer, name, strlen(name));
+          return index;
+        }
+
+        //---------------------------------------------------------------------
+        ULONG defineString(const char *value, size_t length)
+        {
+          ULONG id = mNextStringID;
+          ++mNextStringID;
+
+          mBuffer.push_back(static_cast<char>(BinaryLogFormat::RecordType_String));
+          BinaryLogFormat::appendVarInt(mBuffer, id);
+          BinaryLogFormat::appendString(mBuffer, value, length);
+          return id;
+        }
+
+        //---------------------------------------------------------------------
+        void appendStringRef(const String &value)
+        {
+          // only call site constants (messages and value names) are worth
+          // interning, the table is capped so that messages containing
+          // dynamic text cannot grow it without bound
+          StringIDMap::iterator found = mStrings.find(value);
+          if (found != mStrings.end()) {
+            BinaryLogFormat::appendStringRef(mEvent, (*found).second);
+            return;
+          }
+
+          if (mStrings.size() < Size_MaxInternedStrings) {
+            ULONG id = defineString(value.c_str(), value.length());
+            mStrings[value] = id;
+            BinaryLogFormat::appendStringRef(mEvent, id);
+            return;
+          }
+
+          BinaryLogFormat::appendInlineStringRef(mEvent, value.c_str(), value.length());
+        }
+
+        //---------------------------------------------------------------------
+        ULONG getStaticStringID(const char *value)
+        {
+          // function names and file paths are compiler provided literals
+          if (!value) return 0;
+
+          StaticStringIDMap::iterator found = mStaticStrings.find(value);
+          if (found != mStaticStrings.end()) return (*found).second;
+
+          ULONG id = defineString(value, strlen(value));
+          mStaticStrings[value] = id;
+          return id;
+        }
+
+        //---------------------------------------------------------------------
+        static bool isInteger(const String &value)
+        {
+          if ((value.isEmpty()) || (value.length() > 18)) return false;
+
+          String::size_type pos = ('-' == value[0] ? 1 : 0);
+          if (pos >= value.length()) return false;
+          if (('0' == value[pos]) && (value.length() > pos + 1)) return false;  // leading zeros must survive decoding
+
+          for (; pos < value.length(); ++pos) {
+            if ((value[pos] < '0') || (value[pos] > '9')) return false;
+          }
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        void appendGroup(ElementPtr parentEl)
+        {
+          if (parentEl) {
+            for (ElementPtr childEl = parentEl->getFirstChildElement(); childEl; childEl = childEl->getNextSiblingElement()) {
+              appendStringRef(childEl->getValue());
+
+              if (childEl->getFirstChildElement()) {
+                mEvent.push_back(static_cast<char>(BinaryLogFormat::ValueType_Group));
+                appendGroup(childEl);
+                continue;
+              }
+
+              String value = childEl->getTextDecoded();
+              if (value.isEmpty()) {
+                mEvent.push_back(static_cast<char>(BinaryLogFormat::ValueType_Empty));
+                continue;
+              }
+
+              if (isInteger(value)) {
+                mEvent.push_back(static_cast<char>(BinaryLogFormat::ValueType_Integer));
+                BinaryLogFormat::appendSignedVarInt(mEvent, zsLib::Numeric<zsLib::LONGLONG>(value));
+                continue;
+              }
+
+              mEvent.push_back(static_cast<char>(BinaryLogFormat::ValueType_String));
+              BinaryLogFormat::appendString(mEvent, value.c_str(), value.length());
+            }
+          }
+
+          // end of group
+          BinaryLogFormat::appendVarInt(mEvent, 0);
+        }
+
+      protected:
+        mutable Lock mLock;
+
+        FILE *mFile;
+        ULONGLONG mBaseTime;
+        std::string mBuffer;
+        std::string mEvent;
+
+        SubsystemIndexMap mSubsystems;
+        ULONG mNextSubsystemIndex;
+
+        StringIDMap mStrings;
+        StaticStringIDMap mStaticStrings;
+        ULONG mNextStringID;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark RotatingFileLogger
+      #pragma mark
+
+      ZS_DECLARE_CLASS_PTR(RotatingFileLogger)
+
+      class RotatingFileLogger : public zsLib::ILogDelegate
+      {
+      public:
+        typedef zsLib::Subsystem Subsystem;
+        typedef zsLib::ThreadPtr ThreadPtr;
+
+        struct Segment
+        {
+          String mFileName;
+          time_t mCreated;
+          bool mCompressed;
+
+          String mStamp;   // sort key (file name time stamp)
+          ULONG mID;
+        };
+
+        typedef std::list<Segment> SegmentList;
+
+        enum Sizes
+        {
+          Size_Buffer = 256 * 1024,
+          Size_BufferAlignment = 4096,
+          Size_CompressChunk = 64 * 1024,
+        };
+
+        enum Timeouts
+        {
+          Milliseconds_FlushInterval = 1000,
+          Seconds_RotateRetry = 30,
+        };
+
+      protected:
+        //---------------------------------------------------------------------
+        RotatingFileLogger(
+                           const char *fileName,
+                           size_t maxFileSizeInBytes,
+                           ULONG maxFiles,
+                           ULONG maxAgeInSeconds,
+                           bool compressRotatedFiles
+                           ) :
+          mFileName(fileName),
+          mMaxFileSize(maxFileSizeInBytes),
+          mMaxFiles(maxFiles),
+          mMaxAgeInSeconds(maxAgeInSeconds),
+          mCompress(compressRotatedFiles),
+          mFile(NULL),
+          mFileSize(0),
+          mFileCreated(0),
+          mRawBuffer(new char[Size_Buffer + Size_BufferAlignment]),
+          mBuffer(NULL),
+          mBufferUsed(0),
+          mNextSegmentID(1),
+          mRotatePending(false),
+          mRotateRetryAfter(0),
+          mHasRenamedSegment(false),
+          mShouldShutdown(false),
+          mWakePending(false)
+        {
+          // align the write buffer to a page boundary
+          zsLib::PTRNUMBER address = reinterpret_cast<zsLib::PTRNUMBER>(mRawBuffer.get());
+          address = (address + (Size_BufferAlignment - 1)) & ~(static_cast<zsLib::PTRNUMBER>(Size_BufferAlignment - 1));
+          mBuffer = reinterpret_cast<char *>(address);
+
+#ifdef OPENPEER_CORE_ROTATING_LOGGER_NO_COMPRESSION
+          mCompress = false;
+#endif //OPENPEER_CORE_ROTATING_LOGGER_NO_COMPRESSION
+        }
+
+      public:
+        //---------------------------------------------------------------------
+        ~RotatingFileLogger()
+        {
+          stop();
+        }
+
+        //---------------------------------------------------------------------
+        static void install(
+                            const char *fileName,
+                            size_t maxFileSizeInBytes,
+                            ULONG maxFiles,
+                            ULONG maxAgeInSeconds,
+                            bool compressRotatedFiles
+                            )
+        {
+          ZS_THROW_INVALID_ARGUMENT_IF(!fileName)
+
+          uninstall();
+
+          RotatingFileLoggerPtr pThis(new RotatingFileLogger(fileName, maxFileSizeInBytes, maxFiles, maxAgeInSeconds, compressRotatedFiles));
+          if (!pThis->start()) {
+            ZS_LOG_ERROR(Basic, slog("unable to open rotating log file") + ZS_PARAM("file", fileName))
+            return;
+          }
+
+          {
+            AutoRecursiveLock lock(installLock());
+            installed() = pThis;
+          }
+
+          Log::addListener(pThis);
+        }
+
+        //---------------------------------------------------------------------
+        static void uninstall()
+        {
+          RotatingFileLoggerPtr logger;
+
+          {
+            AutoRecursiveLock lock(installLock());
+            logger = installed();
+            installed().reset();
+          }
+
+          if (!logger) return;
+
+          Log::removeListener(logger);
+          logger->stop();
+        }
+
+        //---------------------------------------------------------------------
+        virtual void onNewSubsystem(Subsystem &inSubsystem)
+        {
+        }
+
+        //---------------------------------------------------------------------
+        virtual void onLog(
+                           const Subsystem &inSubsystem,
+                           zsLib::Log::Severity inSeverity,
+                           zsLib::Log::Level inLevel,
+                           CSTR inFunction,
+                           CSTR inFilePath,
+                           ULONG inLineNumber,
+                           const Log::Params &params
+                           )
+        {
+          // format outside of the lock
+          String line = boost::posix_time::to_simple_string(zsLib::now());
+          line += " : ";
+          line += ILogger::toString(severityToSeverity(inSeverity));
+          line += " : ";
+          line += ILogger::toString(levelToLevel(inLevel));
+          line += " : ";
+          line += inSubsystem.getName();
+          line += " : ";
+          line += params.message();
+
+          ElementPtr objectEl = params.object();
+          if (objectEl) {
+            line += " : ";
+            line += objectEl->getValue();
+            appendGroup(line, objectEl);
+          }
+
+          ElementPtr paramsEl = params.params();
+          if ((paramsEl) &&
+              (paramsEl->getFirstChildElement())) {
+            line += " :";
+            appendGroup(line, paramsEl);
+          }
+
+          line += " @";
+          if (inFunction) line += inFunction;
+          line += "(";
+          if (inFilePath) line += inFilePath;
+          line += ":" + string(inLineNumber) + ")\n";
+
+          bool wake = false;
+
+          {
+            AutoLock lock(mLock);
+            if (!mFile) return;
+
+            append(line.c_str(), line.length());
+
+            if (inSeverity >= Log::Error) {
+              flush();
+            }
+
+            // rotation is performed by the background thread, output keeps
+            // going into the current file until the new file is ready
+            if ((0 != mMaxFileSize) &&
+                (!mRotatePending) &&
+                (mFileSize + mBufferUsed >= mMaxFileSize)) {
+              mRotatePending = true;
+              wake = true;
+            }
+          }
+
+          if (wake) wakeUp();
+        }
+
+        //---------------------------------------------------------------------
+        void operator()()
+        {
+          bool shouldShutdown = false;
+
+          do {
+            {
+              boost::unique_lock<boost::mutex> lock(mWakeMutex);
+              if ((!mShouldShutdown) &&
+                  (!mWakePending)) {
+                mWakeCondition.timed_wait(lock, boost::posix_time::milliseconds(Milliseconds_FlushInterval));
+              }
+              mWakePending = false;
+              shouldShutdown = mShouldShutdown;
+            }
+
+            bool rotatePending = false;
+
+            {
+              AutoLock lock(mLock);
+              if (mFile) {
+                flush();
+
+                if ((0 != mMaxAgeInSeconds) &&
+                    (0 != mFileSize) &&
+                    (time(NULL) - mFileCreated >= static_cast<time_t>(mMaxAgeInSeconds))) {
+                  mRotatePending = true;
+                }
+                rotatePending = ((mRotatePending) &&
+                                 ((0 == mRotateRetryAfter) || (time(NULL) >= mRotateRetryAfter)));
+              }
+            }
+
+            if ((rotatePending) ||
+                (mHasRenamedSegment)) {
+              rotate();
+            }
+
+            compressSegments();
+            enforceBudgets();
+          } while (!shouldShutdown);
+        }
+
+        //---------------------------------------------------------------------
+        static Log::Params slog(const char *message)
+        {
+          return Log::Params(message, "core::RotatingFileLogger");
+        }
+
+      protected:
+        //---------------------------------------------------------------------
+        static RecursiveLock &installLock()
+        {
+          static RecursiveLock lock;
+          return lock;
+        }
+
+        //---------------------------------------------------------------------
+        static RotatingFileLoggerPtr &installed()
+        {
+          static RotatingFileLoggerPtr logger;
+          return logger;
+        }
+
+        //---------------------------------------------------------------------
+        static void appendGroup(String &output, ElementPtr parentEl)
+        {
+          for (ElementPtr childEl = parentEl->getFirstChildElement(); childEl; childEl = childEl->getNextSiblingElement()) {
+            output += " ";
+            output += childEl->getValue();
+            output += "=";
+            if (childEl->getFirstChildElement()) {
+              output += "{";
+              appendGroup(output, childEl);
+              output += " }";
+              continue;
+            }
+            output += childEl->getTextDecoded();
+          }
+        }
+
+        //---------------------------------------------------------------------
+        bool start()
+        {
+          {
+            AutoLock lock(mLock);
+
+            // segments left behind by previous runs count towards the budgets
+            findExistingSegments();
+            if (!openFile()) return false;
+          }
+
+          mThread = ThreadPtr(new boost::thread(boost::ref(*this)));
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        void stop()
+        {
+          ThreadPtr thread;
+          {
+            AutoLock lock(mLock);
+            thread = mThread;
+            mThread.reset();
+          }
+
+          if (thread) {
+            {
+              boost::lock_guard<boost::mutex> wakeLock(mWakeMutex);
+              mShouldShutdown = true;
+              mWakeCondition.notify_one();
+            }
+
+            // the thread flushes and compresses one last time before exiting
+            thread->join();
+          }
+
+          AutoLock lock(mLock);
+          if (!mFile) return;
+
+          flush();
+          fclose(mFile);
+          mFile = NULL;
+        }
+
+        //---------------------------------------------------------------------
+        void wakeUp()
+        {
+          boost::lock_guard<boost::mutex> wakeLock(mWakeMutex);
+          mWakePending = true;
+          mWakeCondition.notify_one();
+        }
+
+        //---------------------------------------------------------------------
+        bool openFile()
+        {
+          mFile = fopen(mFileName.c_str(), "ab");
+          if (!mFile) return false;
+
+          // writes are already buffered within the aligned buffer
+          setvbuf(mFile, NULL, _IONBF, 0);
+
+          fseek(mFile, 0, SEEK_END);
+          long size = ftell(mFile);
+          mFileSize = (size > 0 ? static_cast<size_t>(size) : 0);
+          mFileCreated = time(NULL);
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        void append(const char *data, size_t length)
+        {
+          while (length > 0) {
+            if (Size_Buffer == mBufferUsed) flush();
+
+            size_t available = Size_Buffer - mBufferUsed;
+            size_t total = (length > available ? available : length);
+
+            memcpy(&(mBuffer[mBufferUsed]), data, total);
+            mBufferUsed += total;
+            data += total;
+            length -= total;
+          }
+        }
+
+        //---------------------------------------------------------------------
+        void flush()
+        {
+          if (0 == mBufferUsed) return;
+          if (!mFile) return;
+
+          size_t written = fwrite(mBuffer, 1, mBufferUsed, mFile);
+          mFileSize += written;
+          mBufferUsed = 0;
+        }
+
+        //---------------------------------------------------------------------
+        static bool splitFileName(
+                                  const String &fileName,
+                                  String &outDirectory,
+                                  String &outBaseName
+                                  )
+        {
+          String::size_type pos = fileName.find_last_of("/\\");
+          if (String::npos == pos) {
+            outDirectory = ".";
+            outBaseName = fileName;
+          } else {
+            outDirectory = fileName.substr(0, pos);
+            outBaseName = fileName.substr(pos + 1);
+          }
+          if (outDirectory.isEmpty()) outDirectory = "/";
+          return !outBaseName.isEmpty();
+        }
+
+        //---------------------------------------------------------------------
+        static bool isSegmentOrder(const Segment &segment1, const Segment &segment2)
+        {
+          if (segment1.mStamp != segment2.mStamp) return segment1.mStamp < segment2.mStamp;
+          return segment1.mID < segment2.mID;
+        }
+
+        //---------------------------------------------------------------------
+        // parses "<base>.<YYYYMMDD-HHMMSS>.<id>[.gz]"
+        bool parseSegmentName(
+                              const String &baseName,
+                              const String &entryName,
+                              Segment &outSegment
+                              ) const
+        {
+          enum { StampLength = 15 };
+
+          String prefix = baseName + ".";
+          if (0 != entryName.compare(0, prefix.length(), prefix)) return false;
+
+          String remaining = entryName.substr(prefix.length());
+          if (remaining.length() < StampLength + 2) return false;
+
+          for (size_t index = 0; index < StampLength; ++index) {
+            char ch = remaining[index];
+            if (8 == index) {
+              if ('-' != ch) return false;
+              continue;
+            }
+            if ((ch < '0') || (ch > '9')) return false;
+          }
+          if ('.' != remaining[StampLength]) return false;
+
+          outSegment.mStamp = remaining.substr(0, StampLength);
+          remaining = remaining.substr(StampLength + 1);
+
+          outSegment.mCompressed = false;
+          if ((remaining.length() > 3) &&
+              (0 == remaining.compare(remaining.length() - 3, 3, ".gz"))) {
+            outSegment.mCompressed = true;
+            remaining = remaining.substr(0, remaining.length() - 3);
+          }
+
+          if ((remaining.isEmpty()) || (remaining.length() > 9)) return false;
+          for (String::size_type index = 0; index < remaining.length(); ++index) {
+            if ((remaining[index] < '0') || (remaining[index] > '9')) return false;
+          }
+
+          outSegment.mID = static_cast<ULONG>(strtoul(remaining.c_str(), NULL, 10));
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        void findExistingSegments()
+        {
+#ifndef _WIN32
+          String directory;
+          String baseName;
+          if (!splitFileName(mFileName, directory, baseName)) return;
+
+          DIR *dir = opendir(directory.c_str());
+          if (!dir) return;
+
+          while (struct dirent *entry = readdir(dir)) {
+            Segment segment;
+            if (!parseSegmentName(baseName, String(entry->d_name), segment)) continue;
+
+            String path = (mFileName.length() > baseName.length() ? mFileName.substr(0, mFileName.length() - baseName.length()) : String());
+            segment.mFileName = path + entry->d_name;
+
+            struct stat info;
+            memset(&info, 0, sizeof(info));
+            if (0 != stat(segment.mFileName.c_str(), &info)) continue;
+            if (!S_ISREG(info.st_mode)) continue;
+
+            // the segment was last written just before being rotated
+            segment.mCreated = info.st_mtime;
+
+            if (segment.mID >= mNextSegmentID) mNextSegmentID = segment.mID + 1;
+            mSegments.push_back(segment);
+          }
+
+          closedir(dir);
+
+          mSegments.sort(isSegmentOrder);
+
+          if (mSegments.size() > 0) {
+            ZS_LOG_DEBUG(slog("found existing rotated log segments") + ZS_PARAM("file", mFileName) + ZS_PARAM("total", mSegments.size()))
+          }
+#endif //_WIN32
+        }
+
+        //---------------------------------------------------------------------
+        // called from the background thread only
+        void rotate()
+        {
+          if (!mHasRenamedSegment) {
+            char stamp[32] = {};
+            time_t now = time(NULL);
+            struct tm nowTM;
+#ifdef _WIN32
+            gmtime_s(&nowTM, &now);
+#else
+            gmtime_r(&now, &nowTM);
+#endif //_WIN32
+            strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &nowTM);
+
+            Segment segment;
+            segment.mStamp = stamp;
+            segment.mID = mNextSegmentID;
+            segment.mFileName = mFileName + "." + stamp + "." + string(segment.mID);
+            segment.mCreated = now;
+            segment.mCompressed = false;
+            ++mNextSegmentID;
+
+            // the open file keeps receiving output after being renamed thus
+            // nothing is lost while the new file is opened
+            if (0 != rename(mFileName.c_str(), segment.mFileName.c_str())) {
+              // keep appending to the existing file rather than losing output;
+              // the rotation stays pending (so writers do not re-request it
+              // on every line) and is retried after a back off
+              AutoLock lock(mLock);
+              mRotateRetryAfter = now + Seconds_RotateRetry;
+              return;
+            }
+
+            mRenamedSegment = segment;
+            mHasRenamedSegment = true;
+          }
+
+          FILE *file = fopen(mFileName.c_str(), "ab");
+          if (!file) {
+            // output continues into the renamed segment, retried upon the
+            // next pass of the background thread
+            return;
+          }
+
+          // writes are already buffered within the aligned buffer
+          setvbuf(file, NULL, _IONBF, 0);
+
+          FILE *oldFile = NULL;
+
+          {
+            AutoLock lock(mLock);
+
+            // buffered output belongs to the renamed segment
+            flush();
+
+            oldFile = mFile;
+            mFile = file;
+            mFileSize = 0;
+            mFileCreated = time(NULL);
+            mRotatePending = false;
+            mRotateRetryAfter = 0;
+
+            mSegments.push_back(mRenamedSegment);
+          }
+
+          mHasRenamedSegment = false;
+
+          if (oldFile) fclose(oldFile);
+        }
+
+        //---------------------------------------------------------------------
+        void compressSegments()
+        {
+          if (!mCompress) return;
+
+          while (true) {
+            String fileName;
+
+            {
+              AutoLock lock(mLock);
+              for (SegmentList::iterator iter = mSegments.begin(); iter != mSegments.end(); ++iter) {
+                if ((*iter).mCompressed) continue;
+                fileName = (*iter).mFileName;
+                break;
+              }
+            }
+
+            if (fileName.isEmpty()) return;
+
+            String compressedFileName = fileName + ".gz";
+            bool compressed = compressFile(fileName, compressedFileName);
+
+            AutoLock lock(mLock);
+            for (SegmentList::iterator iter = mSegments.begin(); iter != mSegments.end(); ++iter) {
+              if ((*iter).mFileName != fileName) continue;
+
+              // on failure the segment stays uncompressed (but is not retried)
+              (*iter).mCompressed = true;
+              if (compressed) (*iter).mFileName = compressedFileName;
+              break;
+            }
+          }
+        }
+
+        //---------------------------------------------------------------------
+        static bool compressFile(
+                                 const String &source,
+                                 const String &destination
+                                 )
+        {
+#ifndef OPENPEER_CORE_ROTATING_LOGGER_NO_COMPRESSION
+          FILE *input = fopen(source.c_str(), "rb");
+          if (!input) return false;
+
+          gzFile output = gzopen(destination.c_str(), "wb6");
+          if (!output) {
+            fclose(input);
+            return false;
+          }
+
+          boost::scoped_array<char> chunk(new char[Size_CompressChunk]);
+          bool failed = false;
+
+          while (true) {
+            size_t read = fread(chunk.get(), 1, Size_CompressChunk, input);
+            if (0 == read) break;
+
+            if (gzwrite(output, chunk.get(), static_cast<unsigned>(read)) != static_cast<int>(read)) {
+              failed = true;
+              break;
+            }
+          }
+
+          if (ferror(input)) failed = true;
+
+          fclose(input);
+          if (Z_OK != gzclose(output)) failed = true;
+
+          if (failed) {
+            remove(destination.c_str());
+            return false;
+          }
+
+          remove(source.c_str());
+          return true;
+#else
+          return false;
+#endif //OPENPEER_CORE_ROTATING_LOGGER_NO_COMPRESSION
+        }
+
+        //---------------------------------------------------------------------
+        void enforceBudgets()
+        {
+          typedef std::list<String> FileNameList;
+          FileNameList removeFiles;
+
+          {
+            AutoLock lock(mLock);
+
+            time_t now = time(NULL);
+
+            while (mSegments.size() > 0) {
+              const Segment &oldest = mSegments.front();
+
+              bool tooMany = ((0 != mMaxFiles) && (mSegments.size() > mMaxFiles));
+              bool tooOld = ((0 != mMaxAgeInSeconds) && (now - oldest.mCreated > static_cast<time_t>(mMaxAgeInSeconds)));
+              if ((!tooMany) && (!tooOld)) break;
+
+              // a segment still being compressed is removed once compressed
+              if ((mCompress) && (!oldest.mCompressed)) break;
+
+              removeFiles.push_back(oldest.mFileName);
+              mSegments.pop_front();
+            }
+          }
+
+          for (FileNameList::iterator iter = removeFiles.begin(); iter != removeFiles.end(); ++iter) {
+            remove((*iter).c_str());
+          }
+        }
+
+      protected:
+        mutable Lock mLock;
+
+        String mFileName;
+        size_t mMaxFileSize;
+        ULONG mMaxFiles;
+        ULONG mMaxAgeInSeconds;
+        bool mCompress;
+
+        FILE *mFile;
+        size_t mFileSize;
+        time_t mFileCreated;
+
+        boost::scoped_array<char> mRawBuffer;
+        char *mBuffer;
+        size_t mBufferUsed;
+
+        SegmentList mSegments;
+        ULONG mNextSegmentID;
+
+        bool mRotatePending;
+        time_t mRotateRetryAfter;   // a failed rotation is not retried before this time
+
+        // only accessed by the background thread
+        Segment mRenamedSegment;
+        bool mHasRenamedSegment;
+
+        ThreadPtr mThread;
+
+        boost::mutex mWakeMutex;
+        boost::condition_variable mWakeCondition;
+        bool mShouldShutdown;
+        bool mWakePending;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark LogRateLimiter (helpers)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      static Lock &rateLimiterLock()
+      {
+        static Lock lock;
+        return lock;
+      }
+
+      //-----------------------------------------------------------------------
+      static LogRateLimiter::RuleMap &rateLimiterSubsystemRules()
+      {
+        static LogRateLimiter::RuleMap rules;
+        return rules;
+      }
+
+      //-----------------------------------------------------------------------
+      static LogRateLimiter::RuleMap &rateLimiterCallSiteRules()
+      {
+        static LogRateLimiter::RuleMap rules;
+        return rules;
+      }
+
+      //-----------------------------------------------------------------------
+      static boost::atomic<ULONG> &rateLimiterRulesVersion()
+      {
+        // call sites start at version 0 thus they resolve upon first use
+        static boost::atomic<ULONG> version(1);
+        return version;
+      }
+
+      //-----------------------------------------------------------------------
+      static void setRule(
+                          LogRateLimiter::RuleMap &rules,
+                          const char *name,
+                          const LogRateLimiter::Rule &rule
+                          )
+      {
+        ZS_THROW_INVALID_ARGUMENT_IF(!name)
+
+        AutoLock lock(rateLimiterLock());
+
+        if (rule.hasData()) {
+          rules[String(name)] = rule;
+        } else {
+          rules.erase(String(name));
+        }
+        rateLimiterRulesVersion().fetch_add(1, boost::memory_order_release);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark LogRateLimiter::Rule
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      LogRateLimiter::Rule::Rule() :
+        mMaxPerSecond(0),
+        mSampleOneInEvery(0)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      LogRateLimiter::Rule::Rule(
+                                 ULONG maxPerSecond,
+                                 ULONG sampleOneInEvery
+                                 ) :
+        mMaxPerSecond(maxPerSecond),
+        mSampleOneInEvery(sampleOneInEvery)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      bool LogRateLimiter::Rule::hasData() const
+      {
+        return ((0 != mMaxPerSecond) ||
+                (mSampleOneInEvery > 1));
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark LogRateLimiter::CallSite
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      LogRateLimiter::CallSite::CallSite(const char *name) :
+        mName(name),
+        mRulesVersion(0),
+        mMaxPerSecond(0),
+        mSampleOneInEvery(0),
+        mTotal(0),
+        mWindowStart(0),
+        mTotalInWindow(0),
+        mSuppressed(0)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark LogRateLimiter
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void LogRateLimiter::setSubsystemRule(
+                                            const char *subsystemName,
+                                            const Rule &rule
+                                            )
+      {
+        setRule(rateLimiterSubsystemRules(), subsystemName, rule);
+      }
+
+      //-----------------------------------------------------------------------
+      void LogRateLimiter::setCallSiteRule(
+                                           const char *callSiteName,
+                                           const Rule &rule
+                                           )
+      {
+        setRule(rateLimiterCallSiteRules(), callSiteName, rule);
+      }
+
+      //-----------------------------------------------------------------------
+      void LogRateLimiter::clearRules()
+      {
+        AutoLock lock(rateLimiterLock());
+        rateLimiterSubsystemRules().clear();
+        rateLimiterCallSiteRules().clear();
+        rateLimiterRulesVersion().fetch_add(1, boost::memory_order_release);
+      }
+
+      //-----------------------------------------------------------------------
+      bool LogRateLimiter::shouldLog(
+                                     const zsLib::Subsystem &subsystem,
+                                     CallSite &site,
+                                     ULONG &outSuppressed
+                                     )
+      {
+        outSuppressed = 0;
+
+        ULONG version = rateLimiterRulesVersion().load(boost::memory_order_acquire);
+
+        if (site.mRulesVersion.load(boost::memory_order_acquire) != version) {
+          // only taken once per call site after the rules change
+          AutoLock lock(rateLimiterLock());
+
+          version = rateLimiterRulesVersion().load(boost::memory_order_acquire);
+
+          Rule rule;
+
+          RuleMap::iterator found = rateLimiterCallSiteRules().find(String(site.mName));
+          if (found != rateLimiterCallSiteRules().end()) {
+            rule = (*found).second;
+          } else {
+            found = rateLimiterSubsystemRules().find(String(subsystem.getName()));
+            if (found != rateLimiterSubsystemRules().end()) {
+              rule = (*found).second;
+            }
+          }
+
+          site.mMaxPerSecond.store(rule.mMaxPerSecond, boost::memory_order_relaxed);
+          site.mSampleOneInEvery.store(rule.mSampleOneInEvery, boost::memory_order_relaxed);
+          site.mRulesVersion.store(version, boost::memory_order_release);
+        }
+
+        ULONG sampleOneInEvery = site.mSampleOneInEvery.load(boost::memory_order_relaxed);
+        ULONG maxPerSecond = site.mMaxPerSecond.load(boost::memory_order_relaxed);
+
+        if ((sampleOneInEvery < 2) &&
+            (0 == maxPerSecond)) {
+          // no rule applies (nothing can have been suppressed)
+          return true;
+        }
+
+        ULONG total = site.mTotal.fetch_add(1, boost::memory_order_relaxed);
+
+        if (sampleOneInEvery > 1) {
+          if (0 != (total % sampleOneInEvery)) {
+            site.mSuppressed.fetch_add(1, boost::memory_order_relaxed);
+            return false;
+          }
+        }
+
+        if (0 != maxPerSecond) {
+          ULONG now = static_cast<ULONG>(time(NULL));
+          ULONG windowStart = site.mWindowStart.load(boost::memory_order_relaxed);
+          if (now != windowStart) {
+            if (site.mWindowStart.compare_exchange_strong(windowStart, now, boost::memory_order_relaxed)) {
+              site.mTotalInWindow.store(0, boost::memory_order_relaxed);
+            }
+          }
+          if (site.mTotalInWindow.fetch_add(1, boost::memory_order_relaxed) >= maxPerSecond) {
+            site.mSuppressed.fetch_add(1, boost::memory_order_relaxed);
+            return false;
+          }
+        }
+
+        outSuppressed = site.mSuppressed.exchange(0, boost::memory_order_relaxed);
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr LogRateLimiter::toDebug()
+      {
+        ElementPtr resultEl = Element::create("core::LogRateLimiter");
+
+        AutoLock lock(rateLimiterLock());
+
+        UseServicesHelper::debugAppend(resultEl, "version", rateLimiterRulesVersion().load());
+
+        for (int loop = 0; loop < 2; ++loop) {
+          const RuleMap &rules = (0 == loop ? rateLimiterSubsystemRules() : rateLimiterCallSiteRules());
+          for (RuleMap::const_iterator iter = rules.begin(); iter != rules.end(); ++iter) {
+            ElementPtr ruleEl = Element::create(0 == loop ? "subsystem" : "call site");
+            UseServicesHelper::debugAppend(ruleEl, "name", (*iter).first);
+            UseServicesHelper::debugAppend(ruleEl, "max per second", (*iter).second.mMaxPerSecond);
+            UseServicesHelper::debugAppend(ruleEl, "sample one in every", (*iter).second.mSampleOneInEvery);
+            UseServicesHelper::debugAppend(resultEl, ruleEl);
+          }
+        }
+
+        return resultEl;
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    #pragma mark
+    #pragma mark ILogger::CustomLoggerStatistics
+    #pragma mark
+
+    //-------------------------------------------------------------------------
+    ILogger::CustomLoggerStatistics::CustomLoggerStatistics() :
+      mBufferSize(0),
+      mQueued(0),
+      mDelivered(0),
+      mDropped(0),
+      mOverflows(0),
+      mHighWaterMark(0)
+    {
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installStdOutLogger(bool colorizeOutput)
+    {
+      services::ILogger::installStdOutLogger(colorizeOutput);
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installFileLogger(const char *fileName, bool colorizeOutput)
+    {
+      services::ILogger::installFileLogger(fileName, colorizeOutput);
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installBinaryFileLogger(const char *fileName)
+    {
+      internal::BinaryFileLogger::install(fileName);
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installRotatingFileLogger(
+                                            const char *fileName,
+                                            size_t maxFileSizeInBytes,
+                                            ULONG maxFiles,
+                                            ULONG maxAgeInSeconds,
+                                            bool compressRotatedFiles
+                                            )
+    {
+      internal::RotatingFileLogger::install(fileName, maxFileSizeInBytes, maxFiles, maxAgeInSeconds, compressRotatedFiles);
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installTelnetLogger(
+                                      WORD listenPort,                             // what port to bind to on 0.0.0.0:port to listen for incoming telnet sessions
+                                      ULONG maxSecondsWaitForSocketToBeAvailable,  // since the port might still be in use for a period of time between runs (TCP timeout), how long to wait for the port to come alive (recommend 60)
+                                      bool colorizeOutput
+                                      )
+    {
+      services::ILogger::installTelnetLogger(listenPort, maxSecondsWaitForSocketToBeAvailable, colorizeOutput);
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installOutgoingTelnetLogger(
+                                              const char *serverToConnect,
+                                              bool colorizeOutput,
+                                              const char *stringToSendUponConnection
+                                              )
+    {
+      services::ILogger::installOutgoingTelnetLogger(serverToConnect, colorizeOutput, stringToSendUponConnection);
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installDebuggerLogger()
+    {
+      services::ILogger::installDebuggerLogger();
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::installCustomLogger(
+                                      ILoggerDelegatePtr delegate,
+                                      size_t asyncBufferSize
+                                      )
+    {
+      internal::CustomLoggerPtr logger = internal::CustomLogger::singleton();
+      if (!logger) return;
+      logger->installLogger(delegate, asyncBufferSize);
+    }
+
+    //-------------------------------------------------------------------------
+    ILogger::CustomLoggerStatistics ILogger::getCustomLoggerStatistics()
+    {
+      internal::CustomLoggerPtr logger = internal::CustomLogger::singleton();
+      if (!logger) return CustomLoggerStatistics();
+      return logger->getStatistics();
+    }
+
+    //-------------------------------------------------------------------------
+    bool ILogger::isTelnetLoggerListening()
+    {
+      return services::ILogger::isTelnetLoggerListening();
+    }
+
+    //-------------------------------------------------------------------------
+    bool ILogger::isTelnetLoggerConnected()
+    {
+      return services::ILogger::isTelnetLoggerConnected();
+    }
+
+    //-------------------------------------------------------------------------
+    bool ILogger::isOutgoingTelnetLoggerConnected()
+    {
+      return services::ILogger::isOutgoingTelnetLoggerConnected();
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::uninstallStdOutLogger()
+    {
+      services::ILogger::uninstallStdOutLogger();
+    }
+      
+    //-------------------------------------------------------------------------
+    void ILogger::uninstallFileLogger()
+    {
+      services::ILogger::uninstallFileLogger();
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::uninstallBinaryFileLogger()
+    {
+      internal::BinaryFileLogger::uninstall();
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::uninstallRotatingFileLogger()
+    {
+      internal::RotatingFileLogger::uninstall();
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::uninstallTelnetLogger()
+    {
+      services::ILogger::uninstallTelnetLogger();
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::uninstallOutgoingTelnetLogger()
+    {
+      services::ILogger::uninstallOutgoingTelnetLogger();
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::uninstallDebuggerLogger()
+    {
+      services::ILogger::uninstallDebuggerLogger();
+    }
+
+    namespace application
+    {
+      //-----------------------------------------------------------------------
+      static PTRNUMBER getGUISubsystem()
+      {
+        Subsystem *subsystem = &(ZS_GET_SUBSYSTEM());
+        return (PTRNUMBER)(subsystem);
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    PTRNUMBER ILogger::getApplicationSubsystemID()
+    {
+      return application::getGUISubsystem();
+    }
+
+    //-------------------------------------------------------------------------
+    ILogger::Level ILogger::getLogLevel(SubsystemID subsystemUniqueID)
+    {
+      return internal::levelToLevel(((Subsystem *)subsystemUniqueID)->getOutputLevel());
+    }
+
+    //---------------------------------------------------------------------------
+    void ILogger::setLogLevel(ILogger::Level level)
+    {
+      services::ILogger::setLogLevel(internal::levelToLevel(level));
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::setLogLevel(
+                              PTRNUMBER subsystemUniqueID,
+                              ILogger::Level level
+                              )
+    {
+      ((Subsystem *)subsystemUniqueID)->setOutputLevel(internal::levelToLevel(level));
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::setLogLevel(
+                              const char *subsystemName,
+                              ILogger::Level level
+                              )
+    {
+      services::ILogger::setLogLevel(subsystemName, internal::levelToLevel(level));
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::setLogRateLimit(
+                                  const char *subsystemName,
+                                  ULONG maxPerSecond,
+                                  ULONG sampleOneInEvery
+                                  )
+    {
+      internal::LogRateLimiter::setSubsystemRule(subsystemName, internal::LogRateLimiter::Rule(maxPerSecond, sampleOneInEvery));
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::setLogCallSiteRateLimit(
+                                          const char *callSiteName,
+                                          ULONG maxPerSecond,
+                                          ULONG sampleOneInEvery
+                                          )
+    {
+      internal::LogRateLimiter::setCallSiteRule(callSiteName, internal::LogRateLimiter::Rule(maxPerSecond, sampleOneInEvery));
+    }
+
+    //-------------------------------------------------------------------------
+    void ILogger::clearLogRateLimits()
+    {
+      internal::LogRateLimiter::clearRules();
     }
 
     //-------------------------------------------------------------------------
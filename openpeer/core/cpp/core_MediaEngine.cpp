@@ -32,6 +32,8 @@
 #include <openpeer/core/internal/core_MediaEngine.h>
 #include <openpeer/core/internal/core_Stack.h>
 #include <openpeer/core/internal/core_thread.h>
+#include <openpeer/core/internal/core_Logger.h>
+#include <openpeer/core/internal/core_Settings.h>
 #include <openpeer/core/ILogger.h>
 
 #include <openpeer/services/IHelper.h>
@@ -56,11 +58,18 @@
 #include <sys/sysctl.h>
 #endif
 
-#define OPENPEER_MEDIA_ENGINE_VOICE_CODEC_ISAC
 //#define OPENPEER_MEDIA_ENGINE_VOICE_CODEC_OPUS
 #define OPENPEER_MEDIA_ENGINE_INVALID_CAPTURE (-1)
 #define OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL (-1)
 #define OPENPEER_MEDIA_ENGINE_MTU (576)
+#define OPENPEER_MEDIA_ENGINE_RECEIVE_READERS_WARN_AFTER_IN_MILLISECONDS (500)
+#define OPENPEER_MEDIA_ENGINE_QUALITY_WINDOW_SAMPLES (30)
+
+#define OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_CONGESTED_LOSS_PERCENT (5)
+#define OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_CONGESTED_RTT_MS (400)
+#define OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_HEALTHY_LOSS_PERCENT (1)
+#define OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_HEALTHY_SAMPLES_BEFORE_INCREASE (3)
+#define OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_INTERVAL_IN_SECONDS (2)
 
 namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_webrtc) } }
 
@@ -70,14 +79,47 @@ namespace openpeer
   {
     namespace internal
     {
+      using zsLib::Milliseconds;
+
       ZS_DECLARE_TYPEDEF_PTR(MediaEngine::ForCallTransport, ForCallTransport)
 
       typedef IStackForInternal UseStack;
 
       ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+      ZS_DECLARE_TYPEDEF_PTR(ISettingsForInternal, UseSettings)
 
       typedef zsLib::ThreadPtr ThreadPtr;
       
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark MediaEngine_ReceiveReader
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: counts a receive path thread as inside a voice/video channel
+      //          for the duration of a Received*Packet call so the lifetime
+      //          thread does not delete the channel underneath it
+      class MediaEngine_ReceiveReader
+      {
+      public:
+        MediaEngine_ReceiveReader(boost::atomic<ULONG> &readers) :
+          mReaders(readers)
+        {
+          mReaders.fetch_add(1, boost::memory_order_seq_cst);
+        }
+
+        ~MediaEngine_ReceiveReader()
+        {
+          mReaders.fetch_sub(1, boost::memory_order_seq_cst);
+        }
+
+      private:
+        boost::atomic<ULONG> &mReaders;
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -92,6 +134,91 @@ namespace openpeer
         MediaEngine::setup(delegate);
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IMediaEngineForCall
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      IMediaEngineForCall::VoiceCodecInfoList IMediaEngineForCall::getVoiceCodecs()
+      {
+        return MediaEngine::getVoiceCodecs();
+      }
+
+      //-----------------------------------------------------------------------
+      IMediaEngineForCall::VoiceCodecInfo IMediaEngineForCall::getVoiceRedundancyCodec()
+      {
+        return MediaEngine::getVoiceRedundancyCodec();
+      }
+
+      //-----------------------------------------------------------------------
+      IMediaEngineForCall::VideoCodecInfoList IMediaEngineForCall::getVideoCodecs()
+      {
+        return MediaEngine::getVideoCodecs();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IMediaEngineForCall::VoiceCodecInfo
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      IMediaEngineForCall::VoiceCodecInfo::VoiceCodecInfo() :
+        mPayloadType(0),
+        mPTime(0),
+        mClockRate(0),
+        mChannels(0),
+        mMinBitrate(0),
+        mStartBitrate(0),
+        mMaxBitrate(0),
+        mRedPayloadType(-1)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      bool IMediaEngineForCall::VoiceCodecInfo::operator==(const VoiceCodecInfo &rValue) const
+      {
+        return (0 == mName.compareNoCase(rValue.mName)) &&
+               (mPayloadType == rValue.mPayloadType) &&
+               (mPTime == rValue.mPTime) &&
+               (mClockRate == rValue.mClockRate) &&
+               (mChannels == rValue.mChannels) &&
+               (mMinBitrate == rValue.mMinBitrate) &&
+               (mStartBitrate == rValue.mStartBitrate) &&
+               (mMaxBitrate == rValue.mMaxBitrate) &&
+               (mRedPayloadType == rValue.mRedPayloadType);
+      }
+
+      //-----------------------------------------------------------------------
+      bool IMediaEngineForCall::VoiceCodecInfo::operator!=(const VoiceCodecInfo &rValue) const
+      {
+        return !(*this == rValue);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr IMediaEngineForCall::VoiceCodecInfo::toDebug() const
+      {
+        ElementPtr resultEl = Element::create("core::IMediaEngineForCall::VoiceCodecInfo");
+
+        UseServicesHelper::debugAppend(resultEl, "name", mName);
+        UseServicesHelper::debugAppend(resultEl, "payload type", (DWORD)mPayloadType);
+        UseServicesHelper::debugAppend(resultEl, "ptime", mPTime);
+        UseServicesHelper::debugAppend(resultEl, "clock rate", mClockRate);
+        UseServicesHelper::debugAppend(resultEl, "channels", mChannels);
+        UseServicesHelper::debugAppend(resultEl, "min bitrate", mMinBitrate);
+        UseServicesHelper::debugAppend(resultEl, "start bitrate", mStartBitrate);
+        UseServicesHelper::debugAppend(resultEl, "max bitrate", mMaxBitrate);
+        UseServicesHelper::debugAppend(resultEl, "red payload type", mRedPayloadType);
+
+        return resultEl;
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -106,6 +233,43 @@ namespace openpeer
         return MediaEngine::singleton();
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IMediaEngineForCallTransport::VoiceSession
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      IMediaEngineForCallTransport::VoiceSession::VoiceSession(
+                                                               TransportPtr transport,
+                                                               PUID callID,
+                                                               const VoiceCodecInfo &codec
+                                                               ) :
+        mID(zsLib::createPUID()),
+        mCallID(callID),
+        mCodec(codec),
+        mTransport("voice session"),
+        mChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
+        mReceiveReaders(0)
+      {
+        mTransport.redirect(transport);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr IMediaEngineForCallTransport::VoiceSession::toDebug() const
+      {
+        ElementPtr resultEl = Element::create("core::IMediaEngineForCallTransport::VoiceSession");
+
+        UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "call", mCallID);
+        UseServicesHelper::debugAppend(resultEl, "codec", mCodec.toDebug());
+        UseServicesHelper::debugAppend(resultEl, "channel", mChannel.load());
+
+        return resultEl;
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -145,12 +309,14 @@ namespace openpeer
         mChannelRenderViewCropRight(1.0F),
         mChannelRenderViewCropBottom(1.0F),
         mContinuousVideoCapture(true),
+        mMediaEngineCreated(false),
+        mMediaEngineAvailable(false),
         mVoiceChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
         mVoiceTransport(&mRedirectVoiceTransport),
-        mVoiceExternalTransport(NULL),
+        mVoiceExternalTransport(),
         mVideoChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
         mVideoTransport(&mRedirectVideoTransport),
-        mVideoExternalTransport(NULL),
+        mVideoExternalTransport(),
         mCaptureId(OPENPEER_MEDIA_ENGINE_INVALID_CAPTURE),
         mVoiceEngine(NULL),
         mVoiceBase(NULL),
@@ -161,7 +327,15 @@ namespace openpeer
         mVoiceVolumeControl(NULL),
         mVoiceHardware(NULL),
         mVoiceFile(NULL),
-        mVoiceEngineReady(false),
+        mVoiceExternalMedia(NULL),
+        mVoiceReceiveChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
+        mVoiceReceiveReaders(0),
+        mVoiceCallID(0),
+        mVoiceSendBitrate(0),
+        mVoiceFECEnabled(false),
+        mVoiceDTXEnabled(false),
+        mVoiceHealthySamples(0),
+        mConferenceEnabled(false),
         mVcpm(NULL),
         mVideoEngine(NULL),
         mVideoBase(NULL),
@@ -170,7 +344,8 @@ namespace openpeer
         mVideoCapture(NULL),
         mVideoRtpRtcp(NULL),
         mVideoCodec(NULL),
-        mVideoEngineReady(false),
+        mVideoReceiveChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
+        mVideoReceiveReaders(0),
         mRedirectVoiceTransport("voice"),
         mRedirectVideoTransport("video"),
         mLifetimeWantAudio(false),
@@ -182,6 +357,10 @@ namespace openpeer
         mLifetimeHasVideoChannel(false),
         mLifetimeHasRecordVideoCapture(false),
         mLifetimeInProgress(false),
+        mLifetimeWorkDeferred(false),
+        mLifetimeWorkPending(false),
+        mLifetimeWorkShutdown(false),
+        mLifetimeWorkSampling(false),
         mLifetimeWantEcEnabled(false),
         mLifetimeWantAgcEnabled(false),
         mLifetimeWantNsEnabled(false),
@@ -207,8 +386,10 @@ namespace openpeer
         mLifetimeWantContinuousVideoCapture(true),
         mLifetimeWantVideoRecordFile(""),
         mLifetimeWantSaveVideoToLibrary(false),
-        mLifetimeWantVoiceExternalTransport(NULL),
-        mLifetimeWantVideoExternalTransport(NULL)
+        mLifetimeWantVoiceExternalTransport(),
+        mLifetimeWantVideoExternalTransport(),
+        mLifetimeWantVoiceCallID(0),
+        mLifetimeWantConferenceEnabled(false)
       {
 #ifdef TARGET_OS_IPHONE
         int name[] = {CTL_HW, HW_MACHINE};
@@ -248,12 +429,14 @@ namespace openpeer
         mChannelRenderViewCropRight(1.0F),
         mChannelRenderViewCropBottom(1.0F),
         mContinuousVideoCapture(true),
+        mMediaEngineCreated(false),
+        mMediaEngineAvailable(false),
         mVoiceChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
         mVoiceTransport(NULL),
-        mVoiceExternalTransport(NULL),
+        mVoiceExternalTransport(),
         mVideoChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
         mVideoTransport(NULL),
-        mVideoExternalTransport(NULL),
+        mVideoExternalTransport(),
         mCaptureId(OPENPEER_MEDIA_ENGINE_INVALID_CAPTURE),
         mVoiceEngine(NULL),
         mVoiceBase(NULL),
@@ -264,7 +447,15 @@ namespace openpeer
         mVoiceVolumeControl(NULL),
         mVoiceHardware(NULL),
         mVoiceFile(NULL),
-        mVoiceEngineReady(false),
+        mVoiceExternalMedia(NULL),
+        mVoiceReceiveChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
+        mVoiceReceiveReaders(0),
+        mVoiceCallID(0),
+        mVoiceSendBitrate(0),
+        mVoiceFECEnabled(false),
+        mVoiceDTXEnabled(false),
+        mVoiceHealthySamples(0),
+        mConferenceEnabled(false),
         mVcpm(NULL),
         mVideoEngine(NULL),
         mVideoBase(NULL),
@@ -273,7 +464,8 @@ namespace openpeer
         mVideoCapture(NULL),
         mVideoRtpRtcp(NULL),
         mVideoCodec(NULL),
-        mVideoEngineReady(false),
+        mVideoReceiveChannel(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL),
+        mVideoReceiveReaders(0),
         mRedirectVoiceTransport("voice"),
         mRedirectVideoTransport("video"),
         mLifetimeWantAudio(false),
@@ -285,6 +477,10 @@ namespace openpeer
         mLifetimeHasVideoChannel(false),
         mLifetimeHasRecordVideoCapture(false),
         mLifetimeInProgress(false),
+        mLifetimeWorkDeferred(false),
+        mLifetimeWorkPending(false),
+        mLifetimeWorkShutdown(false),
+        mLifetimeWorkSampling(false),
         mLifetimeWantEcEnabled(false),
         mLifetimeWantAgcEnabled(false),
         mLifetimeWantNsEnabled(false),
@@ -310,8 +506,10 @@ namespace openpeer
         mLifetimeWantContinuousVideoCapture(true),
         mLifetimeWantVideoRecordFile(""),
         mLifetimeWantSaveVideoToLibrary(false),
-        mLifetimeWantVoiceExternalTransport(NULL),
-        mLifetimeWantVideoExternalTransport(NULL)
+        mLifetimeWantVoiceExternalTransport(),
+        mLifetimeWantVideoExternalTransport(),
+        mLifetimeWantVoiceCallID(0),
+        mLifetimeWantConferenceEnabled(false)
       {
 #ifdef TARGET_OS_IPHONE
         int name[] = {CTL_HW, HW_MACHINE};
@@ -328,7 +526,24 @@ namespace openpeer
       MediaEngine::~MediaEngine()
       {
         if(isNoop()) return;
-        
+
+        ThreadPtr thread;
+        {
+          boost::unique_lock<boost::mutex> lock(mLifetimeWorkMutex);
+          mLifetimeWorkShutdown = true;
+          thread = mLifetimeThread;
+          mLifetimeThread.reset();
+        }
+        mLifetimeWorkCondition.notify_all();
+
+        if (thread) {
+          if (thread->get_id() == boost::this_thread::get_id()) {
+            thread->detach();
+          } else {
+            thread->join();
+          }
+        }
+
         destroyMediaEngine();
       }
 
@@ -337,115 +552,135 @@ namespace openpeer
       {
         AutoRecursiveLock lock(mLock);
         
-        ZS_LOG_DEBUG(log("init media engine"))
+        ZS_LOG_DEBUG(log("init media engine (voice and video engines will be created on first use)"))
+      }
+
+      //-----------------------------------------------------------------------
+      bool MediaEngine::createMediaEngine()
+      {
+        AutoRecursiveLock lock(mLock);
+
+        if (mMediaEngineCreated) return mMediaEngineAvailable;
+
+        // only ever attempt creation once, a partially created engine is cleaned up by destroyMediaEngine()
+        mMediaEngineCreated = true;
+
+        ZS_LOG_DEBUG(log("creating voice and video engines"))
+
+        Time start = zsLib::now();
 
         mVoiceEngine = webrtc::VoiceEngine::Create();
         if (mVoiceEngine == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to create voice engine"))
-          return;
+          return false;
         }
         mVoiceBase = webrtc::VoEBase::GetInterface(mVoiceEngine);
         if (mVoiceBase == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for voice base"))
-          return;
+          return false;
         }
         mVoiceCodec = webrtc::VoECodec::GetInterface(mVoiceEngine);
         if (mVoiceCodec == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for voice codec"))
-          return;
+          return false;
         }
         mVoiceNetwork = webrtc::VoENetwork::GetInterface(mVoiceEngine);
         if (mVoiceNetwork == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for voice network"))
-          return;
+          return false;
         }
         mVoiceRtpRtcp = webrtc::VoERTP_RTCP::GetInterface(mVoiceEngine);
         if (mVoiceRtpRtcp == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for voice RTP/RTCP"))
-          return;
+          return false;
         }
         mVoiceAudioProcessing = webrtc::VoEAudioProcessing::GetInterface(mVoiceEngine);
         if (mVoiceAudioProcessing == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for audio processing"))
-          return;
+          return false;
         }
         mVoiceVolumeControl = webrtc::VoEVolumeControl::GetInterface(mVoiceEngine);
         if (mVoiceVolumeControl == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for volume control"))
-          return;
+          return false;
         }
         mVoiceHardware = webrtc::VoEHardware::GetInterface(mVoiceEngine);
         if (mVoiceHardware == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for audio hardware"))
-          return;
+          return false;
         }
         mVoiceFile = webrtc::VoEFile::GetInterface(mVoiceEngine);
         if (mVoiceFile == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for voice file"))
-          return;
+          return false;
+        }
+        mVoiceExternalMedia = webrtc::VoEExternalMedia::GetInterface(mVoiceEngine);
+        if (mVoiceExternalMedia == NULL) {
+          ZS_LOG_ERROR(Detail, log("failed to get interface for voice external media"))
+          return false;
         }
 
         mError = mVoiceBase->Init();
         if (mError < 0) {
           ZS_LOG_ERROR(Detail, log("failed to initialize voice base") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
+          return false;
         } else if (mVoiceBase->LastError() > 0) {
           ZS_LOG_WARNING(Detail, log("an error has occured during voice base init") + ZS_PARAM("error", mVoiceBase->LastError()))
         }
         mError = mVoiceBase->RegisterVoiceEngineObserver(*this);
         if (mError < 0) {
           ZS_LOG_ERROR(Detail, log("failed to register voice engine observer") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
+          return false;
         }
 
         mVideoEngine = webrtc::VideoEngine::Create();
         if (mVideoEngine == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to create video engine"))
-          return;
+          return false;
         }
 
         mVideoBase = webrtc::ViEBase::GetInterface(mVideoEngine);
         if (mVideoBase == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for video base"))
-          return;
+          return false;
         }
         mVideoCapture = webrtc::ViECapture::GetInterface(mVideoEngine);
         if (mVideoCapture == NULL) {
           ZS_LOG_ERROR(Detail, log("failed get interface for video capture"))
-          return;
+          return false;
         }
         mVideoRtpRtcp = webrtc::ViERTP_RTCP::GetInterface(mVideoEngine);
         if (mVideoRtpRtcp == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for video RTP/RTCP"))
-          return;
+          return false;
         }
         mVideoNetwork = webrtc::ViENetwork::GetInterface(mVideoEngine);
         if (mVideoNetwork == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for video network"))
-          return;
+          return false;
         }
         mVideoRender = webrtc::ViERender::GetInterface(mVideoEngine);
         if (mVideoRender == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for video render"))
-          return;
+          return false;
         }
         mVideoCodec = webrtc::ViECodec::GetInterface(mVideoEngine);
         if (mVideoCodec == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for video codec"))
-          return;
+          return false;
         }
 #if 0
         mVideoFile = webrtc::ViEFile::GetInterface(mVideoEngine);
         if (mVideoFile == NULL) {
           ZS_LOG_ERROR(Detail, log("failed to get interface for video file"))
-          return;
+          return false;
         }
 #endif
         
         mError = mVideoBase->Init();
         if (mError < 0) {
           ZS_LOG_ERROR(Detail, log("failed to initialize video base") + ZS_PARAM("error", mVideoBase->LastError()))
-          return;
+          return false;
         } else if (mVideoBase->LastError() > 0) {
           ZS_LOG_WARNING(Detail, log("an error has occured during video base init") + ZS_PARAM("error", mVideoBase->LastError()))
         }
@@ -453,7 +688,7 @@ namespace openpeer
         mError = mVideoBase->SetVoiceEngine(mVoiceEngine);
         if (mError < 0) {
           ZS_LOG_ERROR(Detail, log("failed to set voice engine for video base") + ZS_PARAM("error", mVideoBase->LastError()))
-          return;
+          return false;
         }
         
         setLogLevel();
@@ -486,24 +721,29 @@ namespace openpeer
           mError = mVoiceEngine->SetTraceFilter(traceFilter);
           if (mError < 0) {
             ZS_LOG_ERROR(Detail, log("failed to set trace filter for voice") + ZS_PARAM("error", mVoiceBase->LastError()))
-            return;
+            return false;
           }
           mError = mVoiceEngine->SetTraceCallback(this);
           if (mError < 0) {
             ZS_LOG_ERROR(Detail, log("failed to set trace callback for voice") + ZS_PARAM("error", mVoiceBase->LastError()))
-            return;
+            return false;
           }
           mError = mVideoEngine->SetTraceFilter(traceFilter);
           if (mError < 0) {
             ZS_LOG_ERROR(Detail, log("failed to set trace filter for video") + ZS_PARAM("error", mVideoBase->LastError()))
-            return;
+            return false;
           }
           mError = mVideoEngine->SetTraceCallback(this);
           if (mError < 0) {
             ZS_LOG_ERROR(Detail, log("failed to set trace callback for video") + ZS_PARAM("error", mVideoBase->LastError()))
-            return;
+            return false;
           }
         }
+
+        mMediaEngineAvailable = true;
+
+        ZS_LOG_DEBUG(log("voice and video engines created") + ZS_PARAM("duration (ms)", (zsLib::now() - start).total_milliseconds()))
+        return true;
       }
       
       //-----------------------------------------------------------------------
@@ -580,9 +820,19 @@ namespace openpeer
             }
           }
           
-          if (!VoiceEngine::Delete(mVoiceEngine)) {
-            ZS_LOG_ERROR(Detail, log("failed to delete voice engine"))
-            return;
+          if (mVoiceExternalMedia) {
+            mError = mVoiceExternalMedia->Release();
+            if (mError < 0) {
+              ZS_LOG_ERROR(Detail, log("failed to release voice external media") + ZS_PARAM("error", mVoiceBase->LastError()))
+              return;
+            }
+          }
+          
+          if (mVoiceEngine) {
+            if (!VoiceEngine::Delete(mVoiceEngine)) {
+              ZS_LOG_ERROR(Detail, log("failed to delete voice engine"))
+              return;
+            }
           }
         }
         
@@ -644,9 +894,11 @@ namespace openpeer
             }
           }
 #endif
-          if (!VideoEngine::Delete(mVideoEngine)) {
-            ZS_LOG_ERROR(Detail, log("failed to delete video engine"))
-            return;
+          if (mVideoEngine) {
+            if (!VideoEngine::Delete(mVideoEngine)) {
+              ZS_LOG_ERROR(Detail, log("failed to delete video engine"))
+              return;
+            }
           }
         }
       }
@@ -695,7 +947,7 @@ namespace openpeer
           mLifetimeWantDefaultVideoOrientation = orientation;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-------------------------------------------------------------------------
@@ -719,7 +971,7 @@ namespace openpeer
           mLifetimeWantRecordVideoOrientation = orientation;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-------------------------------------------------------------------------
@@ -740,7 +992,7 @@ namespace openpeer
           mLifetimeWantSetVideoOrientation = true;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-----------------------------------------------------------------------
@@ -754,7 +1006,7 @@ namespace openpeer
           mLifetimeWantCaptureRenderView = renderView;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -778,7 +1030,7 @@ namespace openpeer
           mLifetimeWantChannelRenderView = renderView;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -802,7 +1054,7 @@ namespace openpeer
             mLifetimeWantBackCameraCaptureCapability = capability;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
 
       }
       
@@ -824,10 +1076,17 @@ namespace openpeer
         }
         
         bool lockAcquired = mLock.try_lock();
-        
+
+        if ((lockAcquired) &&
+            (!mMediaEngineAvailable)) {
+          // engine not created yet (or failed), do not force creation merely to answer a query
+          mLock.unlock();
+          lockAcquired = false;
+        }
+
         if (!lockAcquired) {
           AutoRecursiveLock lock(mLifetimeLock);
-          mLifetimeInProgress = false;
+          releaseLifetimeInProgress();
           ZS_LOG_WARNING(Debug, log("get capture capabilities - cached value returned"))
           if (cameraType == CameraType_Front)
             return mLifetimeFrontCameraCaptureCapabilityList;
@@ -843,13 +1102,14 @@ namespace openpeer
           AutoRecursiveLock lock(mLifetimeLock);
           if (cameraType == CameraType_Front) {
             mLifetimeFrontCameraCaptureCapabilityList = capabilityList;
-            mLifetimeInProgress = false;
+            releaseLifetimeInProgress();
             return mLifetimeFrontCameraCaptureCapabilityList;
           } else if (cameraType == CameraType_Back) {
             mLifetimeBackCameraCaptureCapabilityList = capabilityList;
-            mLifetimeInProgress = false;
+            releaseLifetimeInProgress();
             return mLifetimeBackCameraCaptureCapabilityList;
           } else {
+            releaseLifetimeInProgress();
             return CaptureCapabilityList();
           }
         }
@@ -871,7 +1131,7 @@ namespace openpeer
           mLifetimeWantCaptureRenderViewCropBottom = bottom;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-----------------------------------------------------------------------
@@ -890,7 +1150,7 @@ namespace openpeer
           mLifetimeWantChannelRenderViewCropBottom = bottom;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-----------------------------------------------------------------------
@@ -901,7 +1161,7 @@ namespace openpeer
           mLifetimeWantEcEnabled = enabled;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -912,7 +1172,7 @@ namespace openpeer
           mLifetimeWantAgcEnabled = enabled;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -923,7 +1183,7 @@ namespace openpeer
           mLifetimeWantNsEnabled = enabled;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-------------------------------------------------------------------------
@@ -937,7 +1197,7 @@ namespace openpeer
           mLifetimeWantVoiceRecordFile = fileName;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-------------------------------------------------------------------------
@@ -958,7 +1218,7 @@ namespace openpeer
           mLifetimeWantMuteEnabled = enabled;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -976,10 +1236,16 @@ namespace openpeer
         }
         
         bool lockAcquired = mLock.try_lock();
-        
+
+        if ((lockAcquired) &&
+            (!mMediaEngineAvailable)) {
+          mLock.unlock();
+          lockAcquired = false;
+        }
+
         if (!lockAcquired) {
           AutoRecursiveLock lock(mLifetimeLock);
-          mLifetimeInProgress = false;
+          releaseLifetimeInProgress();
           ZS_LOG_WARNING(Debug, log("get mute enabled - cached value returned"))
           return mLifetimeWantMuteEnabled;
         }
@@ -992,7 +1258,7 @@ namespace openpeer
         {
           AutoRecursiveLock lock(mLifetimeLock);
           mLifetimeWantMuteEnabled = enabled;
-          mLifetimeInProgress = false;
+          releaseLifetimeInProgress();
           return mLifetimeWantMuteEnabled;
         }
       }
@@ -1005,7 +1271,7 @@ namespace openpeer
           mLifetimeWantLoudspeakerEnabled = enabled;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -1023,10 +1289,16 @@ namespace openpeer
         }
         
         bool lockAcquired = mLock.try_lock();
-        
+
+        if ((lockAcquired) &&
+            (!mMediaEngineAvailable)) {
+          mLock.unlock();
+          lockAcquired = false;
+        }
+
         if (!lockAcquired) {
           AutoRecursiveLock lock(mLifetimeLock);
-          mLifetimeInProgress = false;
+          releaseLifetimeInProgress();
           ZS_LOG_WARNING(Debug, log("get loudspeaker enabled - cached value returned"))
           return mLifetimeWantLoudspeakerEnabled;
         }
@@ -1039,7 +1311,7 @@ namespace openpeer
         {
           AutoRecursiveLock lock(mLifetimeLock);
           mLifetimeWantLoudspeakerEnabled = enabled;
-          mLifetimeInProgress = false;
+          releaseLifetimeInProgress();
           return mLifetimeWantLoudspeakerEnabled;
         }
       }
@@ -1048,7 +1320,13 @@ namespace openpeer
       IMediaEngine::OutputAudioRoutes MediaEngine::getOutputAudioRoute()
       {
         bool lockAcquired = mLock.try_lock();
-        
+
+        if ((lockAcquired) &&
+            (!mMediaEngineAvailable)) {
+          mLock.unlock();
+          lockAcquired = false;
+        }
+
         if (!lockAcquired) {
           AutoRecursiveLock lock(mLifetimeLock);
           ZS_LOG_WARNING(Debug, log("get loudspeaker enabled - cached value returned"))
@@ -1077,7 +1355,7 @@ namespace openpeer
           mLifetimeWantContinuousVideoCapture = continuousVideoCapture;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -1101,7 +1379,7 @@ namespace openpeer
           mLifetimeWantFaceDetection = faceDetection;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -1122,7 +1400,7 @@ namespace openpeer
           mLifetimeWantCameraType = type;
         }
 
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -1143,7 +1421,7 @@ namespace openpeer
           mLifetimeWantVideoCapture = true;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
@@ -1154,7 +1432,7 @@ namespace openpeer
           mLifetimeWantVideoCapture = false;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-------------------------------------------------------------------------
@@ -1167,7 +1445,7 @@ namespace openpeer
           mLifetimeWantSaveVideoToLibrary = saveToLibrary;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-------------------------------------------------------------------------
@@ -1178,14 +1456,20 @@ namespace openpeer
           mLifetimeWantRecordVideoCapture = false;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
       
       //-----------------------------------------------------------------------
       int MediaEngine::getVideoTransportStatistics(RtpRtcpStatistics &stat)
       {
         bool lockAcquired = mLock.try_lock();
-        
+
+        if ((lockAcquired) &&
+            (!mMediaEngineAvailable)) {
+          mLock.unlock();
+          lockAcquired = false;
+        }
+
         if (!lockAcquired) {
           AutoRecursiveLock lock(mLifetimeLock);
           ZS_LOG_WARNING(Debug, log("get video transport statistics - cached value returned"))
@@ -1209,7 +1493,13 @@ namespace openpeer
       int MediaEngine::getVoiceTransportStatistics(RtpRtcpStatistics &stat)
       {
         bool lockAcquired = mLock.try_lock();
-        
+
+        if ((lockAcquired) &&
+            (!mMediaEngineAvailable)) {
+          mLock.unlock();
+          lockAcquired = false;
+        }
+
         if (!lockAcquired) {
           AutoRecursiveLock lock(mLifetimeLock);
           ZS_LOG_WARNING(Debug, log("get voice transport statistics - cached value returned"))
@@ -1240,7 +1530,35 @@ namespace openpeer
             mLifetimeWantAudio = true;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::setConferenceEnabled(bool enabled)
+      {
+        {
+          AutoRecursiveLock lock(mLifetimeLock);
+
+          ZS_LOG_DETAIL(log("set conference enabled") + ZS_PARAM("enabled", enabled))
+
+          mLifetimeWantConferenceEnabled = enabled;
+        }
+
+        notifyLifetimeWork();
+      }
+
+      //-----------------------------------------------------------------------
+      bool MediaEngine::getConferenceEnabled()
+      {
+        AutoRecursiveLock lock(mLifetimeLock);
+        return mLifetimeWantConferenceEnabled;
+      }
+
+      //-----------------------------------------------------------------------
+      IMediaEngine::ConferenceLevelList MediaEngine::getConferenceLevels()
+      {
+        // the mixer only holds participants while the conference is active
+        return mAudioMixer.getLevels();
       }
 
       //-----------------------------------------------------------------------
@@ -1257,6 +1575,93 @@ namespace openpeer
         singleton(delegate);
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark MediaEngine => IMediaEngineForCall
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      MediaEngine::VoiceCodecInfoList MediaEngine::getVoiceCodecs()
+      {
+        VoiceCodecInfoList result;
+
+#ifdef OPENPEER_MEDIA_ENGINE_VOICE_CODEC_OPUS
+        {
+          VoiceCodecInfo opus;
+          opus.mName = "opus";
+          opus.mPayloadType = 110;
+          opus.mPTime = 20;
+          opus.mClockRate = 48000;
+          opus.mChannels = 2;
+          opus.mMinBitrate = 12000;
+          opus.mStartBitrate = 32000;
+          opus.mMaxBitrate = 64000;
+          result.push_back(opus);
+        }
+#endif //OPENPEER_MEDIA_ENGINE_VOICE_CODEC_OPUS
+
+        // legacy codec, must remain last
+        {
+          VoiceCodecInfo isac;
+          isac.mName = "ISAC";
+          isac.mPayloadType = 103;
+          isac.mPTime = 30;
+          isac.mClockRate = 16000;
+          isac.mChannels = 1;
+          isac.mMinBitrate = 10000;
+          isac.mStartBitrate = 32000;
+          isac.mMaxBitrate = 32000;
+          result.push_back(isac);
+        }
+
+        return result;
+      }
+
+      //-----------------------------------------------------------------------
+      MediaEngine::VoiceCodecInfo MediaEngine::getVoiceRedundancyCodec()
+      {
+        VoiceCodecInfo red;
+        red.mName = "red";
+        red.mPayloadType = 127;
+        red.mClockRate = 8000;
+        red.mChannels = 1;
+        return red;
+      }
+
+      //-----------------------------------------------------------------------
+      MediaEngine::VideoCodecInfoList MediaEngine::getVideoCodecs()
+      {
+        VideoCodecInfoList result;
+
+        // the video engine's default payload types
+        {
+          VideoCodecInfo vp8;
+          vp8.mName = "VP8";
+          vp8.mPayloadType = 100;
+          vp8.mClockRate = 90000;
+          result.push_back(vp8);
+        }
+        {
+          VideoCodecInfo red;
+          red.mName = "red";
+          red.mPayloadType = 116;
+          red.mClockRate = 90000;
+          result.push_back(red);
+        }
+        {
+          VideoCodecInfo ulpfec;
+          ulpfec.mName = "ulpfec";
+          ulpfec.mPayloadType = 117;
+          ulpfec.mClockRate = 90000;
+          result.push_back(ulpfec);
+        }
+
+        return result;
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -1266,14 +1671,29 @@ namespace openpeer
       #pragma mark
 
       //-----------------------------------------------------------------------
-      void MediaEngine::startVoice()
+      void MediaEngine::startVoice(
+                                   PUID callID,
+                                   const VoiceCodecInfo &codec
+                                   )
       {
         {
           AutoRecursiveLock lock(mLifetimeLock);
           mLifetimeWantAudio = true;
+          mLifetimeWantVoiceCallID = callID;
+          mLifetimeWantVoiceCodec = codec;
+          mLifetimeVoiceStartRequested = zsLib::now();
+        }
+
+        {
+          AutoLock lock(mQualityLock);
+          CallMediaQuality &quality = mCallQuality[callID];
+          if (0 == quality.mCallID) {
+            quality.mCallID = callID;
+            quality.mStarted = zsLib::now();
+          }
         }
 
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-----------------------------------------------------------------------
@@ -1284,7 +1704,7 @@ namespace openpeer
           mLifetimeWantAudio = false;
         }
 
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-----------------------------------------------------------------------
@@ -1293,9 +1713,10 @@ namespace openpeer
         {
           AutoRecursiveLock lock(mLifetimeLock);
           mLifetimeWantVideoChannel = true;
+          mLifetimeVideoStartRequested = zsLib::now();
         }
 
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-----------------------------------------------------------------------
@@ -1306,21 +1727,21 @@ namespace openpeer
           mLifetimeWantVideoChannel = false;
         }
 
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
       }
 
       //-----------------------------------------------------------------------
-      int MediaEngine::registerVoiceExternalTransport(Transport &transport)
+      int MediaEngine::registerVoiceExternalTransport(TransportPtr transport)
       {
         {
           AutoRecursiveLock lock(mLifetimeLock);
           
           ZS_LOG_DEBUG(log("register voice external transport"))
           
-          mLifetimeWantVoiceExternalTransport = &transport;
+          mLifetimeWantVoiceExternalTransport = transport;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
 
         return 0;
       }
@@ -1333,10 +1754,10 @@ namespace openpeer
           
           ZS_LOG_DEBUG(log("deregister voice external transport"))
           
-          mLifetimeWantVoiceExternalTransport = NULL;
+          mLifetimeWantVoiceExternalTransport.reset();
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
 
         return 0;
       }
@@ -1344,22 +1765,19 @@ namespace openpeer
       //-----------------------------------------------------------------------
       int MediaEngine::receivedVoiceRTPPacket(const void *data, size_t length)
       {
-        int channel = OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL;
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          if (mVoiceEngineReady)
-            channel = mVoiceChannel;
-        }
+        MediaEngine_ReceiveReader reader(mVoiceReceiveReaders);
+
+        int channel = mVoiceReceiveChannel.load(boost::memory_order_seq_cst);
 
         if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) {
           ZS_LOG_WARNING(Debug, log("voice channel is not ready yet"))
           return -1;
         }
 
-        mError = mVoiceNetwork->ReceivedRTPPacket(channel, data, length);
-        if (0 != mError) {
+        int error = mVoiceNetwork->ReceivedRTPPacket(channel, data, length);
+        if (0 != error) {
           ZS_LOG_ERROR(Detail, log("received voice RTP packet failed") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return mError;
+          return error;
         }
 
         return 0;
@@ -1368,39 +1786,36 @@ namespace openpeer
       //-----------------------------------------------------------------------
       int MediaEngine::receivedVoiceRTCPPacket(const void* data, size_t length)
       {
-        int channel = OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL;
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          if (mVoiceEngineReady)
-            channel = mVoiceChannel;
-        }
+        MediaEngine_ReceiveReader reader(mVoiceReceiveReaders);
+
+        int channel = mVoiceReceiveChannel.load(boost::memory_order_seq_cst);
 
         if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) {
           ZS_LOG_WARNING(Debug, log("voice channel is not ready yet"))
           return -1;
         }
 
-        mError = mVoiceNetwork->ReceivedRTCPPacket(channel, data, length);
-        if (0 != mError) {
+        int error = mVoiceNetwork->ReceivedRTCPPacket(channel, data, length);
+        if (0 != error) {
           ZS_LOG_ERROR(Detail, log("received voice RTCP packet failed") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return mError;
+          return error;
         }
 
         return 0;
       }
 
       //-----------------------------------------------------------------------
-      int MediaEngine::registerVideoExternalTransport(Transport &transport)
+      int MediaEngine::registerVideoExternalTransport(TransportPtr transport)
       {
         {
           AutoRecursiveLock lock(mLifetimeLock);
           
           ZS_LOG_DEBUG(log("register video external transport"))
           
-          mLifetimeWantVideoExternalTransport = &transport;
+          mLifetimeWantVideoExternalTransport = transport;
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
 
         return 0;
       }
@@ -1413,10 +1828,10 @@ namespace openpeer
           
           ZS_LOG_DEBUG(log("deregister video external transport"))
           
-          mLifetimeWantVideoExternalTransport = NULL;
+          mLifetimeWantVideoExternalTransport.reset();
         }
         
-        ThreadPtr(new boost::thread(boost::ref(*((mThisWeak.lock()).get()))));
+        notifyLifetimeWork();
 
         return 0;
       }
@@ -1424,22 +1839,19 @@ namespace openpeer
       //-----------------------------------------------------------------------
       int MediaEngine::receivedVideoRTPPacket(const void *data, size_t length)
       {
-        int channel = OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL;
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          if (mVideoEngineReady)
-            channel = mVideoChannel;
-        }
+        MediaEngine_ReceiveReader reader(mVideoReceiveReaders);
+
+        int channel = mVideoReceiveChannel.load(boost::memory_order_seq_cst);
 
         if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) {
           ZS_LOG_WARNING(Debug, log("video channel is not ready yet"))
           return -1;
         }
 
-        mError = mVideoNetwork->ReceivedRTPPacket(channel, data, length, webrtc::PacketTime());
-        if (0 != mError) {
+        int error = mVideoNetwork->ReceivedRTPPacket(channel, data, length, webrtc::PacketTime());
+        if (0 != error) {
           ZS_LOG_ERROR(Detail, log("received video RTP packet failed") + ZS_PARAM("error", mVideoBase->LastError()))
-          return mError;
+          return error;
         }
 
         return 0;
@@ -1448,27 +1860,143 @@ namespace openpeer
       //-----------------------------------------------------------------------
       int MediaEngine::receivedVideoRTCPPacket(const void *data, size_t length)
       {
-        int channel = OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL;
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          if (mVideoEngineReady)
-            channel = mVideoChannel;
-        }
+        MediaEngine_ReceiveReader reader(mVideoReceiveReaders);
+
+        int channel = mVideoReceiveChannel.load(boost::memory_order_seq_cst);
 
         if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) {
           ZS_LOG_WARNING(Debug, log("video channel is not ready yet"))
           return -1;
         }
 
-        mError = mVideoNetwork->ReceivedRTCPPacket(channel, data, length);
-        if (0 != mError) {
+        int error = mVideoNetwork->ReceivedRTCPPacket(channel, data, length);
+        if (0 != error) {
           ZS_LOG_ERROR(Detail, log("received video RTCP packet failed") + ZS_PARAM("error", mVideoBase->LastError()))
-          return mError;
+          return error;
+        }
+
+        return 0;
+      }
+
+      //-----------------------------------------------------------------------
+      MediaEngine::VoiceSessionPtr MediaEngine::startVoiceSession(
+                                                                  TransportPtr transport,
+                                                                  PUID callID,
+                                                                  const VoiceCodecInfo &codec
+                                                                  )
+      {
+        VoiceSessionPtr session(new VoiceSession(transport, callID, codec));
+
+        {
+          AutoRecursiveLock lock(mLifetimeLock);
+
+          ZS_LOG_DEBUG(log("start voice session") + ZS_PARAM("session", session->mID) + ZS_PARAM("call", callID))
+
+          mLifetimeWantVoiceSessions[session->mID] = session;
+        }
+
+        {
+          AutoLock lock(mQualityLock);
+          CallMediaQuality &quality = mCallQuality[callID];
+          if (0 == quality.mCallID) {
+            quality.mCallID = callID;
+            quality.mStarted = zsLib::now();
+          }
+        }
+
+        notifyLifetimeWork();
+
+        return session;
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::stopVoiceSession(VoiceSessionPtr session)
+      {
+        if (!session) return;
+
+        // the session keeps the transport alive until no sender is left
+        // inside it (released by the lifetime thread when still in use)
+        session->mTransport.redirect(TransportPtr());
+
+        {
+          AutoRecursiveLock lock(mLifetimeLock);
+
+          ZS_LOG_DEBUG(log("stop voice session") + ZS_PARAM("session", session->mID))
+
+          mLifetimeWantVoiceSessions.erase(session->mID);
+        }
+
+        notifyLifetimeWork();
+      }
+
+      //-----------------------------------------------------------------------
+      int MediaEngine::receivedVoiceSessionRTPPacket(const VoiceSession &session, const void *data, size_t length)
+      {
+        MediaEngine_ReceiveReader reader(session.mReceiveReaders);
+
+        int channel = session.mChannel.load(boost::memory_order_seq_cst);
+
+        if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) {
+          OPENPEER_CORE_LOG_HOT_TRACE(log("voice session channel is not ready yet") + ZS_PARAM("session", session.mID))
+          return -1;
+        }
+
+        int error = mVoiceNetwork->ReceivedRTPPacket(channel, data, length);
+        if (0 != error) {
+          ZS_LOG_ERROR(Detail, log("received voice session RTP packet failed") + ZS_PARAM("session", session.mID) + ZS_PARAM("error", mVoiceBase->LastError()))
+          return error;
+        }
+
+        return 0;
+      }
+
+      //-----------------------------------------------------------------------
+      int MediaEngine::receivedVoiceSessionRTCPPacket(const VoiceSession &session, const void *data, size_t length)
+      {
+        MediaEngine_ReceiveReader reader(session.mReceiveReaders);
+
+        int channel = session.mChannel.load(boost::memory_order_seq_cst);
+
+        if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) {
+          OPENPEER_CORE_LOG_HOT_TRACE(log("voice session channel is not ready yet") + ZS_PARAM("session", session.mID))
+          return -1;
+        }
+
+        int error = mVoiceNetwork->ReceivedRTCPPacket(channel, data, length);
+        if (0 != error) {
+          ZS_LOG_ERROR(Detail, log("received voice session RTCP packet failed") + ZS_PARAM("session", session.mID) + ZS_PARAM("error", mVoiceBase->LastError()))
+          return error;
         }
 
         return 0;
       }
 
+      //-----------------------------------------------------------------------
+      ElementPtr MediaEngine::getMediaQuality(PUID callID) const
+      {
+        AutoLock lock(mQualityLock);
+
+        CallMediaQualityMap::const_iterator found = mCallQuality.find(callID);
+        if (found == mCallQuality.end()) return ElementPtr();
+
+        return (*found).second.toDebug();
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr MediaEngine::finalizeMediaQuality(PUID callID)
+      {
+        AutoLock lock(mQualityLock);
+
+        CallMediaQualityMap::iterator found = mCallQuality.find(callID);
+        if (found == mCallQuality.end()) return ElementPtr();
+
+        ElementPtr resultEl = (*found).second.toDebug();
+        mCallQuality.erase(found);
+
+        ZS_LOG_DETAIL(log("call media quality summary") + resultEl)
+        return resultEl;
+      }
+
       //---------------------------------------------------------------------
       //---------------------------------------------------------------------
       //---------------------------------------------------------------------
@@ -1501,10 +2029,10 @@ namespace openpeer
           case webrtc::kTraceMemory:
           case webrtc::kTraceTimer:
           case webrtc::kTraceStream:
-            ZS_LOG_TRACE(log(traceString))
+            OPENPEER_CORE_LOG_HOT_TRACE(log(traceString))
             break;
           default:
-            ZS_LOG_TRACE(log(traceString))
+            OPENPEER_CORE_LOG_HOT_TRACE(log(traceString))
             break;
         }
       }
@@ -1650,12 +2178,126 @@ namespace openpeer
         pthread_setname_np("org.openpeer.core.mediaEngine");
 #endif
 #endif
-        ZS_LOG_DEBUG(log("media engine lifetime thread spawned"))
+        ZS_LOG_DEBUG(log("media engine lifetime thread started"))
+
+        Time nextSample;
+        Time nextAdapt;
+
+        while (true)
+        {
+          Duration sampleInterval;
+          bool sampleDue = false;
+          bool adaptDue = false;
+
+          {
+            boost::unique_lock<boost::mutex> lock(mLifetimeWorkMutex);
+            while ((!mLifetimeWorkPending) &&
+                   (!mLifetimeWorkShutdown)) {
+              // quality sampling and voice adaptation tick independently so
+              // turning off the sampling never turns off the adaptation
+              bool adapt = false;
+              if (mLifetimeWorkSampling) {
+                SettingsSnapshotPtr settings = UseSettings::snapshot();
+                sampleInterval = settings->mMediaEngineQualitySampleInterval;
+                adapt = settings->mMediaEngineAdaptVoiceCodec;
+              }
+
+              Time tick = zsLib::now();
+
+              if ((!mLifetimeWorkSampling) ||
+                  (Duration() == sampleInterval)) {
+                nextSample = Time();
+              } else if (Time() == nextSample) {
+                nextSample = tick + sampleInterval;
+              }
+
+              if (!adapt) {
+                nextAdapt = Time();
+              } else if (Time() == nextAdapt) {
+                nextAdapt = tick + Seconds(OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_INTERVAL_IN_SECONDS);
+              }
+
+              if ((Time() == nextSample) &&
+                  (Time() == nextAdapt)) {
+                mLifetimeWorkCondition.wait(lock);
+                continue;
+              }
+
+              sampleDue = ((Time() != nextSample) && (tick >= nextSample));
+              adaptDue = ((Time() != nextAdapt) && (tick >= nextAdapt));
+              if ((sampleDue) || (adaptDue)) break;
+
+              Time wakeAt = nextSample;
+              if ((Time() == wakeAt) ||
+                  ((Time() != nextAdapt) && (nextAdapt < wakeAt))) {
+                wakeAt = nextAdapt;
+              }
+              mLifetimeWorkCondition.timed_wait(lock, wakeAt);
+            }
+            if (mLifetimeWorkShutdown) break;
+
+            // every request made until now is satisfied by the pass below
+            if ((!sampleDue) && (!adaptDue)) mLifetimeWorkPending = false;
+          }
+
+          if ((sampleDue) || (adaptDue)) {
+            if (adaptDue) {
+              nextAdapt = Time();
+              internalAdaptMediaQuality();
+            }
+            if (sampleDue) {
+              nextSample = Time();
+              internalSampleMediaQuality(sampleInterval);
+            }
+            continue;
+          }
+
+          if (internalLifetimeStep()) {
+            ZS_LOG_DEBUG(log("repeating media thread operation again"))
+            boost::unique_lock<boost::mutex> lock(mLifetimeWorkMutex);
+            mLifetimeWorkPending = true;
+          }
+        }
 
+        ZS_LOG_DEBUG(log("media engine lifetime thread completed"))
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::notifyLifetimeWork()
+      {
+        {
+          boost::unique_lock<boost::mutex> lock(mLifetimeWorkMutex);
+          if (mLifetimeWorkShutdown) return;
+
+          mLifetimeWorkPending = true;
+
+          if (!mLifetimeThread) {
+            mLifetimeThread = ThreadPtr(new boost::thread(boost::ref(*this)));
+            return;
+          }
+        }
+        mLifetimeWorkCondition.notify_one();
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::releaseLifetimeInProgress()
+      {
+        AutoRecursiveLock lock(mLifetimeLock);
+        mLifetimeInProgress = false;
+
+        if (!mLifetimeWorkDeferred) return;
+        mLifetimeWorkDeferred = false;
+
+        ZS_LOG_DEBUG(log("resuming deferred media lifetime work"))
+        notifyLifetimeWork();
+      }
+
+      //-----------------------------------------------------------------------
+      bool MediaEngine::internalLifetimeStep()
+      {
         bool repeat = false;
         bool refreshStatus = false;
-
-        bool firstAttempt = true;
+        bool sampling = false;
 
         bool wantAudio = false;
         bool wantVideoCapture = false;
@@ -1696,21 +2338,22 @@ namespace openpeer
         bool wantSaveVideoToLibrary = false;
         RtpRtcpStatistics videoTransportStatistics;
         RtpRtcpStatistics voiceTransportStatistics;
-        Transport *wantVoiceExternalTransport = NULL;
-        Transport *wantVideoExternalTransport = NULL;
-
-        // attempt to get the lifetime lock
-        while (true)
+        TransportPtr wantVoiceExternalTransport;
+        TransportPtr wantVideoExternalTransport;
+        VoiceSessionMap wantVoiceSessions;
+        PUID wantVoiceCallID = 0;
+        VoiceCodecInfo wantVoiceCodec;
+        bool wantConferenceEnabled = false;
+        Time voiceStartRequested;
+        Time videoStartRequested;
+
+        // snapshot the desired state (every change queued since the last pass is applied at once)
         {
-          if (!firstAttempt) {
-            boost::this_thread::sleep(zsLib::Milliseconds(10));       // do not hammer CPU
-          }
-          firstAttempt = false;
-
           AutoRecursiveLock lock(mLifetimeLock);
           if (mLifetimeInProgress) {
-            ZS_LOG_WARNING(Debug, log("could not obtain media lifetime lock"))
-            continue;
+            ZS_LOG_DEBUG(log("media lifetime in progress elsewhere (will run once released)"))
+            mLifetimeWorkDeferred = true;
+            return false;
           }
 
           mLifetimeInProgress = true;
@@ -1759,12 +2402,34 @@ namespace openpeer
           wantSaveVideoToLibrary = mLifetimeWantSaveVideoToLibrary;
           wantVoiceExternalTransport = mLifetimeWantVoiceExternalTransport;
           wantVideoExternalTransport = mLifetimeWantVideoExternalTransport;
-          break;
+          wantVoiceSessions = mLifetimeWantVoiceSessions;
+          wantVoiceCallID = mLifetimeWantVoiceCallID;
+          wantVoiceCodec = mLifetimeWantVoiceCodec;
+          wantConferenceEnabled = mLifetimeWantConferenceEnabled;
+          voiceStartRequested = mLifetimeVoiceStartRequested;
+          videoStartRequested = mLifetimeVideoStartRequested;
         }
 
         {
           AutoRecursiveLock lock(mLock);
-          
+
+          bool needEngine = (wantAudio) || (wantVideoCapture) || (wantVideoChannel) || (wantRecordVideoCapture) || (wantVoiceSessions.size() > 0);
+
+          // until the engines exist the settings below remain queued in the lifetime "want" state
+          bool engineCreated = false;
+          if ((mMediaEngineCreated) ||
+              (needEngine)) {
+            if (!mMediaEngineCreated) refreshStatus = true;
+            engineCreated = createMediaEngine();
+          }
+
+          if ((needEngine) &&
+              (!engineCreated)) {
+            ZS_LOG_ERROR(Detail, log("media engine is not available thus voice/video cannot be started"))
+            wantAudio = wantVideoCapture = wantVideoChannel = wantRecordVideoCapture = false;
+            refreshStatus = false;
+          }
+
           if (wantFrontCameraCaptureCapability.width != mFrontCameraCaptureCapability.width ||
               wantFrontCameraCaptureCapability.height != mFrontCameraCaptureCapability.height ||
               wantFrontCameraCaptureCapability.maxFPS != mFrontCameraCaptureCapability.maxFPS) {
@@ -1797,17 +2462,20 @@ namespace openpeer
             mChannelRenderViewCropBottom = wantChannelRenderViewCropBottom;
           }
           
-          if (wantEcEnabled != mEcEnabled) {
+          if ((engineCreated) &&
+              (wantEcEnabled != mEcEnabled)) {
             mEcEnabled = wantEcEnabled;
             internalSetEcEnabled(wantEcEnabled);
           }
           
-          if (wantAgcEnabled != mAgcEnabled) {
+          if ((engineCreated) &&
+              (wantAgcEnabled != mAgcEnabled)) {
             mAgcEnabled = wantAgcEnabled;
             internalSetAgcEnabled(wantAgcEnabled);
           }
           
-          if (wantNsEnabled != mNsEnabled) {
+          if ((engineCreated) &&
+              (wantNsEnabled != mNsEnabled)) {
             mNsEnabled = wantNsEnabled;
             internalSetNsEnabled(wantNsEnabled);
           }
@@ -1816,12 +2484,14 @@ namespace openpeer
             mVoiceRecordFile = wantVoiceRecordFile;
           }
           
-          if (wantMuteEnabled != mMuteEnabled) {
+          if ((engineCreated) &&
+              (wantMuteEnabled != mMuteEnabled)) {
             mMuteEnabled = wantMuteEnabled;
             internalSetMuteEnabled(wantMuteEnabled);
           }
           
-          if (wantLoudspeakerEnabled != mLoudspeakerEnabled) {
+          if ((engineCreated) &&
+              (wantLoudspeakerEnabled != mLoudspeakerEnabled)) {
             mLoudspeakerEnabled = wantLoudspeakerEnabled;
             internalSetLoudspeakerEnabled(wantLoudspeakerEnabled);
           }
@@ -1841,6 +2511,39 @@ namespace openpeer
           if (wantContinuousVideoCapture != mContinuousVideoCapture) {
             mContinuousVideoCapture = wantContinuousVideoCapture;
           }
+
+          if (wantVoiceCallID != mVoiceCallID) {
+            mVoiceCallID = wantVoiceCallID;
+          }
+
+          if ((wantVoiceCodec.hasData()) &&
+              (wantVoiceCodec != mVoiceCodecInfo)) {
+            ZS_LOG_DEBUG(log("voice codec changing") + ZS_PARAM("was", mVoiceCodecInfo.toDebug()) + ZS_PARAM("desired", wantVoiceCodec.toDebug()))
+            mVoiceCodecInfo = wantVoiceCodec;
+            mVoiceSendBitrate = wantVoiceCodec.mStartBitrate;
+            mVoiceHealthySamples = 0;
+            if ((engineCreated) &&
+                (hasAudio) &&
+                (wantAudio)) {
+              // the channel keeps running, only the send codec is swapped
+              setVoiceSendCodec(mVoiceChannel, mVoiceCodecInfo, mVoiceSendBitrate);
+
+              if (mVoiceFECEnabled) {
+                // adaptation re-enables redundancy with the new RED payload type (if it was offered)
+                mError = mVoiceRtpRtcp->SetFECStatus(mVoiceChannel, false);
+                if (mError != 0) {
+                  ZS_LOG_ERROR(Detail, log("failed to disable voice FEC") + ZS_PARAM("error", mVoiceBase->LastError()))
+                } else {
+                  mVoiceFECEnabled = false;
+                }
+              }
+            }
+          }
+
+          if (wantConferenceEnabled != mConferenceEnabled) {
+            ZS_LOG_DEBUG(log("conference mode changing") + ZS_PARAM("enabled", wantConferenceEnabled))
+            mConferenceEnabled = wantConferenceEnabled;
+          }
           
           if (wantVoiceExternalTransport != mVoiceExternalTransport) {
             mVoiceExternalTransport = wantVoiceExternalTransport;
@@ -1907,6 +2610,7 @@ namespace openpeer
 
           if (wantAudio) {
             if (!hasAudio) {
+              mRedirectVoiceTransport.armFirstPacket(voiceStartRequested);
               internalStartVoice();
               refreshStatus = true;
             }
@@ -1917,6 +2621,34 @@ namespace openpeer
             }
           }
 
+          for (VoiceSessionMap::iterator sessionIter = mVoiceSessions.begin(); sessionIter != mVoiceSessions.end(); )
+          {
+            VoiceSessionMap::iterator current = sessionIter;
+            ++sessionIter;
+
+            if (wantVoiceSessions.end() != wantVoiceSessions.find(current->first)) continue;
+
+            internalStopVoiceSession(current->second);
+            if (!current->second->mTransport.reclaim()) {
+              mRetiredVoiceSessions.push_back(current->second);
+            }
+            mVoiceSessions.erase(current);
+          }
+
+          if (engineCreated) {
+            for (VoiceSessionMap::iterator sessionIter = wantVoiceSessions.begin(); sessionIter != wantVoiceSessions.end(); ++sessionIter)
+            {
+              if (mVoiceSessions.end() != mVoiceSessions.find(sessionIter->first)) continue;
+
+              if (internalStartVoiceSession(sessionIter->second)) {
+                mVoiceSessions[sessionIter->first] = sessionIter->second;
+              }
+            }
+
+            // every started voice channel now exists so the mixer can follow
+            internalUpdateConference();
+          }
+
           if (wantVideoChannel) {
             if (wantChannelRenderView != mChannelRenderView) {
               if (hasVideoChannel) {
@@ -1937,6 +2669,7 @@ namespace openpeer
 
           if (wantVideoChannel) {
             if (!hasVideoChannel) {
+              mRedirectVideoTransport.armFirstPacket(videoStartRequested);
               internalStartVideoChannel();
               refreshStatus = true;
             }
@@ -1969,6 +2702,15 @@ namespace openpeer
             internalGetVideoTransportStatistics(videoTransportStatistics);
             internalGetVoiceTransportStatistics(voiceTransportStatistics);
           }
+
+          sampling = (((OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL != mVoiceChannel) &&
+                       (0 != mVoiceCallID)) ||
+                      (mVoiceSessions.size() > 0));
+        }
+
+        {
+          boost::unique_lock<boost::mutex> lock(mLifetimeWorkMutex);
+          mLifetimeWorkSampling = sampling;
         }
 
         {
@@ -1993,13 +2735,112 @@ namespace openpeer
           mLifetimeInProgress = false;
         }
 
-        if (repeat) {
-          ZS_LOG_DEBUG(log("repeating media thread operation again"))
-          (*this)();
-          return;
+        if (!internalReclaimTransports()) {
+          // a sender is still inside a retired transport (it leaves within microseconds)
+          boost::this_thread::yield();
+          repeat = true;
         }
 
-        ZS_LOG_DEBUG(log("media engine lifetime thread completed"))
+        return repeat;
+      }
+
+      //-----------------------------------------------------------------------
+      bool MediaEngine::internalReclaimTransports()
+      {
+        // only ever called from the media engine lifetime thread
+        bool reclaimed = true;
+
+        if (!mRedirectVoiceTransport.reclaim()) reclaimed = false;
+        if (!mRedirectVideoTransport.reclaim()) reclaimed = false;
+
+        for (VoiceSessionList::iterator iter = mRetiredVoiceSessions.begin(); iter != mRetiredVoiceSessions.end(); )
+        {
+          VoiceSessionList::iterator current = iter;
+          ++iter;
+
+          if (!(*current)->mTransport.reclaim()) {
+            reclaimed = false;
+            continue;
+          }
+          mRetiredVoiceSessions.erase(current);
+        }
+
+        return reclaimed;
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::internalAdaptMediaQuality()
+      {
+        AutoRecursiveLock lock(mLock);
+
+        if (0 == mVoiceCallID) return;
+        if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == mVoiceChannel) return;
+
+        RtpRtcpStatistics voiceStat;
+        if (0 != internalGetVoiceTransportStatistics(voiceStat)) return;
+
+        internalAdaptVoiceCodec(voiceStat);
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::internalSampleMediaQuality(Duration interval)
+      {
+        MediaQualitySampleList samples;
+
+        // the mixer never logs from the audio threads
+        mAudioMixer.logStatistics();
+
+        {
+          AutoRecursiveLock lock(mLock);
+
+          // the focused call
+          if (0 != mVoiceCallID) {
+            MediaQualitySample sample;
+            sample.mCallID = mVoiceCallID;
+            if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL != mVoiceChannel) {
+              sample.mHasVoice = (0 == internalGetVoiceTransportStatistics(sample.mVoice));
+            }
+            if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL != mVideoReceiveChannel.load(boost::memory_order_acquire)) {
+              sample.mHasVideo = (0 == internalGetVideoTransportStatistics(sample.mVideo));
+            }
+            samples.push_back(sample);
+          }
+
+          // every other call with a started voice session (lifetime thread only)
+          for (VoiceSessionMap::iterator iter = mVoiceSessions.begin(); iter != mVoiceSessions.end(); ++iter)
+          {
+            VoiceSessionPtr &session = (*iter).second;
+            if (session->mCallID == mVoiceCallID) continue;
+
+            int channel = session->mChannel.load(boost::memory_order_acquire);
+            if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) continue;
+
+            MediaQualitySample sample;
+            sample.mCallID = session->mCallID;
+            sample.mHasVoice = (0 == internalGetVoiceChannelStatistics(channel, sample.mVoice));
+            samples.push_back(sample);
+          }
+        }
+
+        Time tick = zsLib::now();
+        Duration maxGap = interval * 3;     // counters older than this are a previous focus period, not a rate
+
+        AutoLock lock(mQualityLock);
+
+        for (MediaQualitySampleList::iterator iter = samples.begin(); iter != samples.end(); ++iter)
+        {
+          MediaQualitySample &sample = (*iter);
+
+          CallMediaQualityMap::iterator found = mCallQuality.find(sample.mCallID);
+          if (found == mCallQuality.end()) {
+            OPENPEER_CORE_LOG_HOT_TRACE(log("call media quality already finalized (thus ignoring sample)") + ZS_PARAM("call", sample.mCallID))
+            continue;
+          }
+
+          CallMediaQuality &quality = (*found).second;
+          if (sample.mHasVoice) quality.mVoice.record(sample.mVoice, tick, maxGap);
+          if (sample.mHasVideo) quality.mVideo.record(sample.mVideo, tick, maxGap);
+        }
       }
       
       //-----------------------------------------------------------------------
@@ -2269,10 +3110,19 @@ namespace openpeer
       
       //-----------------------------------------------------------------------
       int MediaEngine::internalGetVoiceTransportStatistics(RtpRtcpStatistics &stat)
+      {
+        return internalGetVoiceChannelStatistics(mVoiceChannel, stat);
+      }
+
+      //-----------------------------------------------------------------------
+      int MediaEngine::internalGetVoiceChannelStatistics(
+                                                         int channel,
+                                                         RtpRtcpStatistics &stat
+                                                         )
       {
         webrtc::CallStatistics callStat;
-        
-        mError = mVoiceRtpRtcp->GetRTCPStatistics(mVoiceChannel, callStat);
+
+        mError = mVoiceRtpRtcp->GetRTCPStatistics(channel, callStat);
         if (0 != mError) {
           ZS_LOG_ERROR(Detail, log("failed to get RTCP statistics for voice") + ZS_PARAM("error", mVoiceBase->LastError()))
           return mError;
@@ -2291,6 +3141,37 @@ namespace openpeer
         return 0;
       }
 
+      //-----------------------------------------------------------------------
+      void MediaEngine::waitForReceiveReaders(
+                                              boost::atomic<ULONG> &readers,
+                                              const char *channelType
+                                              )
+      {
+        // the channel was unpublished (seq_cst) before this is called so any
+        // reader arriving now loads the invalid channel; the readers already
+        // inside a Received*Packet call must leave before the channel is
+        // deleted (they never block on the lifetime thread so this drains);
+        // each channel counts its own readers so traffic on the other
+        // channels never delays this
+        Time start = zsLib::now();
+        bool warned = false;
+        ULONG spins = 0;
+
+        while (0 != readers.load(boost::memory_order_seq_cst)) {
+          ++spins;
+          if ((!warned) &&
+              (zsLib::now() - start > Milliseconds(OPENPEER_MEDIA_ENGINE_RECEIVE_READERS_WARN_AFTER_IN_MILLISECONDS))) {
+            ZS_LOG_WARNING(Detail, log("receive path readers are slow to leave the channel being stopped") + ZS_PARAM("channel type", channelType) + ZS_PARAM("readers", readers.load()) + ZS_PARAM("spins", spins))
+            warned = true;
+          }
+          boost::this_thread::yield();
+        }
+
+        if (0 != spins) {
+          ZS_LOG_DEBUG(log("receive path readers left") + ZS_PARAM("channel type", channelType) + ZS_PARAM("spins", spins))
+        }
+      }
+
       //-----------------------------------------------------------------------
       void MediaEngine::internalStartVoice()
       {
@@ -2348,47 +3229,23 @@ namespace openpeer
           return;
         }
 #endif
-        webrtc::CodecInst cinst;
-        memset(&cinst, 0, sizeof(webrtc::CodecInst));
-        for (int idx = 0; idx < mVoiceCodec->NumOfCodecs(); idx++) {
-          mError = mVoiceCodec->GetCodec(idx, cinst);
-          if (mError != 0) {
-            ZS_LOG_ERROR(Detail, log("failed to get voice codec") + ZS_PARAM("error", mVoiceBase->LastError()))
-            return;
-          }
-#ifdef OPENPEER_MEDIA_ENGINE_VOICE_CODEC_ISAC
-          if (strcmp(cinst.plname, "ISAC") == 0) {
-            strcpy(cinst.plname, "ISAC");
-            cinst.pltype = 103;
-            cinst.rate = 32000;
-            cinst.pacsize = 480; // 30ms
-            cinst.plfreq = 16000;
-            cinst.channels = 1;
-            mError = mVoiceCodec->SetSendCodec(mVoiceChannel, cinst);
-            if (mError != 0) {
-              ZS_LOG_ERROR(Detail, log("failed to set send voice codec") + ZS_PARAM("error", mVoiceBase->LastError()))
-              return;
-            }
-            break;
-          }
-#elif defined OPENPEER_MEDIA_ENGINE_VOICE_CODEC_OPUS
-          if (strcmp(cinst.plname, "OPUS") == 0) {
-            strcpy(cinst.plname, "OPUS");
-            cinst.pltype = 110;
-            cinst.rate = 20000;
-            cinst.pacsize = 320; // 20ms
-            cinst.plfreq = 16000;
-            cinst.channels = 1;
-            mError = mVoiceCodec->SetSendCodec(mVoiceChannel, cinst);
-            if (mError != 0) {
-              ZS_LOG_ERROR(Detail, log("failed to set send voice codec") + ZS_PARAM("error", mVoiceBase->LastError()))
-              return;
-            }
-            break;
-          }
-#endif
+        if (!mVoiceCodecInfo.hasData()) {
+          VoiceCodecInfoList codecs = getVoiceCodecs();
+          mVoiceCodecInfo = codecs.back();
         }
-        
+        mVoiceSendBitrate = mVoiceCodecInfo.mStartBitrate;
+        mVoiceFECEnabled = false;
+        mVoiceDTXEnabled = false;
+        mVoiceHealthySamples = 0;
+
+        mError = registerVoiceReceiveCodecs(mVoiceChannel);
+        if (mError != 0)
+          return;
+
+        mError = setVoiceSendCodec(mVoiceChannel, mVoiceCodecInfo, mVoiceSendBitrate);
+        if (mError != 0)
+          return;
+
         webrtc::CodecInst cfinst;
         memset(&cfinst, 0, sizeof(webrtc::CodecInst));
         for (int idx = 0; idx < mVoiceCodec->NumOfCodecs(); idx++) {
@@ -2418,107 +3275,450 @@ namespace openpeer
           return;
         }
 
-        mError = mVoiceBase->StartReceive(mVoiceChannel);
-        if (mError != 0) {
-          ZS_LOG_ERROR(Detail, log("failed to start receiving voice") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
-        }
-        mError = mVoiceBase->StartPlayout(mVoiceChannel);
-        if (mError != 0) {
-          ZS_LOG_ERROR(Detail, log("failed to start playout") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
+        mError = mVoiceBase->StartReceive(mVoiceChannel);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to start receiving voice") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return;
+        }
+        mError = mVoiceBase->StartPlayout(mVoiceChannel);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to start playout") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return;
+        }
+        if (!mVoiceRecordFile.empty()) {
+          mError = mVoiceFile->StartRecordingCall(mVoiceRecordFile, &cfinst);
+          if (mError != 0) {
+            ZS_LOG_ERROR(Detail, log("failed to start call recording") + ZS_PARAM("error", mVoiceBase->LastError()))
+          }
+        }
+        
+        mVoiceReceiveChannel.store(mVoiceChannel, boost::memory_order_release);
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::internalStopVoice()
+      {
+        mVoiceReceiveChannel.store(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL, boost::memory_order_seq_cst);
+        waitForReceiveReaders(mVoiceReceiveReaders, "voice");
+
+        ZS_LOG_DEBUG(log("stop voice"))
+
+        internalRemoveConferenceChannel(mVoiceChannel);
+
+        mError = mVoiceBase->StopSend(mVoiceChannel);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to stop sending voice") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return;
+        }
+        mError = mVoiceBase->StopPlayout(mVoiceChannel);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to stop playout") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return;
+        }
+        mError = mVoiceBase->StopReceive(mVoiceChannel);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to stop receiving voice") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return;
+        }
+        if (!mVoiceRecordFile.empty()) {
+          mError = mVoiceFile->StopRecordingCall();
+          if (mError != 0) {
+            ZS_LOG_ERROR(Detail, log("failed to stop call recording") + ZS_PARAM("error", mVoiceBase->LastError()))
+          }
+          mVoiceRecordFile.erase();
+        }
+        mError = deregisterVoiceTransport();
+        if (0 != mError)
+          return;
+        mError = mVoiceBase->DeleteChannel(mVoiceChannel);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to delete voice channel") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return;
+        }
+
+        mVoiceChannel = OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL;
+      }
+      
+      //-----------------------------------------------------------------------
+      int MediaEngine::registerVoiceTransport()
+      {
+        if (NULL != mVoiceTransport) {
+          mError = mVoiceNetwork->RegisterExternalTransport(mVoiceChannel, *mVoiceTransport);
+          if (0 != mError) {
+            ZS_LOG_ERROR(Detail, log("failed to register voice external transport") + ZS_PARAM("error", mVoiceBase->LastError()))
+            return mError;
+          }
+        } else {
+          ZS_LOG_ERROR(Detail, log("external voice transport is not set"))
+          return -1;
+        }
+
+        return 0;
+      }
+      
+      //-----------------------------------------------------------------------
+      int MediaEngine::deregisterVoiceTransport()
+      {
+        mError = mVoiceNetwork->DeRegisterExternalTransport(mVoiceChannel);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to deregister voice external transport") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return mError;
+        }
+
+        return 0;
+      }
+
+      //-----------------------------------------------------------------------
+      int MediaEngine::setVoiceTransportParameters()
+      {
+        // No transport parameters for external transport.
+        return 0;
+      }
+
+      //-----------------------------------------------------------------------
+      int MediaEngine::setVoiceSendCodec(
+                                         int channel,
+                                         const VoiceCodecInfo &codec,
+                                         int bitrate
+                                         )
+      {
+        webrtc::CodecInst cinst;
+        memset(&cinst, 0, sizeof(webrtc::CodecInst));
+
+        bool found = false;
+        for (int idx = 0; idx < mVoiceCodec->NumOfCodecs(); idx++) {
+          mError = mVoiceCodec->GetCodec(idx, cinst);
+          if (mError != 0) {
+            ZS_LOG_ERROR(Detail, log("failed to get voice codec") + ZS_PARAM("error", mVoiceBase->LastError()))
+            return mError;
+          }
+          if (0 != codec.mName.compareNoCase(cinst.plname)) continue;
+          if (static_cast<int>(codec.mClockRate) != cinst.plfreq) continue;
+
+          found = true;
+          break;
+        }
+
+        if (!found) {
+          VoiceCodecInfoList codecs = getVoiceCodecs();
+          const VoiceCodecInfo &legacy = codecs.back();
+          if (0 == legacy.mName.compareNoCase(codec.mName)) {
+            ZS_LOG_ERROR(Detail, log("legacy voice codec is not available in the voice engine") + ZS_PARAM("codec", codec.toDebug()))
+            return -1;
+          }
+
+          ZS_LOG_WARNING(Detail, log("voice codec is not available in the voice engine (thus falling back to legacy codec)") + ZS_PARAM("codec", codec.toDebug()))
+          return setVoiceSendCodec(channel, legacy, legacy.mStartBitrate);
+        }
+
+        cinst.pltype = codec.mPayloadType;
+        cinst.pacsize = (cinst.plfreq / 1000) * codec.mPTime;
+        cinst.channels = codec.mChannels;
+        cinst.rate = (bitrate > 0 ? bitrate : codec.mStartBitrate);
+
+        ZS_LOG_DEBUG(log("setting send voice codec") + ZS_PARAM("channel", channel) + ZS_PARAM("codec", codec.toDebug()) + ZS_PARAM("bitrate", cinst.rate))
+
+        mError = mVoiceCodec->SetSendCodec(channel, cinst);
+        if (mError != 0) {
+          ZS_LOG_ERROR(Detail, log("failed to set send voice codec") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return mError;
+        }
+
+        return 0;
+      }
+
+      //-----------------------------------------------------------------------
+      int MediaEngine::registerVoiceReceiveCodecs(int channel)
+      {
+        VoiceCodecInfoList codecs = getVoiceCodecs();
+        codecs.push_back(getVoiceRedundancyCodec());
+
+        webrtc::CodecInst cinst;
+        memset(&cinst, 0, sizeof(webrtc::CodecInst));
+
+        for (int idx = 0; idx < mVoiceCodec->NumOfCodecs(); idx++) {
+          mError = mVoiceCodec->GetCodec(idx, cinst);
+          if (mError != 0) {
+            ZS_LOG_ERROR(Detail, log("failed to get voice codec") + ZS_PARAM("error", mVoiceBase->LastError()))
+            return mError;
+          }
+
+          for (VoiceCodecInfoList::iterator iter = codecs.begin(); iter != codecs.end(); ++iter)
+          {
+            const VoiceCodecInfo &codec = (*iter);
+            if (0 != codec.mName.compareNoCase(cinst.plname)) continue;
+            if (static_cast<int>(codec.mClockRate) != cinst.plfreq) continue;
+
+            // the remote party sends using the payload types offered in the local description
+            cinst.pltype = codec.mPayloadType;
+            mError = mVoiceCodec->SetRecPayloadType(channel, cinst);
+            if (mError != 0) {
+              ZS_LOG_ERROR(Detail, log("failed to set receive voice codec payload type") + ZS_PARAM("codec", codec.toDebug()) + ZS_PARAM("error", mVoiceBase->LastError()))
+              return mError;
+            }
+            break;
+          }
+        }
+
+        return 0;
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::internalAdaptVoiceCodec(const RtpRtcpStatistics &stat)
+      {
+        if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == mVoiceChannel) return;
+        if (!mVoiceCodecInfo.hasData()) return;
+
+        // the send side adapts to the loss the remote party reports about
+        // our stream (not the loss we measure on the stream we receive)
+        unsigned short fractionLost = 0;
+        bool hasLoss = internalGetVoiceRemoteFractionLost(fractionLost);
+        ULONG lossPercent = (static_cast<ULONG>(fractionLost) * 100) / 256;    // RTCP fraction lost is in 1/256ths
+
+        bool congested = ((hasLoss) && (lossPercent >= OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_CONGESTED_LOSS_PERCENT));
+        bool healthy = ((hasLoss) && (lossPercent <= OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_HEALTHY_LOSS_PERCENT));
+
+        int bitrate = mVoiceSendBitrate;
+        bool fec = mVoiceFECEnabled;
+
+        if ((congested) ||
+            (stat.rttMs >= OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_CONGESTED_RTT_MS)) {
+          mVoiceHealthySamples = 0;
+          bitrate = (bitrate * 3) / 4;
+        } else if (healthy) {
+          ++mVoiceHealthySamples;
+          if (mVoiceHealthySamples >= OPENPEER_MEDIA_ENGINE_VOICE_ADAPT_HEALTHY_SAMPLES_BEFORE_INCREASE) {
+            mVoiceHealthySamples = 0;
+            bitrate += (mVoiceCodecInfo.mMaxBitrate - mVoiceCodecInfo.mMinBitrate) / 8;
+          }
+        } else {
+          mVoiceHealthySamples = 0;
+        }
+
+        if (bitrate < mVoiceCodecInfo.mMinBitrate) bitrate = mVoiceCodecInfo.mMinBitrate;
+        if (bitrate > mVoiceCodecInfo.mMaxBitrate) bitrate = mVoiceCodecInfo.mMaxBitrate;
+
+        // hysteresis keeps redundancy from flapping around a single threshold
+        if (congested) fec = true;
+        else if (healthy) fec = false;
+
+        // redundancy is only sent when the remote party offered RED
+        if (mVoiceCodecInfo.mRedPayloadType < 0) fec = false;
+
+        bool dtx = (bitrate < mVoiceCodecInfo.mStartBitrate);
+
+        if (bitrate != mVoiceSendBitrate) {
+          if (0 == setVoiceSendCodec(mVoiceChannel, mVoiceCodecInfo, bitrate)) {
+            mVoiceSendBitrate = bitrate;
+          }
         }
-        if (!mVoiceRecordFile.empty()) {
-          mError = mVoiceFile->StartRecordingCall(mVoiceRecordFile, &cfinst);
+
+        if (fec != mVoiceFECEnabled) {
+          mError = mVoiceRtpRtcp->SetFECStatus(mVoiceChannel, fec, mVoiceCodecInfo.mRedPayloadType);
           if (mError != 0) {
-            ZS_LOG_ERROR(Detail, log("failed to start call recording") + ZS_PARAM("error", mVoiceBase->LastError()))
+            ZS_LOG_ERROR(Detail, log("failed to set voice FEC status") + ZS_PARAM("enabled", fec) + ZS_PARAM("error", mVoiceBase->LastError()))
+          } else {
+            mVoiceFECEnabled = fec;
           }
         }
-        
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          mVoiceEngineReady = true;
+
+        if (dtx != mVoiceDTXEnabled) {
+          mError = mVoiceCodec->SetVADStatus(mVoiceChannel, dtx, webrtc::kVadConventional, !dtx);
+          if (mError != 0) {
+            ZS_LOG_ERROR(Detail, log("failed to set voice DTX status") + ZS_PARAM("enabled", dtx) + ZS_PARAM("error", mVoiceBase->LastError()))
+          } else {
+            mVoiceDTXEnabled = dtx;
+          }
         }
+
+        OPENPEER_CORE_LOG_HOT_TRACE(log("adapted voice codec") + ZS_PARAM("remote loss (%)", hasLoss ? lossPercent : 0) + ZS_PARAM("has remote loss", hasLoss) + ZS_PARAM("rtt (ms)", stat.rttMs) + ZS_PARAM("bitrate", mVoiceSendBitrate) + ZS_PARAM("fec", mVoiceFECEnabled) + ZS_PARAM("dtx", mVoiceDTXEnabled))
       }
 
       //-----------------------------------------------------------------------
-      void MediaEngine::internalStopVoice()
+      bool MediaEngine::internalGetVoiceRemoteFractionLost(unsigned short &outFractionLost)
       {
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          mVoiceEngineReady = false;
+        unsigned int localSSRC = 0;
+        mError = mVoiceRtpRtcp->GetLocalSSRC(mVoiceChannel, localSSRC);
+        if (0 != mError) {
+          ZS_LOG_ERROR(Detail, log("failed to get local SSRC for voice") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return false;
         }
 
-        ZS_LOG_DEBUG(log("stop voice"))
-
-        mError = mVoiceBase->StopSend(mVoiceChannel);
-        if (mError != 0) {
-          ZS_LOG_ERROR(Detail, log("failed to stop sending voice") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
+        std::vector<webrtc::ReportBlock> blocks;
+        mError = mVoiceRtpRtcp->GetRemoteRTCPReportBlocks(mVoiceChannel, &blocks);
+        if (0 != mError) {
+          ZS_LOG_ERROR(Detail, log("failed to get remote RTCP report blocks for voice") + ZS_PARAM("error", mVoiceBase->LastError()))
+          return false;
         }
-        mError = mVoiceBase->StopPlayout(mVoiceChannel);
-        if (mError != 0) {
-          ZS_LOG_ERROR(Detail, log("failed to stop playout") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
+
+        for (std::vector<webrtc::ReportBlock>::iterator iter = blocks.begin(); iter != blocks.end(); ++iter)
+        {
+          const webrtc::ReportBlock &block = (*iter);
+          if (block.source_SSRC != localSSRC) continue;
+
+          outFractionLost = block.fraction_lost;
+          return true;
         }
-        mError = mVoiceBase->StopReceive(mVoiceChannel);
-        if (mError != 0) {
-          ZS_LOG_ERROR(Detail, log("failed to stop receiving voice") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
+
+        ZS_LOG_TRACE(log("no remote report block about the voice send stream yet") + ZS_PARAM("local ssrc", localSSRC) + ZS_PARAM("blocks", blocks.size()))
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      bool MediaEngine::internalStartVoiceSession(VoiceSessionPtr session)
+      {
+        ZS_LOG_DEBUG(log("start voice session channel") + ZS_PARAM("session", session->mID))
+
+        int channel = mVoiceBase->CreateChannel();
+        if (channel < 0) {
+          ZS_LOG_ERROR(Detail, log("could not create voice session channel") + ZS_PARAM("session", session->mID) + ZS_PARAM("error", mVoiceBase->LastError()))
+          return false;
         }
-        if (!mVoiceRecordFile.empty()) {
-          mError = mVoiceFile->StopRecordingCall();
-          if (mError != 0) {
-            ZS_LOG_ERROR(Detail, log("failed to stop call recording") + ZS_PARAM("error", mVoiceBase->LastError()))
-          }
-          mVoiceRecordFile.erase();
+
+        mError = mVoiceNetwork->RegisterExternalTransport(channel, session->mTransport);
+        if (0 != mError) {
+          ZS_LOG_ERROR(Detail, log("failed to register voice session external transport") + ZS_PARAM("session", session->mID) + ZS_PARAM("error", mVoiceBase->LastError()))
+          mVoiceBase->DeleteChannel(channel);
+          return false;
         }
-        mError = deregisterVoiceTransport();
-        if (0 != mError)
-          return;
-        mError = mVoiceBase->DeleteChannel(mVoiceChannel);
-        if (mError != 0) {
-          ZS_LOG_ERROR(Detail, log("failed to delete voice channel") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return;
+
+        // only the focused voice channel carries the microphone
+        if ((0 == registerVoiceReceiveCodecs(channel)) &&
+            (0 == setVoiceSendCodec(channel, session->mCodec, session->mCodec.mStartBitrate)) &&
+            (0 == mVoiceVolumeControl->SetInputMute(channel, true)) &&
+            (0 == mVoiceBase->StartSend(channel)) &&
+            (0 == mVoiceBase->StartReceive(channel)) &&
+            (0 == mVoiceBase->StartPlayout(channel))) {
+          session->mChannel.store(channel, boost::memory_order_release);
+          return true;
         }
 
-        mVoiceChannel = OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL;
+        ZS_LOG_ERROR(Detail, log("failed to start voice session channel") + ZS_PARAM("session", session->mID) + ZS_PARAM("error", mVoiceBase->LastError()))
+
+        mVoiceBase->StopSend(channel);
+        mVoiceBase->StopReceive(channel);
+        mVoiceNetwork->DeRegisterExternalTransport(channel);
+        mVoiceBase->DeleteChannel(channel);
+        return false;
       }
-      
+
       //-----------------------------------------------------------------------
-      int MediaEngine::registerVoiceTransport()
+      void MediaEngine::internalStopVoiceSession(VoiceSessionPtr session)
       {
-        if (NULL != mVoiceTransport) {
-          mError = mVoiceNetwork->RegisterExternalTransport(mVoiceChannel, *mVoiceTransport);
-          if (0 != mError) {
-            ZS_LOG_ERROR(Detail, log("failed to register voice external transport") + ZS_PARAM("error", mVoiceBase->LastError()))
-            return mError;
-          }
-        } else {
-          ZS_LOG_ERROR(Detail, log("external voice transport is not set"))
-          return -1;
+        int channel = session->mChannel.exchange(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL, boost::memory_order_seq_cst);
+        if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) return;
+
+        waitForReceiveReaders(session->mReceiveReaders, "voice session");
+
+        ZS_LOG_DEBUG(log("stop voice session channel") + ZS_PARAM("session", session->mID) + ZS_PARAM("channel", channel))
+
+        internalRemoveConferenceChannel(channel);
+
+        mVoiceBase->StopSend(channel);
+        mVoiceBase->StopPlayout(channel);
+        mVoiceBase->StopReceive(channel);
+
+        mError = mVoiceNetwork->DeRegisterExternalTransport(channel);
+        if (0 != mError) {
+          ZS_LOG_ERROR(Detail, log("failed to deregister voice session external transport") + ZS_PARAM("session", session->mID) + ZS_PARAM("error", mVoiceBase->LastError()))
         }
 
-        return 0;
+        mError = mVoiceBase->DeleteChannel(channel);
+        if (0 != mError) {
+          ZS_LOG_ERROR(Detail, log("failed to delete voice session channel") + ZS_PARAM("session", session->mID) + ZS_PARAM("error", mVoiceBase->LastError()))
+        }
       }
-      
+
       //-----------------------------------------------------------------------
-      int MediaEngine::deregisterVoiceTransport()
+      void MediaEngine::internalUpdateConference()
       {
-        mError = mVoiceNetwork->DeRegisterExternalTransport(mVoiceChannel);
-        if (mError != 0) {
-          ZS_LOG_ERROR(Detail, log("failed to deregister voice external transport") + ZS_PARAM("error", mVoiceBase->LastError()))
-          return mError;
+        ConferenceChannelMap channels;
+
+        if (mConferenceEnabled) {
+          int channel = mVoiceReceiveChannel.load(boost::memory_order_acquire);
+          if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL != channel) {
+            channels[channel] = mVoiceCallID;
+          }
+
+          for (VoiceSessionMap::iterator iter = mVoiceSessions.begin(); iter != mVoiceSessions.end(); ++iter)
+          {
+            VoiceSessionPtr session = (*iter).second;
+            channel = session->mChannel.load(boost::memory_order_acquire);
+            if (OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL == channel) continue;
+
+            channels[channel] = session->mCallID;
+          }
         }
 
-        return 0;
+        for (ConferenceChannelMap::iterator iter = mConferenceChannels.begin(); iter != mConferenceChannels.end(); )
+        {
+          ConferenceChannelMap::iterator current = iter;
+          ++iter;
+
+          ConferenceChannelMap::iterator found = channels.find((*current).first);
+          if ((found != channels.end()) &&
+              ((*found).second == (*current).second)) continue;
+
+          internalRemoveConferenceChannel((*current).first);
+        }
+
+        for (ConferenceChannelMap::iterator iter = channels.begin(); iter != channels.end(); ++iter)
+        {
+          int channel = (*iter).first;
+          PUID callID = (*iter).second;
+
+          if (mConferenceChannels.end() != mConferenceChannels.find(channel)) continue;
+
+          mError = mVoiceExternalMedia->RegisterExternalMediaProcessing(channel, webrtc::kPlaybackPerChannel, mAudioMixer);
+          if (0 != mError) {
+            ZS_LOG_ERROR(Detail, log("failed to register conference playback processing") + ZS_PARAM("channel", channel) + ZS_PARAM("error", mVoiceBase->LastError()))
+            continue;
+          }
+          mError = mVoiceExternalMedia->RegisterExternalMediaProcessing(channel, webrtc::kRecordingPerChannel, mAudioMixer);
+          if (0 != mError) {
+            ZS_LOG_ERROR(Detail, log("failed to register conference recording processing") + ZS_PARAM("channel", channel) + ZS_PARAM("error", mVoiceBase->LastError()))
+            mVoiceExternalMedia->DeRegisterExternalMediaProcessing(channel, webrtc::kPlaybackPerChannel);
+            continue;
+          }
+
+          if (channel != mVoiceChannel) {
+            // voice sessions carry the host microphone only while in conference
+            mError = mVoiceVolumeControl->SetInputMute(channel, false);
+            if (0 != mError) {
+              ZS_LOG_WARNING(Detail, log("failed to unmute conference voice session") + ZS_PARAM("channel", channel) + ZS_PARAM("error", mVoiceBase->LastError()))
+            }
+          }
+
+          mAudioMixer.addParticipant(channel, callID);
+          mConferenceChannels[channel] = callID;
+        }
+
+        ZS_LOG_DEBUG(log("conference updated") + ZS_PARAM("enabled", mConferenceEnabled) + ZS_PARAM("participants", mConferenceChannels.size()))
       }
 
       //-----------------------------------------------------------------------
-      int MediaEngine::setVoiceTransportParameters()
+      void MediaEngine::internalRemoveConferenceChannel(int channel)
       {
-        // No transport parameters for external transport.
-        return 0;
+        ConferenceChannelMap::iterator found = mConferenceChannels.find(channel);
+        if (found == mConferenceChannels.end()) return;
+
+        mConferenceChannels.erase(found);
+
+        // must be done before the channel is deleted
+        mAudioMixer.removeParticipant(channel);
+
+        mError = mVoiceExternalMedia->DeRegisterExternalMediaProcessing(channel, webrtc::kRecordingPerChannel);
+        if (0 != mError) {
+          ZS_LOG_WARNING(Detail, log("failed to deregister conference recording processing") + ZS_PARAM("channel", channel) + ZS_PARAM("error", mVoiceBase->LastError()))
+        }
+        mError = mVoiceExternalMedia->DeRegisterExternalMediaProcessing(channel, webrtc::kPlaybackPerChannel);
+        if (0 != mError) {
+          ZS_LOG_WARNING(Detail, log("failed to deregister conference playback processing") + ZS_PARAM("channel", channel) + ZS_PARAM("error", mVoiceBase->LastError()))
+        }
+
+        if (channel != mVoiceChannel) {
+          mVoiceVolumeControl->SetInputMute(channel, true);
+        }
       }
       
       //-----------------------------------------------------------------------
@@ -2910,19 +4110,14 @@ namespace openpeer
           internalStartChannelRenderer();
         }
         
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          mVideoEngineReady = true;
-        }
+        mVideoReceiveChannel.store(mVideoChannel, boost::memory_order_release);
       }
       
       //-----------------------------------------------------------------------
       void MediaEngine::internalStopVideoChannel()
       {
-        {
-          AutoRecursiveLock lock(mMediaEngineReadyLock);
-          mVideoEngineReady = false;
-        }
+        mVideoReceiveChannel.store(OPENPEER_MEDIA_ENGINE_INVALID_CHANNEL, boost::memory_order_seq_cst);
+        waitForReceiveReaders(mVideoReceiveReaders, "video");
         
         if (mChannelRenderView != NULL) {
           internalStopChannelRenderer();
@@ -3511,6 +4706,35 @@ namespace openpeer
         return Log::Params(message, "core::MediaEngine");
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark MediaEngine_RedirectTransportSender
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: counts a sender as inside the redirected transport for the
+      //          duration of a SendPacket/SendRTCPPacket call
+      class MediaEngine_RedirectTransportSender
+      {
+      public:
+        MediaEngine_RedirectTransportSender(boost::atomic<ULONG> &sending) :
+          mSending(sending)
+        {
+          mSending.fetch_add(1, boost::memory_order_seq_cst);
+        }
+
+        ~MediaEngine_RedirectTransportSender()
+        {
+          mSending.fetch_sub(1, boost::memory_order_seq_cst);
+        }
+
+      private:
+        boost::atomic<ULONG> &mSending;
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -3523,7 +4747,9 @@ namespace openpeer
       MediaEngine::RedirectTransport::RedirectTransport(const char *transportType) :
         mID(zsLib::createPUID()),
         mTransportType(transportType),
-        mTransport(0)
+        mTransport(NULL),
+        mSending(0),
+        mFirstPacketPending(false)
       {
       }
 
@@ -3538,29 +4764,40 @@ namespace openpeer
       //-----------------------------------------------------------------------
       int MediaEngine::RedirectTransport::SendPacket(int channel, const void *data, int len)
       {
-        Transport *transport = NULL;
-        {
-          AutoRecursiveLock lock(mLock);
-          transport = mTransport;
-        }
+        MediaEngine_RedirectTransportSender sender(mSending);
+
+        Transport *transport = mTransport.load(boost::memory_order_seq_cst);
         if (!transport) {
-          ZS_LOG_WARNING(Debug, log("RTP packet cannot be sent as no transport is not registered") + ZS_PARAM("channel", channel) + ZS_PARAM("length", len))
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(ZS_GET_SUBSYSTEM(), Debug, "core::MediaEngine::RedirectTransport::SendPacket", log("RTP packet cannot be sent as no transport is not registered") + ZS_PARAM("channel", channel) + ZS_PARAM("length", len))
           return 0;
         }
 
+        if (mFirstPacketPending.load(boost::memory_order_relaxed)) {
+          if (mFirstPacketPending.exchange(false, boost::memory_order_acquire)) {
+            ULONG latency = static_cast<ULONG>((zsLib::now() - mFirstPacketRequested).total_milliseconds());
+
+            ElementPtr latencyEl;
+            {
+              AutoLock lock(mFirstPacketLock);
+              mFirstPacketLatency.record(latency);
+              latencyEl = mFirstPacketLatency.toDebug("start to first packet", "ms");
+            }
+
+            ZS_LOG_DETAIL(log("first packet sent since start") + ZS_PARAM("channel", channel) + ZS_PARAM("latency (ms)", latency) + latencyEl)
+          }
+        }
+
         return transport->SendPacket(channel, data, len);
       }
 
       //-----------------------------------------------------------------------
       int MediaEngine::RedirectTransport::SendRTCPPacket(int channel, const void *data, int len)
       {
-        Transport *transport = NULL;
-        {
-          AutoRecursiveLock lock(mLock);
-          transport = mTransport;
-        }
+        MediaEngine_RedirectTransportSender sender(mSending);
+
+        Transport *transport = mTransport.load(boost::memory_order_seq_cst);
         if (!transport) {
-          ZS_LOG_WARNING(Debug, log("RTCP packet cannot be sent as no transport is not registered") + ZS_PARAM("channel", channel) + ZS_PARAM("length", len))
+          OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(ZS_GET_SUBSYSTEM(), Debug, "core::MediaEngine::RedirectTransport::SendRTCPPacket", log("RTCP packet cannot be sent as no transport is not registered") + ZS_PARAM("channel", channel) + ZS_PARAM("length", len))
           return 0;
         }
 
@@ -3576,10 +4813,54 @@ namespace openpeer
       #pragma mark
 
       //-----------------------------------------------------------------------
-      void MediaEngine::RedirectTransport::redirect(Transport *transport)
+      bool MediaEngine::RedirectTransport::redirect(TransportPtr transport)
       {
-        AutoRecursiveLock lock(mLock);
-        mTransport = transport;
+        {
+          AutoLock lock(mRetiredLock);
+
+          Transport *previous = mTransport.exchange(transport.get(), boost::memory_order_seq_cst);
+          if (previous != transport.get()) {
+            // a sender may still be inside the previous transport thus keep
+            // it alive until every sender left (see "reclaim")
+            if (mCurrent) mRetired.push_back(mCurrent);
+          }
+          mCurrent = transport;
+        }
+
+        bool reclaimed = reclaim();
+        ZS_LOG_DEBUG(log("transport redirected") + ZS_PARAM("previous released", reclaimed))
+        return reclaimed;
+      }
+
+      //-----------------------------------------------------------------------
+      bool MediaEngine::RedirectTransport::reclaim()
+      {
+        TransportList released;
+
+        {
+          AutoLock lock(mRetiredLock);
+          if (mRetired.size() < 1) return true;
+
+          // a sender entering after the redirect reads the new transport
+          // thus once none are inside the retired transports are unused
+          if (0 != mSending.load(boost::memory_order_seq_cst)) return false;
+
+          released.swap(mRetired);
+        }
+
+        // retired transports are destroyed outside the lock
+        ZS_LOG_DEBUG(log("released retired transports") + ZS_PARAM("total", released.size()))
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::RedirectTransport::armFirstPacket(Time requested)
+      {
+        if (Time() == requested) requested = zsLib::now();
+
+        // only ever called from the media engine lifetime thread before the channel starts sending
+        mFirstPacketRequested = requested;
+        mFirstPacketPending.store(true, boost::memory_order_release);
       }
 
       //-----------------------------------------------------------------------
@@ -3598,6 +4879,148 @@ namespace openpeer
         UseServicesHelper::debugAppend(objectEl, "type", mTransportType);
         return Log::Params(message, objectEl);
       }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark MediaEngine::MediaQualityHistograms
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::MediaQualityHistograms::reset()
+      {
+        mSamples = 0;
+        mJitter.reset();
+        mRtt.reset();
+        mLoss.reset();
+        mSendBitrate.reset();
+        mReceiveBitrate.reset();
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr MediaEngine::MediaQualityHistograms::toDebug(const char *name) const
+      {
+        ElementPtr resultEl = Element::create(name);
+
+        UseServicesHelper::debugAppend(resultEl, "samples", mSamples);
+        if (0 == mSamples) return resultEl;
+
+        UseServicesHelper::debugAppend(resultEl, mJitter.toDebug("jitter", "timestamp units"));
+        if (mRtt.hasData()) UseServicesHelper::debugAppend(resultEl, mRtt.toDebug("rtt", "ms"));
+        UseServicesHelper::debugAppend(resultEl, mLoss.toDebug("loss", "per mille"));
+        if (mSendBitrate.hasData()) UseServicesHelper::debugAppend(resultEl, mSendBitrate.toDebug("send bitrate", "kbps"));
+        if (mReceiveBitrate.hasData()) UseServicesHelper::debugAppend(resultEl, mReceiveBitrate.toDebug("receive bitrate", "kbps"));
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark MediaEngine::MediaQualityStatistics
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      MediaEngine::MediaQualityStatistics::MediaQualityStatistics()
+      {
+        memset(&mLast, 0, sizeof(mLast));
+      }
+
+      //-----------------------------------------------------------------------
+      void MediaEngine::MediaQualityStatistics::record(
+                                                       const RtpRtcpStatistics &stat,
+                                                       Time when,
+                                                       Duration maxGap
+                                                       )
+      {
+        if (mWindow.mSamples >= OPENPEER_MEDIA_ENGINE_QUALITY_WINDOW_SAMPLES) {
+          // the window shows recent quality that the call total would average away
+          mLastWindow = mWindow;
+          mWindow.reset();
+        }
+
+        MediaQualityHistograms *histograms[] = {&mTotal, &mWindow};
+
+        // the fraction lost only changes when a new RTCP report was made thus
+        // a stale report repeated across samples must not be counted again
+        bool reportChanged = ((0 != stat.extendedMax) &&
+                              ((Time() == mLastSampled) ||
+                               (stat.extendedMax != mLast.extendedMax) ||
+                               (stat.cumulativeLost != mLast.cumulativeLost)));
+
+        for (size_t index = 0; index < (sizeof(histograms) / sizeof(histograms[0])); ++index) {
+          MediaQualityHistograms &histogram = *(histograms[index]);
+
+          ++histogram.mSamples;
+          histogram.mJitter.record(stat.jitter);
+          if (stat.rttMs > 0) histogram.mRtt.record(static_cast<ULONG>(stat.rttMs));
+          if (reportChanged) histogram.mLoss.record((static_cast<ULONG>(stat.fractionLost) * 1000) / 256);    // RTCP fraction lost is in 1/256ths
+        }
+
+        if (Time() != mLastSampled) {
+          Duration elapsed = when - mLastSampled;
+          zsLib::ULONGLONG elapsedMs = elapsed.total_milliseconds();
+
+          // a channel restart resets its counters thus only count forward progress
+          if ((elapsedMs > 0) &&
+              (elapsed <= maxGap) &&
+              (stat.bytesSent >= mLast.bytesSent) &&
+              (stat.bytesReceived >= mLast.bytesReceived)) {
+            // bits per millisecond is kilobits per second
+            ULONG sendBitrate = static_cast<ULONG>((static_cast<zsLib::ULONGLONG>(stat.bytesSent - mLast.bytesSent) * 8) / elapsedMs);
+            ULONG receiveBitrate = static_cast<ULONG>((static_cast<zsLib::ULONGLONG>(stat.bytesReceived - mLast.bytesReceived) * 8) / elapsedMs);
+
+            for (size_t index = 0; index < (sizeof(histograms) / sizeof(histograms[0])); ++index) {
+              histograms[index]->mSendBitrate.record(sendBitrate);
+              histograms[index]->mReceiveBitrate.record(receiveBitrate);
+            }
+          }
+        }
+
+        mLast = stat;
+        mLastSampled = when;
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr MediaEngine::MediaQualityStatistics::toDebug(const char *name) const
+      {
+        ElementPtr resultEl = Element::create(name);
+
+        UseServicesHelper::debugAppend(resultEl, "samples", mTotal.mSamples);
+        if (0 == mTotal.mSamples) return resultEl;
+
+        UseServicesHelper::debugAppend(resultEl, "cumulative lost", mLast.cumulativeLost);
+        UseServicesHelper::debugAppend(resultEl, mTotal.toDebug("total"));
+        UseServicesHelper::debugAppend(resultEl, mWindow.toDebug("window"));
+        if (0 != mLastWindow.mSamples) UseServicesHelper::debugAppend(resultEl, mLastWindow.toDebug("last window"));
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark MediaEngine::CallMediaQuality
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      ElementPtr MediaEngine::CallMediaQuality::toDebug() const
+      {
+        ElementPtr resultEl = Element::create("core::MediaEngine::CallMediaQuality");
+
+        UseServicesHelper::debugAppend(resultEl, "call", mCallID);
+        UseServicesHelper::debugAppend(resultEl, "started", mStarted);
+        UseServicesHelper::debugAppend(resultEl, mVoice.toDebug("voice"));
+        if (0 != mVideo.mTotal.mSamples) UseServicesHelper::debugAppend(resultEl, mVideo.toDebug("video"));
+
+        return resultEl;
+      }
     }
 
     //-------------------------------------------------------------------------
@@ -32,12 +32,28 @@
 #include <openpeer/core/internal/core_Settings.h>
 
 #include <openpeer/core/internal/core.h>
+#include <openpeer/core/internal/core_Stack.h>
 
 #include <openpeer/services/IHelper.h>
 #include <openpeer/services/ISettings.h>
 
 #include <zsLib/XML.h>
 
+#include <boost/thread.hpp>
+
+#include <sys/stat.h>
+
+#if defined(__linux__) && !defined(OPENPEER_CORE_SETTINGS_NO_INOTIFY)
+#define OPENPEER_CORE_SETTINGS_USE_INOTIFY
+#endif //defined(__linux__) && !defined(OPENPEER_CORE_SETTINGS_NO_INOTIFY)
+
+#ifdef OPENPEER_CORE_SETTINGS_USE_INOTIFY
+#include <sys/inotify.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif //OPENPEER_CORE_SETTINGS_USE_INOTIFY
+
 namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_core) } }
 
 namespace openpeer
@@ -49,6 +65,119 @@ namespace openpeer
     namespace internal
     {
       ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+      ZS_DECLARE_TYPEDEF_PTR(IStackForInternal, UseStack)
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark SettingsSnapshot
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      SettingsSnapshot::SettingsSnapshot() :
+        mVersion(0),
+        mAccountBackgroundingPhase(0),
+        mConversationThreadHostBackgroundingPhase(0),
+        mConversationThreadHostPeerContactAutoFindInSeconds(0),
+        mCallTransportBundleMedia(false),
+        mCallTransportKeepSocketsWarm(false),
+        mCallTransportMaxConcurrentMediaSessions(0),
+        mMediaEngineAdaptVoiceCodec(false)
+      {
+      }
+
+      //-----------------------------------------------------------------------
+      bool SettingsSnapshot::operator==(const SettingsSnapshot &rValue) const
+      {
+        // the version is intentionally not compared
+        return ((mAccountBackgroundingPhase == rValue.mAccountBackgroundingPhase) &&
+                (mConversationThreadHostBackgroundingPhase == rValue.mConversationThreadHostBackgroundingPhase) &&
+                (mConversationThreadHostInactiveCloseTime == rValue.mConversationThreadHostInactiveCloseTime) &&
+                (mConversationThreadHostPeerContactAutoFindInSeconds == rValue.mConversationThreadHostPeerContactAutoFindInSeconds) &&
+                (mCallTransportBundleMedia == rValue.mCallTransportBundleMedia) &&
+                (mCallTransportKeepSocketsWarm == rValue.mCallTransportKeepSocketsWarm) &&
+                (mCallTransportWarmUpTime == rValue.mCallTransportWarmUpTime) &&
+                (mCallTransportMaxConcurrentMediaSessions == rValue.mCallTransportMaxConcurrentMediaSessions) &&
+                (mMediaEngineQualitySampleInterval == rValue.mMediaEngineQualitySampleInterval) &&
+                (mMediaEngineAdaptVoiceCodec == rValue.mMediaEngineAdaptVoiceCodec) &&
+                (mThreadMoveMessageToCacheTime == rValue.mThreadMoveMessageToCacheTime) &&
+                (mStackCoreThreadPriority == rValue.mStackCoreThreadPriority) &&
+                (mStackMediaThreadPriority == rValue.mStackMediaThreadPriority) &&
+                (mStackAuthorizedApplicationIDSplitChar == rValue.mStackAuthorizedApplicationIDSplitChar) &&
+                (mStackQueueStatisticsLogInterval == rValue.mStackQueueStatisticsLogInterval) &&
+                (mStackShutdownDeadline == rValue.mStackShutdownDeadline));
+      }
+
+      //-----------------------------------------------------------------------
+      bool SettingsSnapshot::operator!=(const SettingsSnapshot &rValue) const
+      {
+        return !((*this) == rValue);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr SettingsSnapshot::toDebug() const
+      {
+        ElementPtr resultEl = Element::create("core::SettingsSnapshot");
+
+        UseServicesHelper::debugAppend(resultEl, "version", mVersion);
+        UseServicesHelper::debugAppend(resultEl, "account backgrounding phase", mAccountBackgroundingPhase);
+        UseServicesHelper::debugAppend(resultEl, "conversation thread backgrounding phase", mConversationThreadHostBackgroundingPhase);
+        UseServicesHelper::debugAppend(resultEl, "conversation thread inactive close time", mConversationThreadHostInactiveCloseTime);
+        UseServicesHelper::debugAppend(resultEl, "conversation thread auto find (s)", mConversationThreadHostPeerContactAutoFindInSeconds);
+        UseServicesHelper::debugAppend(resultEl, "call bundle media", mCallTransportBundleMedia);
+        UseServicesHelper::debugAppend(resultEl, "call keep sockets warm", mCallTransportKeepSocketsWarm);
+        UseServicesHelper::debugAppend(resultEl, "call warm up time", mCallTransportWarmUpTime);
+        UseServicesHelper::debugAppend(resultEl, "call max concurrent media sessions", mCallTransportMaxConcurrentMediaSessions);
+        UseServicesHelper::debugAppend(resultEl, "media quality sample interval", mMediaEngineQualitySampleInterval);
+        UseServicesHelper::debugAppend(resultEl, "media adapt voice codec", mMediaEngineAdaptVoiceCodec);
+        UseServicesHelper::debugAppend(resultEl, "move message to cache time", mThreadMoveMessageToCacheTime);
+        UseServicesHelper::debugAppend(resultEl, "core thread priority", mStackCoreThreadPriority);
+        UseServicesHelper::debugAppend(resultEl, "media thread priority", mStackMediaThreadPriority);
+        UseServicesHelper::debugAppend(resultEl, "authorized application id split char", mStackAuthorizedApplicationIDSplitChar);
+        UseServicesHelper::debugAppend(resultEl, "queue statistics log interval", mStackQueueStatisticsLogInterval);
+        UseServicesHelper::debugAppend(resultEl, "shutdown deadline", mStackShutdownDeadline);
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ISettingsForInternal
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      SettingsSnapshotPtr ISettingsForInternal::snapshot()
+      {
+        static SettingsSnapshotPtr emptySnapshot(new SettingsSnapshot);
+
+        SettingsPtr singleton = Settings::singleton();
+        if (!singleton) return emptySnapshot;
+        return singleton->snapshot();
+      }
+
+      //-----------------------------------------------------------------------
+      void ISettingsForInternal::subscribeChanges(
+                                                  ISettingsChangedDelegatePtr delegate,
+                                                  IMessageQueuePtr queue
+                                                  )
+      {
+        SettingsPtr singleton = Settings::singleton();
+        if (!singleton) return;
+        singleton->subscribeChanges(delegate, queue);
+      }
+
+      //-----------------------------------------------------------------------
+      void ISettingsForInternal::unsubscribeChanges(ISettingsChangedDelegatePtr delegate)
+      {
+        SettingsPtr singleton = Settings::singleton();
+        if (!singleton) return;
+        singleton->unsubscribeChanges(delegate);
+      }
 
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -71,7 +200,7 @@ namespace openpeer
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       #pragma mark
-      #pragma mark ISettingsForStack
+      #pragma mark ISettingsForThread
       #pragma mark
 
       //-----------------------------------------------------------------------
@@ -82,6 +211,288 @@ namespace openpeer
         return singleton->getThreadMoveMessageToCacheTimeInSeconds();
       }
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark SettingsFileWatcher
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      SettingsFileWatcher::SettingsFileWatcher(const char *fileName) :
+        mFileName(fileName),
+        mShouldShutdown(false),
+        mNotifyFD(-1),
+        mWatchFD(-1),
+        mLastModified(0)
+      {
+        String::size_type pos = mFileName.rfind('/');
+        if (String::npos == pos) {
+          mDirectory = ".";
+          mBaseName = mFileName;
+        } else {
+          mDirectory = mFileName.substr(0, pos);
+          mBaseName = mFileName.substr(pos + 1);
+          if (mDirectory.isEmpty()) mDirectory = "/";
+        }
+
+        ZS_LOG_DETAIL(log("created"))
+      }
+
+      //-----------------------------------------------------------------------
+      SettingsFileWatcher::~SettingsFileWatcher()
+      {
+        ZS_LOG_DETAIL(log("destroyed"))
+        cancel();
+      }
+
+      //-----------------------------------------------------------------------
+      SettingsFileWatcherPtr SettingsFileWatcher::create(const char *fileName)
+      {
+        ZS_THROW_INVALID_ARGUMENT_IF(!fileName)
+
+        SettingsFileWatcherPtr pThis(new SettingsFileWatcher(fileName));
+
+        if (!pThis->reload()) {
+          ZS_LOG_ERROR(Detail, pThis->log("unable to apply settings file"))
+          return SettingsFileWatcherPtr();
+        }
+
+        if (!pThis->startWatching()) {
+          ZS_LOG_ERROR(Detail, pThis->log("unable to watch settings file"))
+          return SettingsFileWatcherPtr();
+        }
+
+        pThis->mThread = ThreadPtr(new boost::thread(boost::ref(*pThis)));
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      void SettingsFileWatcher::cancel()
+      {
+        mShouldShutdown.store(true, boost::memory_order_release);
+
+        if (mThread) {
+          mThread->join();
+          mThread.reset();
+        }
+
+#ifdef OPENPEER_CORE_SETTINGS_USE_INOTIFY
+        if (-1 != mNotifyFD) {
+          if (-1 != mWatchFD) inotify_rm_watch(mNotifyFD, mWatchFD);
+          close(mNotifyFD);
+        }
+#endif //OPENPEER_CORE_SETTINGS_USE_INOTIFY
+
+        mNotifyFD = -1;
+        mWatchFD = -1;
+      }
+
+      //-----------------------------------------------------------------------
+      void SettingsFileWatcher::operator()()
+      {
+        ZS_LOG_DEBUG(log("watching settings file"))
+
+        while (!mShouldShutdown.load(boost::memory_order_acquire)) {
+          if (!waitForChange()) continue;
+
+          ZS_LOG_DETAIL(log("settings file changed"))
+          reload();
+        }
+
+        ZS_LOG_DEBUG(log("stopped watching settings file"))
+      }
+
+      //-----------------------------------------------------------------------
+      Log::Params SettingsFileWatcher::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("core::SettingsFileWatcher");
+        UseServicesHelper::debugAppend(objectEl, "id", mID);
+        UseServicesHelper::debugAppend(objectEl, "file", mFileName);
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      bool SettingsFileWatcher::startWatching()
+      {
+#ifdef OPENPEER_CORE_SETTINGS_USE_INOTIFY
+        mNotifyFD = inotify_init();
+        if (-1 == mNotifyFD) return false;
+
+        fcntl(mNotifyFD, F_SETFL, fcntl(mNotifyFD, F_GETFL) | O_NONBLOCK);
+
+        // watch the directory as editors commonly replace the file
+        mWatchFD = inotify_add_watch(mNotifyFD, mDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        return (-1 != mWatchFD);
+#else
+        return true;
+#endif //OPENPEER_CORE_SETTINGS_USE_INOTIFY
+      }
+
+      //-----------------------------------------------------------------------
+      bool SettingsFileWatcher::waitForChange()
+      {
+#ifdef OPENPEER_CORE_SETTINGS_USE_INOTIFY
+        struct pollfd pollFD;
+        pollFD.fd = mNotifyFD;
+        pollFD.events = POLLIN;
+        pollFD.revents = 0;
+
+        int result = poll(&pollFD, 1, Milliseconds_PollInterval);
+        if (result <= 0) return false;
+
+        bool changed = false;
+
+        char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        while (true) {
+          ssize_t length = read(mNotifyFD, buffer, sizeof(buffer));
+          if (length <= 0) break;
+
+          for (char *pos = buffer; pos < buffer + length; ) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(pos);
+            if ((event->len > 0) &&
+                (mBaseName == event->name)) {
+              changed = true;
+            }
+            pos += sizeof(struct inotify_event) + event->len;
+          }
+        }
+        return changed;
+#else
+        boost::this_thread::sleep(boost::posix_time::milliseconds(Milliseconds_PollInterval));
+
+        struct stat info;
+        if (0 != stat(mFileName.c_str(), &info)) return false;
+        if (info.st_mtime == mLastModified) return false;
+        return true;
+#endif //OPENPEER_CORE_SETTINGS_USE_INOTIFY
+      }
+
+      //-----------------------------------------------------------------------
+      bool SettingsFileWatcher::reload()
+      {
+        struct stat info;
+        if (0 == stat(mFileName.c_str(), &info)) {
+          mLastModified = info.st_mtime;
+        }
+
+        String contents;
+        if (!readFile(contents)) {
+          ZS_LOG_WARNING(Detail, log("unable to read settings file"))
+          return false;
+        }
+
+        String rootName;
+        ValueMap values;
+        if (!parse(contents, rootName, values)) {
+          ZS_LOG_WARNING(Detail, log("unable to parse settings file (ignoring change)"))
+          return false;
+        }
+
+        // apply only the settings that have changed or were added
+        DocumentPtr doc = Document::create();
+        ElementPtr rootEl = Element::create(rootName);
+        doc->adoptAsLastChild(rootEl);
+
+        size_t changed = 0;
+        for (ValueMap::iterator iter = values.begin(); iter != values.end(); ++iter) {
+          ValueMap::iterator found = mApplied.find((*iter).first);
+          if ((found != mApplied.end()) &&
+              ((*found).second == (*iter).second)) continue;
+
+          DocumentPtr valueDoc = Document::createFromParsedJSON((*iter).second);
+          ElementPtr valueEl = (valueDoc ? valueDoc->getFirstChildElement() : ElementPtr());
+          if (!valueEl) continue;
+
+          valueEl->orphan();
+          rootEl->adoptAsLastChild(valueEl);
+          ++changed;
+        }
+
+        size_t removed = 0;
+        for (ValueMap::iterator iter = mApplied.begin(); iter != mApplied.end(); ++iter) {
+          if (values.end() != values.find((*iter).first)) continue;
+
+          SettingsPtr settings = Settings::singleton();
+          if ((settings) &&
+              (settings->restoreDefault((*iter).first.c_str()))) {
+            ZS_LOG_DEBUG(log("restored default of setting removed from file") + ZS_PARAM("key", (*iter).first))
+          } else {
+            // only the core defaults are known individually
+            ZS_LOG_DEBUG(log("clearing setting removed from file") + ZS_PARAM("key", (*iter).first))
+            ISettings::clear((*iter).first.c_str());
+          }
+          ++removed;
+        }
+
+        if (0 != changed) {
+          GeneratorPtr generator = Generator::createJSONGenerator();
+
+          size_t length = 0;
+          boost::shared_array<char> output = generator->write(doc, &length);
+
+          if (!ISettings::apply(output.get())) {
+            ZS_LOG_WARNING(Detail, log("settings file changes failed to apply"))
+            return false;
+          }
+        }
+
+        ZS_LOG_DETAIL(log("settings file applied") + ZS_PARAM("changed", changed) + ZS_PARAM("removed", removed) + ZS_PARAM("total", values.size()))
+
+        mApplied = values;
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      bool SettingsFileWatcher::readFile(String &outContents) const
+      {
+        FILE *file = fopen(mFileName.c_str(), "rb");
+        if (!file) return false;
+
+        char buffer[4096];
+        while (true) {
+          size_t read = fread(buffer, 1, sizeof(buffer), file);
+          if (0 == read) break;
+          outContents.append(buffer, read);
+        }
+
+        bool failed = (0 != ferror(file));
+        fclose(file);
+        return !failed;
+      }
+
+      //-----------------------------------------------------------------------
+      bool SettingsFileWatcher::parse(
+                                      const String &contents,
+                                      String &outRootName,
+                                      ValueMap &outValues
+                                      )
+      {
+        DocumentPtr doc = Document::createFromParsedJSON(contents);
+        if (!doc) return false;
+
+        ElementPtr rootEl = doc->getFirstChildElement();
+        if (!rootEl) return false;
+
+        outRootName = rootEl->getValue();
+
+        GeneratorPtr generator = Generator::createJSONGenerator();
+
+        // each setting is remembered in its encoded form so any change to
+        // its value (or its type) is detected
+        for (ElementPtr childEl = rootEl->getFirstChildElement(); childEl; childEl = childEl->getNextSiblingElement()) {
+          DocumentPtr valueDoc = Document::create();
+          valueDoc->adoptAsLastChild(childEl->clone());
+
+          size_t length = 0;
+          boost::shared_array<char> output = generator->write(valueDoc, &length);
+          outValues[childEl->getValue()] = (output ? String(output.get()) : String());
+        }
+
+        return true;
+      }
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -91,7 +502,8 @@ namespace openpeer
       #pragma mark
 
       //-----------------------------------------------------------------------
-      Settings::Settings()
+      Settings::Settings() :
+        mSnapshotVersion(0)
       {
         ZS_LOG_DETAIL(log("created"))
       }
@@ -147,6 +559,8 @@ namespace openpeer
         }
 
         stack::ISettings::setup(delegate ? mThisWeak.lock() : stack::ISettingsDelegatePtr());
+
+        notifySettingsChanged();
       }
       
       //-----------------------------------------------------------------------
@@ -157,15 +571,89 @@ namespace openpeer
           get(mAppliedDefaults) = true;
         }
 
-        setUInt(OPENPEER_CORE_SETTING_ACCOUNT_BACKGROUNDING_PHASE, 1);
-        setUInt(OPENPEER_CORE_SETTING_THREAD_MOVE_MESSAGE_TO_CACHE_TIME_IN_SECONDS, 120);
+        for (const DefaultValue *value = defaultValues(); NULL != value->mKey; ++value) {
+          applyDefault(*value);
+        }
 
-        setUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_INACTIVE_CLOSE_TIME_IN_SECONDS, 600);
+        stack::ISettings::applyDefaults();
 
-        setString(OPENPEER_CORE_SETTING_STACK_CORE_THREAD_PRIORITY, "normal");
-        setString(OPENPEER_CORE_SETTING_STACK_MEDIA_THREAD_PRIORITY, "real-time");
+        notifySettingsChanged();
+      }
 
-        stack::ISettings::applyDefaults();
+      //-----------------------------------------------------------------------
+      bool Settings::watchFile(const char *jsonFileName)
+      {
+        unwatchFile();
+
+        SettingsFileWatcherPtr watcher = SettingsFileWatcher::create(jsonFileName);
+        if (!watcher) return false;
+
+        AutoRecursiveLock lock(mLock);
+        mFileWatcher = watcher;
+        return true;
+      }
+
+      //-----------------------------------------------------------------------
+      void Settings::unwatchFile()
+      {
+        SettingsFileWatcherPtr watcher;
+
+        {
+          AutoRecursiveLock lock(mLock);
+          watcher = mFileWatcher;
+          mFileWatcher.reset();
+        }
+
+        if (!watcher) return;
+
+        // must not hold the lock while the watcher thread is joined
+        watcher->cancel();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark Settings => ISettingsForInternal
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      SettingsSnapshotPtr Settings::snapshot()
+      {
+        SettingsSnapshotPtr current = boost::atomic_load(&mSnapshot);
+        if (current) return current;
+
+        // only ever happens once (before any setting has been read)
+        return rebuildSnapshot();
+      }
+
+      //-----------------------------------------------------------------------
+      void Settings::subscribeChanges(
+                                      ISettingsChangedDelegatePtr delegate,
+                                      IMessageQueuePtr queue
+                                      )
+      {
+        ZS_THROW_INVALID_ARGUMENT_IF(!delegate)
+
+        AutoRecursiveLock lock(mSnapshotLock);
+        if (queue) {
+          mChangedDelegates[delegate.get()] = ISettingsChangedDelegateProxy::createWeak(queue, delegate);
+        } else {
+          // delivered on the subscriber's own queue
+          mChangedDelegates[delegate.get()] = ISettingsChangedDelegateProxy::createWeak(delegate);
+        }
+
+        ZS_LOG_DEBUG(log("subscribed to settings changes") + ZS_PARAM("total", mChangedDelegates.size()))
+      }
+
+      //-----------------------------------------------------------------------
+      void Settings::unsubscribeChanges(ISettingsChangedDelegatePtr delegate)
+      {
+        AutoRecursiveLock lock(mSnapshotLock);
+        mChangedDelegates.erase(delegate.get());
+
+        ZS_LOG_DEBUG(log("unsubscribed from settings changes") + ZS_PARAM("total", mChangedDelegates.size()))
       }
 
       //-----------------------------------------------------------------------
@@ -201,19 +689,7 @@ namespace openpeer
       //-----------------------------------------------------------------------
       Duration Settings::getThreadMoveMessageToCacheTimeInSeconds()
       {
-        {
-          AutoRecursiveLock lock(mLock);
-          if (Duration() != mThreadMoveMessageToCacheTimeInSeconds) return mThreadMoveMessageToCacheTimeInSeconds;
-        }
-
-        Duration cacheDuration = Seconds(getUInt(OPENPEER_CORE_SETTING_THREAD_MOVE_MESSAGE_TO_CACHE_TIME_IN_SECONDS));
-
-        {
-          AutoRecursiveLock lock(mLock);
-          mThreadMoveMessageToCacheTimeInSeconds = cacheDuration;
-        }
-
-        return cacheDuration;
+        return snapshot()->mThreadMoveMessageToCacheTime;
       }
 
       //-----------------------------------------------------------------------
@@ -316,9 +792,11 @@ namespace openpeer
 
         if (!delegate) {
           UseServicesSettings::setString(key, value);
-          return;
+        } else {
+          delegate->setString(key, value);
         }
-        delegate->setString(key, value);
+
+        notifySettingsChanged();
       }
 
       //-----------------------------------------------------------------------
@@ -335,9 +813,11 @@ namespace openpeer
 
         if (!delegate) {
           UseServicesSettings::setInt(key, value);
-          return;
+        } else {
+          delegate->setInt(key, value);
         }
-        delegate->setInt(key, value);
+
+        notifySettingsChanged();
       }
 
       //-----------------------------------------------------------------------
@@ -354,9 +834,11 @@ namespace openpeer
 
         if (!delegate) {
           UseServicesSettings::setUInt(key, value);
-          return;
+        } else {
+          delegate->setUInt(key, value);
         }
-        delegate->setUInt(key, value);
+
+        notifySettingsChanged();
       }
 
       //-----------------------------------------------------------------------
@@ -373,9 +855,11 @@ namespace openpeer
 
         if (!delegate) {
           UseServicesSettings::setBool(key, value);
-          return;
+        } else {
+          delegate->setBool(key, value);
         }
-        delegate->setBool(key, value);
+
+        notifySettingsChanged();
       }
 
       //-----------------------------------------------------------------------
@@ -392,9 +876,11 @@ namespace openpeer
 
         if (!delegate) {
           UseServicesSettings::setFloat(key, value);
-          return;
+        } else {
+          delegate->setFloat(key, value);
         }
-        delegate->setFloat(key, value);
+
+        notifySettingsChanged();
       }
 
       //-----------------------------------------------------------------------
@@ -411,9 +897,11 @@ namespace openpeer
 
         if (!delegate) {
           UseServicesSettings::setDouble(key, value);
-          return;
+        } else {
+          delegate->setDouble(key, value);
         }
-        delegate->setDouble(key, value);
+
+        notifySettingsChanged();
       }
 
       //-----------------------------------------------------------------------
@@ -427,9 +915,11 @@ namespace openpeer
 
         if (!delegate) {
           UseServicesSettings::clear(key);
-          return;
+        } else {
+          delegate->clear(key);
         }
-        delegate->clear(key);
+
+        notifySettingsChanged();
       }
 
       //-----------------------------------------------------------------------
@@ -454,6 +944,124 @@ namespace openpeer
         return Log::Params(message, "core::Settings");
       }
 
+      //-----------------------------------------------------------------------
+      void Settings::notifySettingsChanged()
+      {
+        {
+          AutoRecursiveLock lock(mSnapshotLock);
+          if (!boost::atomic_load(&mSnapshot)) return;  // nobody has read a snapshot yet
+        }
+
+        rebuildSnapshot();
+      }
+
+      //-----------------------------------------------------------------------
+      const Settings::DefaultValue *Settings::defaultValues()
+      {
+        static const DefaultValue values[] =
+        {
+          {OPENPEER_CORE_SETTING_ACCOUNT_BACKGROUNDING_PHASE, DefaultValueType_UInt, NULL, 1},
+          {OPENPEER_CORE_SETTING_THREAD_MOVE_MESSAGE_TO_CACHE_TIME_IN_SECONDS, DefaultValueType_UInt, NULL, 120},
+
+          {OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_INACTIVE_CLOSE_TIME_IN_SECONDS, DefaultValueType_UInt, NULL, 600},
+
+          {OPENPEER_CORE_SETTING_CALLTRANSPORT_BUNDLE_MEDIA, DefaultValueType_Bool, NULL, true},
+          {OPENPEER_CORE_SETTING_CALLTRANSPORT_KEEP_SOCKETS_WARM, DefaultValueType_Bool, NULL, false},
+          {OPENPEER_CORE_SETTING_CALLTRANSPORT_WARM_UP_TIME_IN_SECONDS, DefaultValueType_UInt, NULL, 90},
+          {OPENPEER_CORE_SETTING_CALLTRANSPORT_MAX_CONCURRENT_MEDIA_SESSIONS, DefaultValueType_UInt, NULL, 0},
+
+          {OPENPEER_CORE_SETTING_MEDIA_ENGINE_QUALITY_SAMPLE_INTERVAL_IN_SECONDS, DefaultValueType_UInt, NULL, 2},
+          {OPENPEER_CORE_SETTING_MEDIA_ENGINE_ADAPT_VOICE_CODEC, DefaultValueType_Bool, NULL, true},
+
+          {OPENPEER_CORE_SETTING_STACK_CORE_THREAD_PRIORITY, DefaultValueType_String, "normal", 0},
+          {OPENPEER_CORE_SETTING_STACK_MEDIA_THREAD_PRIORITY, DefaultValueType_String, "real-time", 0},
+          {OPENPEER_CORE_SETTING_STACK_CORE_THREAD_SHARDS, DefaultValueType_UInt, NULL, 1},
+          {OPENPEER_CORE_SETTING_STACK_QUEUE_STATISTICS_LOG_INTERVAL_IN_SECONDS, DefaultValueType_UInt, NULL, 0},
+          {OPENPEER_CORE_SETTING_STACK_SHUTDOWN_DEADLINE_IN_SECONDS, DefaultValueType_UInt, NULL, 10},
+
+          {NULL, DefaultValueType_UInt, NULL, 0}
+        };
+        return values;
+      }
+
+      //-----------------------------------------------------------------------
+      void Settings::applyDefault(const DefaultValue &value)
+      {
+        switch (value.mType) {
+          case DefaultValueType_String: setString(value.mKey, value.mString); break;
+          case DefaultValueType_UInt:   setUInt(value.mKey, value.mUInt); break;
+          case DefaultValueType_Bool:   setBool(value.mKey, 0 != value.mUInt); break;
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      bool Settings::restoreDefault(const char *key)
+      {
+        if (!key) return false;
+
+        for (const DefaultValue *value = defaultValues(); NULL != value->mKey; ++value) {
+          if (0 != strcmp(value->mKey, key)) continue;
+          applyDefault(*value);
+          return true;
+        }
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      SettingsSnapshotPtr Settings::rebuildSnapshot()
+      {
+        AutoRecursiveLock lock(mSnapshotLock);
+
+        SettingsSnapshotPtr snapshot(new SettingsSnapshot);
+
+        snapshot->mAccountBackgroundingPhase = getUInt(OPENPEER_CORE_SETTING_ACCOUNT_BACKGROUNDING_PHASE);
+        snapshot->mConversationThreadHostBackgroundingPhase = getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_BACKGROUNDING_PHASE);
+        snapshot->mConversationThreadHostInactiveCloseTime = Seconds(getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_INACTIVE_CLOSE_TIME_IN_SECONDS));
+        snapshot->mConversationThreadHostPeerContactAutoFindInSeconds = getUInt(OPENPEER_CORE_SETTING_CONVERSATION_THREAD_HOST_PEER_CONTACT);
+        snapshot->mCallTransportBundleMedia = getBool(OPENPEER_CORE_SETTING_CALLTRANSPORT_BUNDLE_MEDIA);
+        snapshot->mCallTransportKeepSocketsWarm = getBool(OPENPEER_CORE_SETTING_CALLTRANSPORT_KEEP_SOCKETS_WARM);
+        snapshot->mCallTransportWarmUpTime = Seconds(getUInt(OPENPEER_CORE_SETTING_CALLTRANSPORT_WARM_UP_TIME_IN_SECONDS));
+        snapshot->mCallTransportMaxConcurrentMediaSessions = getUInt(OPENPEER_CORE_SETTING_CALLTRANSPORT_MAX_CONCURRENT_MEDIA_SESSIONS);
+        snapshot->mMediaEngineQualitySampleInterval = Seconds(getUInt(OPENPEER_CORE_SETTING_MEDIA_ENGINE_QUALITY_SAMPLE_INTERVAL_IN_SECONDS));
+        snapshot->mMediaEngineAdaptVoiceCodec = getBool(OPENPEER_CORE_SETTING_MEDIA_ENGINE_ADAPT_VOICE_CODEC);
+        snapshot->mThreadMoveMessageToCacheTime = Seconds(getUInt(OPENPEER_CORE_SETTING_THREAD_MOVE_MESSAGE_TO_CACHE_TIME_IN_SECONDS));
+        snapshot->mStackCoreThreadPriority = getString(OPENPEER_CORE_SETTING_STACK_CORE_THREAD_PRIORITY);
+        snapshot->mStackMediaThreadPriority = getString(OPENPEER_CORE_SETTING_STACK_MEDIA_THREAD_PRIORITY);
+        snapshot->mStackAuthorizedApplicationIDSplitChar = getString(OPENPEER_CORE_SETTING_STACK_AUTHORIZED_APPLICATION_ID_SPLIT_CHAR);
+        snapshot->mStackQueueStatisticsLogInterval = Seconds(getUInt(OPENPEER_CORE_SETTING_STACK_QUEUE_STATISTICS_LOG_INTERVAL_IN_SECONDS));
+        snapshot->mStackShutdownDeadline = Seconds(getUInt(OPENPEER_CORE_SETTING_STACK_SHUTDOWN_DEADLINE_IN_SECONDS));
+
+        SettingsSnapshotPtr current = boost::atomic_load(&mSnapshot);
+        if ((current) &&
+            (*current == *snapshot)) {
+          ZS_LOG_TRACE(log("settings snapshot did not change") + ZS_PARAM("version", current->mVersion))
+          return current;
+        }
+
+        ++mSnapshotVersion;
+        snapshot->mVersion = mSnapshotVersion;
+
+        // the retired snapshot is freed once its last reader releases it
+        boost::atomic_store(&mSnapshot, snapshot);
+
+        ZS_LOG_DEBUG(log("settings snapshot rebuilt") + snapshot->toDebug())
+
+        if (!current) return snapshot;    // first snapshot is not a change
+
+        for (ChangedDelegateMap::iterator iter = mChangedDelegates.begin(); iter != mChangedDelegates.end(); ) {
+          ChangedDelegateMap::iterator notifyIter = iter; ++iter;
+
+          try {
+            (*notifyIter).second->onSettingsChanged(snapshot);
+          } catch(ISettingsChangedDelegateProxy::Exceptions::DelegateGone &) {
+            ZS_LOG_WARNING(Detail, log("settings changed delegate gone"))
+            mChangedDelegates.erase(notifyIter);
+          }
+        }
+
+        return snapshot;
+      }
+
     }
 
     //-------------------------------------------------------------------------
@@ -478,7 +1086,11 @@ namespace openpeer
                               const char *value
                               )
     {
-      return UseServicesSettings::setString(key, value);
+      UseServicesSettings::setString(key, value);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->notifySettingsChanged();
     }
 
     //-------------------------------------------------------------------------
@@ -487,7 +1099,11 @@ namespace openpeer
                            LONG value
                            )
     {
-      return UseServicesSettings::setInt(key, value);
+      UseServicesSettings::setInt(key, value);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->notifySettingsChanged();
     }
 
     //-------------------------------------------------------------------------
@@ -496,7 +1112,11 @@ namespace openpeer
                             ULONG value
                             )
     {
-      return UseServicesSettings::setUInt(key, value);
+      UseServicesSettings::setUInt(key, value);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->notifySettingsChanged();
     }
 
     //-------------------------------------------------------------------------
@@ -505,7 +1125,11 @@ namespace openpeer
                             bool value
                             )
     {
-      return UseServicesSettings::setBool(key, value);
+      UseServicesSettings::setBool(key, value);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->notifySettingsChanged();
     }
 
     //-------------------------------------------------------------------------
@@ -514,7 +1138,11 @@ namespace openpeer
                              float value
                              )
     {
-      return UseServicesSettings::setFloat(key, value);
+      UseServicesSettings::setFloat(key, value);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->notifySettingsChanged();
     }
 
     //-------------------------------------------------------------------------
@@ -523,19 +1151,48 @@ namespace openpeer
                               double value
                               )
     {
-      return UseServicesSettings::setDouble(key, value);
+      UseServicesSettings::setDouble(key, value);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->notifySettingsChanged();
     }
 
     //-------------------------------------------------------------------------
     void ISettings::clear(const char *key)
     {
-      return UseServicesSettings::clear(key);
+      UseServicesSettings::clear(key);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->notifySettingsChanged();
     }
 
     //-------------------------------------------------------------------------
     bool ISettings::apply(const char *jsonSettings)
     {
-      return UseServicesSettings::apply(jsonSettings);
+      bool result = UseServicesSettings::apply(jsonSettings);
+
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (singleton) singleton->notifySettingsChanged();
+
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    bool ISettings::watchFile(const char *jsonFileName)
+    {
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return false;
+      return singleton->watchFile(jsonFileName);
+    }
+
+    //-------------------------------------------------------------------------
+    void ISettings::unwatchFile()
+    {
+      internal::SettingsPtr singleton = internal::Settings::singleton();
+      if (!singleton) return;
+      singleton->unwatchFile();
     }
 
     //-------------------------------------------------------------------------
@@ -0,0 +1,372 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+
+#include <openpeer/core/internal/core_ShutdownCoordinator.h>
+
+#include <openpeer/services/IHelper.h>
+
+#include <zsLib/XML.h>
+
+#define OPENPEER_CORE_SHUTDOWN_COORDINATOR_FORCED_GRACE_IN_SECONDS (5)
+
+namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_core) } }
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ShutdownCoordinator
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      ShutdownCoordinator::ShutdownCoordinator(IMessageQueuePtr queue) :
+        MessageQueueAssociator(queue),
+        mStarted(false),
+        mCompleted(false),
+        mForcing(false),
+        mTotalParticipants(0),
+        mTotalForced(0)
+      {
+        ZS_LOG_DEBUG(log("created"))
+      }
+
+      //-----------------------------------------------------------------------
+      ShutdownCoordinator::~ShutdownCoordinator()
+      {
+        mThisWeak.reset();
+        ZS_LOG_DEBUG(log("destroyed"))
+        cancel();
+      }
+
+      //-----------------------------------------------------------------------
+      ShutdownCoordinatorPtr ShutdownCoordinator::create(IMessageQueuePtr queue)
+      {
+        ShutdownCoordinatorPtr pThis(new ShutdownCoordinator(queue));
+        pThis->mThisWeak = pThis;
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      void ShutdownCoordinator::registerAccount(AccountPtr account)
+      {
+        if (!account) return;
+
+        Participant participant;
+        participant.mAccount = account;
+        participant.mAsync = IAccountAsyncProxy::createWeak(account->getAssociatedMessageQueue(), account);
+
+        AutoRecursiveLock lock(mLock);
+
+        if (mCompleted) {
+          ZS_LOG_WARNING(Detail, log("account created after shutdown completed (telling it to shutdown)") + ZS_PARAM("account id", account->getID()))
+          participant.mAsync->onShutdown();
+          return;
+        }
+
+        mParticipants[account->getID()] = participant;
+
+        ZS_LOG_DEBUG(log("tracking account") + ZS_PARAM("account id", account->getID()) + ZS_PARAM("live accounts", mParticipants.size()))
+
+        if (mStarted) {
+          ++mTotalParticipants;
+          participant.mAsync->onShutdown();
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void ShutdownCoordinator::notifyAccountShutdown(AccountID accountID)
+      {
+        AutoRecursiveLock lock(mLock);
+
+        ParticipantMap::iterator found = mParticipants.find(accountID);
+        if (found == mParticipants.end()) return;
+
+        ZS_LOG_DEBUG(log("account is shutdown") + ZS_PARAM("account id", accountID) + ZS_PARAM("forced", (*found).second.mForced))
+
+        mParticipants.erase(found);
+
+        checkComplete();
+      }
+
+      //-----------------------------------------------------------------------
+      void ShutdownCoordinator::start(
+                                      IShutdownCoordinatorDelegatePtr delegate,
+                                      Duration deadline
+                                      )
+      {
+        ParticipantMap participants;
+
+        {
+          AutoRecursiveLock lock(mLock);
+
+          if (mStarted) {
+            ZS_LOG_WARNING(Detail, log("shutdown already started"))
+            return;
+          }
+
+          mStarted = true;
+          mStartTime = zsLib::now();
+          mDelegate = delegate;
+          mDeadline = deadline;
+          mTotalParticipants = mParticipants.size();
+
+          participants = mParticipants;
+
+          ZS_LOG_BASIC(log("shutting down all live accounts") + ZS_PARAM("accounts", participants.size()) + ZS_PARAM("deadline (s)", deadline.total_seconds()))
+
+          if ((participants.size() > 0) &&
+              (Duration() != deadline)) {
+            mDeadlineTimer = Timer::create(mThisWeak.lock(), deadline, false);
+          }
+        }
+
+        // each account receives the request on its own queue so they all shutdown in parallel
+        for (ParticipantMap::iterator iter = participants.begin(); iter != participants.end(); ++iter) {
+          (*iter).second.mAsync->onShutdown();
+        }
+
+        AutoRecursiveLock lock(mLock);
+        checkComplete();
+      }
+
+      //-----------------------------------------------------------------------
+      bool ShutdownCoordinator::isComplete() const
+      {
+        AutoRecursiveLock lock(mLock);
+        return mCompleted;
+      }
+
+      //-----------------------------------------------------------------------
+      void ShutdownCoordinator::cancel()
+      {
+        AutoRecursiveLock lock(mLock);
+
+        if (mDeadlineTimer) {
+          mDeadlineTimer->cancel();
+          mDeadlineTimer.reset();
+        }
+
+        mDelegate.reset();
+        mParticipants.clear();
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr ShutdownCoordinator::toDebug() const
+      {
+        AutoRecursiveLock lock(mLock);
+
+        ElementPtr resultEl = Element::create("core::ShutdownCoordinator");
+
+        UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "started", mStarted);
+        UseServicesHelper::debugAppend(resultEl, "completed", mCompleted);
+        UseServicesHelper::debugAppend(resultEl, "forcing", mForcing);
+        UseServicesHelper::debugAppend(resultEl, "live accounts", mParticipants.size());
+        UseServicesHelper::debugAppend(resultEl, "deadline", mDeadline);
+        UseServicesHelper::debugAppend(resultEl, "deadline timer", (bool)mDeadlineTimer);
+        UseServicesHelper::debugAppend(resultEl, "accounts shutdown", mTotalParticipants);
+        UseServicesHelper::debugAppend(resultEl, "accounts forced", mTotalForced);
+
+        if (Time() != mStartTime) {
+          Time end = (Time() != mCompletedTime ? mCompletedTime : zsLib::now());
+          UseServicesHelper::debugAppend(resultEl, "duration (ms)", (end - mStartTime).total_milliseconds());
+        }
+
+        if (mHoldouts.size() > 0) {
+          ElementPtr holdoutsEl = Element::create("holdouts");
+          for (HoldoutList::const_iterator iter = mHoldouts.begin(); iter != mHoldouts.end(); ++iter) {
+            const Holdout &holdout = (*iter);
+
+            ElementPtr holdoutEl = Element::create("holdout");
+            UseServicesHelper::debugAppend(holdoutEl, "account id", holdout.mAccountID);
+            UseServicesHelper::debugAppend(holdoutEl, "state", holdout.mState);
+            UseServicesHelper::debugAppend(holdoutEl, "waiting for", holdout.mBlocker);
+            UseServicesHelper::debugAppend(holdoutsEl, holdoutEl);
+          }
+          UseServicesHelper::debugAppend(resultEl, holdoutsEl);
+        }
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ShutdownCoordinator => ITimerDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void ShutdownCoordinator::onTimer(TimerPtr timer)
+      {
+        ParticipantMap remaining;
+
+        {
+          AutoRecursiveLock lock(mLock);
+          if (timer != mDeadlineTimer) {
+            ZS_LOG_DEBUG(log("ignoring obsolete timer"))
+            return;
+          }
+
+          mDeadlineTimer->cancel();
+          mDeadlineTimer.reset();
+
+          if (mCompleted) return;
+
+          if (mForcing) {
+            // forced accounts had their grace period to report back; stop
+            // waiting so the stack shutdown can never hang on them
+            for (ParticipantMap::iterator iter = mParticipants.begin(); iter != mParticipants.end(); ++iter) {
+              ZS_LOG_WARNING(Basic, log("forced account never reported its shutdown (abandoning)") + ZS_PARAM("account id", (*iter).first))
+            }
+            mParticipants.clear();
+            checkComplete();
+            return;
+          }
+
+          mForcing = true;
+          remaining = mParticipants;
+        }
+
+        // must not hold the coordinator lock while asking the accounts (accounts call into the coordinator with their own lock held)
+        HoldoutList holdouts;
+        for (ParticipantMap::iterator iter = remaining.begin(); iter != remaining.end(); ++iter) {
+          Participant &participant = (*iter).second;
+
+          Holdout holdout;
+          holdout.mAccountID = (*iter).first;
+
+          UseAccountPtr account = participant.mAccount.lock();
+          if (account) {
+            holdout.mState = IAccount::toString(account->getState());
+            holdout.mBlocker = account->getShutdownBlocker();
+          } else {
+            holdout.mState = "destroyed";
+          }
+
+          ZS_LOG_WARNING(Basic, log("shutdown deadline expired, forcing account to shutdown") + ZS_PARAM("account id", holdout.mAccountID) + ZS_PARAM("state", holdout.mState) + ZS_PARAM("waiting for", holdout.mBlocker))
+
+          holdouts.push_back(holdout);
+          participant.mAsync->onForceShutdown();
+        }
+
+        AutoRecursiveLock lock(mLock);
+
+        for (HoldoutList::iterator iter = holdouts.begin(); iter != holdouts.end(); ++iter) {
+          ParticipantMap::iterator found = mParticipants.find((*iter).mAccountID);
+          if (found == mParticipants.end()) continue;
+          (*found).second.mForced = true;
+        }
+
+        mTotalForced += holdouts.size();
+        mHoldouts.splice(mHoldouts.end(), holdouts);
+
+        checkComplete();
+
+        if (!mCompleted) {
+          mDeadlineTimer = Timer::create(mThisWeak.lock(), Seconds(OPENPEER_CORE_SHUTDOWN_COORDINATOR_FORCED_GRACE_IN_SECONDS), false);
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ShutdownCoordinator => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Log::Params ShutdownCoordinator::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("core::ShutdownCoordinator");
+        UseServicesHelper::debugAppend(objectEl, "id", mID);
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      void ShutdownCoordinator::checkComplete()
+      {
+        if (!mStarted) return;
+        if (mCompleted) return;
+
+        for (ParticipantMap::iterator iter_doNotUse = mParticipants.begin(); iter_doNotUse != mParticipants.end(); )
+        {
+          ParticipantMap::iterator current = iter_doNotUse; ++iter_doNotUse;
+
+          if (!(*current).second.mAccount.expired()) continue;
+
+          ZS_LOG_DEBUG(log("account is gone") + ZS_PARAM("account id", (*current).first))
+          mParticipants.erase(current);
+        }
+
+        if (mParticipants.size() > 0) {
+          ZS_LOG_TRACE(log("waiting for accounts to shutdown") + ZS_PARAM("remaining", mParticipants.size()))
+          return;
+        }
+
+        mCompleted = true;
+        mCompletedTime = zsLib::now();
+
+        if (mDeadlineTimer) {
+          mDeadlineTimer->cancel();
+          mDeadlineTimer.reset();
+        }
+
+        if (mHoldouts.size() > 0) {
+          ZS_LOG_WARNING(Basic, log("accounts shutdown completed (with holdouts)") + ZS_PARAM("coordinator", toDebug()))
+        } else {
+          ZS_LOG_BASIC(log("accounts shutdown completed") + ZS_PARAM("coordinator", toDebug()))
+        }
+
+        if (mDelegate) {
+          try {
+            mDelegate->onShutdownCoordinatorCompleted();
+          } catch (IShutdownCoordinatorDelegateProxy::Exceptions::DelegateGone &) {
+            ZS_LOG_WARNING(Detail, log("delegate gone"))
+          }
+          mDelegate.reset();
+        }
+      }
+    }
+  }
+}
@@ -31,7 +31,10 @@
 
 #include <openpeer/core/internal/core_Stack.h>
 #include <openpeer/core/internal/core_MediaEngine.h>
+#include <openpeer/core/internal/core_Helper.h>
 #include <openpeer/core/internal/core_Settings.h>
+#include <openpeer/core/internal/core_ShutdownCoordinator.h>
+#include <openpeer/core/internal/core_TaskPool.h>
 #include <openpeer/core/IConversationThread.h>
 #include <openpeer/core/ICall.h>
 
@@ -46,6 +49,8 @@
 #include <zsLib/helpers.h>
 #include <zsLib/MessageQueueThread.h>
 #include <zsLib/Socket.h>
+#include <zsLib/Timer.h>
+#include <zsLib/XML.h>
 
 #define OPENPEER_CORE_STACK_CORE_THREAD_QUEUE_NAME  "org.openpeer.core.coreThread"
 #define OPENPEER_CORE_STACK_MEDIA_THREAD_QUEUE_NAME "org.openpeer.core.mediaThread"
@@ -93,6 +98,7 @@ namespace openpeer
     namespace internal
     {
       ZS_DECLARE_TYPEDEF_PTR(IMediaEngineForStack, UseMediaEngine)
+      ZS_DECLARE_TYPEDEF_PTR(ISettingsForInternal, UseSettings)
 
       typedef IStackForInternal UseStack;
 
@@ -118,6 +124,7 @@ namespace openpeer
       #pragma mark
 
       class ShutdownCheckAgain : public IShutdownCheckAgainDelegate,
+                                 public IShutdownCoordinatorDelegate,
                                  public zsLib::MessageQueueAssociator
       {
       protected:
@@ -151,6 +158,17 @@ namespace openpeer
           mStack->notifyShutdownCheckAgain();
         }
 
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark ShutdownCheckAgain => IShutdownCoordinatorDelegate
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        virtual void onShutdownCoordinatorCompleted()
+        {
+          mStack->notifyShutdownCheckAgain();
+        }
+
       protected:
         //---------------------------------------------------------------------
         #pragma mark
@@ -160,6 +178,66 @@ namespace openpeer
         IStackShutdownCheckAgainPtr mStack;
       };
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark StackQueueStatisticsLogger
+      #pragma mark
+
+      class StackQueueStatisticsLogger : public ITimerDelegate,
+                                         public zsLib::MessageQueueAssociator
+      {
+      protected:
+        //---------------------------------------------------------------------
+        StackQueueStatisticsLogger(IMessageQueuePtr queue) :
+          zsLib::MessageQueueAssociator(queue)
+        {}
+
+      public:
+        //---------------------------------------------------------------------
+        static StackQueueStatisticsLoggerPtr create(
+                                                    IMessageQueuePtr queue,
+                                                    Duration interval
+                                                    )
+        {
+          StackQueueStatisticsLoggerPtr pThis(new StackQueueStatisticsLogger(queue));
+          pThis->mTimer = Timer::create(pThis, interval);
+          return pThis;
+        }
+
+        //---------------------------------------------------------------------
+        void cancel()
+        {
+          if (!mTimer) return;
+          mTimer->cancel();
+          mTimer.reset();
+        }
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark StackQueueStatisticsLogger => ITimerDelegate
+        #pragma mark
+
+        //---------------------------------------------------------------------
+        virtual void onTimer(TimerPtr timer)
+        {
+          IStackPtr stack = IStack::singleton();
+          if (!stack) return;
+
+          ZS_LOG_BASIC(Log::Params("message queue statistics", "core::Stack") + ZS_PARAM("statistics", stack->getMessageQueueStatistics()))
+        }
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark StackQueueStatisticsLogger => (data)
+        #pragma mark
+
+        TimerPtr mTimer;
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -203,7 +281,15 @@ namespace openpeer
       protected:
         //---------------------------------------------------------------------
         InterceptApplicationThread(IStackMessageQueueDelegatePtr delegate) :
-          mDelegate(delegate)
+          mDelegate(delegate),
+          mSignalPending(false),
+          mTotalSignals(0),
+          mTotalSignalsCoalesced(0),
+          mTotalResignals(0),
+          mTotalBatches(0),
+          mTotalMessages(0),
+          mTotalBudgetExceeded(0),
+          mTotalMaxMessagesReached(0)
         {
         }
 
@@ -261,17 +347,101 @@ namespace openpeer
           {
             AutoLock lock(mLock);
             delegate = mDelegate;
+
+            ZS_THROW_CUSTOM_MSG_IF(IMessageQueue::Exceptions::MessageQueueGone, !delegate, "message posted to message queue after queue was deleted.")
+
+            if (mSignalPending) {
+              // the custom thread has not processed since the last signal
+              ++mTotalSignalsCoalesced;
+              return;
+            }
+
+            mSignalPending = true;
+            ++mTotalSignals;
+          }
+
+          delegate->onStackMessageQueueWakeUpCustomThreadAndProcessOnCustomThread();
+        }
+
+        //---------------------------------------------------------------------
+        void processMessages(
+                             Duration budget,
+                             ULONG maxMessages
+                             )
+        {
+          {
+            AutoLock lock(mLock);
+            mSignalPending = false;
+          }
+
+          Time start = zsLib::now();
+          ULONG processed = 0;
+          bool budgetExceeded = false;
+          bool maxMessagesReached = false;
+
+          while (mQueue->getTotalUnprocessedMessages() > 0) {
+            mQueue->processOnlyOneMessage();
+            ++processed;
+
+            if ((0 != maxMessages) &&
+                (processed >= maxMessages)) {
+              maxMessagesReached = true;
+              break;
+            }
+            if ((Duration() != budget) &&
+                ((zsLib::now() - start) >= budget)) {
+              budgetExceeded = true;
+              break;
+            }
           }
 
-          ZS_THROW_CUSTOM_MSG_IF(IMessageQueue::Exceptions::MessageQueueGone, !delegate, "message posted to message queue after queue was deleted.")
+          Duration elapsed = zsLib::now() - start;
+
+          IStackMessageQueueDelegatePtr delegate;
+
+          {
+            AutoLock lock(mLock);
+
+            ++mTotalBatches;
+            mTotalMessages += processed;
+            if (budgetExceeded) ++mTotalBudgetExceeded;
+            if (maxMessagesReached) ++mTotalMaxMessagesReached;
+
+            mBatchMessages.record(processed);
+            mBatchTime.record(elapsed.is_negative() ? 0 : static_cast<ULONG>(elapsed.total_microseconds()));
+
+            if (mQueue->getTotalUnprocessedMessages() < 1) return;
+            if (mSignalPending) return;     // a post during processing already signalled
+            if (!mDelegate) return;
+
+            // remaining work goes back to the custom thread so it can service its own events first
+            mSignalPending = true;
+            ++mTotalResignals;
+            delegate = mDelegate;
+          }
 
           delegate->onStackMessageQueueWakeUpCustomThreadAndProcessOnCustomThread();
         }
 
         //---------------------------------------------------------------------
-        void processMessage()
+        ElementPtr toDebug() const
         {
-          mQueue->processOnlyOneMessage();
+          AutoLock lock(mLock);
+
+          ElementPtr resultEl = Element::create("core::InterceptApplicationThread");
+
+          UseServicesHelper::debugAppend(resultEl, "signal pending", mSignalPending);
+          UseServicesHelper::debugAppend(resultEl, "signals", mTotalSignals);
+          UseServicesHelper::debugAppend(resultEl, "signals coalesced", mTotalSignalsCoalesced);
+          UseServicesHelper::debugAppend(resultEl, "resignals", mTotalResignals);
+          UseServicesHelper::debugAppend(resultEl, "batches", mTotalBatches);
+          UseServicesHelper::debugAppend(resultEl, "messages", mTotalMessages);
+          UseServicesHelper::debugAppend(resultEl, "budget exceeded", mTotalBudgetExceeded);
+          UseServicesHelper::debugAppend(resultEl, "max messages reached", mTotalMaxMessagesReached);
+          UseServicesHelper::debugAppend(resultEl, mBatchMessages.toDebug("batch messages", "messages"));
+          UseServicesHelper::debugAppend(resultEl, mBatchTime.toDebug("batch time", "us"));
+
+          return resultEl;
         }
 
       protected:
@@ -279,6 +449,19 @@ namespace openpeer
         InterceptApplicationThreadPtr mThisWeak;
         IStackMessageQueueDelegatePtr mDelegate;
         MessageQueuePtr mQueue;
+
+        bool mSignalPending;
+
+        ULONG mTotalSignals;
+        ULONG mTotalSignalsCoalesced;
+        ULONG mTotalResignals;
+        ULONG mTotalBatches;
+        ULONG mTotalMessages;
+        ULONG mTotalBudgetExceeded;
+        ULONG mTotalMaxMessagesReached;
+
+        Histogram mBatchMessages;
+        Histogram mBatchTime;
       };
 
       //-----------------------------------------------------------------------
@@ -310,6 +493,16 @@ namespace openpeer
         return singleton->getQueueCore();
       }
 
+      //-----------------------------------------------------------------------
+      IMessageQueuePtr IStackForInternal::queueCore(const char *shardKey)
+      {
+        StackPtr singleton = Stack::singleton();
+        if (!singleton) {
+          return services::IMessageQueueManager::getMessageQueue(OPENPEER_CORE_STACK_CORE_THREAD_QUEUE_NAME);
+        }
+        return singleton->getQueueCore(shardKey);
+      }
+
       //-----------------------------------------------------------------------
       IMessageQueuePtr IStackForInternal::queueMedia()
       {
@@ -340,6 +533,22 @@ namespace openpeer
         return singleton->getQueueKeyGeneration();
       }
 
+      //-----------------------------------------------------------------------
+      TaskPoolPtr IStackForInternal::taskPool()
+      {
+        StackPtr singleton = Stack::singleton();
+        if (!singleton) return TaskPoolPtr();
+        return singleton->getTaskPool();
+      }
+
+      //-----------------------------------------------------------------------
+      ShutdownCoordinatorPtr IStackForInternal::shutdownCoordinator()
+      {
+        StackPtr singleton = Stack::singleton();
+        if (!singleton) return ShutdownCoordinatorPtr();
+        return singleton->getShutdownCoordinator();
+      }
+
       //-----------------------------------------------------------------------
       IMediaEngineDelegatePtr IStackForInternal::mediaEngineDelegate()
       {
@@ -422,11 +631,19 @@ namespace openpeer
 
         ZS_LOG_FORCED(Informational, Basic, slog("instance information") + ZS_PARAM("device id", deviceID) + ZS_PARAM("instance id", instanceID) + ZS_PARAM("authorized application id", authorizedAppId))
 
-        IMessageQueueManager::registerMessageQueueThreadPriority(OPENPEER_CORE_STACK_CORE_THREAD_QUEUE_NAME, zsLib::threadPriorityFromString(services::ISettings::getString(OPENPEER_CORE_SETTING_STACK_CORE_THREAD_PRIORITY)));
-        IMessageQueueManager::registerMessageQueueThreadPriority(OPENPEER_CORE_STACK_MEDIA_THREAD_QUEUE_NAME, zsLib::threadPriorityFromString(services::ISettings::getString(OPENPEER_CORE_SETTING_STACK_MEDIA_THREAD_PRIORITY)));
+        ULONG totalShards = services::ISettings::getUInt(OPENPEER_CORE_SETTING_STACK_CORE_THREAD_SHARDS);
+        if (totalShards < 1) totalShards = 1;
+        mCoreShardQueues.resize(totalShards);
+
+        applyThreadPriorities(*UseSettings::snapshot());
 
         makeReady();
 
+        applyQueueStatisticsLogging(*UseSettings::snapshot());
+
+        // the stack is not associated with a queue of its own
+        UseSettings::subscribeChanges(mThisWeak.lock(), getQueueCore());
+
         if (stackDelegate) {
           mStackDelegate = IStackDelegateProxy::create(getQueueApplication(), stackDelegate);
         }
@@ -446,22 +663,79 @@ namespace openpeer
       //-----------------------------------------------------------------------
       void Stack::shutdown()
       {
-        AutoRecursiveLock lock(mLock);
+        ShutdownCoordinatorPtr coordinator;
+        IShutdownCoordinatorDelegatePtr coordinatorDelegate;
 
-        if (!mApplicationQueue) {
-          // already shutdown...
-          return;
+        {
+          AutoRecursiveLock lock(mLock);
+
+          if (!mApplicationQueue) {
+            // already shutdown...
+            return;
+          }
+
+          if (mShutdownCheckAgainDelegate) {
+            // already shutting down...
+            return;
+          }
+
+          UseSettings::unsubscribeChanges(mThisWeak.lock());
+
+          if (mQueueStatisticsLogger) {
+            mQueueStatisticsLogger->cancel();
+            mQueueStatisticsLogger.reset();
+          }
+
+          ShutdownCheckAgainPtr checkAgain = ShutdownCheckAgain::create(getQueueApplication(), mThisWeak.lock());
+          mShutdownCheckAgainDelegate = IShutdownCheckAgainDelegateProxy::create(checkAgain);
+
+          coordinator = mShutdownCoordinator;
+          if (!coordinator) {
+            // no account was ever created so there is nothing to coordinate
+            mShutdownCheckAgainDelegate->onShutdownCheckAgain();
+            return;
+          }
+
+          // the check again will be kicked once the accounts are all shutdown
+          coordinatorDelegate = IShutdownCoordinatorDelegateProxy::create(getQueueApplication(), checkAgain);
         }
 
-        if (mShutdownCheckAgainDelegate) {
-          // already shutting down...
-          return;
+        // accounts call into the stack while holding their own locks thus the stack lock must not be held while fanning out
+        coordinator->start(coordinatorDelegate, UseSettings::snapshot()->mStackShutdownDeadline);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr Stack::getMessageQueueStatistics(bool resetAfterReading)
+      {
+        InstrumentedQueueList queues;
+        TaskPoolPtr taskPool;
+        InterceptApplicationThreadPtr intercept;
+
+        {
+          AutoRecursiveLock lock(mLock);
+          queues = mInstrumentedQueues;
+          taskPool = mTaskPool;
+          intercept = dynamic_pointer_cast<InterceptApplicationThread>(mApplicationQueue);
         }
 
-        ShutdownCheckAgainPtr checkAgain = ShutdownCheckAgain::create(getQueueApplication(), mThisWeak.lock());
-        mShutdownCheckAgainDelegate = IShutdownCheckAgainDelegateProxy::create(checkAgain);
+        ElementPtr resultEl = Element::create("core::Stack::MessageQueueStatistics");
+
+        ElementPtr queuesEl = Element::create("queues");
+        for (InstrumentedQueueList::iterator iter = queues.begin(); iter != queues.end(); ++iter) {
+          UseServicesHelper::debugAppend(queuesEl, (*iter)->getStatistics(resetAfterReading));
+        }
+        UseServicesHelper::debugAppend(resultEl, queuesEl);
+        UseServicesHelper::debugAppend(resultEl, CoalescedWake::toDebugTotals());
 
-        mShutdownCheckAgainDelegate->onShutdownCheckAgain();
+        if (intercept) {
+          UseServicesHelper::debugAppend(resultEl, intercept->toDebug());
+        }
+
+        if (taskPool) {
+          UseServicesHelper::debugAppend(resultEl, taskPool->toDebug());
+        }
+
+        return resultEl;
       }
 
       //-----------------------------------------------------------------------
@@ -477,7 +751,7 @@ namespace openpeer
 
         String fakeDomain = String(applicationID) + ".com";
 
-        String splitChar = services::ISettings::getString(OPENPEER_CORE_SETTING_STACK_AUTHORIZED_APPLICATION_ID_SPLIT_CHAR);
+        String splitChar = UseSettings::snapshot()->mStackAuthorizedApplicationIDSplitChar;
         if (splitChar.isEmpty()) {
           splitChar = ":";
         }
@@ -515,7 +789,7 @@ namespace openpeer
           *outRemainingDurationAvailable = Seconds(0);
         }
 
-        String splitChar = services::ISettings::getString(OPENPEER_CORE_SETTING_STACK_AUTHORIZED_APPLICATION_ID_SPLIT_CHAR);
+        String splitChar = UseSettings::snapshot()->mStackAuthorizedApplicationIDSplitChar;
         if (splitChar.isEmpty()) {
           splitChar = ":";
         }
@@ -582,7 +856,10 @@ namespace openpeer
       }
 
       //-----------------------------------------------------------------------
-      void Stack::notifyProcessMessageFromCustomThread()
+      void Stack::notifyProcessMessageFromCustomThread(
+                                                       Duration budget,
+                                                       ULONG maxMessages
+                                                       )
       {
         InterceptApplicationThreadPtr thread;
         {
@@ -591,7 +868,29 @@ namespace openpeer
           ZS_THROW_INVALID_USAGE_IF(!thread)  // you can only call this method if you specified a delegate upon setup and have not already finalized the shutdown
         }
 
-        thread->processMessage();
+        thread->processMessages(budget, maxMessages);
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark Stack => ISettingsChangedDelegate
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void Stack::onSettingsChanged(SettingsSnapshotPtr snapshot)
+      {
+        AutoRecursiveLock lock(mLock);
+
+        if (!mApplicationQueue) {
+          ZS_LOG_DEBUG(slog("settings changed but stack is not setup (thus ignoring)"))
+          return;
+        }
+
+        applyThreadPriorities(*snapshot);
+        applyQueueStatisticsLogging(*snapshot);
       }
 
       //-----------------------------------------------------------------------
@@ -611,6 +910,13 @@ namespace openpeer
 
         ZS_THROW_BAD_STATE_IF(!mShutdownCheckAgainDelegate)
 
+        if (mShutdownCoordinator) {
+          if (!mShutdownCoordinator->isComplete()) {
+            ZS_LOG_DEBUG(slog("waiting for shutdown coordinator to complete"))
+            return;   // coordinator will notify again upon completion
+          }
+        }
+
         size_t total = IMessageQueueManager::getTotalUnprocessedMessages();
 
         if (total > 0) {
@@ -660,7 +966,7 @@ namespace openpeer
         if (!mApplicationQueue) {
           mApplicationQueue = IMessageQueueManager::getMessageQueueForGUIThread();
         }
-        return mApplicationQueue;
+        return instrument("application", mApplicationQueue);
       }
 
       //-----------------------------------------------------------------------
@@ -671,7 +977,26 @@ namespace openpeer
         if (!mCoreQueue) {
           mCoreQueue = IMessageQueueManager::getMessageQueue(OPENPEER_CORE_STACK_CORE_THREAD_QUEUE_NAME);
         }
-        return mCoreQueue;
+        return instrument(coreQueueName(0), mCoreQueue);
+      }
+
+      //-----------------------------------------------------------------------
+      IMessageQueuePtr Stack::getQueueCore(const char *shardKey)
+      {
+        AutoRecursiveLock lock(mLock);
+        ZS_THROW_INVALID_USAGE_IF(!mApplicationQueue) // set-up was not called
+
+        if (mCoreShardQueues.size() < 2) return getQueueCore();
+
+        size_t shard = static_cast<size_t>(hashShardKey(shardKey) % mCoreShardQueues.size());
+        if (0 == shard) return getQueueCore();
+
+        IMessageQueuePtr &queue = mCoreShardQueues[shard];
+        if (!queue) {
+          queue = IMessageQueueManager::getMessageQueue(coreQueueName(shard));
+          ZS_LOG_DEBUG(slog("created core shard queue") + ZS_PARAM("shard", shard) + ZS_PARAM("name", coreQueueName(shard)))
+        }
+        return instrument(coreQueueName(shard), queue);
       }
 
       //-----------------------------------------------------------------------
@@ -682,21 +1007,44 @@ namespace openpeer
         if (!mMediaQueue) {
           mMediaQueue = IMessageQueueManager::getMessageQueue(OPENPEER_CORE_STACK_MEDIA_THREAD_QUEUE_NAME);
         }
-        return mMediaQueue;
+        return instrument(OPENPEER_CORE_STACK_MEDIA_THREAD_QUEUE_NAME, mMediaQueue);
       }
 
       //-----------------------------------------------------------------------
-      IMessageQueuePtr Stack::getQueueServices() const
+      IMessageQueuePtr Stack::getQueueServices()
       {
         AutoRecursiveLock lock(mLock);
-        return UseServicesHelper::getServiceQueue();
+        return instrument("services", UseServicesHelper::getServiceQueue());
       }
 
       //-----------------------------------------------------------------------
-      IMessageQueuePtr Stack::getQueueKeyGeneration() const
+      IMessageQueuePtr Stack::getQueueKeyGeneration()
       {
         AutoRecursiveLock lock(mLock);
-        return stack::IStack::getKeyGenerationQueue();
+        return instrument("key generation", stack::IStack::getKeyGenerationQueue());
+      }
+
+      //-----------------------------------------------------------------------
+      TaskPoolPtr Stack::getTaskPool()
+      {
+        AutoRecursiveLock lock(mLock);
+        if (!mApplicationQueue) return TaskPoolPtr();
+        if (!mTaskPool) {
+          mTaskPool = TaskPool::create();
+          ZS_LOG_DETAIL(slog("created task pool") + ZS_PARAM("workers", mTaskPool->getTotalWorkers()))
+        }
+        return mTaskPool;
+      }
+
+      //-----------------------------------------------------------------------
+      ShutdownCoordinatorPtr Stack::getShutdownCoordinator()
+      {
+        AutoRecursiveLock lock(mLock);
+        if (!mApplicationQueue) return ShutdownCoordinatorPtr();
+        if (!mShutdownCoordinator) {
+          mShutdownCoordinator = ShutdownCoordinator::create(getQueueCore());
+        }
+        return mShutdownCoordinator;
       }
 
       //-----------------------------------------------------------------------
@@ -715,13 +1063,34 @@ namespace openpeer
         MessageQueueThreadPtr  servicesThread;
         MessageQueueThreadPtr  keyGenerationThread;
         IStackMessageQueueDelegatePtr stackMessage;
+        TaskPoolPtr taskPool;
 
         {
           AutoRecursiveLock lock(mLock);
           mApplicationQueue.reset();
           mCoreQueue.reset();
+          mCoreShardQueues.clear();
           mMediaQueue.reset();
           mStackMessageQueueDelegate.reset();
+          mInstrumentedQueues.clear();
+
+          if (mQueueStatisticsLogger) {
+            mQueueStatisticsLogger->cancel();
+            mQueueStatisticsLogger.reset();
+          }
+
+          taskPool = mTaskPool;
+          mTaskPool.reset();
+
+          if (mShutdownCoordinator) {
+            mShutdownCoordinator->cancel();
+            mShutdownCoordinator.reset();
+          }
+        }
+
+        // joins the workers (must not hold the stack lock while they finish)
+        if (taskPool) {
+          taskPool->shutdown();
         }
       }
 
@@ -748,6 +1117,84 @@ namespace openpeer
         }
       }
 
+      //-----------------------------------------------------------------------
+      void Stack::applyThreadPriorities(const SettingsSnapshot &snapshot)
+      {
+        if (mCoreThreadPriority != snapshot.mStackCoreThreadPriority) {
+          ZS_LOG_DETAIL(slog("core thread priority changed") + ZS_PARAM("old", mCoreThreadPriority) + ZS_PARAM("new", snapshot.mStackCoreThreadPriority))
+          mCoreThreadPriority = snapshot.mStackCoreThreadPriority;
+
+          size_t totalShards = (mCoreShardQueues.size() > 0 ? mCoreShardQueues.size() : 1);
+          for (size_t shard = 0; shard < totalShards; ++shard) {
+            IMessageQueueManager::registerMessageQueueThreadPriority(coreQueueName(shard), zsLib::threadPriorityFromString(mCoreThreadPriority));
+          }
+        }
+
+        if (mMediaThreadPriority != snapshot.mStackMediaThreadPriority) {
+          ZS_LOG_DETAIL(slog("media thread priority changed") + ZS_PARAM("old", mMediaThreadPriority) + ZS_PARAM("new", snapshot.mStackMediaThreadPriority))
+          mMediaThreadPriority = snapshot.mStackMediaThreadPriority;
+          IMessageQueueManager::registerMessageQueueThreadPriority(OPENPEER_CORE_STACK_MEDIA_THREAD_QUEUE_NAME, zsLib::threadPriorityFromString(mMediaThreadPriority));
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void Stack::applyQueueStatisticsLogging(const SettingsSnapshot &snapshot)
+      {
+        if (mQueueStatisticsLogInterval == snapshot.mStackQueueStatisticsLogInterval) return;
+
+        ZS_LOG_DETAIL(slog("queue statistics log interval changed") + ZS_PARAM("old", mQueueStatisticsLogInterval) + ZS_PARAM("new", snapshot.mStackQueueStatisticsLogInterval))
+        mQueueStatisticsLogInterval = snapshot.mStackQueueStatisticsLogInterval;
+
+        if (mQueueStatisticsLogger) {
+          mQueueStatisticsLogger->cancel();
+          mQueueStatisticsLogger.reset();
+        }
+
+        if (mQueueStatisticsLogInterval <= Seconds(0)) return;
+
+        mQueueStatisticsLogger = StackQueueStatisticsLogger::create(getQueueCore(), mQueueStatisticsLogInterval);
+      }
+
+      //-----------------------------------------------------------------------
+      IMessageQueuePtr Stack::instrument(
+                                         const String &name,
+                                         IMessageQueuePtr queue
+                                         )
+      {
+        if (!queue) return queue;
+
+        for (InstrumentedQueueList::iterator iter = mInstrumentedQueues.begin(); iter != mInstrumentedQueues.end(); ++iter) {
+          if ((*iter)->getQueue() == queue) return (*iter);
+        }
+
+        InstrumentedMessageQueuePtr instrumented = InstrumentedMessageQueue::create(name, queue);
+        mInstrumentedQueues.push_back(instrumented);
+
+        ZS_LOG_DEBUG(slog("instrumenting message queue") + ZS_PARAM("name", name))
+        return instrumented;
+      }
+
+      //-----------------------------------------------------------------------
+      ULONG Stack::hashShardKey(const char *shardKey)
+      {
+        // FNV-1a (stable across runs and platforms)
+        ULONG hash = 2166136261UL;
+        if (!shardKey) return hash;
+
+        for (const unsigned char *pos = reinterpret_cast<const unsigned char *>(shardKey); '\0' != *pos; ++pos) {
+          hash ^= static_cast<ULONG>(*pos);
+          hash = static_cast<ULONG>((hash * 16777619UL) & 0xFFFFFFFFUL);
+        }
+        return hash;
+      }
+
+      //-----------------------------------------------------------------------
+      String Stack::coreQueueName(size_t shard)
+      {
+        if (0 == shard) return String(OPENPEER_CORE_STACK_CORE_THREAD_QUEUE_NAME);
+        return String(OPENPEER_CORE_STACK_CORE_THREAD_QUEUE_NAME) + "." + string(shard);
+      }
+
       //-----------------------------------------------------------------------
       Log::Params Stack::slog(const char *message)
       {
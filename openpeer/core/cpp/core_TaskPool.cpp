@@ -0,0 +1,393 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+#include <openpeer/core/internal/core_TaskPool.h>
+#include <openpeer/core/internal/core_Logger.h>
+#include <openpeer/core/internal/core_Stack.h>
+
+#include <openpeer/services/IHelper.h>
+
+#include <zsLib/XML.h>
+
+#include <boost/bind.hpp>
+
+namespace openpeer { namespace core { ZS_DECLARE_SUBSYSTEM(openpeer_core) } }
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      ZS_DECLARE_TYPEDEF_PTR(services::IHelper, UseServicesHelper)
+      ZS_DECLARE_TYPEDEF_PTR(IStackForInternal, UseStack)
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark (helpers)
+      #pragma mark
+
+      struct CurrentWorker
+      {
+        const TaskPool *mPool;
+        size_t mIndex;
+      };
+
+      //-----------------------------------------------------------------------
+      static boost::thread_specific_ptr<CurrentWorker> &currentWorker()
+      {
+        static boost::thread_specific_ptr<CurrentWorker> current;
+        return current;
+      }
+
+      //-----------------------------------------------------------------------
+      static ULONG toMicroseconds(const Duration &duration)
+      {
+        if (duration.is_negative()) return 0;
+        zsLib::ULONGLONG value = static_cast<zsLib::ULONGLONG>(duration.total_microseconds());
+        if (value > static_cast<zsLib::ULONGLONG>(ULONG(-1))) return ULONG(-1);
+        return static_cast<ULONG>(value);
+      }
+
+      //-----------------------------------------------------------------------
+      static void runInline(
+                            ITaskPoolTaskPtr task,
+                            ITaskPoolTaskDelegatePtr delegate
+                            )
+      {
+        task->run();
+
+        try {
+          delegate->onTaskPoolTaskCompleted(task);
+        } catch(ITaskPoolTaskDelegateProxy::Exceptions::DelegateGone &) {
+          ZS_LOG_WARNING(Detail, Log::Params("delegate gone", "core::TaskPool") + ZS_PARAM("task", task->getTaskName()))
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ITaskPoolForInternal
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      void ITaskPoolForInternal::submit(
+                                        ITaskPoolTaskPtr task,
+                                        ITaskPoolTaskDelegatePtr inDelegate
+                                        )
+      {
+        ZS_THROW_INVALID_ARGUMENT_IF(!task)
+        ZS_THROW_INVALID_ARGUMENT_IF(!inDelegate)
+
+        ITaskPoolTaskDelegatePtr delegate = ITaskPoolTaskDelegateProxy::createWeak(inDelegate);
+
+        TaskPoolPtr pool = UseStack::taskPool();
+        if (!pool) {
+          ZS_LOG_WARNING(Detail, Log::Params("task pool is not available (thus running task inline)", "core::TaskPool") + ZS_PARAM("task", task->getTaskName()))
+          runInline(task, delegate);
+          return;
+        }
+
+        pool->submitJob(task, delegate);
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr ITaskPoolForInternal::toDebug()
+      {
+        TaskPoolPtr pool = UseStack::taskPool();
+        if (!pool) return ElementPtr();
+        return pool->toDebug();
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TaskPool
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      TaskPool::TaskPool(size_t totalWorkers) :
+        mNextWorker(0),
+        mPending(0),
+        mShouldShutdown(false),
+        mTotalCompleted(0)
+      {
+        for (size_t index = 0; index < totalWorkers; ++index) {
+          mWorkers.push_back(WorkerPtr(new Worker));
+        }
+        ZS_LOG_DETAIL(log("created") + ZS_PARAM("workers", totalWorkers))
+      }
+
+      //-----------------------------------------------------------------------
+      TaskPool::~TaskPool()
+      {
+        shutdown();
+        ZS_LOG_DETAIL(log("destroyed"))
+      }
+
+      //-----------------------------------------------------------------------
+      TaskPoolPtr TaskPool::create(size_t totalWorkers)
+      {
+        if (0 == totalWorkers) {
+          totalWorkers = static_cast<size_t>(boost::thread::hardware_concurrency());
+        }
+        if (totalWorkers < 1) totalWorkers = 1;
+
+        TaskPoolPtr pThis(new TaskPool(totalWorkers));
+
+        // all workers must exist before any thread starts stealing from them
+        for (size_t index = 0; index < pThis->mWorkers.size(); ++index) {
+          pThis->mWorkers[index]->mThread = ThreadPtr(new boost::thread(boost::bind(&TaskPool::workerLoop, pThis.get(), index)));
+        }
+        return pThis;
+      }
+
+      //-----------------------------------------------------------------------
+      void TaskPool::submitJob(
+                               ITaskPoolTaskPtr task,
+                               ITaskPoolTaskDelegatePtr delegate
+                               )
+      {
+        Job job;
+        job.mTask = task;
+        job.mDelegate = delegate;
+        job.mQueued = zsLib::now();
+
+        // tasks spawned from a pool thread stay local (best cache locality), others are spread round robin
+        size_t index = getCurrentWorkerIndex();
+        if (index >= mWorkers.size()) {
+          index = mNextWorker.fetch_add(1, boost::memory_order_relaxed) % mWorkers.size();
+        }
+
+        {
+          // the shutdown check and the push share one critical section so
+          // a worker can never exit between them and strand the job
+          boost::unique_lock<boost::mutex> lock(mWakeMutex);
+          if (mShouldShutdown) {
+            lock.unlock();
+            ZS_LOG_WARNING(Detail, log("task pool is shutdown (thus running task inline)") + ZS_PARAM("task", task->getTaskName()))
+            runInline(task, delegate);
+            return;
+          }
+
+          // counted before it is visible so a thief can never take the pending count below zero
+          mPending.fetch_add(1, boost::memory_order_release);
+
+          WorkerPtr &worker = mWorkers[index];
+          AutoLock workerLock(worker->mLock);
+          worker->mJobs.push_back(job);
+        }
+        mWakeCondition.notify_one();
+      }
+
+      //-----------------------------------------------------------------------
+      void TaskPool::shutdown()
+      {
+        {
+          boost::unique_lock<boost::mutex> lock(mWakeMutex);
+          if (mShouldShutdown) return;
+          mShouldShutdown = true;
+        }
+        mWakeCondition.notify_all();
+
+        ZS_LOG_DETAIL(log("shutting down") + ZS_PARAM("pending", mPending.load(boost::memory_order_acquire)))
+
+        // workers drain their queues before exiting
+        for (WorkerList::iterator iter = mWorkers.begin(); iter != mWorkers.end(); ++iter) {
+          WorkerPtr &worker = (*iter);
+          if (!worker->mThread) continue;
+          worker->mThread->join();
+          worker->mThread.reset();
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      ElementPtr TaskPool::toDebug() const
+      {
+        ElementPtr resultEl = Element::create("core::TaskPool");
+
+        UseServicesHelper::debugAppend(resultEl, "id", mID);
+        UseServicesHelper::debugAppend(resultEl, "workers", mWorkers.size());
+        UseServicesHelper::debugAppend(resultEl, "pending", mPending.load(boost::memory_order_acquire));
+
+        AutoLock lock(mStatsLock);
+
+        UseServicesHelper::debugAppend(resultEl, "completed", mTotalCompleted);
+
+        ElementPtr tasksEl = Element::create("tasks");
+        for (TaskStatsMap::const_iterator iter = mStats.begin(); iter != mStats.end(); ++iter) {
+          const TaskStats &stats = (*iter).second;
+
+          ElementPtr taskEl = Element::create("task");
+          UseServicesHelper::debugAppend(taskEl, "name", (*iter).first);
+          UseServicesHelper::debugAppend(taskEl, "stolen", stats.mStolen);
+          UseServicesHelper::debugAppend(taskEl, stats.mWaitTime.toDebug("wait", "us"));
+          UseServicesHelper::debugAppend(taskEl, stats.mRunTime.toDebug("run", "us"));
+          UseServicesHelper::debugAppend(tasksEl, taskEl);
+        }
+        UseServicesHelper::debugAppend(resultEl, tasksEl);
+
+        return resultEl;
+      }
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TaskPool => (internal)
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      Log::Params TaskPool::log(const char *message) const
+      {
+        ElementPtr objectEl = Element::create("core::TaskPool");
+        UseServicesHelper::debugAppend(objectEl, "id", mID);
+        return Log::Params(message, objectEl);
+      }
+
+      //-----------------------------------------------------------------------
+      size_t TaskPool::getCurrentWorkerIndex() const
+      {
+        CurrentWorker *current = currentWorker().get();
+        if (!current) return mWorkers.size();
+        if (this != current->mPool) return mWorkers.size();
+        return current->mIndex;
+      }
+
+      //-----------------------------------------------------------------------
+      bool TaskPool::popJob(
+                            size_t index,
+                            Job &outJob,
+                            bool &outStolen
+                            )
+      {
+        outStolen = false;
+
+        // newest local job first (LIFO)
+        {
+          WorkerPtr &worker = mWorkers[index];
+          AutoLock lock(worker->mLock);
+          if (worker->mJobs.size() > 0) {
+            outJob = worker->mJobs.back();
+            worker->mJobs.pop_back();
+            return true;
+          }
+        }
+
+        // steal the oldest job from another worker (FIFO)
+        for (size_t offset = 1; offset < mWorkers.size(); ++offset) {
+          WorkerPtr &victim = mWorkers[(index + offset) % mWorkers.size()];
+          AutoLock lock(victim->mLock);
+          if (victim->mJobs.size() < 1) continue;
+
+          outJob = victim->mJobs.front();
+          victim->mJobs.pop_front();
+          outStolen = true;
+          return true;
+        }
+
+        return false;
+      }
+
+      //-----------------------------------------------------------------------
+      void TaskPool::runJob(
+                            Job &job,
+                            bool stolen
+                            )
+      {
+        const char *name = job.mTask->getTaskName();
+
+        Time start = zsLib::now();
+        job.mTask->run();
+        Time finish = zsLib::now();
+
+        ULONG waitTime = toMicroseconds(start - job.mQueued);
+        ULONG runTime = toMicroseconds(finish - start);
+
+        {
+          AutoLock lock(mStatsLock);
+          TaskStats &stats = mStats[name];
+          stats.mWaitTime.record(waitTime);
+          stats.mRunTime.record(runTime);
+          if (stolen) ++(stats.mStolen);
+          ++mTotalCompleted;
+        }
+
+        OPENPEER_CORE_LOG_HOT_TRACE(log("task completed") + ZS_PARAM("task", name) + ZS_PARAM("wait (us)", waitTime) + ZS_PARAM("run (us)", runTime) + ZS_PARAM("stolen", stolen))
+
+        try {
+          job.mDelegate->onTaskPoolTaskCompleted(job.mTask);
+        } catch(ITaskPoolTaskDelegateProxy::Exceptions::DelegateGone &) {
+          ZS_LOG_WARNING(Detail, log("delegate gone") + ZS_PARAM("task", name))
+        }
+      }
+
+      //-----------------------------------------------------------------------
+      void TaskPool::workerLoop(size_t index)
+      {
+        CurrentWorker *current = new CurrentWorker;
+        current->mPool = this;
+        current->mIndex = index;
+        currentWorker().reset(current);
+
+        ZS_LOG_DEBUG(log("worker started") + ZS_PARAM("index", index))
+
+        while (true) {
+          Job job;
+          bool stolen = false;
+
+          if (popJob(index, job, stolen)) {
+            mPending.fetch_sub(1, boost::memory_order_acq_rel);
+            runJob(job, stolen);
+            continue;
+          }
+
+          boost::unique_lock<boost::mutex> lock(mWakeMutex);
+          if (mPending.load(boost::memory_order_acquire) > 0) continue;   // a job was pushed after the scan
+          if (mShouldShutdown) break;
+
+          mWakeCondition.timed_wait(lock, boost::posix_time::milliseconds(Milliseconds_IdleWait));
+        }
+
+        ZS_LOG_DEBUG(log("worker stopped") + ZS_PARAM("index", index))
+        currentWorker().reset();
+      }
+    }
+  }
+}
@@ -37,6 +37,7 @@
 #include <openpeer/core/internal/core_Helper.h>
 #include <openpeer/core/internal/core_Stack.h>
 #include <openpeer/core/internal/core_Settings.h>
+#include <openpeer/core/internal/core_Logger.h>
 
 #include <openpeer/core/ICache.h>
 
@@ -277,6 +278,7 @@ namespace openpeer
 
         //---------------------------------------------------------------------
         MessagePtr Message::create(
+                                   IMessageQueuePtr queue,
                                    const char *messageID,
                                    const char *replacesMessageID,
                                    const char *fromPeerURI,
@@ -288,6 +290,7 @@ namespace openpeer
         {
           MessagePtr pThis = MessagePtr(new Message);
           pThis->mThisWeak = pThis;
+          pThis->mQueue = queue;
           pThis->mData = MessageDataPtr(new MessageData);
 
           pThis->mData->mMessageID = String(messageID);
@@ -318,6 +321,7 @@ namespace openpeer
 
           MessagePtr pThis = MessagePtr(new Message);
           pThis->mThisWeak = pThis;
+          pThis->mQueue = Account::convert(account)->getAssociatedMessageQueue();
 
           pThis->mData = pThis->parseFromElement(account, messageBundleEl, false);
 
@@ -515,7 +519,7 @@ namespace openpeer
           if (!mData) return; // nothing to do
 
           if ((mFlags & Flag_Cached) != 0) {
-            ZS_LOG_TRACE(log("already cached"))
+            OPENPEER_CORE_LOG_HOT_TRACE(log("already cached"))
             mData.reset();
             return;
           }
@@ -590,7 +594,7 @@ namespace openpeer
           }
 
           mData->mScheduledAt = zsLib::now();
-          mData->mTimer = Timer::create(ITimerDelegateProxy::create(UseStack::queueCore(), mThisWeak.lock()), UseSettings::getThreadMoveMessageToCacheTimeInSeconds(), false);
+          mData->mTimer = Timer::create(ITimerDelegateProxy::create(mQueue, mThisWeak.lock()), UseSettings::getThreadMoveMessageToCacheTimeInSeconds(), false);
         }
 
         //---------------------------------------------------------------------
@@ -627,7 +631,7 @@ namespace openpeer
                   }
                 }
                 if (data->mValidated) {
-                  ZS_LOG_TRACE(log("message received validated") + ZS_PARAM("message ID", data->mMessageID))
+                  OPENPEER_CORE_LOG_HOT_TRACE(log("message received validated") + ZS_PARAM("message ID", data->mMessageID))
                 } else {
                   ZS_LOG_WARNING(Debug, log("message received did not validate validated") + ZS_PARAM("message ID", data->mMessageID))
                 }
@@ -768,7 +772,7 @@ namespace openpeer
           pThis->mVersion = Numeric<UINT>(messageReceiptsEl->getAttributeValue("version"));
           ElementPtr messagesEl = messageReceiptsEl->findFirstChildElement("messages");
           if (!messagesEl) {
-            ZS_LOG_TRACE(pThis->log("no messages contained within message receipts"))
+            OPENPEER_CORE_LOG_HOT_TRACE(pThis->log("no messages contained within message receipts"))
             return pThis;
           }
 
@@ -778,7 +782,7 @@ namespace openpeer
             {
               String id = messageEl->getAttributeValue("id");
               String timeStr = messageEl->getText();
-              ZS_LOG_TRACE(pThis->log("Parsing receipt") + ZS_PARAM("receipt ID", id) + ZS_PARAM("acknowledged at", timeStr))
+              OPENPEER_CORE_LOG_HOT_TRACE(pThis->log("Parsing receipt") + ZS_PARAM("receipt ID", id) + ZS_PARAM("acknowledged at", timeStr))
               Time time = UseServicesHelper::stringToTime(timeStr);
 
               if (Time() == time) {
@@ -787,7 +791,7 @@ namespace openpeer
               }
 
               pThis->mReceipts[id] = time;
-              ZS_LOG_TRACE(pThis->log("Found receipt") + ZS_PARAM("receipt ID", id) + ZS_PARAM("acknowledged at", time))
+              OPENPEER_CORE_LOG_HOT_TRACE(pThis->log("Found receipt") + ZS_PARAM("receipt ID", id) + ZS_PARAM("acknowledged at", time))
 
               messageEl = messageEl->findNextSiblingElement("message");
             }
@@ -1676,7 +1680,12 @@ namespace openpeer
             ElementPtr secretEl = createElementWithText("secret", description->mSecuritySecret);
             ElementPtr saltEl = createElementWithText("salt", description->mSecuritySalt);
 
-            ElementPtr codecsEl = Element::create("codecs");
+            // NOTE: peers that predate codec negotiation never advance past
+            //       the first "codec" found in "codecs" (thus looping
+            //       forever), so codecs are only listed in "mediaCodecs"
+            //       (which they ignore) and "codecs" is always left empty
+            ElementPtr legacyCodecsEl = Element::create("codecs");
+            ElementPtr codecsEl = Element::create("mediaCodecs");
 
             ElementPtr iceUsernameFragEl = IMessageHelper::createElementWithTextAndJSONEncode("iceUsernameFrag", description->mICEUsernameFrag);
             ElementPtr icePasswordEl = IMessageHelper::createElementWithTextAndJSONEncode("icePassword", description->mICEPassword);
@@ -1717,13 +1726,20 @@ namespace openpeer
 
             descriptionEl->adoptAsLastChild(ssrcEl);
             descriptionEl->adoptAsLastChild(securityEl);
-            descriptionEl->adoptAsLastChild(codecsEl);
+            descriptionEl->adoptAsLastChild(legacyCodecsEl);
+            if (codecsEl->hasChildren()) {
+              descriptionEl->adoptAsLastChild(codecsEl);
+            }
             descriptionEl->adoptAsLastChild(iceUsernameFragEl);
             descriptionEl->adoptAsLastChild(icePasswordEl);
             if (description->mFinal) {
               ElementPtr finalEl = createElementWithNumber("iceFinal", "true");
               descriptionEl->adoptAsLastChild(finalEl);
             }
+            if (description->mBundleID.hasData()) {
+              ElementPtr bundleEl = createElementWithText("bundle", description->mBundleID);
+              descriptionEl->adoptAsLastChild(bundleEl);
+            }
 
             descriptionEl->adoptAsLastChild(candidatesEl);
 
@@ -1808,7 +1824,8 @@ namespace openpeer
               description->mSecuritySecret = secretEl->getText();
               description->mSecuritySalt = saltEl->getText();
 
-              ElementPtr codecsEl = descriptionEl->findFirstChildElement("codecs");
+              ElementPtr codecsEl = descriptionEl->findFirstChildElement("mediaCodecs");
+              if (!codecsEl) codecsEl = descriptionEl->findFirstChildElement("codecs");
               ElementPtr codecEl = (codecsEl ? codecsEl->findFirstChildElement("codec") : ElementPtr());
 
               while (codecEl)
@@ -1820,6 +1837,8 @@ namespace openpeer
                 codec.mRate = Numeric<decltype(codec.mRate)>(codecEl->findFirstChildElementChecked("rate")->getText());
                 codec.mChannels = Numeric<decltype(codec.mChannels)>(codecEl->findFirstChildElementChecked("channels")->getText());
                 description->mCodecs.push_back(codec);
+
+                codecEl = codecEl->findNextSiblingElement("codec");
               }
 
               description->mICEUsernameFrag = IMessageHelper::getElementTextAndDecode(descriptionEl->findFirstChildElementChecked("iceUsernameFrag"));
@@ -1835,6 +1854,11 @@ namespace openpeer
                 }
               }
 
+              ElementPtr bundleEl = descriptionEl->findFirstChildElement("bundle");
+              if (bundleEl) {
+                description->mBundleID = bundleEl->getText();
+              }
+
               ElementPtr candidatesEl = descriptionEl->findFirstChildElement("candidates");
               ElementPtr candidateEl = candidatesEl->findFirstChildElement("candidate");
 
@@ -1949,6 +1973,7 @@ namespace openpeer
           UseServicesHelper::debugAppend(resultEl, "codecs", mCodecs.size());
           UseServicesHelper::debugAppend(resultEl, "candidates", mCandidates.size());
           UseServicesHelper::debugAppend(resultEl, "final", mFinal);
+          UseServicesHelper::debugAppend(resultEl, "bundle", mBundleID);
 
           return resultEl;
         }
@@ -2208,6 +2233,7 @@ namespace openpeer
 
           ThreadPtr pThis(new Thread);
           pThis->mThisWeak = pThis;
+          pThis->mQueue = Account::convert(account)->getAssociatedMessageQueue();
           pThis->mPublication = publication;
 
           SplitMap result;
@@ -2467,15 +2493,15 @@ namespace openpeer
                   version = getVersion(dialogEl);
                   DialogPtr &dialog = (*found).second;
                   if (version > dialog->version()) {
-                    ZS_LOG_TRACE(log("dialog change detected") + ZS_PARAM("dialog", dialog->toDebug()))
+                    OPENPEER_CORE_LOG_HOT_TRACE(log("dialog change detected") + ZS_PARAM("dialog", dialog->toDebug()))
                     update = true;
                   } else {
                     dialogs[id] = dialog; // using existing dialog
-                    ZS_LOG_TRACE(log("using existing dialog") + ZS_PARAM("dialog", dialog->toDebug()))
+                    OPENPEER_CORE_LOG_HOT_TRACE(log("using existing dialog") + ZS_PARAM("dialog", dialog->toDebug()))
                   }
                 } else {
                   update = true;
-                  ZS_LOG_TRACE(log("new dialog detected") + ZS_PARAM("dialog ID", id))
+                  OPENPEER_CORE_LOG_HOT_TRACE(log("new dialog detected") + ZS_PARAM("dialog ID", id))
                 }
 
                 if (update) {
@@ -2488,7 +2514,7 @@ namespace openpeer
                 dialogBundleEl = dialogBundleEl->findNextSiblingElement("dialogBundle");
               }
             } else {
-              ZS_LOG_TRACE(log("dialogs did not change"))
+              OPENPEER_CORE_LOG_HOT_TRACE(log("dialogs did not change"))
               dialogs = mDialogs;
             }
           } catch (zsLib::XML::Exceptions::CheckFailed &) {
@@ -2625,7 +2651,7 @@ namespace openpeer
               {
                 const DescriptionPtr &description = (*descIter);
 
-                ZS_LOG_TRACE(log("found old description") + Dialog::toDebug(dialog) + description->toDebug())
+                OPENPEER_CORE_LOG_HOT_TRACE(log("found old description") + Dialog::toDebug(dialog) + description->toDebug())
                 oldDescriptions[description->mDescriptionID] = ChangedDescription(dialog->dialogID(), description);
               }
             }
@@ -2638,7 +2664,7 @@ namespace openpeer
               {
                 const DescriptionPtr &description = (*descIter);
 
-                ZS_LOG_TRACE(log("found new description") + Dialog::toDebug(dialog) + description->toDebug())
+                OPENPEER_CORE_LOG_HOT_TRACE(log("found new description") + Dialog::toDebug(dialog) + description->toDebug())
                 newDescriptions[description->mDescriptionID] = ChangedDescription(dialog->dialogID(), description);
               }
             }
@@ -2657,11 +2683,11 @@ namespace openpeer
                 if (description->mVersion > oldDescription->mVersion) {
                   // this description has changed
                   mDescriptionsChanged[descriptionID] = changed;
-                  ZS_LOG_TRACE(log("description change detected") + ZS_PARAM("dialog ID", dialogID) + description->toDebug())
+                  OPENPEER_CORE_LOG_HOT_TRACE(log("description change detected") + ZS_PARAM("dialog ID", dialogID) + description->toDebug())
                 }
               } else {
                 // this is a new description entirely
-                ZS_LOG_TRACE(log("new description detected") + ZS_PARAM("dialog ID", dialogID) + description->toDebug())
+                OPENPEER_CORE_LOG_HOT_TRACE(log("new description detected") + ZS_PARAM("dialog ID", dialogID) + description->toDebug())
                 mDescriptionsChanged[descriptionID] = changed;
               }
             }
@@ -2676,7 +2702,7 @@ namespace openpeer
               if (found == newDescriptions.end()) {
                 // this description has now been removed entirely...
                 mDescriptionsRemoved.push_back(descriptionID);
-                ZS_LOG_TRACE(log("description removal detected") + ZS_PARAM("dialog ID", dialogID) + ZS_PARAM("description ID", descriptionID))
+                OPENPEER_CORE_LOG_HOT_TRACE(log("description removal detected") + ZS_PARAM("dialog ID", dialogID) + ZS_PARAM("description ID", descriptionID))
               }
             }
 
@@ -2690,7 +2716,7 @@ namespace openpeer
               DialogMap::iterator found = dialogs.find(id);
               if (found == dialogs.end()) {
                 // this is dialog is completely gone...
-                ZS_LOG_TRACE(log("dialog detected removed") + ZS_PARAM("dialog ID", id))
+                OPENPEER_CORE_LOG_HOT_TRACE(log("dialog detected removed") + ZS_PARAM("dialog ID", id))
                 mDialogsRemoved.push_back(id);
               }
             }
@@ -2729,6 +2755,7 @@ namespace openpeer
 
           ThreadPtr pThis = ThreadPtr(new Thread);
           pThis->mThisWeak = pThis;
+          pThis->mQueue = Account::convert(account)->getAssociatedMessageQueue();
           pThis->mType = threadType;
           pThis->mCanModify = true;
 
@@ -2786,7 +2813,7 @@ namespace openpeer
             ZS_THROW_INVALID_ARGUMENT_IF(!peerHostLocation->getPeer())
 
             String hostContactURI = peerHostLocation->getPeer()->getPeerURI();
-            ZS_LOG_TRACE(pThis->log("slave thread") + ZS_PARAM("using host URI", hostContactURI) + ZS_PARAM("base thread ID", baseThreadID) + ZS_PARAM("host thread ID", hostThreadID))
+            OPENPEER_CORE_LOG_HOT_TRACE(pThis->log("slave thread") + ZS_PARAM("using host URI", hostContactURI) + ZS_PARAM("base thread ID", baseThreadID) + ZS_PARAM("host thread ID", hostThreadID))
 
             relationships.push_back(hostContactURI);
           }
@@ -3336,7 +3363,7 @@ namespace openpeer
               mContactPublicationsCompleted[uri] = IPublicationPtr();
 
               ZS_LOG_DEBUG(log("publishing host contact document"))
-              repository->publish(IPublicationPublisherDelegateProxy::createNoop(UseStack::queueCore()), contactPublication);
+              repository->publish(IPublicationPublisherDelegateProxy::createNoop(mQueue), contactPublication);
             }
 
             mContactPublications.clear();
@@ -3344,12 +3371,12 @@ namespace openpeer
 
           if (permissions) {
             ZS_LOG_DEBUG(log("publishing thread permission document"))
-            repository->publish(IPublicationPublisherDelegateProxy::createNoop(UseStack::queueCore()), mPermissionPublication);
+            repository->publish(IPublicationPublisherDelegateProxy::createNoop(mQueue), mPermissionPublication);
           }
 
           if (publication) {
             ZS_LOG_DEBUG(log("publishing thread document"))
-            repository->publish(IPublicationPublisherDelegateProxy::createNoop(UseStack::queueCore()), mPublication);
+            repository->publish(IPublicationPublisherDelegateProxy::createNoop(mQueue), mPublication);
           }
         }
 
@@ -3462,7 +3489,7 @@ namespace openpeer
           }
 
           if (mContactPublicationsCompleted.end() != mContactPublicationsCompleted.find(contact->getPeerURI())) {
-            ZS_LOG_TRACE(log("contact already published") + UseContact::toDebug(contact))
+            OPENPEER_CORE_LOG_HOT_TRACE(log("contact already published") + UseContact::toDebug(contact))
             return;
           }
 
@@ -3631,7 +3658,7 @@ namespace openpeer
           }
 
           if (!changed) {
-            ZS_LOG_TRACE(log("no message receipts changed detected from previous received map (thus ignoring request to set receipts)"))
+            OPENPEER_CORE_LOG_HOT_TRACE(log("no message receipts changed detected from previous received map (thus ignoring request to set receipts)"))
             // nothing changed thus do not cause an update
             return;
           }
@@ -32,6 +32,7 @@
 #pragma once
 
 #include <openpeer/core/internal/core_Account.h>
+#include <openpeer/core/internal/core_AudioMixer.h>
 #include <openpeer/core/internal/core_Backgrounding.h>
 #include <openpeer/core/internal/core_Cache.h>
 #include <openpeer/core/internal/core_Call.h>
@@ -46,8 +47,11 @@
 #include <openpeer/core/internal/core_Helper.h>
 #include <openpeer/core/internal/core_Identity.h>
 #include <openpeer/core/internal/core_IdentityLookup.h>
+#include <openpeer/core/internal/core_InstrumentedMessageQueue.h>
 #include <openpeer/core/internal/core_Logger.h>
 #include <openpeer/core/internal/core_MediaEngine.h>
 #include <openpeer/core/internal/core_Settings.h>
+#include <openpeer/core/internal/core_ShutdownCoordinator.h>
 #include <openpeer/core/internal/core_Stack.h>
+#include <openpeer/core/internal/core_TaskPool.h>
 #include <openpeer/core/internal/core_thread.h>
@@ -33,6 +33,7 @@
 
 #include <openpeer/core/internal/types.h>
 #include <openpeer/core/internal/core_CallTransport.h>
+#include <openpeer/core/internal/core_Helper.h>
 
 #include <openpeer/core/IAccount.h>
 #include <openpeer/core/IConversationThread.h>
@@ -139,6 +140,8 @@ namespace openpeer
 
         virtual IPeerFilesPtr getPeerFiles() const = 0;
 
+        virtual CallTransportPtr getCallTransport() const = 0;
+
         virtual IConversationThreadDelegatePtr getConversationThreadDelegate() const = 0;
         virtual void notifyConversationThreadCreated(
                                                      ConversationThreadPtr thread,
@@ -184,6 +187,45 @@ namespace openpeer
         virtual ContactPtr findContact(const char *peerURI) const = 0;
       };
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IAccountForShutdownCoordinator
+      #pragma mark
+
+      interaction IAccountForShutdownCoordinator
+      {
+        ZS_DECLARE_TYPEDEF_PTR(IAccountForShutdownCoordinator, ForShutdownCoordinator)
+
+        virtual PUID getID() const = 0;
+
+        virtual IAccount::AccountStates getState(
+                                                 WORD *outErrorCode = NULL,
+                                                 String *outErrorReason = NULL
+                                                 ) const = 0;
+
+        //---------------------------------------------------------------------
+        // PURPOSE: describes what the account is still waiting upon to
+        //          complete its graceful shutdown (empty if nothing)
+        virtual String getShutdownBlocker() const = 0;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IAccountAsync
+      #pragma mark
+
+      interaction IAccountAsync
+      {
+        virtual void onShutdown() = 0;
+        virtual void onForceShutdown() = 0;
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -201,6 +243,8 @@ namespace openpeer
                       public IAccountForConversationThread,
                       public IAccountForIdentity,
                       public IAccountForIdentityLookup,
+                      public IAccountForShutdownCoordinator,
+                      public IAccountAsync,
                       public ICallTransportDelegate,
                       public stack::IAccountDelegate,
                       public IPeerSubscriptionDelegate,
@@ -266,6 +310,7 @@ namespace openpeer
         static AccountPtr convert(ForConversationThreadPtr account);
         static AccountPtr convert(ForIdentityPtr account);
         static AccountPtr convert(ForIdentityLookupPtr account);
+        static AccountPtr convert(ForShutdownCoordinatorPtr account);
 
       protected:
         //---------------------------------------------------------------------
@@ -401,6 +446,28 @@ namespace openpeer
 
         // (duplicate) virtual ContactPtr findContact(const char *peerURI) const;
 
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Account => IAccountForShutdownCoordinator
+        #pragma mark
+
+        // (duplicate) virtual PUID getID() const;
+
+        // (duplicate) virtual IAccount::AccountStates getState(
+        //                                                      WORD *outErrorCode = NULL,
+        //                                                      String *outErrorReason = NULL
+        //                                                      ) const;
+
+        virtual String getShutdownBlocker() const;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Account => IAccountAsync
+        #pragma mark
+
+        virtual void onShutdown();
+        virtual void onForceShutdown();
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark Account => ICallTransportDelegate
@@ -576,7 +643,10 @@ namespace openpeer
 
         AutoPUID mID;
         AccountWeakPtr mThisWeak;
+        CoalescedWake mWake;
         AccountPtr mGracefulShutdownReference;
+        bool mForceShutdown;                                          // skip waiting for children once the shutdown deadline has passed
+        String mShutdownBlocker;
 
         IAccount::AccountStates mCurrentState;
         WORD mLastErrorCode;
@@ -650,3 +720,7 @@ namespace openpeer
   }
 }
 
+ZS_DECLARE_PROXY_BEGIN(openpeer::core::internal::IAccountAsync)
+ZS_DECLARE_PROXY_METHOD_0(onShutdown)
+ZS_DECLARE_PROXY_METHOD_0(onForceShutdown)
+ZS_DECLARE_PROXY_END()
@@ -190,6 +190,7 @@ namespace openpeer
 
           AutoPUID mID;
           ContactSubscriptionWeakPtr mThisWeak;
+          CoalescedWake mWake;
           ContactSubscriptionPtr mGracefulShutdownReference;
 
           AccountWeakPtr mOuter;
@@ -150,6 +150,11 @@ namespace openpeer
                                           CallStates state
                                           );
 
+          virtual void onCallMediaQualitySummary(
+                                                 ICallPtr call,
+                                                 ElementPtr summaryEl
+                                                 );
+
         private:
           //-------------------------------------------------------------------
           #pragma mark
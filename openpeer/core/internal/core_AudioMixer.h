@@ -0,0 +1,224 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+
+#pragma once
+
+#include <openpeer/core/internal/types.h>
+#include <openpeer/core/IMediaEngine.h>
+
+#include <voe_external_media.h>
+
+#include <boost/atomic.hpp>
+
+#include <map>
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark AudioMixer
+      #pragma mark
+
+      //-----------------------------------------------------------------------
+      // PURPOSE: mixes the audio of the voice channels taking part in a
+      //          conference hosted by this device
+      // NOTE:    the voice engine already plays out the sum of every started
+      //          channel so the host hears everyone; what the mixer adds is
+      //          the mix-minus sent to each participant (the host microphone
+      //          plus every other participant but never the participant's own
+      //          audio). All processing happens on the voice engine audio
+      //          threads through the per channel external media callbacks so
+      //          the only lock held is the short mixer lock, nothing is
+      //          allocated once a participant is added and nothing is logged
+      //          (frames left out of a mix are counted and reported from the
+      //          media engine lifetime thread by "logStatistics").
+      class AudioMixer : public webrtc::VoEMediaProcess
+      {
+      public:
+        typedef IMediaEngine::ConferenceLevel ConferenceLevel;
+        typedef IMediaEngine::ConferenceLevelList ConferenceLevelList;
+
+        enum Limits
+        {
+          Limit_MaxSamplesPer10ms = 480,      // 48kHz mono
+        };
+
+      public:
+        AudioMixer();
+        ~AudioMixer();
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark AudioMixer => (kernels)
+        #pragma mark
+
+        // mix[i] += samples[i]
+        static void accumulate(
+                               int32_t *mix,
+                               const int16_t *samples,
+                               size_t total
+                               );
+
+        // out[i] = saturated 16 bit value of mix[i]
+        static void saturate(
+                             int16_t *out,
+                             const int32_t *mix,
+                             size_t total
+                             );
+
+        // 0 = silence (-60dBov or below), 100 = full scale
+        static ULONG level(
+                           const int16_t *samples,
+                           size_t total
+                           );
+
+        // linear interpolation of one 10ms frame to another sample count
+        static void resample(
+                             int16_t *out,
+                             size_t outTotal,
+                             const int16_t *samples,
+                             size_t total
+                             );
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark AudioMixer => friend MediaEngine
+        #pragma mark
+
+        void addParticipant(
+                            int channel,
+                            PUID callID
+                            );
+        void removeParticipant(int channel);
+
+        ConferenceLevelList getLevels() const;
+
+        // must not be called from an audio thread
+        void logStatistics();
+
+        ElementPtr toDebug() const;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark AudioMixer => webrtc::VoEMediaProcess
+        #pragma mark
+
+        virtual void Process(
+                             int channel,
+                             webrtc::ProcessingTypes type,
+                             int16_t audio10ms[],
+                             int length,
+                             int samplingFreq,
+                             bool isStereo
+                             );
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark AudioMixer => (internal)
+        #pragma mark
+
+        void receivedFrame(
+                           int channel,
+                           const int16_t *samples,
+                           int length,
+                           int samplingFreq
+                           );
+
+        void mixMinus(
+                      int channel,
+                      int16_t *samples,
+                      int length,
+                      int samplingFreq
+                      );
+
+        Log::Params log(const char *message) const;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark AudioMixer::Participant
+        #pragma mark
+
+        struct Participant
+        {
+          PUID mCallID;
+
+          int16_t mFrame[Limit_MaxSamplesPer10ms];  // last 10ms played out for the participant
+          int mFrameLength;
+          int mFrameFrequency;
+          Time mFrameTime;
+
+          ULONG mLevel;                             // smoothed, see level()
+          ULONG mLouderFrames;                      // consecutive frames louder than the active speaker
+
+          Participant();
+        };
+
+        typedef int ChannelID;
+        typedef std::map<ChannelID, Participant> ParticipantMap;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark AudioMixer => (data)
+        #pragma mark
+
+        PUID mID;
+        mutable Lock mLock;
+
+        ParticipantMap mParticipants;
+        ChannelID mActiveSpeaker;                   // -1 when nobody has spoken yet
+        PUID mActiveSpeakerCallID;
+        ULONG mActiveSpeakerLevel;                  // level when the active speaker took over
+
+        // counted on the audio threads, reported by "logStatistics"
+        boost::atomic<ULONG> mMixedFrames;
+        boost::atomic<ULONG> mResampledFrames;      // participant frames resampled to the recording rate
+        boost::atomic<ULONG> mSkippedFrames;        // stale participant frames left out of a mix
+        boost::atomic<ULONG> mRejectedFrames;       // frames the mixer cannot process (stereo or oversized)
+        boost::atomic<ULONG> mSpeakerChanges;       // times the active speaker changed
+
+        ULONG mReportedSkippedFrames;               // only used by "logStatistics"
+        ULONG mReportedRejectedFrames;
+        ULONG mReportedSpeakerChanges;
+      };
+    }
+  }
+}
@@ -55,6 +55,29 @@ namespace openpeer
       public:
         friend interaction ICache;
 
+        struct PrefixStatistics
+        {
+          ULONG mHits;
+          ULONG mMisses;
+          ULONG mStores;
+          ULONG mClears;
+          ULONG mNoDelegate;
+
+          zsLib::ULONGLONG mBytesFetched;
+          zsLib::ULONGLONG mBytesStored;
+
+          Histogram mFetchLatency;
+          Histogram mStoreLatency;
+          Histogram mClearLatency;
+
+          PrefixStatistics();
+
+          ElementPtr toDebug(const String &prefix) const;
+        };
+
+        typedef String CookiePrefix;
+        typedef std::map<CookiePrefix, PrefixStatistics> PrefixStatisticsMap;
+
       protected:
         Cache();
 
@@ -83,6 +106,11 @@ namespace openpeer
                            );
         virtual void clear(const char *cookieNamePath);
 
+        virtual ElementPtr getStatistics() const;
+        virtual void resetStatistics();
+
+        static ElementPtr toDebug(CachePtr cache);
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark Cache => stack::ICacheDelegate
@@ -105,6 +133,26 @@ namespace openpeer
         Log::Params log(const char *message) const;
         static Log::Params slog(const char *message);
 
+        virtual ElementPtr toDebug() const;
+
+        static CookiePrefix toPrefix(const char *cookieNamePath);
+
+        void recordFetch(
+                         const char *cookieNamePath,
+                         const Time &start,
+                         size_t bytes
+                         ) const;
+        void recordStore(
+                         const char *cookieNamePath,
+                         const Time &start,
+                         size_t bytes
+                         );
+        void recordClear(
+                         const char *cookieNamePath,
+                         const Time &start
+                         );
+        void recordNoDelegate(const char *cookieNamePath) const;
+
       protected:
         //---------------------------------------------------------------------
         #pragma mark
@@ -116,6 +164,10 @@ namespace openpeer
         CacheWeakPtr mThisWeak;
 
         ICacheDelegatePtr mDelegate;
+
+        mutable Lock mStatisticsLock;
+        mutable PrefixStatisticsMap mStatistics;
+        Time mStatisticsSince;
       };
     }
   }
@@ -34,6 +34,7 @@
 #include <openpeer/core/internal/types.h>
 #include <openpeer/core/internal/core_thread.h>
 #include <openpeer/core/internal/core_ConversationThread.h>
+#include <openpeer/core/internal/core_MediaEngine.h>
 #include <openpeer/core/ICall.h>
 
 #include <openpeer/services/IICESocket.h>
@@ -42,6 +43,10 @@
 
 #include <zsLib/Timer.h>
 
+#include <boost/atomic.hpp>
+
+#include <set>
+
 namespace openpeer
 {
   namespace core
@@ -114,6 +119,7 @@ namespace openpeer
         virtual bool hasVideo() const = 0;
 
         virtual void notifyLostFocus() = 0;
+        virtual void notifyTransportSocketsAvailable() = 0;
 
         virtual bool sendRTPPacket(
                                    PUID toLocationID,
@@ -165,6 +171,14 @@ namespace openpeer
         ZS_DECLARE_TYPEDEF_PTR(ICallTransportForCall, UseCallTransport)
         ZS_DECLARE_TYPEDEF_PTR(IContactForCall, UseContact)
         ZS_DECLARE_TYPEDEF_PTR(IConversationThreadForCall, UseConversationThread)
+        ZS_DECLARE_TYPEDEF_PTR(IMediaEngineForCall, UseMediaEngine)
+
+        typedef UseMediaEngine::VoiceCodecInfo VoiceCodecInfo;
+        typedef UseMediaEngine::VoiceCodecInfoList VoiceCodecInfoList;
+        typedef UseMediaEngine::VideoCodecInfo VideoCodecInfo;
+        typedef UseMediaEngine::VideoCodecInfoList VideoCodecInfoList;
+
+        typedef std::set<BYTE> PayloadTypeSet;
 
         struct Exceptions
         {
@@ -259,6 +273,8 @@ namespace openpeer
         virtual Time getAnswerTime() const;
         virtual Time getClosedTime() const;
 
+        virtual ElementPtr getMediaQuality() const;
+
         virtual void ring();
         virtual void answer();
         virtual void hold(bool hold);
@@ -275,6 +291,7 @@ namespace openpeer
         // (duplicate) virtual bool hasVideo() const;
 
         virtual void notifyLostFocus();
+        virtual void notifyTransportSocketsAvailable();
 
         virtual bool sendRTPPacket(
                                    PUID toLocationID,
@@ -308,7 +325,7 @@ namespace openpeer
         #pragma mark Call => IWakeDelegate
         #pragma mark
 
-        virtual void onWake() {step();}
+        virtual void onWake() {mWake.notifyWoken(); step();}
 
         //---------------------------------------------------------------------
         #pragma mark
@@ -432,6 +449,8 @@ namespace openpeer
 
         void setClosedReason(CallClosedReasons reason);
 
+        void setPickedLocation(CallLocationPtr location);
+
         IICESocketSubscriptionPtr findSubscription(
                                                    IICESocketPtr socket,
                                                    bool &outFound,
@@ -502,6 +521,8 @@ namespace openpeer
           CallLocationStates getState() const;
           DialogPtr getRemoteDialog() const;
 
+          const VoiceCodecInfo &getVoiceCodec() const {return mVoiceCodec;}
+
           void updateRemoteDialog(const DialogPtr &remoteDialog);
 
           bool sendRTPPacket(
@@ -574,6 +595,17 @@ namespace openpeer
                                            bool *outIsRTP = NULL
                                            );
 
+          bool demuxBundledPacket(
+                                  const BYTE *buffer,
+                                  size_t bufferLengthInBytes,
+                                  SocketTypes &outType
+                                  );
+          bool demuxBundledRTCPPacket(
+                                      const BYTE *buffer,
+                                      size_t bufferLengthInBytes,
+                                      SocketTypes &outType
+                                      );
+
         private:
           //-------------------------------------------------------------------
           #pragma mark
@@ -600,7 +632,32 @@ namespace openpeer
 
           IICESocketPtr mAudioSocket;
           IICESocketPtr mVideoSocket;
-          
+
+          bool mBundled;                      // audio and video share one ICE socket session (set during init only)
+          VoiceCodecInfo mVoiceCodec;         // negotiated from the remote audio description (set during init only)
+
+          PayloadTypeSet mBundledAudioPayloadTypes;   // payload types negotiated for the bundled audio stream (set during init only)
+          PayloadTypeSet mBundledVideoPayloadTypes;   // payload types negotiated for the bundled video stream (set during init only)
+          DWORD mRemoteAudioSSRC;             // SSRC declared in the remote audio description, 0 if undeclared (set during init only)
+          DWORD mRemoteVideoSSRC;             // SSRC declared in the remote video description, 0 if undeclared (set during init only)
+
+          //-------------------------------------------------------------------
+          // variables accessed from the ICE socket session receive path
+          // (media queue) and read by toDebug
+          boost::atomic<DWORD> mBundledAudioSSRC;     // remote audio SSRC learned from received RTP
+          boost::atomic<DWORD> mBundledVideoSSRC;     // remote video SSRC learned from received RTP
+
+          //-------------------------------------------------------------------
+          // variables written from the media engine send path
+          boost::atomic<DWORD> mLocalAudioSSRC;       // our audio SSRC, matched against RTCP report blocks
+          boost::atomic<DWORD> mLocalVideoSSRC;       // our video SSRC, matched against RTCP report blocks
+
+          //-------------------------------------------------------------------
+          // variables read from the media engine send path (set during init
+          // only and kept alive by the RTP socket session values below)
+          boost::atomic<IICESocketSession *> mAudioSendSession;
+          boost::atomic<IICESocketSession *> mVideoSendSession;
+
           //-------------------------------------------------------------------
           // variables protected with object lock
           DialogPtr mRemoteDialog;
@@ -624,6 +681,7 @@ namespace openpeer
         SharedRecursiveLock mStepLock;
 
         CallWeakPtr mThisWeakNoQueue;
+        CoalescedWake mWake;
         CallPtr mGracefulShutdownReference;
 
         IWakeDelegatePtr mThisWakeDelegate;
@@ -690,8 +748,6 @@ namespace openpeer
         //---------------------------------------------------------------------
         // variables protected with independent locks
 
-        LockedValue<TimerPtr> mMediaCheckTimer;
-
         LockedValue<IICESocketPtr> mAudioSocket;
         LockedValue<IICESocketPtr> mVideoSocket;
 
@@ -702,6 +758,14 @@ namespace openpeer
         LockedValue<CallLocationPtr> mPickedLocation;
         LockedValue<CallLocationPtr> mEarlyLocation;
 
+        //---------------------------------------------------------------------
+        // variables read from the media engine send path without a lock
+
+        boost::atomic<CallLocation *> mSendLocation;  // mirrors "mPickedLocation"
+
+        Lock mSendLocationsLock;
+        CallLocationList mSendLocations;              // every location published in "mSendLocation" (kept alive until the call is destroyed)
+
         LockedValue<bool> mNotifiedCallTransportDestroyed;
       };
 
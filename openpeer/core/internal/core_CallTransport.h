@@ -33,12 +33,20 @@
 
 #include <openpeer/core/internal/types.h>
 #include <openpeer/core/internal/core_MediaEngine.h>
+#include <openpeer/core/internal/core_Helper.h>
 
 #include <openpeer/services/IWakeDelegate.h>
 
 #include <zsLib/MessageQueueAssociator.h>
 #include <zsLib/Timer.h>
 
+#include <boost/atomic.hpp>
+
+#define OPENPEER_CORE_SETTING_CALLTRANSPORT_BUNDLE_MEDIA "openpeer/core/call-bundle-media"    // video shares the audio ICE socket when the remote party agrees
+#define OPENPEER_CORE_SETTING_CALLTRANSPORT_KEEP_SOCKETS_WARM "openpeer/core/call-keep-sockets-warm"   // keep call sockets gathered (and TURN allocated) even while idle
+#define OPENPEER_CORE_SETTING_CALLTRANSPORT_WARM_UP_TIME_IN_SECONDS "openpeer/core/call-warm-up-time-in-seconds"   // how long a warm-up hint keeps idle sockets gathered (0 = ignore hints)
+#define OPENPEER_CORE_SETTING_CALLTRANSPORT_MAX_CONCURRENT_MEDIA_SESSIONS "openpeer/core/call-max-concurrent-media-sessions"   // media sessions for calls without focus (0 = off, only the focused call has media)
+
 namespace openpeer
 {
   namespace core
@@ -127,6 +135,8 @@ namespace openpeer
       {
         ZS_DECLARE_TYPEDEF_PTR(ICallTransportForCall, ForCall)
 
+        typedef IMediaEngineForCall::VoiceCodecInfo VoiceCodecInfo;
+
         enum SocketTypes
         {
           SocketType_Audio,
@@ -140,12 +150,31 @@ namespace openpeer
 
         virtual void focus(
                            CallPtr call,
-                           PUID locationID
+                           PUID locationID,
+                           const VoiceCodecInfo &voiceCodec
                            ) = 0;
         virtual void loseFocus(PUID callID) = 0;
 
+        // NOTE: keeps (muted) voice media flowing for a call that does not
+        //       have focus; focusing the call or detaching ends it
+        virtual void attachMedia(
+                                 CallPtr call,
+                                 PUID locationID,
+                                 const VoiceCodecInfo &voiceCodec
+                                 ) = 0;
+        virtual void detachMedia(PUID callID) = 0;
+
         virtual IICESocketPtr getSocket(SocketTypes type) const = 0;
 
+        // NOTE: the call is woken (once) when the transport's sockets are
+        //       available; returns false if they never will be (shutdown)
+        virtual bool notifyWhenSocketsAvailable(CallPtr call) = 0;
+
+        // NOTE: rolling media quality of the call (NULL if it never had
+        //       media); finalizing ends sampling and returns the summary
+        virtual ElementPtr getMediaQuality(PUID callID) const = 0;
+        virtual ElementPtr finalizeMediaQuality(PUID callID) = 0;
+
         virtual void notifyReceivedRTPPacket(
                                              PUID callID,
                                              PUID locationID,
@@ -155,6 +184,24 @@ namespace openpeer
                                              ) = 0;
       };
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ICallTransportForConversationThread
+      #pragma mark
+
+      interaction ICallTransportForConversationThread
+      {
+        ZS_DECLARE_TYPEDEF_PTR(ICallTransportForConversationThread, ForConversationThread)
+
+        // NOTE: hint that a call is likely to be placed soon; gathers the
+        //       call sockets now so placing the call does not wait on
+        //       STUN/TURN candidate gathering
+        virtual void warmUp() = 0;
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -183,6 +230,7 @@ namespace openpeer
                              public ICallTransport,
                              public ICallTransportForAccount,
                              public ICallTransportForCall,
+                             public ICallTransportForConversationThread,
                              public IWakeDelegate,
                              public ICallTransportAsync,
                              public ITimerDelegate
@@ -192,14 +240,19 @@ namespace openpeer
         friend interaction ICallTransport;
 
         ZS_DECLARE_TYPEDEF_PTR(ICallForCallTransport, UseCall)
+        ZS_DECLARE_TYPEDEF_PTR(IMediaEngineForCallTransport, UseMediaEngine)
 
         ZS_DECLARE_CLASS_PTR(TransportSocket)
+        ZS_DECLARE_CLASS_PTR(MediaSession)
 
         friend class TransportSocket;
+        friend class MediaSession;
 
         typedef ICallTransport::CallTransportStates CallTransportStates;
 
         typedef std::list<TransportSocketPtr> TransportSocketList;
+        typedef std::map<PUID, MediaSessionPtr> MediaSessionMap;
+        typedef std::map<PUID, UseCallWeakPtr> CallWeakMap;
 
       protected:
         CallTransport(
@@ -223,6 +276,7 @@ namespace openpeer
         static CallTransportPtr convert(ICallTransportPtr transport);
         static CallTransportPtr convert(ForAccountPtr transport);
         static CallTransportPtr convert(ForCallPtr transport);
+        static CallTransportPtr convert(ForConversationThreadPtr transport);
 
       protected:
         //---------------------------------------------------------------------
@@ -257,12 +311,25 @@ namespace openpeer
 
         virtual void focus(
                            CallPtr call,
-                           PUID locationID
+                           PUID locationID,
+                           const VoiceCodecInfo &voiceCodec
                            );
         virtual void loseFocus(PUID callID);
 
+        virtual void attachMedia(
+                                 CallPtr call,
+                                 PUID locationID,
+                                 const VoiceCodecInfo &voiceCodec
+                                 );
+        virtual void detachMedia(PUID callID);
+
         virtual IICESocketPtr getSocket(SocketTypes type) const;
 
+        virtual bool notifyWhenSocketsAvailable(CallPtr call);
+
+        virtual ElementPtr getMediaQuality(PUID callID) const;
+        virtual ElementPtr finalizeMediaQuality(PUID callID);
+
         virtual void notifyReceivedRTPPacket(
                                              PUID callID,
                                              PUID locationID,
@@ -271,6 +338,13 @@ namespace openpeer
                                              size_t bufferLengthInBytes
                                              );
 
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark CallTransport => ICallTransportForConversationThread
+        #pragma mark
+
+        virtual void warmUp();
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark CallTransport => ITimerDelegate
@@ -314,12 +388,21 @@ namespace openpeer
         void stop();
 
         void cancel();
+        MediaSessionMap internalCancel();
         void step();
         void setState(CallTransportStates state);
 
+        bool needsSockets() const;
         void fixSockets();
+        void notifySocketWaiters();
+        void refreshWarmSockets();
         bool cleanObsoleteSockets();
 
+        void publishMediaRoute();
+        void reclaimMediaRoutes();
+
+        MediaSessionPtr removeMediaSession(PUID callID);
+
       public:
         //---------------------------------------------------------------------
         //---------------------------------------------------------------------
@@ -344,6 +427,7 @@ namespace openpeer
                     const IICESocket::TURNServerInfoList &turnServers,
                     const IICESocket::STUNServerInfoList &stunServers
                     );
+          void init(TransportSocketPtr sharedSocket);
 
         public:
           ~TransportSocket();
@@ -360,7 +444,14 @@ namespace openpeer
                                            const IICESocket::STUNServerInfoList &stunServers
                                            );
 
+          static TransportSocketPtr createBundled(
+                                                  IMessageQueuePtr queue,
+                                                  CallTransportPtr outer,
+                                                  TransportSocketPtr sharedSocket
+                                                  );
+
           PUID getID() const {return mID;}
+          bool isBundled() const {return (bool)mSharedSocket;}
 
           IICESocketPtr getRTPSocket() const {return mRTPSocket;}
 
@@ -401,13 +492,114 @@ namespace openpeer
           CallTransportWeakPtr mOuter;
 
           IICESocketPtr mRTPSocket;
+          TransportSocketPtr mSharedSocket;   // NOTE: set when bundled, the RTP socket is owned by the shared transport socket (this one only borrows it)
+        };
+
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        //---------------------------------------------------------------------
+        #pragma mark CallTransport::MediaSession
+
+        // PURPOSE: voice media for a call that does not have focus; sends
+        //          directly to its call/location rather than to the focus
+        class MediaSession : public webrtc::Transport
+        {
+        public:
+          friend class CallTransport;
+
+        protected:
+          MediaSession(
+                       UseCallPtr call,
+                       PUID locationID,
+                       UseMediaEnginePtr engine
+                       );
+
+        public:
+          ~MediaSession();
+
+          static ElementPtr toDebug(MediaSessionPtr session);
+
+          //-------------------------------------------------------------------
+          #pragma mark CallTransport::MediaSession => friend CallTransport
+
+          static MediaSessionPtr create(
+                                        UseCallPtr call,
+                                        PUID locationID,
+                                        const VoiceCodecInfo &voiceCodec,
+                                        UseMediaEnginePtr engine
+                                        );
+
+          PUID getCallID() const {return mCallID;}
+          PUID getLocationID() const {return mLocationID;}
+
+          void stop();
+
+          //-------------------------------------------------------------------
+          #pragma mark CallTransport::MediaSession => webrtc::Transport
+
+          virtual int SendPacket(int channel, const void *data, int len);
+          virtual int SendRTCPPacket(int channel, const void *data, int len);
+
+        protected:
+          //-------------------------------------------------------------------
+          #pragma mark CallTransport::MediaSession => (internal)
+
+          Log::Params log(const char *message) const;
+
+          virtual ElementPtr toDebug() const;
+
+        protected:
+          //-------------------------------------------------------------------
+          #pragma mark CallTransport::MediaSession => (data)
+          PUID mID;
+          PUID mCallID;
+          UseCallWeakPtr mCall;
+          PUID mLocationID;
+
+          UseMediaEnginePtr mEngine;
+          UseMediaEngine::VoiceSessionPtr mVoiceSession;   // set once at creation
+          boost::atomic<bool> mStopped;
+        };
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark CallTransport::MediaRoute
+        #pragma mark
+
+        // PURPOSE: immutable copy of the state needed to route RTP/RTCP
+        //          packets between the calls and the media engine (the
+        //          focused call when mCallID is set, plus any attached media
+        //          sessions); published atomically so neither the receive
+        //          nor the send path takes the transport lock
+        struct MediaRoute
+        {
+          PUID mCallID;
+          PUID mLocationID;
+          UseCallWeakPtr mCall;
+          bool mHasAudio;
+          bool mHasVideo;
+          PUID mAudioSocketID;
+          PUID mVideoSocketID;
+          UseMediaEnginePtr mEngine;
+
+          MediaSessionMap mSessions;
+
+          mutable boost::atomic<ULONG> mReaders;   // send/receive path threads currently reading this route
+
+          MediaRoute() : mCallID(0), mLocationID(0), mHasAudio(false), mHasVideo(false), mAudioSocketID(0), mVideoSocketID(0), mReaders(0) {}
         };
 
+        typedef boost::shared_ptr<MediaRoute> MediaRoutePtr;
+        typedef std::list<MediaRoutePtr> MediaRouteList;
+
       protected:
         //-------------------------------------------------------------------
         #pragma mark CallTransport => (data)
         AutoPUID mID;
         CallTransportWeakPtr mThisWeak;
+        CoalescedWake mWake;
         CallTransportPtr mGracefulShutdownReference;
 
         ICallTransportDelegatePtr mDelegate;
@@ -420,13 +612,18 @@ namespace openpeer
         ULONG mTotalCalls;
         TimerPtr mSocketCleanupTimer;
 
+        Time mWarmUntil;                      // idle sockets are kept gathered until this time (from warm-up hints)
+        TimerPtr mWarmRefreshTimer;           // keeps idle sockets (and their TURN allocations) awake
+
         bool mStarted;
         UseCallWeakPtr mFocus;
         PUID mFocusCallID;
         PUID mFocusLocationID;
+        VoiceCodecInfo mFocusVoiceCodec;
         bool mHasAudio;
         bool mHasVideo;
         ULONG mBlockUntilStartStopCompleted;
+        UseMediaEnginePtr mStartedEngine;
 
         TransportSocketPtr mAudioSocket;
         TransportSocketPtr mVideoSocket;
@@ -435,6 +632,16 @@ namespace openpeer
         PUID mVideoSocketID;
 
         TransportSocketList mObsoleteSockets;
+
+        CallWeakMap mSocketWaiters;           // calls to wake once sockets are available
+
+        MediaSessionMap mMediaSessions;
+
+        MediaRoutePtr mCurrentMediaRoute;
+        MediaRouteList mRetiredMediaRoutes;   // each freed once no send/receive path reader is left inside it
+        TimerPtr mReclaimMediaRoutesTimer;    // retries freeing retired routes while readers are active
+        boost::atomic<const MediaRoute *> mMediaRoute;
+        boost::atomic<ULONG> mMediaRouteLoaders;  // readers between loading "mMediaRoute" and counting themselves in it
       };
 
       //-----------------------------------------------------------------------
@@ -34,6 +34,8 @@
 #include <openpeer/core/internal/types.h>
 #include <openpeer/core/IConversationThread.h>
 #include <openpeer/core/internal/core_thread.h>
+#include <openpeer/core/internal/core_Settings.h>
+#include <openpeer/core/internal/core_Helper.h>
 
 #include <openpeer/services/IHelper.h>
 #include <openpeer/services/IWakeDelegate.h>
@@ -56,6 +58,7 @@ namespace openpeer
     {
       interaction IAccountForConversationThread;
       interaction ICallForConversationThread;
+      interaction ICallTransportForConversationThread;
       interaction IContactForConversationThread;
       interaction IConversationThreadHostForConversationThread;
       interaction IConversationThreadSlaveForConversationThread;
@@ -356,7 +359,8 @@ namespace openpeer
                                   public IConversationThreadForHost,
                                   public IConversationThreadForSlave,
                                   public IWakeDelegate,
-                                  public ITimerDelegate
+                                  public ITimerDelegate,
+                                  public ISettingsChangedDelegate
       {
       public:
         friend interaction IConversationThreadFactory;
@@ -365,6 +369,7 @@ namespace openpeer
 
         ZS_DECLARE_TYPEDEF_PTR(IAccountForConversationThread, UseAccount)
         ZS_DECLARE_TYPEDEF_PTR(ICallForConversationThread, UseCall)
+        ZS_DECLARE_TYPEDEF_PTR(ICallTransportForConversationThread, UseCallTransport)
         ZS_DECLARE_TYPEDEF_PTR(IContactForConversationThread, UseContact)
         ZS_DECLARE_TYPEDEF_PTR(IConversationThreadHostForConversationThread, UseConversationThreadHost)
         ZS_DECLARE_TYPEDEF_PTR(IConversationThreadSlaveForConversationThread, UseConversationThreadSlave)
@@ -628,7 +633,7 @@ namespace openpeer
         #pragma mark ConversationThread => IWakeDelegate
         #pragma mark
 
-        virtual void onWake() {step();}
+        virtual void onWake() {mWake.notifyWoken(); step();}
 
         //-----------------------------------------------------------------------
         #pragma mark
@@ -637,6 +642,13 @@ namespace openpeer
 
         virtual void onTimer(TimerPtr timer) {step();}
 
+        //-----------------------------------------------------------------------
+        #pragma mark
+        #pragma mark ConversationThread => ISettingsChangedDelegate
+        #pragma mark
+
+        virtual void onSettingsChanged(SettingsSnapshotPtr snapshot);
+
       protected:
         //-----------------------------------------------------------------------
         #pragma mark
@@ -668,6 +680,7 @@ namespace openpeer
         #pragma mark
 
         ConversationThreadWeakPtr mThisWeak;
+        CoalescedWake mWake;
 
         AutoPUID mID;
         ConversationThreadPtr mGracefulShutdownReference;
@@ -58,6 +58,7 @@ namespace openpeer
         static ElementPtr toDebug(IConversationThreadDocumentFetcherPtr fetcher);
 
         static IConversationThreadDocumentFetcherPtr create(
+                                                            IMessageQueuePtr queue,
                                                             IConversationThreadDocumentFetcherDelegatePtr delegate,
                                                             IPublicationRepositoryPtr repository
                                                             );
@@ -145,6 +146,7 @@ namespace openpeer
         #pragma mark
 
         static ConversationThreadDocumentFetcherPtr create(
+                                                           IMessageQueuePtr queue,
                                                            IConversationThreadDocumentFetcherDelegatePtr delegate,
                                                            IPublicationRepositoryPtr repository
                                                            );
@@ -220,6 +222,7 @@ namespace openpeer
         static IConversationThreadDocumentFetcherFactory &singleton();
 
         virtual ConversationThreadDocumentFetcherPtr create(
+                                                            IMessageQueuePtr queue,
                                                             IConversationThreadDocumentFetcherDelegatePtr delegate,
                                                             IPublicationRepositoryPtr repository
                                                             );
@@ -253,7 +253,7 @@ namespace openpeer
         #pragma mark ConversationThreadHost => IWakeDelegate
         #pragma mark
 
-        virtual void onWake() {step();}
+        virtual void onWake() {mWake.notifyWoken(); step();}
 
       protected:
         //---------------------------------------------------------------------
@@ -339,6 +339,7 @@ namespace openpeer
         #pragma mark
 
         ConversationThreadHostWeakPtr mThisWeak;
+        CoalescedWake mWake;
 
         AutoPUID mID;
         ConversationThreadHostPtr mGracefulShutdownReference;
@@ -375,6 +375,7 @@ namespace openpeer
 
         AutoPUID mID;
         ConversationThreadSlaveWeakPtr mThisWeak;
+        CoalescedWake mWake;
         ConversationThreadSlavePtr mGracefulShutdownReference;
         ConversationThreadSlavePtr mSelfHoldingStartupReferenceUntilPublicationFetchCompletes;
 
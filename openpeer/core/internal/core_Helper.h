@@ -34,6 +34,11 @@
 #include <openpeer/core/internal/types.h>
 #include <openpeer/core/IHelper.h>
 
+#include <openpeer/services/IWakeDelegate.h>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
 namespace openpeer
 {
   namespace core
@@ -80,6 +85,51 @@ namespace openpeer
                             IdentityInfo &outContact
                             );
       };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark CoalescedWake
+      #pragma mark
+
+      // schedules "onWake()" at most once until the object has woken up
+      class CoalescedWake : boost::noncopyable
+      {
+      public:
+        CoalescedWake();
+
+        //---------------------------------------------------------------------
+        // PURPOSE: post "onWake()" unless a wake is already pending
+        // RETURNS: true if a wake was posted, false if it was coalesced
+        bool wake(IWakeDelegatePtr delegate);
+        bool wake(
+                  IMessageQueuePtr queue,
+                  IWakeDelegatePtr delegate
+                  );
+
+        //---------------------------------------------------------------------
+        // PURPOSE: must be called at the start of "onWake()" so any wake
+        //          requested while stepping schedules another pass
+        void notifyWoken();
+
+        ULONG getTotalPosted() const;
+        ULONG getTotalCoalesced() const;
+
+        static ElementPtr toDebugTotals();
+
+      protected:
+        bool post(
+                  IMessageQueuePtr queue,
+                  IWakeDelegatePtr delegate
+                  );
+
+      protected:
+        boost::atomic<bool> mPending;
+        boost::atomic<ULONG> mTotalPosted;
+        boost::atomic<ULONG> mTotalCoalesced;
+      };
     }
   }
 }
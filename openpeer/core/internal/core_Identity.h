@@ -60,7 +60,10 @@ namespace openpeer
 
         static ElementPtr toDebug(ForAccountPtr identity);
 
-        static ForAccountPtr createFromExistingSession(IServiceIdentitySessionPtr session);
+        static ForAccountPtr createFromExistingSession(
+                                                       IMessageQueuePtr queue,
+                                                       IServiceIdentitySessionPtr session
+                                                       );
 
         virtual String getIdentityURI() const = 0;
 
@@ -174,7 +177,10 @@ namespace openpeer
         #pragma mark Identity => IIdentityForAccount
         #pragma mark
 
-        static IdentityPtr createFromExistingSession(IServiceIdentitySessionPtr session);
+        static IdentityPtr createFromExistingSession(
+                                                     IMessageQueuePtr queue,
+                                                     IServiceIdentitySessionPtr session
+                                                     );
 
         // (duplicate) virtual String getIdentityURI() const;
 
@@ -249,7 +255,10 @@ namespace openpeer
                                                            Time identityAccessSecretExpires
                                                            );
 
-        virtual IdentityPtr createFromExistingSession(IServiceIdentitySessionPtr session);
+        virtual IdentityPtr createFromExistingSession(
+                                                      IMessageQueuePtr queue,
+                                                      IServiceIdentitySessionPtr session
+                                                      );
       };
 
     }
@@ -32,6 +32,7 @@
 #pragma once
 
 #include <openpeer/core/internal/types.h>
+#include <openpeer/core/internal/core_TaskPool.h>
 #include <openpeer/core/IIdentityLookup.h>
 
 #include <openpeer/stack/IBootstrappedNetwork.h>
@@ -76,6 +77,7 @@ namespace openpeer
                              public SharedRecursiveLock,
                              public IIdentityLookup,
                              public IBootstrappedNetworkDelegate,
+                             public ITaskPoolTaskDelegate,
                              public IMessageMonitorResultDelegate<IdentityLookupCheckResult>,
                              public IMessageMonitorResultDelegate<IdentityLookupResult>
       {
@@ -109,6 +111,35 @@ namespace openpeer
         typedef PUID MonitorID;
         typedef std::map<MonitorID, IMessageMonitorPtr> MonitorMap;
 
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark IdentityLookup::PrepareIdentitiesTask
+        #pragma mark
+
+        // validates, splits and groups the identity URIs on the task pool
+        class PrepareIdentitiesTask : public ITaskPoolTask
+        {
+        public:
+          PrepareIdentitiesTask(
+                                const IdentityLookupInfoList &identities,
+                                const char *identityServiceDomain
+                                );
+
+          virtual const char *getTaskName() const {return "core::IdentityLookup::PrepareIdentitiesTask";}
+          virtual void run();
+
+        public:
+          IdentityLookupInfoList mIdentities;
+          String mIdentityServiceDomain;
+
+          IdentifierDomainOrLegacyTypeMap mDomainOrLegacyTypeIdentifiers;
+          IdentifierSafeCharDomainLegacyTypeMap mConcatDomains;
+          IdentifierSafeCharDomainLegacyTypeMap mSafeCharDomains;
+          DomainOrLegacyTypeToDomainMap mTypeToDomainMap;
+        };
+
+        typedef boost::shared_ptr<PrepareIdentitiesTask> PrepareIdentitiesTaskPtr;
+
       protected:
         IdentityLookup(
                        IMessageQueuePtr queue,
@@ -166,6 +197,13 @@ namespace openpeer
 
         virtual void onBootstrappedNetworkPreparationCompleted(IBootstrappedNetworkPtr bootstrappedNetwork);
 
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark IdentityLookup => ITaskPoolTaskDelegate
+        #pragma mark
+
+        virtual void onTaskPoolTaskCompleted(ITaskPoolTaskPtr task);
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark Identity => IMessageMonitorResultDelegate<IdentityLookupCheckResult>
@@ -209,12 +247,7 @@ namespace openpeer
 
         virtual ElementPtr toDebug() const;
 
-        void prepareIdentity(
-                             const String &domain,
-                             const String &type,
-                             const String &identifier,
-                             const Time &lastUpdated
-                             );
+        bool prepareBootstrapper(const String &domain);
 
         void step();
 
@@ -244,6 +277,8 @@ namespace openpeer
 
         bool mAlreadyIssuedForProviderDomain;
 
+        bool mPreparing;
+
         BootstrappedNetworkMap mBootstrappedNetworks;
         MonitorMap mMonitors;
 
@@ -0,0 +1,166 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+#pragma once
+
+#include <openpeer/core/internal/types.h>
+
+#include <zsLib/IMessageQueue.h>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark InstrumentedMessageQueue
+      #pragma mark
+
+      // wraps a message queue to measure its depth, the time messages wait
+      // before being dispatched and the time spent in each handler
+      class InstrumentedMessageQueue : public zsLib::IMessageQueue,
+                                       boost::noncopyable
+      {
+      public:
+        struct MethodStats
+        {
+          ULONG mTotal;
+          zsLib::ULONGLONG mSum;      // microseconds
+          ULONG mMax;                 // microseconds
+
+          MethodStats() : mTotal(0), mSum(0), mMax(0) {}
+        };
+
+        typedef std::pair<const char *, const char *> MethodKey;     // delegate and method names are string literals
+        typedef std::map<MethodKey, MethodStats> MethodStatsMap;
+
+        enum Limits
+        {
+          Limit_SlowestMethods = 10,
+        };
+
+        class Message : public IMessageQueueMessage
+        {
+        public:
+          Message(
+                  InstrumentedMessageQueuePtr outer,
+                  IMessageQueueMessagePtr message
+                  );
+
+          virtual const char *getDelegateName() const {return mMessage->getDelegateName();}
+          virtual const char *getMethodName() const {return mMessage->getMethodName();}
+
+          virtual void processMessage();
+
+        protected:
+          InstrumentedMessageQueueWeakPtr mOuter;
+          IMessageQueueMessagePtr mMessage;
+          Time mPosted;
+        };
+
+        friend class Message;
+
+      protected:
+        InstrumentedMessageQueue(
+                                 const char *name,
+                                 IMessageQueuePtr queue
+                                 );
+
+      public:
+        static InstrumentedMessageQueuePtr create(
+                                                  const char *name,
+                                                  IMessageQueuePtr queue
+                                                  );
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark InstrumentedMessageQueue => IMessageQueue
+        #pragma mark
+
+        virtual void post(IMessageQueueMessagePtr message);
+
+        virtual size_type getTotalUnprocessedMessages() const;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark InstrumentedMessageQueue => (for Stack)
+        #pragma mark
+
+        const String &getName() const {return mName;}
+        IMessageQueuePtr getQueue() const {return mQueue;}
+
+        ElementPtr getStatistics(bool resetAfterReading);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark InstrumentedMessageQueue => (internal)
+        #pragma mark
+
+        void notifyProcessed(
+                             const Message &message,
+                             const Time &posted,
+                             const Time &started,
+                             const Time &finished
+                             );
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark InstrumentedMessageQueue => (data)
+        #pragma mark
+
+        AutoPUID mID;
+        InstrumentedMessageQueueWeakPtr mThisWeak;
+
+        String mName;
+        IMessageQueuePtr mQueue;
+
+        boost::atomic<ULONG> mPosted;
+        boost::atomic<ULONG> mProcessed;
+        boost::atomic<ULONG> mMaxDepth;
+
+        mutable Lock mLock;
+        Histogram mWaitTime;          // microseconds between post and dispatch
+        Histogram mHandlerTime;       // microseconds inside the handler
+        MethodStatsMap mMethods;
+      };
+    }
+  }
+}
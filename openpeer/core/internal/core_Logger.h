@@ -34,12 +34,146 @@
 #include <openpeer/core/internal/types.h>
 #include <openpeer/core/ILogger.h>
 
+#include <boost/atomic.hpp>
+
+// Compile time floor for hot path (per packet media and conversation thread
+// parsing) log statements. Levels more detailed than the floor compile to a
+// constant false check and are stripped by the optimizer. Release builds
+// default to a floor of "Debug" (i.e. Trace and Insane are removed).
+#ifndef OPENPEER_CORE_HOT_PATH_LOG_FLOOR
+#ifdef NDEBUG
+#define OPENPEER_CORE_HOT_PATH_LOG_FLOOR Debug
+#else
+#define OPENPEER_CORE_HOT_PATH_LOG_FLOOR Insane
+#endif //NDEBUG
+#endif //OPENPEER_CORE_HOT_PATH_LOG_FLOOR
+
+// Runtime level check (used by the hot path macros below).
+#define OPENPEER_CORE_IS_SUBSYSTEM_LOGGING(xSubsystem, xLevel)                                                        \
+  (((xSubsystem).getOutputLevel()) >= ::zsLib::Log::xLevel)
+
+#define OPENPEER_CORE_IS_HOT_PATH_SUBSYSTEM_LOGGING(xSubsystem, xLevel)                                               \
+  ((::zsLib::Log::xLevel <= ::zsLib::Log::OPENPEER_CORE_HOT_PATH_LOG_FLOOR) &&                                      \
+   (OPENPEER_CORE_IS_SUBSYSTEM_LOGGING(xSubsystem, xLevel)))
+
+// Hot path trace logging. The zsLib macros already skip building the
+// parameters when the runtime level check fails, these additionally compile
+// to nothing when Trace is more detailed than OPENPEER_CORE_HOT_PATH_LOG_FLOOR.
+#define OPENPEER_CORE_LOG_HOT_SUBSYSTEM_TRACE(xSubsystem, xParams)                                                    \
+  {                                                                                                                 \
+    if (OPENPEER_CORE_IS_HOT_PATH_SUBSYSTEM_LOGGING(xSubsystem, Trace)) {                                           \
+      ZS_LOG_SUBSYSTEM_TRACE(xSubsystem, xParams)                                                                   \
+    }                                                                                                               \
+  }
+
+#define OPENPEER_CORE_LOG_HOT_TRACE(xParams)                                                                          \
+  OPENPEER_CORE_LOG_HOT_SUBSYSTEM_TRACE(ZS_GET_SUBSYSTEM(), xParams)
+
+// Rate limited / sampled variants of the zsLib logging macros meant for per
+// packet (or otherwise very hot) log statements. The call site name is used
+// to apply a per call site rule set via "ILogger::setLogCallSiteRateLimit",
+// otherwise the subsystem rule set via "ILogger::setLogRateLimit" applies.
+// The parameters are only evaluated when the log statement is output.
+#define OPENPEER_CORE_LOG_SUBSYSTEM_TRACE_LIMITED(xSubsystem, xCallSiteName, xParams)                                 \
+  {                                                                                                                 \
+    if (OPENPEER_CORE_IS_HOT_PATH_SUBSYSTEM_LOGGING(xSubsystem, Trace)) {                                           \
+      static ::openpeer::core::internal::LogRateLimiter::CallSite sLogCallSite(xCallSiteName);                      \
+      ::zsLib::ULONG logSuppressed = 0;                                                                             \
+      if (::openpeer::core::internal::LogRateLimiter::shouldLog((xSubsystem), sLogCallSite, logSuppressed)) {       \
+        if (0 != logSuppressed) {                                                                                   \
+          ZS_LOG_SUBSYSTEM_TRACE((xSubsystem), (xParams) + ZS_PARAM("suppressed", logSuppressed))                  \
+        } else {                                                                                                    \
+          ZS_LOG_SUBSYSTEM_TRACE((xSubsystem), xParams)                                                             \
+        }                                                                                                           \
+      }                                                                                                             \
+    }                                                                                                               \
+  }
+
+#define OPENPEER_CORE_LOG_SUBSYSTEM_WARNING_LIMITED(xSubsystem, xLevel, xCallSiteName, xParams)                        \
+  {                                                                                                                 \
+    if (OPENPEER_CORE_IS_HOT_PATH_SUBSYSTEM_LOGGING(xSubsystem, xLevel)) {                                          \
+      static ::openpeer::core::internal::LogRateLimiter::CallSite sLogCallSite(xCallSiteName);                      \
+      ::zsLib::ULONG logSuppressed = 0;                                                                             \
+      if (::openpeer::core::internal::LogRateLimiter::shouldLog((xSubsystem), sLogCallSite, logSuppressed)) {       \
+        if (0 != logSuppressed) {                                                                                   \
+          ZS_LOG_SUBSYSTEM_WARNING((xSubsystem), xLevel, (xParams) + ZS_PARAM("suppressed", logSuppressed))        \
+        } else {                                                                                                    \
+          ZS_LOG_SUBSYSTEM_WARNING((xSubsystem), xLevel, xParams)                                                   \
+        }                                                                                                           \
+      }                                                                                                             \
+    }                                                                                                               \
+  }
+
 namespace openpeer
 {
   namespace core
   {
     namespace internal
     {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark LogRateLimiter
+      #pragma mark
+
+      class LogRateLimiter
+      {
+      public:
+        // NOTE: the function local statics created by the logging macros
+        //       rely upon the compiler's thread safe static initialization.
+        //       Every counter is atomic so "shouldLog" only needs to lock
+        //       when the rules changed since the call site last resolved
+        //       them (the counts are approximate under contention).
+        struct CallSite
+        {
+          const char *mName;
+
+          boost::atomic<ULONG> mRulesVersion;     // version of the rules last resolved
+          boost::atomic<ULONG> mMaxPerSecond;
+          boost::atomic<ULONG> mSampleOneInEvery;
+
+          boost::atomic<ULONG> mTotal;
+          boost::atomic<ULONG> mWindowStart;      // seconds
+          boost::atomic<ULONG> mTotalInWindow;
+          boost::atomic<ULONG> mSuppressed;
+
+          CallSite(const char *name);
+        };
+
+        struct Rule
+        {
+          ULONG mMaxPerSecond;
+          ULONG mSampleOneInEvery;
+
+          Rule();
+          Rule(ULONG maxPerSecond, ULONG sampleOneInEvery);
+
+          bool hasData() const;
+        };
+
+        typedef String Name;
+        typedef std::map<Name, Rule> RuleMap;
+
+        static void setSubsystemRule(
+                                     const char *subsystemName,
+                                     const Rule &rule
+                                     );
+        static void setCallSiteRule(
+                                    const char *callSiteName,
+                                    const Rule &rule
+                                    );
+        static void clearRules();
+
+        static bool shouldLog(
+                              const zsLib::Subsystem &subsystem,
+                              CallSite &site,
+                              ULONG &outSuppressed
+                              );
+
+        static ElementPtr toDebug();
+      };
     }
   }
 }
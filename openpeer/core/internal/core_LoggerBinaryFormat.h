@@ -0,0 +1,214 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+
+#pragma once
+
+// NOTE: This header is deliberately free of any zsLib / openpeer
+//       dependencies so that the stand-alone decoder tool
+//       (see openpeer/core/tools/core_BinaryLogDecoder.cpp) can include it.
+//
+// FILE LAYOUT:
+//
+//   header:    magic "OPBLOG02"
+//              varint  base time (microseconds since 1970-01-01 UTC)
+//
+//   records:   byte    record type
+//
+//     'S' (subsystem)  varint subsystem index, string name
+//     'F' (string)     varint string ID, string value
+//     'E' (event)      varint time offset from base time (microseconds)
+//                      varint subsystem index
+//                      byte   (severity << 4) | level
+//                      strref message
+//                      varint function string ID (0 = none)
+//                      varint file path string ID (0 = none)
+//                      varint line number
+//                      strref object name
+//                      group  object values
+//                      group  parameter values
+//
+//   group:     each value, terminated by a name strref of 0:
+//              strref name
+//              byte   value type
+//                     ValueType_Empty    (no payload)
+//                     ValueType_Integer  zig-zag varint
+//                     ValueType_String   string
+//                     ValueType_Group    group
+//
+//   strref:    varint reference
+//                     0                  no string
+//                     (ID << 1) | 1      string previously defined by a 'F' record
+//                     (length + 1) << 1  "length" raw bytes follow inline
+//
+//   string:    varint length, followed by the raw bytes
+//
+// Only call site constants (function names, file paths, messages and value
+// names) are interned and only up to a fixed number of strings, anything
+// else is written inline. String IDs are assigned on first use (starting
+// at 1) and a 'F' record is always written before the first event
+// referencing the ID.
+
+#include <string>
+#include <stdint.h>
+
+#define OPENPEER_CORE_BINARY_LOG_MAGIC "OPBLOG02"
+#define OPENPEER_CORE_BINARY_LOG_MAGIC_LENGTH (8)
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark BinaryLogFormat
+      #pragma mark
+
+      struct BinaryLogFormat
+      {
+        enum RecordTypes
+        {
+          RecordType_Subsystem  = 'S',
+          RecordType_String     = 'F',
+          RecordType_Event      = 'E',
+        };
+
+        enum ValueTypes
+        {
+          ValueType_Empty       = 0,
+          ValueType_Integer     = 1,
+          ValueType_String      = 2,
+          ValueType_Group       = 3,
+        };
+
+        //---------------------------------------------------------------------
+        static void appendVarInt(std::string &buffer, uint64_t value)
+        {
+          while (value >= 0x80) {
+            buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+          }
+          buffer.push_back(static_cast<char>(value));
+        }
+
+        //---------------------------------------------------------------------
+        static void appendSignedVarInt(std::string &buffer, int64_t value)
+        {
+          appendVarInt(buffer, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        //---------------------------------------------------------------------
+        static void appendString(std::string &buffer, const char *str, size_t length)
+        {
+          appendVarInt(buffer, length);
+          if (0 != length) buffer.append(str, length);
+        }
+
+        //---------------------------------------------------------------------
+        static void appendStringRef(std::string &buffer, uint64_t id)
+        {
+          appendVarInt(buffer, (id << 1) | 1);
+        }
+
+        //---------------------------------------------------------------------
+        static void appendInlineStringRef(std::string &buffer, const char *str, size_t length)
+        {
+          appendVarInt(buffer, (static_cast<uint64_t>(length) + 1) << 1);
+          if (0 != length) buffer.append(str, length);
+        }
+
+        //---------------------------------------------------------------------
+        static bool readVarInt(const unsigned char * &ioPos, const unsigned char *end, uint64_t &outValue)
+        {
+          outValue = 0;
+          for (int shift = 0; shift < 64; shift += 7) {
+            if (ioPos >= end) return false;
+            unsigned char value = *ioPos;
+            ++ioPos;
+            outValue |= (static_cast<uint64_t>(value & 0x7F) << shift);
+            if (0 == (value & 0x80)) return true;
+          }
+          return false;
+        }
+
+        //---------------------------------------------------------------------
+        static bool readSignedVarInt(const unsigned char * &ioPos, const unsigned char *end, int64_t &outValue)
+        {
+          uint64_t value = 0;
+          if (!readVarInt(ioPos, end, value)) return false;
+          outValue = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        static bool readString(const unsigned char * &ioPos, const unsigned char *end, std::string &outValue)
+        {
+          uint64_t length = 0;
+          if (!readVarInt(ioPos, end, length)) return false;
+          if (length > static_cast<uint64_t>(end - ioPos)) return false;
+          outValue.assign(reinterpret_cast<const char *>(ioPos), static_cast<size_t>(length));
+          ioPos += length;
+          return true;
+        }
+
+        //---------------------------------------------------------------------
+        // outID is 0 when the string was inline (or there is no string)
+        static bool readStringRef(const unsigned char * &ioPos, const unsigned char *end, uint64_t &outID, std::string &outInline, bool &outHasString)
+        {
+          uint64_t ref = 0;
+          outID = 0;
+          outInline.clear();
+          outHasString = false;
+
+          if (!readVarInt(ioPos, end, ref)) return false;
+          if (0 == ref) return true;
+
+          outHasString = true;
+          if (0 != (ref & 1)) {
+            outID = (ref >> 1);
+            return true;
+          }
+
+          uint64_t length = (ref >> 1) - 1;
+          if (length > static_cast<uint64_t>(end - ioPos)) return false;
+          outInline.assign(reinterpret_cast<const char *>(ioPos), static_cast<size_t>(length));
+          ioPos += length;
+          return true;
+        }
+      };
+    }
+  }
+}
@@ -32,10 +32,14 @@
 #pragma once
 
 #include <openpeer/core/internal/types.h>
+#include <openpeer/core/internal/core_AudioMixer.h>
 #include <openpeer/core/IMediaEngine.h>
 
 #include <zsLib/MessageQueueAssociator.h>
 
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+
 #include <voe_base.h>
 #include <voe_codec.h>
 #include <voe_network.h>
@@ -44,6 +48,7 @@
 #include <voe_volume_control.h>
 #include <voe_hardware.h>
 #include <voe_file.h>
+#include <voe_external_media.h>
 
 #include <vie_base.h>
 #include <vie_network.h>
@@ -52,6 +57,8 @@
 #include <vie_codec.h>
 #include <vie_rtp_rtcp.h>
 
+#define OPENPEER_CORE_SETTING_MEDIA_ENGINE_QUALITY_SAMPLE_INTERVAL_IN_SECONDS "openpeer/core/media-quality-sample-interval-in-seconds"   // 0 = do not sample call media quality
+#define OPENPEER_CORE_SETTING_MEDIA_ENGINE_ADAPT_VOICE_CODEC "openpeer/core/media-adapt-voice-codec"   // adapt voice bitrate, FEC and DTX every few seconds (independent of the quality sample interval)
 
 namespace openpeer
 {
@@ -74,6 +81,68 @@ namespace openpeer
         static void setup(IMediaEngineDelegatePtr delegate);
       };
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IMediaEngineForCall
+      #pragma mark
+
+      interaction IMediaEngineForCall
+      {
+        ZS_DECLARE_TYPEDEF_PTR(IMediaEngineForCall, ForCall)
+
+        struct VoiceCodecInfo
+        {
+          String mName;             // matched case insensitively against the engine's codecs
+          BYTE mPayloadType;        // payload type the receiving party expects
+          DWORD mPTime;             // milliseconds of audio per packet
+          DWORD mClockRate;
+          DWORD mChannels;
+
+          int mMinBitrate;          // bits per second adaptation range
+          int mStartBitrate;
+          int mMaxBitrate;
+
+          int mRedPayloadType;      // RED payload type the receiving party offered, -1 if not offered (FEC stays off)
+
+          VoiceCodecInfo();
+
+          bool hasData() const {return mName.hasData();}
+          bool operator==(const VoiceCodecInfo &rValue) const;
+          bool operator!=(const VoiceCodecInfo &rValue) const;
+
+          ElementPtr toDebug() const;
+        };
+
+        typedef std::list<VoiceCodecInfo> VoiceCodecInfoList;
+
+        // NOTE: voice codecs offered in the call dialog, most preferred
+        //       first; the last entry is the legacy codec every peer
+        //       understands (does not create the engine)
+        static VoiceCodecInfoList getVoiceCodecs();
+
+        // NOTE: redundant audio (RED) offered alongside the voice codecs,
+        //       voice FEC is only enabled when the remote party offered it
+        static VoiceCodecInfo getVoiceRedundancyCodec();
+
+        struct VideoCodecInfo
+        {
+          String mName;
+          BYTE mPayloadType;        // payload type the engine sends and receives with
+          DWORD mClockRate;
+
+          VideoCodecInfo() : mPayloadType(0), mClockRate(0) {}
+        };
+
+        typedef std::list<VideoCodecInfo> VideoCodecInfoList;
+
+        // NOTE: video payloads offered in the call dialog (the video engine
+        //       uses fixed payload types thus these are not negotiated)
+        static VideoCodecInfoList getVideoCodecs();
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -85,15 +154,21 @@ namespace openpeer
       interaction IMediaEngineForCallTransport
       {
         ZS_DECLARE_TYPEDEF_PTR(IMediaEngineForCallTransport, ForCallTransport)
-
-        typedef webrtc::Transport Transport;
+        ZS_DECLARE_STRUCT_PTR(VoiceSession)
+        ZS_DECLARE_TYPEDEF_PTR(webrtc::Transport, Transport)
+        typedef IMediaEngineForCall::VoiceCodecInfo VoiceCodecInfo;
 
         static ForCallTransportPtr singleton();
 
-        virtual void startVoice() = 0;
+        virtual void startVoice(
+                                PUID callID,
+                                const VoiceCodecInfo &codec
+                                ) = 0;
         virtual void stopVoice() = 0;
 
-        virtual int registerVoiceExternalTransport(Transport &transport) = 0;
+        // NOTE: the media engine keeps a reference to a registered transport
+        //       until it was deregistered and every sender left it
+        virtual int registerVoiceExternalTransport(TransportPtr transport) = 0;
         virtual int deregisterVoiceExternalTransport() = 0;
         virtual int receivedVoiceRTPPacket(const void *data, size_t length) = 0;
         virtual int receivedVoiceRTCPPacket(const void *data, size_t length) = 0;
@@ -101,10 +176,33 @@ namespace openpeer
         virtual void startVideoChannel() = 0;
         virtual void stopVideoChannel() = 0;
 
-        virtual int registerVideoExternalTransport(Transport &transport) = 0;
+        virtual int registerVideoExternalTransport(TransportPtr transport) = 0;
         virtual int deregisterVideoExternalTransport() = 0;
         virtual int receivedVideoRTPPacket(const void *data, size_t length) = 0;
         virtual int receivedVideoRTCPPacket(const void *data, size_t length) = 0;
+
+        // NOTE: a voice session is an additional voice channel (besides the
+        //       one controlled by startVoice/stopVoice) that plays out what
+        //       it receives while its microphone input is muted; the session
+        //       keeps a reference to the transport until stopVoiceSession
+        //       was called and every sender left the transport.
+        //       While a conference is enabled the microphone is unmuted and
+        //       the session sends the conference mix instead.
+        virtual VoiceSessionPtr startVoiceSession(
+                                                  TransportPtr transport,
+                                                  PUID callID,
+                                                  const VoiceCodecInfo &codec
+                                                  ) = 0;
+        virtual void stopVoiceSession(VoiceSessionPtr session) = 0;
+        virtual int receivedVoiceSessionRTPPacket(const VoiceSession &session, const void *data, size_t length) = 0;
+        virtual int receivedVoiceSessionRTCPPacket(const VoiceSession &session, const void *data, size_t length) = 0;
+
+        // NOTE: RTCP statistics are sampled on an interval while a call's
+        //       voice channel is started and kept as rolling histograms per
+        //       call; finalizing returns the call's summary and forgets the
+        //       call (NULL if it never had media)
+        virtual ElementPtr getMediaQuality(PUID callID) const = 0;
+        virtual ElementPtr finalizeMediaQuality(PUID callID) = 0;
       };
 
       //-----------------------------------------------------------------------
@@ -128,9 +226,15 @@ namespace openpeer
         friend interaction IMediaEngineFactory;
         friend interaction IMediaEngine;
         friend interaction IMediaEngineForStack;
+        friend interaction IMediaEngineForCall;
         friend interaction IMediaEngineForCallTransport;
 
-        typedef webrtc::Transport Transport;
+        typedef zsLib::ThreadPtr ThreadPtr;
+        typedef IMediaEngineForCall::VoiceCodecInfoList VoiceCodecInfoList;
+        typedef IMediaEngineForCall::VideoCodecInfo VideoCodecInfo;
+        typedef IMediaEngineForCall::VideoCodecInfoList VideoCodecInfoList;
+        typedef IMediaEngineForCallTransport::Transport Transport;
+        typedef IMediaEngineForCallTransport::TransportPtr TransportPtr;
         typedef webrtc::TraceLevel TraceLevel;
         typedef webrtc::VoiceEngine VoiceEngine;
         typedef webrtc::VoEBase VoiceBase;
@@ -141,6 +245,7 @@ namespace openpeer
         typedef webrtc::VoEVolumeControl VoiceVolumeControl;
         typedef webrtc::VoEHardware VoiceHardware;
         typedef webrtc::VoEFile VoiceFile;
+        typedef webrtc::VoEExternalMedia VoiceExternalMedia;
         typedef webrtc::OutputAudioRoute OutputAudioRoute;
         typedef webrtc::EcModes EcModes;
         typedef webrtc::VideoCaptureModule VideoCaptureModule;
@@ -152,6 +257,77 @@ namespace openpeer
         typedef webrtc::ViERTP_RTCP VideoRtpRtcp;
         typedef webrtc::ViECodec VideoCodec;
 
+        typedef std::map<PUID, VoiceSessionPtr> VoiceSessionMap;
+        typedef std::list<VoiceSessionPtr> VoiceSessionList;
+
+        typedef int ChannelID;
+        typedef std::map<ChannelID, PUID> ConferenceChannelMap;    // channel -> call
+
+        struct MediaQualityHistograms
+        {
+          ULONG mSamples;
+
+          Histogram mJitter;            // RTP timestamp units
+          Histogram mRtt;               // milliseconds
+          Histogram mLoss;              // per mille of packets lost since the previous report (one entry per new report)
+          Histogram mSendBitrate;       // kbps
+          Histogram mReceiveBitrate;    // kbps
+
+          MediaQualityHistograms() : mSamples(0) {}
+
+          void reset();
+
+          ElementPtr toDebug(const char *name) const;
+        };
+
+        struct MediaQualityStatistics
+        {
+          MediaQualityHistograms mTotal;        // whole call
+          MediaQualityHistograms mWindow;       // current window (reset every OPENPEER_MEDIA_ENGINE_QUALITY_WINDOW_SAMPLES samples)
+          MediaQualityHistograms mLastWindow;   // most recently completed window
+
+          Time mLastSampled;
+          RtpRtcpStatistics mLast;      // counters at "mLastSampled" (for bitrates)
+
+          MediaQualityStatistics();
+
+          void record(
+                      const RtpRtcpStatistics &stat,
+                      Time when,
+                      Duration maxGap
+                      );
+
+          ElementPtr toDebug(const char *name) const;
+        };
+
+        struct CallMediaQuality
+        {
+          PUID mCallID;
+          Time mStarted;
+
+          MediaQualityStatistics mVoice;
+          MediaQualityStatistics mVideo;
+
+          CallMediaQuality() : mCallID(0) {}
+
+          ElementPtr toDebug() const;
+        };
+
+        typedef std::map<PUID, CallMediaQuality> CallMediaQualityMap;
+
+        struct MediaQualitySample
+        {
+          PUID mCallID;
+          bool mHasVoice;
+          bool mHasVideo;
+          RtpRtcpStatistics mVoice;
+          RtpRtcpStatistics mVideo;
+
+          MediaQualitySample() : mCallID(0), mHasVoice(false), mHasVideo(false) {}
+        };
+
+        typedef std::list<MediaQualitySample> MediaQualitySampleList;
+
       protected:
 
         MediaEngine(
@@ -165,6 +341,7 @@ namespace openpeer
 
         static MediaEnginePtr create(IMediaEngineDelegatePtr delegate);
         
+        bool createMediaEngine();
         void destroyMediaEngine();
         virtual void setLogLevel();
 
@@ -237,6 +414,11 @@ namespace openpeer
         virtual int getVoiceTransportStatistics(RtpRtcpStatistics &stat);
 
         virtual void pauseVoice(bool pause = true);
+
+        virtual void setConferenceEnabled(bool enabled);
+        virtual bool getConferenceEnabled();
+        virtual ConferenceLevelList getConferenceLevels();
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark MediaEngine => IMediaEngineForStack
@@ -244,27 +426,51 @@ namespace openpeer
 
         static void setup(IMediaEngineDelegatePtr delegate);
 
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark MediaEngine => IMediaEngineForCall
+        #pragma mark
+
+        static VoiceCodecInfoList getVoiceCodecs();
+        static VoiceCodecInfo getVoiceRedundancyCodec();
+        static VideoCodecInfoList getVideoCodecs();
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark MediaEngine => IMediaEngineForCallTransport
         #pragma mark
 
-        virtual void startVoice();
+        virtual void startVoice(
+                                PUID callID,
+                                const VoiceCodecInfo &codec
+                                );
         virtual void stopVoice();
         
         virtual void startVideoChannel();
         virtual void stopVideoChannel();
 
-        virtual int registerVoiceExternalTransport(Transport &transport);
+        virtual int registerVoiceExternalTransport(TransportPtr transport);
         virtual int deregisterVoiceExternalTransport();
         virtual int receivedVoiceRTPPacket(const void *data, size_t length);
         virtual int receivedVoiceRTCPPacket(const void *data, size_t length);
 
-        virtual int registerVideoExternalTransport(Transport &transport);
+        virtual int registerVideoExternalTransport(TransportPtr transport);
         virtual int deregisterVideoExternalTransport();
         virtual int receivedVideoRTPPacket(const void *data, size_t length);
         virtual int receivedVideoRTCPPacket(const void *data, size_t length);
 
+        virtual VoiceSessionPtr startVoiceSession(
+                                                  TransportPtr transport,
+                                                  PUID callID,
+                                                  const VoiceCodecInfo &codec
+                                                  );
+        virtual void stopVoiceSession(VoiceSessionPtr session);
+        virtual int receivedVoiceSessionRTPPacket(const VoiceSession &session, const void *data, size_t length);
+        virtual int receivedVoiceSessionRTCPPacket(const VoiceSession &session, const void *data, size_t length);
+
+        virtual ElementPtr getMediaQuality(PUID callID) const;
+        virtual ElementPtr finalizeMediaQuality(PUID callID);
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark MediaEngine => TraceCallback
@@ -301,13 +507,38 @@ namespace openpeer
         void operator()();
 
       protected:
-        
+        void notifyLifetimeWork();
+        void releaseLifetimeInProgress();
+        bool internalLifetimeStep();
+        bool internalReclaimTransports();
+        void internalAdaptMediaQuality();
+        void internalSampleMediaQuality(Duration interval);
+
+        void waitForReceiveReaders(
+                                   boost::atomic<ULONG> &readers,
+                                   const char *channelType
+                                   );
+
         virtual void internalStartVoice();
         virtual void internalStopVoice();
         
         virtual int registerVoiceTransport();
         virtual int deregisterVoiceTransport();
         virtual int setVoiceTransportParameters();
+        virtual int setVoiceSendCodec(
+                                      int channel,
+                                      const VoiceCodecInfo &codec,
+                                      int bitrate
+                                      );
+        virtual int registerVoiceReceiveCodecs(int channel);
+        virtual void internalAdaptVoiceCodec(const RtpRtcpStatistics &stat);
+        virtual bool internalGetVoiceRemoteFractionLost(unsigned short &outFractionLost);
+
+        virtual bool internalStartVoiceSession(VoiceSessionPtr session);
+        virtual void internalStopVoiceSession(VoiceSessionPtr session);
+
+        virtual void internalUpdateConference();
+        virtual void internalRemoveConferenceChannel(int channel);
 
         virtual CaptureCapabilityList internalGetCaptureCapabilities(CameraTypes cameraType);
         virtual void internalSetVideoOrientation();
@@ -321,6 +552,10 @@ namespace openpeer
         virtual OutputAudioRoutes internalGetOutputAudioRoute();
         virtual int internalGetVideoTransportStatistics(RtpRtcpStatistics &stat);
         virtual int internalGetVoiceTransportStatistics(RtpRtcpStatistics &stat);
+        int internalGetVoiceChannelStatistics(
+                                              int channel,
+                                              RtpRtcpStatistics &stat
+                                              );
         virtual void internalStartCaptureRenderer();
         virtual void internalStopCaptureRenderer();
         virtual void internalStartVideoCapture();
@@ -347,7 +582,7 @@ namespace openpeer
         Log::Params log(const char *message) const;
         static Log::Params slog(const char *message);
 
-      protected:
+      public:
         //---------------------------------------------------------------------
         //---------------------------------------------------------------------
         //---------------------------------------------------------------------
@@ -359,6 +594,8 @@ namespace openpeer
         class RedirectTransport : public Transport
         {
         public:
+          typedef std::list<TransportPtr> TransportList;
+
           RedirectTransport(const char *transportType);
 
           //-------------------------------------------------------------------
@@ -374,7 +611,9 @@ namespace openpeer
           #pragma mark MediaEngine::RedirectTransport => friend MediaEngine
           #pragma mark
 
-          void redirect(Transport *transport);
+          bool redirect(TransportPtr transport);
+          bool reclaim();
+          void armFirstPacket(Time requested);
 
         protected:
           //-------------------------------------------------------------------
@@ -386,11 +625,21 @@ namespace openpeer
 
         private:
           PUID mID;
-          mutable RecursiveLock mLock;
 
           const char *mTransportType;
 
-          Transport *mTransport;
+          boost::atomic<Transport *> mTransport;
+          boost::atomic<ULONG> mSending;   // senders currently inside the redirected transport
+
+          Lock mRetiredLock;
+          TransportPtr mCurrent;           // keeps "mTransport" alive
+          TransportList mRetired;          // previous transports kept alive until no sender is left inside them
+
+          boost::atomic<bool> mFirstPacketPending;  // set when started, cleared by the first RTP packet sent
+          Time mFirstPacketRequested;               // published by "mFirstPacketPending"
+
+          Lock mFirstPacketLock;
+          Histogram mFirstPacketLatency;            // milliseconds from start requested until first RTP packet
         };
 
       protected:
@@ -432,9 +681,12 @@ namespace openpeer
         float mChannelRenderViewCropBottom;
         bool mContinuousVideoCapture;
 
+        bool mMediaEngineCreated;         // voice/video engines are created on first start rather than in init()
+        bool mMediaEngineAvailable;
+
         int mVoiceChannel;
         Transport *mVoiceTransport;
-        Transport *mVoiceExternalTransport;
+        TransportPtr mVoiceExternalTransport;
         VoiceEngine *mVoiceEngine;
         VoiceBase *mVoiceBase;
         VoiceCodec *mVoiceCodec;
@@ -444,11 +696,24 @@ namespace openpeer
         VoiceVolumeControl *mVoiceVolumeControl;
         VoiceHardware *mVoiceHardware;
         VoiceFile *mVoiceFile;
-        bool mVoiceEngineReady;
+        VoiceExternalMedia *mVoiceExternalMedia;
+        boost::atomic<int> mVoiceReceiveChannel;   // valid only while voice is started, read lock-free by the receive path
+        boost::atomic<ULONG> mVoiceReceiveReaders; // receive path threads currently inside the voice channel
+        PUID mVoiceCallID;                         // call the primary voice channel belongs to
+        VoiceCodecInfo mVoiceCodecInfo;            // codec negotiated for the primary voice channel
+        int mVoiceSendBitrate;                     // adapted from RTCP feedback within the codec's range
+        bool mVoiceFECEnabled;
+        bool mVoiceDTXEnabled;
+        ULONG mVoiceHealthySamples;                // consecutive samples without congestion
+        VoiceSessionMap mVoiceSessions;            // started additional voice sessions
+
+        bool mConferenceEnabled;
+        AudioMixer mAudioMixer;
+        ConferenceChannelMap mConferenceChannels;  // channels currently processed by the mixer
 
         int mVideoChannel;
         Transport *mVideoTransport;
-        Transport *mVideoExternalTransport;
+        TransportPtr mVideoExternalTransport;
         int mCaptureId;
         char mDeviceUniqueId[512];
         VideoCaptureModule *mVcpm;
@@ -459,10 +724,12 @@ namespace openpeer
         VideoCapture *mVideoCapture;
         VideoRtpRtcp *mVideoRtpRtcp;
         VideoCodec *mVideoCodec;
-        bool mVideoEngineReady;
+        boost::atomic<int> mVideoReceiveChannel;   // valid only while the video channel is started
+        boost::atomic<ULONG> mVideoReceiveReaders; // receive path threads currently inside the video channel
 
         RedirectTransport mRedirectVoiceTransport;
         RedirectTransport mRedirectVideoTransport;
+        VoiceSessionList mRetiredVoiceSessions;    // stopped voice sessions whose transport still has senders inside (lifetime thread only)
 
         // lifetime start / stop state
         mutable RecursiveLock mLifetimeLock;
@@ -478,7 +745,23 @@ namespace openpeer
         bool mLifetimeHasRecordVideoCapture;
 
         bool mLifetimeInProgress;
-        
+        bool mLifetimeWorkDeferred;                 // worker found a getter in progress, re-run once released
+
+        Time mLifetimeVoiceStartRequested;
+        Time mLifetimeVideoStartRequested;
+
+        // lifetime worker, woken whenever the "want" state changes
+        boost::mutex mLifetimeWorkMutex;
+        boost::condition_variable mLifetimeWorkCondition;
+        bool mLifetimeWorkPending;
+        bool mLifetimeWorkShutdown;
+        bool mLifetimeWorkSampling;                 // a call's voice channel is started thus sample its quality and adapt its voice codec
+        ThreadPtr mLifetimeThread;
+
+        mutable Lock mQualityLock;
+        CallMediaQualityMap mCallQuality;
+
+
         bool mLifetimeWantEcEnabled;
         bool mLifetimeWantAgcEnabled;
         bool mLifetimeWantNsEnabled;
@@ -510,10 +793,38 @@ namespace openpeer
         bool mLifetimeWantSaveVideoToLibrary;
         RtpRtcpStatistics mLifetimeVideoTransportStatistics;
         RtpRtcpStatistics mLifetimeVoiceTransportStatistics;
-        Transport *mLifetimeWantVoiceExternalTransport;
-        Transport *mLifetimeWantVideoExternalTransport;
+        TransportPtr mLifetimeWantVoiceExternalTransport;
+        TransportPtr mLifetimeWantVideoExternalTransport;
+        VoiceSessionMap mLifetimeWantVoiceSessions;
+        PUID mLifetimeWantVoiceCallID;
+        VoiceCodecInfo mLifetimeWantVoiceCodec;
+        bool mLifetimeWantConferenceEnabled;
+      };
 
-        mutable RecursiveLock mMediaEngineReadyLock;
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IMediaEngineForCallTransport::VoiceSession
+      #pragma mark
+
+      struct IMediaEngineForCallTransport::VoiceSession
+      {
+        PUID mID;
+        PUID mCallID;
+        VoiceCodecInfo mCodec;
+        MediaEngine::RedirectTransport mTransport;
+        boost::atomic<int> mChannel;              // valid only while started, read lock-free by the receive path
+        mutable boost::atomic<ULONG> mReceiveReaders; // receive path threads currently inside "mChannel"
+
+        VoiceSession(
+                     TransportPtr transport,
+                     PUID callID,
+                     const VoiceCodecInfo &codec
+                     );
+
+        ElementPtr toDebug() const;
       };
 
       //-----------------------------------------------------------------------
@@ -36,12 +36,99 @@
 
 #include <openpeer/stack/ISettings.h>
 
+#include <boost/atomic.hpp>
+
 namespace openpeer
 {
   namespace core
   {
     namespace internal
     {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark SettingsSnapshot
+      #pragma mark
+
+      // Immutable typed copy of the settings read by the core. A new
+      // snapshot is built whenever a setting is set, cleared or applied.
+      class SettingsSnapshot
+      {
+      public:
+        SettingsSnapshot();
+
+        bool operator==(const SettingsSnapshot &rValue) const;
+        bool operator!=(const SettingsSnapshot &rValue) const;
+
+        ElementPtr toDebug() const;
+
+      public:
+        ULONG mVersion;
+
+        ULONG mAccountBackgroundingPhase;
+
+        ULONG mConversationThreadHostBackgroundingPhase;
+        Duration mConversationThreadHostInactiveCloseTime;
+        ULONG mConversationThreadHostPeerContactAutoFindInSeconds;
+
+        bool mCallTransportBundleMedia;
+        bool mCallTransportKeepSocketsWarm;
+        Duration mCallTransportWarmUpTime;
+        ULONG mCallTransportMaxConcurrentMediaSessions;
+
+        Duration mMediaEngineQualitySampleInterval;
+        bool mMediaEngineAdaptVoiceCodec;
+
+        Duration mThreadMoveMessageToCacheTime;
+
+        String mStackCoreThreadPriority;
+        String mStackMediaThreadPriority;
+        String mStackAuthorizedApplicationIDSplitChar;
+        Duration mStackQueueStatisticsLogInterval;
+        Duration mStackShutdownDeadline;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ISettingsChangedDelegate
+      #pragma mark
+
+      interaction ISettingsChangedDelegate
+      {
+        virtual void onSettingsChanged(SettingsSnapshotPtr snapshot) = 0;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ISettingsForInternal
+      #pragma mark
+
+      interaction ISettingsForInternal
+      {
+        // NOTE: never takes the settings lock (boost's shared_ptr atomics
+        //       briefly hold a pooled spinlock); a snapshot is freed once
+        //       the last reference to a retired snapshot is released
+        static SettingsSnapshotPtr snapshot();
+
+        // NOTE: the delegate is notified asynchronously on the queue it is
+        //       associated with (or "queue" when the delegate is not a
+        //       message queue associator) when any value within the
+        //       snapshot changes
+        static void subscribeChanges(
+                                     ISettingsChangedDelegatePtr delegate,
+                                     IMessageQueuePtr queue = IMessageQueuePtr()
+                                     );
+        static void unsubscribeChanges(ISettingsChangedDelegatePtr delegate);
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -68,6 +155,74 @@ namespace openpeer
         static Duration getThreadMoveMessageToCacheTimeInSeconds();
       };
 
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark SettingsFileWatcher
+      #pragma mark
+
+      // Applies a JSON settings file and re-applies the differences whenever
+      // the file changes (inotify on Linux, modification time polling
+      // elsewhere). Keys removed from the file are restored to their core
+      // default when one exists, otherwise they are cleared.
+      class SettingsFileWatcher
+      {
+      public:
+        typedef String Key;
+        typedef String EncodedValue;
+        typedef std::map<Key, EncodedValue> ValueMap;
+        typedef zsLib::ThreadPtr ThreadPtr;
+
+        enum Timeouts
+        {
+          Milliseconds_PollInterval = 1000,
+        };
+
+      protected:
+        SettingsFileWatcher(const char *fileName);
+
+      public:
+        ~SettingsFileWatcher();
+
+        static SettingsFileWatcherPtr create(const char *fileName);
+
+        void cancel();
+
+        void operator()();
+
+      protected:
+        Log::Params log(const char *message) const;
+
+        bool startWatching();
+        bool waitForChange();
+
+        bool reload();
+        bool readFile(String &outContents) const;
+        static bool parse(
+                          const String &contents,
+                          String &outRootName,
+                          ValueMap &outValues
+                          );
+
+      protected:
+        AutoPUID mID;
+
+        String mFileName;
+        String mDirectory;
+        String mBaseName;
+
+        ValueMap mApplied;
+
+        ThreadPtr mThread;
+        boost::atomic<bool> mShouldShutdown;
+
+        int mNotifyFD;
+        int mWatchFD;
+        time_t mLastModified;
+      };
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -82,8 +237,28 @@ namespace openpeer
       {
       public:
         friend interaction ISettings;
+        friend interaction ISettingsForInternal;
         friend interaction ISettingsForStack;
         friend interaction ISettingsForThread;
+        friend class SettingsFileWatcher;
+
+        enum DefaultValueTypes
+        {
+          DefaultValueType_String,
+          DefaultValueType_UInt,
+          DefaultValueType_Bool,
+        };
+
+        struct DefaultValue
+        {
+          const char *mKey;
+          DefaultValueTypes mType;
+          const char *mString;
+          ULONG mUInt;                    // also used for bool values
+        };
+
+        typedef ISettingsChangedDelegate *ChangedDelegateRawPtr;
+        typedef std::map<ChangedDelegateRawPtr, ISettingsChangedDelegatePtr> ChangedDelegateMap;
 
       protected:
         Settings();
@@ -107,6 +282,22 @@ namespace openpeer
 
         virtual void applyDefaults();
 
+        bool watchFile(const char *jsonFileName);
+        void unwatchFile();
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Settings => ISettingsForInternal
+        #pragma mark
+
+        SettingsSnapshotPtr snapshot();
+
+        void subscribeChanges(
+                              ISettingsChangedDelegatePtr delegate,
+                              IMessageQueuePtr queue
+                              );
+        void unsubscribeChanges(ISettingsChangedDelegatePtr delegate);
+
         //---------------------------------------------------------------------
         #pragma mark
         #pragma mark Settings => ISettingsForStack
@@ -169,6 +360,13 @@ namespace openpeer
         Log::Params log(const char *message) const;
         static Log::Params slog(const char *message);
 
+        void notifySettingsChanged();
+        SettingsSnapshotPtr rebuildSnapshot();
+
+        static const DefaultValue *defaultValues();
+        void applyDefault(const DefaultValue &value);
+        bool restoreDefault(const char *key);
+
       protected:
         //---------------------------------------------------------------------
         #pragma mark
@@ -183,8 +381,19 @@ namespace openpeer
 
         AutoBool mAppliedDefaults;
 
-        Duration mThreadMoveMessageToCacheTimeInSeconds;
+        SettingsFileWatcherPtr mFileWatcher;
+
+        mutable RecursiveLock mSnapshotLock;
+        SettingsSnapshotPtr mSnapshot;    // only accessed with boost::atomic_load/atomic_store (spinlock pool, not lock-free)
+        ULONG mSnapshotVersion;
+
+        ChangedDelegateMap mChangedDelegates;
       };
     }
   }
 }
+
+ZS_DECLARE_PROXY_BEGIN(openpeer::core::internal::ISettingsChangedDelegate)
+ZS_DECLARE_PROXY_TYPEDEF(openpeer::core::internal::SettingsSnapshotPtr, SettingsSnapshotPtr)
+ZS_DECLARE_PROXY_METHOD_1(onSettingsChanged, SettingsSnapshotPtr)
+ZS_DECLARE_PROXY_END()
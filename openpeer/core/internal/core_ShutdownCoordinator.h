@@ -0,0 +1,184 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+
+#pragma once
+
+#include <openpeer/core/internal/types.h>
+#include <openpeer/core/internal/core_Account.h>
+
+#include <zsLib/MessageQueueAssociator.h>
+#include <zsLib/Timer.h>
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark IShutdownCoordinatorDelegate
+      #pragma mark
+
+      interaction IShutdownCoordinatorDelegate
+      {
+        virtual void onShutdownCoordinatorCompleted() = 0;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ShutdownCoordinator
+      #pragma mark
+
+      // Tracks every live account so the stack shutdown can ask all of them
+      // to shutdown at once (each on its own queue) rather than waiting on
+      // the application to shut them down one at a time. Accounts still
+      // alive when the deadline expires are forced to shutdown without
+      // waiting on their children and are reported as holdouts. Accounts
+      // that still have not reported shortly after being forced are
+      // abandoned so the shutdown always completes.
+      class ShutdownCoordinator : public MessageQueueAssociator,
+                                  public ITimerDelegate
+      {
+      public:
+        ZS_DECLARE_TYPEDEF_PTR(IAccountForShutdownCoordinator, UseAccount)
+
+        struct Participant
+        {
+          UseAccountWeakPtr mAccount;
+          IAccountAsyncPtr mAsync;
+          bool mForced;
+
+          Participant() : mForced(false) {}
+        };
+
+        typedef PUID AccountID;
+        typedef std::map<AccountID, Participant> ParticipantMap;
+
+        struct Holdout
+        {
+          AccountID mAccountID;
+          String mState;
+          String mBlocker;
+        };
+
+        typedef std::list<Holdout> HoldoutList;
+
+      protected:
+        ShutdownCoordinator(IMessageQueuePtr queue);
+
+      public:
+        ~ShutdownCoordinator();
+
+        static ShutdownCoordinatorPtr create(IMessageQueuePtr queue);
+
+        //---------------------------------------------------------------------
+        // PURPOSE: tracks the account until it reports its shutdown
+        // NOTE:    if the shutdown was already started the account is told
+        //          to shutdown immediately
+        void registerAccount(AccountPtr account);
+
+        void notifyAccountShutdown(AccountID accountID);
+
+        //---------------------------------------------------------------------
+        // PURPOSE: fans out the shutdown to all live accounts
+        // NOTE:    the delegate is notified once all accounts are shutdown
+        //          (or were forced to shutdown and then abandoned when they
+        //          never reported back); a zero deadline disables forced
+        //          shutdown
+        void start(
+                   IShutdownCoordinatorDelegatePtr delegate,
+                   Duration deadline
+                   );
+
+        bool isComplete() const;
+
+        void cancel();
+
+        ElementPtr toDebug() const;
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark ShutdownCoordinator => ITimerDelegate
+        #pragma mark
+
+        virtual void onTimer(TimerPtr timer);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark ShutdownCoordinator => (internal)
+        #pragma mark
+
+        Log::Params log(const char *message) const;
+
+        void checkComplete();
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark ShutdownCoordinator => (data)
+        #pragma mark
+
+        mutable RecursiveLock mLock;
+        AutoPUID mID;
+        ShutdownCoordinatorWeakPtr mThisWeak;
+
+        IShutdownCoordinatorDelegatePtr mDelegate;
+
+        ParticipantMap mParticipants;
+
+        bool mStarted;
+        bool mCompleted;
+        bool mForcing;                    // the deadline expired; the next expiry abandons the remaining accounts
+        Time mStartTime;
+        Time mCompletedTime;
+        Duration mDeadline;
+        TimerPtr mDeadlineTimer;
+
+        ULONG mTotalParticipants;
+        ULONG mTotalForced;
+        HoldoutList mHoldouts;
+      };
+    }
+  }
+}
+
+ZS_DECLARE_PROXY_BEGIN(openpeer::core::internal::IShutdownCoordinatorDelegate)
+ZS_DECLARE_PROXY_METHOD_0(onShutdownCoordinatorCompleted)
+ZS_DECLARE_PROXY_END()
@@ -33,9 +33,14 @@
 
 #include <openpeer/core/IStack.h>
 #include <openpeer/core/internal/types.h>
+#include <openpeer/core/internal/core_Settings.h>
+#include <openpeer/core/internal/core_InstrumentedMessageQueue.h>
 
 #define OPENPEER_CORE_SETTING_STACK_CORE_THREAD_PRIORITY "openpeer/core/core-thread-priority"
 #define OPENPEER_CORE_SETTING_STACK_MEDIA_THREAD_PRIORITY "openpeer/core/media-thread-priority"
+#define OPENPEER_CORE_SETTING_STACK_CORE_THREAD_SHARDS "openpeer/core/core-thread-shards"   // total core queues (read during setup)
+#define OPENPEER_CORE_SETTING_STACK_QUEUE_STATISTICS_LOG_INTERVAL_IN_SECONDS "openpeer/core/queue-statistics-log-interval-in-seconds"  // 0 = disabled
+#define OPENPEER_CORE_SETTING_STACK_SHUTDOWN_DEADLINE_IN_SECONDS "openpeer/core/shutdown-deadline-in-seconds"   // 0 = wait forever for accounts to shutdown gracefully
 
 #define OPENPEER_CORE_SETTING_STACK_AUTHORIZED_APPLICATION_ID_SPLIT_CHAR "openpeer/core/authorized-application-id-split-char"
 
@@ -46,6 +51,8 @@ namespace openpeer
   {
     namespace internal
     {
+      ZS_DECLARE_CLASS_PTR(StackQueueStatisticsLogger)
+
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
       //-----------------------------------------------------------------------
@@ -76,10 +83,14 @@ namespace openpeer
 
         static IMessageQueuePtr queueApplication();
         static IMessageQueuePtr queueCore();
+        static IMessageQueuePtr queueCore(const char *shardKey);  // same key always maps to the same core queue
         static IMessageQueuePtr queueMedia();
         static IMessageQueuePtr queueServices();
         static IMessageQueuePtr queueKeyGeneration();
 
+        static TaskPoolPtr taskPool();      // NULL when not setup or after final shutdown
+        static ShutdownCoordinatorPtr shutdownCoordinator();  // NULL when not setup or after final shutdown
+
         static IMediaEngineDelegatePtr        mediaEngineDelegate();
         static IConversationThreadDelegatePtr conversationThreadDelegate();
         static ICallDelegatePtr               callDelegate();
@@ -98,7 +109,8 @@ namespace openpeer
       class Stack : public IStack,
                     public IStackForInternal,
                     public IStackShutdownCheckAgain,
-                    public IStackMessageQueue
+                    public IStackMessageQueue,
+                    public ISettingsChangedDelegate
       {
       public:
         friend interaction IStack;
@@ -106,6 +118,9 @@ namespace openpeer
         friend interaction IStackForInternal;
         friend interaction IStackShutdownCheckAgain;
 
+        typedef std::vector<IMessageQueuePtr> QueueList;
+        typedef std::list<InstrumentedMessageQueuePtr> InstrumentedQueueList;
+
       protected:
         Stack();
 
@@ -127,6 +142,8 @@ namespace openpeer
 
         virtual void shutdown();
 
+        virtual ElementPtr getMessageQueueStatistics(bool resetAfterReading = false);
+
         static String createAuthorizedApplicationID(
                                                     const char *applicationID,
                                                     const char *applicationIDSharedSecret,
@@ -152,7 +169,17 @@ namespace openpeer
 
         virtual void interceptProcessing(IStackMessageQueueDelegatePtr delegate);
 
-        virtual void notifyProcessMessageFromCustomThread();
+        virtual void notifyProcessMessageFromCustomThread(
+                                                          Duration budget = Duration(),
+                                                          ULONG maxMessages = 1
+                                                          );
+
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark Stack => ISettingsChangedDelegate
+        #pragma mark
+
+        virtual void onSettingsChanged(SettingsSnapshotPtr snapshot);
 
         //---------------------------------------------------------------------
         #pragma mark
@@ -168,9 +195,13 @@ namespace openpeer
 
         virtual IMessageQueuePtr getQueueApplication();
         virtual IMessageQueuePtr getQueueCore();
+        virtual IMessageQueuePtr getQueueCore(const char *shardKey);
         virtual IMessageQueuePtr getQueueMedia();
-        virtual IMessageQueuePtr getQueueServices() const;
-        virtual IMessageQueuePtr getQueueKeyGeneration() const;
+        virtual IMessageQueuePtr getQueueServices();
+        virtual IMessageQueuePtr getQueueKeyGeneration();
+
+        virtual TaskPoolPtr getTaskPool();
+        virtual ShutdownCoordinatorPtr getShutdownCoordinator();
 
         virtual IMediaEngineDelegatePtr getMediaEngineDelegate() const;
 
@@ -184,6 +215,17 @@ namespace openpeer
 
         void makeReady();
 
+        void applyThreadPriorities(const SettingsSnapshot &snapshot);
+        void applyQueueStatisticsLogging(const SettingsSnapshot &snapshot);
+
+        IMessageQueuePtr instrument(
+                                    const String &name,
+                                    IMessageQueuePtr queue
+                                    );
+
+        static ULONG hashShardKey(const char *shardKey);
+        static String coreQueueName(size_t shard);
+
         static Log::Params slog(const char *message);
 
       protected:
@@ -200,12 +242,23 @@ namespace openpeer
 
         IMessageQueuePtr mApplicationQueue;
         IMessageQueuePtr mCoreQueue;
+        QueueList mCoreShardQueues;       // index 0 is the same as "mCoreQueue"
         IMessageQueuePtr mMediaQueue;
 
+        InstrumentedQueueList mInstrumentedQueues;
+        StackQueueStatisticsLoggerPtr mQueueStatisticsLogger;
+        Duration mQueueStatisticsLogInterval;
+
+        TaskPoolPtr mTaskPool;
+        ShutdownCoordinatorPtr mShutdownCoordinator;
+
         IStackDelegatePtr              mStackDelegate;
         IMediaEngineDelegatePtr        mMediaEngineDelegate;
 
         IStackMessageQueueDelegatePtr  mStackMessageQueueDelegate;
+
+        String mCoreThreadPriority;
+        String mMediaThreadPriority;
       };
     }
   }
@@ -0,0 +1,228 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+#pragma once
+
+#include <openpeer/core/internal/types.h>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include <deque>
+
+namespace openpeer
+{
+  namespace core
+  {
+    namespace internal
+    {
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ITaskPoolTask
+      #pragma mark
+
+      interaction ITaskPoolTask
+      {
+        //---------------------------------------------------------------------
+        // PURPOSE: name used to group the timing statistics of the task
+        // NOTE:    must return a string literal (the pointer is kept)
+        virtual const char *getTaskName() const = 0;
+
+        //---------------------------------------------------------------------
+        // PURPOSE: performs the CPU bound work on a pool thread
+        // NOTE:    must only touch data owned by the task (no object locks
+        //          and no delegates)
+        virtual void run() = 0;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ITaskPoolTaskDelegate
+      #pragma mark
+
+      interaction ITaskPoolTaskDelegate
+      {
+        virtual void onTaskPoolTaskCompleted(ITaskPoolTaskPtr task) = 0;
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark ITaskPoolForInternal
+      #pragma mark
+
+      interaction ITaskPoolForInternal
+      {
+        //---------------------------------------------------------------------
+        // PURPOSE: runs the task on the stack's CPU pool and then notifies
+        //          the delegate on the delegate's associated message queue
+        // NOTE:    the delegate is held weakly, if it is destroyed before the
+        //          task completes the result is discarded
+        static void submit(
+                           ITaskPoolTaskPtr task,
+                           ITaskPoolTaskDelegatePtr delegate
+                           );
+
+        static ElementPtr toDebug();
+      };
+
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      //-----------------------------------------------------------------------
+      #pragma mark
+      #pragma mark TaskPool
+      #pragma mark
+
+      class TaskPool : public ITaskPoolForInternal,
+                       boost::noncopyable
+      {
+      public:
+        friend interaction ITaskPoolForInternal;
+
+        typedef zsLib::ThreadPtr ThreadPtr;
+
+        struct Job
+        {
+          ITaskPoolTaskPtr mTask;
+          ITaskPoolTaskDelegatePtr mDelegate;
+          Time mQueued;
+        };
+
+        typedef std::deque<Job> JobQueue;
+
+        struct Worker
+        {
+          Lock mLock;
+          JobQueue mJobs;             // owner pops from back, thieves take from front
+          ThreadPtr mThread;
+        };
+
+        typedef boost::shared_ptr<Worker> WorkerPtr;
+        typedef std::vector<WorkerPtr> WorkerList;
+
+        struct TaskStats
+        {
+          ULONG mStolen;
+          Histogram mWaitTime;        // microseconds between submit and start
+          Histogram mRunTime;         // microseconds spent in "run()"
+
+          TaskStats() : mStolen(0) {}
+        };
+
+        typedef const char *TaskName;
+        typedef std::map<TaskName, TaskStats> TaskStatsMap;
+
+        enum Timeouts
+        {
+          Milliseconds_IdleWait = 1000,
+        };
+
+      protected:
+        TaskPool(size_t totalWorkers);
+
+      public:
+        ~TaskPool();
+
+        static TaskPoolPtr create(size_t totalWorkers = 0);   // 0 = hardware concurrency
+
+        size_t getTotalWorkers() const {return mWorkers.size();}
+
+        void submitJob(
+                       ITaskPoolTaskPtr task,
+                       ITaskPoolTaskDelegatePtr delegate
+                       );
+
+        void shutdown();
+
+        ElementPtr toDebug() const;
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TaskPool => (internal)
+        #pragma mark
+
+        Log::Params log(const char *message) const;
+
+        size_t getCurrentWorkerIndex() const;
+
+        bool popJob(
+                    size_t index,
+                    Job &outJob,
+                    bool &outStolen
+                    );
+
+        void runJob(
+                    Job &job,
+                    bool stolen
+                    );
+
+        void workerLoop(size_t index);
+
+      protected:
+        //---------------------------------------------------------------------
+        #pragma mark
+        #pragma mark TaskPool => (data)
+        #pragma mark
+
+        AutoPUID mID;
+
+        WorkerList mWorkers;
+
+        boost::atomic<size_t> mNextWorker;
+        boost::atomic<size_t> mPending;
+
+        boost::mutex mWakeMutex;
+        boost::condition_variable mWakeCondition;
+        bool mShouldShutdown;
+
+        mutable Lock mStatsLock;
+        TaskStatsMap mStats;
+        ULONG mTotalCompleted;
+      };
+    }
+  }
+}
+
+ZS_DECLARE_PROXY_BEGIN(openpeer::core::internal::ITaskPoolTaskDelegate)
+ZS_DECLARE_PROXY_TYPEDEF(openpeer::core::internal::ITaskPoolTaskPtr, ITaskPoolTaskPtr)
+ZS_DECLARE_PROXY_METHOD_1(onTaskPoolTaskCompleted, ITaskPoolTaskPtr)
+ZS_DECLARE_PROXY_END()
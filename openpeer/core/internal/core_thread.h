@@ -117,6 +117,7 @@ namespace openpeer
 
         public:
           static MessagePtr create(
+                                   IMessageQueuePtr queue,
                                    const char *messageID,
                                    const char *replacesMessageID,
                                    const char *fromPeerURI,
@@ -178,6 +179,7 @@ namespace openpeer
         private:
           AutoPUID mID;
           MessageWeakPtr mThisWeak;
+          IMessageQueuePtr mQueue;                    // queue of the owning account
           int mFlags;
 
           struct ManagedMessageData
@@ -501,6 +503,8 @@ namespace openpeer
             CandidateList mCandidates;
             bool mFinal;
 
+            String mBundleID;       // description ID whose ICE socket this description shares (empty if not bundled)
+
             Description() :
               mVersion(0),
               mSSRC(0),
@@ -792,6 +796,7 @@ namespace openpeer
           ThreadWeakPtr mThisWeak;
 
           AutoPUID mID;
+          IMessageQueuePtr mQueue;                    // queue of the owning account
           ThreadTypes mType;
           bool mCanModify;
           bool mModifying;
@@ -150,16 +150,53 @@ namespace openpeer
         bool operator!=(const ContactStatusInfo &rValue) const;
       };
 
+      struct Histogram
+      {
+        enum Buckets
+        {
+          Buckets_Total = 20,
+        };
+
+        static const ULONG sBucketLimits[Buckets_Total];  // 1-2-5 series, last bucket is unbounded
+
+        ULONG mBuckets[Buckets_Total];
+
+        ULONG mTotal;
+        ULONG mMin;
+        ULONG mMax;
+        zsLib::ULONGLONG mSum;
+
+        Histogram();
+
+        bool hasData() const;
+
+        void record(ULONG value);
+        void reset();
+
+        ULONG average() const;
+        ULONG percentile(ULONG percent) const;   // upper bound of the bucket holding the percentile
+
+        ElementPtr toDebug(
+                           const char *name,
+                           const char *units
+                           ) const;
+      };
+
       ZS_DECLARE_INTERACTION_PTR(ICallTransport)
       ZS_DECLARE_INTERACTION_PTR(IConversationThreadHostSlaveBase)
       ZS_DECLARE_INTERACTION_PTR(IConversationThreadDocumentFetcher)
       ZS_DECLARE_INTERACTION_PTR(IStackShutdownCheckAgain)
+      ZS_DECLARE_INTERACTION_PTR(ITaskPoolTask)
 
+      ZS_DECLARE_INTERACTION_PROXY(IAccountAsync)
       ZS_DECLARE_INTERACTION_PROXY(ICallAsync)
       ZS_DECLARE_INTERACTION_PROXY(ICallTransportDelegate)
       ZS_DECLARE_INTERACTION_PROXY(ICallTransportAsync)
       ZS_DECLARE_INTERACTION_PROXY(IConversationThreadDocumentFetcherDelegate)
+      ZS_DECLARE_INTERACTION_PROXY(ISettingsChangedDelegate)
       ZS_DECLARE_INTERACTION_PROXY(IShutdownCheckAgainDelegate)
+      ZS_DECLARE_INTERACTION_PROXY(IShutdownCoordinatorDelegate)
+      ZS_DECLARE_INTERACTION_PROXY(ITaskPoolTaskDelegate)
 
       ZS_DECLARE_CLASS_PTR(Account)
       ZS_DECLARE_CLASS_PTR(Backgrounding)
@@ -175,9 +212,14 @@ namespace openpeer
       ZS_DECLARE_CLASS_PTR(Factory)
       ZS_DECLARE_CLASS_PTR(Identity)
       ZS_DECLARE_CLASS_PTR(IdentityLookup)
+      ZS_DECLARE_CLASS_PTR(InstrumentedMessageQueue)
       ZS_DECLARE_CLASS_PTR(MediaEngine)
       ZS_DECLARE_CLASS_PTR(Settings)
+      ZS_DECLARE_CLASS_PTR(SettingsFileWatcher)
+      ZS_DECLARE_CLASS_PTR(SettingsSnapshot)
+      ZS_DECLARE_CLASS_PTR(ShutdownCoordinator)
       ZS_DECLARE_CLASS_PTR(Stack)
+      ZS_DECLARE_CLASS_PTR(TaskPool)
       ZS_DECLARE_CLASS_PTR(VideoViewPort)
     }
   }
@@ -149,7 +149,7 @@ namespace openpeer
       #pragma mark
       
       //-----------------------------------------------------------------------
-      int TestMediaEngine::registerVoiceExternalTransport(Transport &transport)
+      int TestMediaEngine::registerVoiceExternalTransport(TransportPtr transport)
       {
         ZS_THROW_INVALID_USAGE("external transport is disabled - cannot be registered")
       }
@@ -173,7 +173,7 @@ namespace openpeer
       }
       
       //-----------------------------------------------------------------------
-      int TestMediaEngine::registerVideoExternalTransport(Transport &transport)
+      int TestMediaEngine::registerVideoExternalTransport(TransportPtr transport)
       {
         ZS_THROW_INVALID_USAGE("external transport is disabled - cannot be registered")
       }
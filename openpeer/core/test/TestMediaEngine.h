@@ -104,12 +104,12 @@ namespace openpeer
         #pragma mark
         
       protected:
-        virtual int registerVoiceExternalTransport(Transport &transport);
+        virtual int registerVoiceExternalTransport(TransportPtr transport);
         virtual int deregisterVoiceExternalTransport();
         virtual int receivedVoiceRTPPacket(const void *data, size_t length);
         virtual int receivedVoiceRTCPPacket(const void *data, size_t length);
         
-        virtual int registerVideoExternalTransport(Transport &transport);
+        virtual int registerVideoExternalTransport(TransportPtr transport);
         virtual int deregisterVideoExternalTransport();
         virtual int receivedVideoRTPPacket(const void *data, size_t length);
         virtual int receivedVideoRTCPPacket(const void *data, size_t length);
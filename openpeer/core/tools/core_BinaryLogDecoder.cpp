@@ -0,0 +1,397 @@
+/*
+
+ Copyright (c) 2013, SMB Phone Inc.
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ The views and conclusions contained in the software and documentation are those
+ of the authors and should not be interpreted as representing official policies,
+ either expressed or implied, of the FreeBSD Project.
+
+ */
+
+
+// Stand-alone decoder for files written by ILogger::installBinaryFileLogger.
+//
+// Built by the "core_BinaryLogDecoder" target of projects/xcode/hfcore and
+// the "core_BinaryLogDecoder" module of projects/android/Android.mk, or by
+// hand (no dependencies beyond the C++ standard library):
+//
+//   c++ -I <path containing openpeer/> -o core_BinaryLogDecoder core_BinaryLogDecoder.cpp
+//
+// Usage:
+//
+//   core_BinaryLogDecoder [--json] <file>
+//
+// Text output prints one formatted line per event. JSON output prints one
+// JSON object per line per event. Values logged more than once under the
+// same name within a group are output as a JSON array (in logged order) so
+// that every key is unique.
+
+#include <openpeer/core/internal/core_LoggerBinaryFormat.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+  typedef openpeer::core::internal::BinaryLogFormat BinaryLogFormat;
+
+  typedef std::map<uint64_t, std::string> StringMap;
+
+  typedef std::vector<std::string> ValueList;
+  typedef std::pair<std::string, ValueList> NamedValues;
+  typedef std::vector<NamedValues> NamedValuesList;
+
+  //---------------------------------------------------------------------------
+  const char *severityToString(int severity)
+  {
+    switch (severity) {
+      case 0: return "Informational";
+      case 1: return "Warning";
+      case 2: return "Error";
+      case 3: return "Fatal";
+    }
+    return "UNDEFINED";
+  }
+
+  //---------------------------------------------------------------------------
+  const char *levelToString(int level)
+  {
+    switch (level) {
+      case 0: return "None";
+      case 1: return "Basic";
+      case 2: return "Detail";
+      case 3: return "Debug";
+      case 4: return "Trace";
+      case 5: return "Insane";
+    }
+    return "UNDEFINED";
+  }
+
+  //---------------------------------------------------------------------------
+  std::string lookup(const StringMap &strings, uint64_t id)
+  {
+    if (0 == id) return std::string();
+    StringMap::const_iterator found = strings.find(id);
+    if (found == strings.end()) return std::string("?");
+    return (*found).second;
+  }
+
+  //---------------------------------------------------------------------------
+  bool readStringRef(
+                     const unsigned char * &ioPos,
+                     const unsigned char *end,
+                     const StringMap &strings,
+                     bool &outHasString,
+                     std::string &outValue
+                     )
+  {
+    uint64_t id = 0;
+    if (!BinaryLogFormat::readStringRef(ioPos, end, id, outValue, outHasString)) return false;
+    if (0 != id) outValue = lookup(strings, id);
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  std::string timeToString(uint64_t microseconds)
+  {
+    time_t seconds = static_cast<time_t>(microseconds / 1000000);
+    struct tm parts;
+    memset(&parts, 0, sizeof(parts));
+#ifdef _WIN32
+    gmtime_s(&parts, &seconds);
+#else
+    gmtime_r(&seconds, &parts);
+#endif
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.%06u",
+             parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday,
+             parts.tm_hour, parts.tm_min, parts.tm_sec,
+             static_cast<unsigned>(microseconds % 1000000));
+    return std::string(buffer);
+  }
+
+  //---------------------------------------------------------------------------
+  std::string jsonEscape(const std::string &value)
+  {
+    std::string result;
+    for (std::string::const_iterator iter = value.begin(); iter != value.end(); ++iter) {
+      unsigned char ch = static_cast<unsigned char>(*iter);
+      switch (ch) {
+        case '"':   result += "\\\""; break;
+        case '\\':  result += "\\\\"; break;
+        case '\n':  result += "\\n"; break;
+        case '\r':  result += "\\r"; break;
+        case '\t':  result += "\\t"; break;
+        default: {
+          if (ch < 0x20) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+            result += buffer;
+            break;
+          }
+          result += static_cast<char>(ch);
+          break;
+        }
+      }
+    }
+    return result;
+  }
+
+  //---------------------------------------------------------------------------
+  // renders a group as either "name=value, name={...}" or a JSON object
+  bool decodeGroup(
+                   const unsigned char * &ioPos,
+                   const unsigned char *end,
+                   const StringMap &strings,
+                   bool json,
+                   std::string &outResult
+                   )
+  {
+    NamedValuesList values;
+
+    while (true) {
+      bool hasName = false;
+      std::string name;
+      if (!readStringRef(ioPos, end, strings, hasName, name)) return false;
+      if (!hasName) break;
+
+      if (ioPos >= end) return false;
+
+      int type = *ioPos;
+      ++ioPos;
+
+      std::string value;
+
+      switch (type) {
+        case BinaryLogFormat::ValueType_Empty: {
+          value = (json ? "null" : "");
+          break;
+        }
+        case BinaryLogFormat::ValueType_Integer: {
+          int64_t number = 0;
+          if (!BinaryLogFormat::readSignedVarInt(ioPos, end, number)) return false;
+          char buffer[32];
+          snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(number));
+          value = buffer;
+          break;
+        }
+        case BinaryLogFormat::ValueType_String: {
+          std::string str;
+          if (!BinaryLogFormat::readString(ioPos, end, str)) return false;
+          value = (json ? "\"" + jsonEscape(str) + "\"" : str);
+          break;
+        }
+        case BinaryLogFormat::ValueType_Group: {
+          if (!decodeGroup(ioPos, end, strings, json, value)) return false;
+          if (!json) value = "{" + value + "}";
+          break;
+        }
+        default: return false;
+      }
+
+      if (!json) {
+        values.push_back(NamedValues(name, ValueList(1, value)));
+        continue;
+      }
+
+      NamedValuesList::iterator iter = values.begin();
+      for (; iter != values.end(); ++iter) {
+        if ((*iter).first == name) break;
+      }
+      if (iter == values.end()) {
+        values.push_back(NamedValues(name, ValueList()));
+        iter = values.end() - 1;
+      }
+      (*iter).second.push_back(value);
+    }
+
+    outResult += (json ? "{" : "");
+
+    for (NamedValuesList::iterator iter = values.begin(); iter != values.end(); ++iter) {
+      const std::string &name = (*iter).first;
+      const ValueList &list = (*iter).second;
+
+      if (iter != values.begin()) outResult += ", ";
+
+      if (!json) {
+        outResult += name + "=" + list.front();
+        continue;
+      }
+
+      outResult += "\"" + jsonEscape(name) + "\": ";
+      if (1 == list.size()) {
+        outResult += list.front();
+        continue;
+      }
+
+      outResult += "[";
+      for (ValueList::const_iterator valueIter = list.begin(); valueIter != list.end(); ++valueIter) {
+        if (valueIter != list.begin()) outResult += ", ";
+        outResult += (*valueIter);
+      }
+      outResult += "]";
+    }
+
+    outResult += (json ? "}" : "");
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  bool json = false;
+  const char *fileName = NULL;
+
+  for (int index = 1; index < argc; ++index) {
+    if (0 == strcmp(argv[index], "--json")) {
+      json = true;
+      continue;
+    }
+    fileName = argv[index];
+  }
+
+  if (!fileName) {
+    fprintf(stderr, "usage: %s [--json] <file>\n", argv[0]);
+    return 1;
+  }
+
+  FILE *file = fopen(fileName, "rb");
+  if (!file) {
+    fprintf(stderr, "unable to open file: %s\n", fileName);
+    return 1;
+  }
+
+  std::vector<unsigned char> data;
+  unsigned char buffer[64 * 1024];
+  size_t read = 0;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + read);
+  }
+  fclose(file);
+
+  if ((data.size() < OPENPEER_CORE_BINARY_LOG_MAGIC_LENGTH) ||
+      (0 != memcmp(&(data[0]), OPENPEER_CORE_BINARY_LOG_MAGIC, OPENPEER_CORE_BINARY_LOG_MAGIC_LENGTH))) {
+    fprintf(stderr, "not a binary log file: %s\n", fileName);
+    return 1;
+  }
+
+  const unsigned char *pos = &(data[0]) + OPENPEER_CORE_BINARY_LOG_MAGIC_LENGTH;
+  const unsigned char *end = &(data[0]) + data.size();
+
+  uint64_t baseTime = 0;
+  if (!BinaryLogFormat::readVarInt(pos, end, baseTime)) {
+    fprintf(stderr, "truncated header: %s\n", fileName);
+    return 1;
+  }
+
+  StringMap subsystems;
+  StringMap strings;
+
+  while (pos < end) {
+    int recordType = *pos;
+    ++pos;
+
+    switch (recordType) {
+      case BinaryLogFormat::RecordType_Subsystem:
+      case BinaryLogFormat::RecordType_String: {
+        uint64_t id = 0;
+        std::string value;
+        if (!BinaryLogFormat::readVarInt(pos, end, id)) goto truncated;
+        if (!BinaryLogFormat::readString(pos, end, value)) goto truncated;
+        (BinaryLogFormat::RecordType_Subsystem == recordType ? subsystems : strings)[id] = value;
+        break;
+      }
+      case BinaryLogFormat::RecordType_Event: {
+        uint64_t offset = 0, subsystem = 0, functionID = 0, filePathID = 0, line = 0;
+        bool hasMessage = false, hasObject = false;
+        std::string message, objectName;
+        if (!BinaryLogFormat::readVarInt(pos, end, offset)) goto truncated;
+        if (!BinaryLogFormat::readVarInt(pos, end, subsystem)) goto truncated;
+        if (pos >= end) goto truncated;
+        int severityLevel = *pos;
+        ++pos;
+        if (!readStringRef(pos, end, strings, hasMessage, message)) goto truncated;
+        if (!BinaryLogFormat::readVarInt(pos, end, functionID)) goto truncated;
+        if (!BinaryLogFormat::readVarInt(pos, end, filePathID)) goto truncated;
+        if (!BinaryLogFormat::readVarInt(pos, end, line)) goto truncated;
+        if (!readStringRef(pos, end, strings, hasObject, objectName)) goto truncated;
+
+        std::string object;
+        std::string params;
+        if (!decodeGroup(pos, end, strings, json, object)) goto truncated;
+        if (!decodeGroup(pos, end, strings, json, params)) goto truncated;
+
+        std::string time = timeToString(baseTime + offset);
+        const char *severity = severityToString(severityLevel >> 4);
+        const char *level = levelToString(severityLevel & 0x0F);
+        std::string subsystemName = (subsystems.end() != subsystems.find(subsystem) ? subsystems[subsystem] : std::string("?"));
+
+        if (json) {
+          printf("{\"time\": \"%s\", \"subsystem\": \"%s\", \"severity\": \"%s\", \"level\": \"%s\", \"message\": \"%s\", \"function\": \"%s\", \"file\": \"%s\", \"line\": %llu, \"object\": {\"name\": \"%s\", \"values\": %s}, \"params\": %s}\n",
+                 time.c_str(),
+                 jsonEscape(subsystemName).c_str(),
+                 severity,
+                 level,
+                 jsonEscape(message).c_str(),
+                 jsonEscape(lookup(strings, functionID)).c_str(),
+                 jsonEscape(lookup(strings, filePathID)).c_str(),
+                 static_cast<unsigned long long>(line),
+                 jsonEscape(objectName).c_str(),
+                 object.c_str(),
+                 params.c_str());
+        } else {
+          printf("%s : %s : %s : %s : %s {%s} %s [%s @ %s:%llu]\n",
+                 time.c_str(),
+                 subsystemName.c_str(),
+                 severity,
+                 level,
+                 objectName.c_str(),
+                 object.c_str(),
+                 (message + (params.empty() ? std::string() : " " + params)).c_str(),
+                 lookup(strings, functionID).c_str(),
+                 lookup(strings, filePathID).c_str(),
+                 static_cast<unsigned long long>(line));
+        }
+        break;
+      }
+      default: {
+        fprintf(stderr, "unknown record type %d (file corrupted?)\n", recordType);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+
+truncated:
+  fprintf(stderr, "log file is truncated\n");
+  return 1;
+}
@@ -17,6 +17,9 @@ LOCAL_MODULE    := hfcore_android
 
 LOCAL_EXPORT_C_INCLUDES:= $(LOCAL_PATH) \
 
+# the rotating file logger compresses rotated segments with zlib
+LOCAL_EXPORT_LDLIBS := -lz
+
 LOCAL_C_INCLUDES:= $(LOCAL_PATH) \
 $(LOCAL_PATH)/openpeer/core/internal \
 $(LOCAL_PATH)/openpeer/core/test \
@@ -43,6 +46,7 @@ LOCAL_SRC_FILES := $(SOURCE_PATH)/core_Account_ContactSubscription.cpp \
 		   $(SOURCE_PATH)/core_Account_DelegateFilter.cpp \
 		   $(SOURCE_PATH)/core_Account_LocationSubscription.cpp \
 		   $(SOURCE_PATH)/core_Account.cpp \
+		   $(SOURCE_PATH)/core_AudioMixer.cpp \
 		   $(SOURCE_PATH)/core_Backgrounding.cpp \
 		   $(SOURCE_PATH)/core_Cache.cpp \
 		   $(SOURCE_PATH)/core_Call.cpp \
@@ -60,9 +64,12 @@ LOCAL_SRC_FILES := $(SOURCE_PATH)/core_Account_ContactSubscription.cpp \
 		   $(SOURCE_PATH)/core_ISystemMessage.cpp \
 		   $(SOURCE_PATH)/core_Identity.cpp \
 		   $(SOURCE_PATH)/core_IdentityLookup.cpp \
+		   $(SOURCE_PATH)/core_InstrumentedMessageQueue.cpp \
 		   $(SOURCE_PATH)/core_Logger.cpp \
 		   $(SOURCE_PATH)/core_Settings.cpp \
+		   $(SOURCE_PATH)/core_ShutdownCoordinator.cpp \
 		   $(SOURCE_PATH)/core_Stack.cpp \
+		   $(SOURCE_PATH)/core_TaskPool.cpp \
 		   $(SOURCE_PATH)/core.cpp \
 		   $(SOURCE_PATH)/core_thread.cpp \
 		   $(SOURCE_PATH)/core_MediaEngine.cpp \
@@ -72,3 +79,24 @@ LOCAL_SRC_FILES := $(SOURCE_PATH)/core_Account_ContactSubscription.cpp \
 
 include $(BUILD_STATIC_LIBRARY)
 
+# stand-alone decoder for files written by ILogger::installBinaryFileLogger
+include $(CLEAR_VARS)
+
+LOCAL_CFLAGS	:= -Wall \
+-W \
+-O2 \
+-pipe \
+
+LOCAL_MODULE    := core_BinaryLogDecoder
+
+LOCAL_C_INCLUDES:= $(LOCAL_PATH) \
+$(ANDROIDNDK_PATH)/sources/cxx-stl/gnu-libstdc++/4.7/include \
+$(ANDROIDNDK_PATH)/sources/cxx-stl/gnu-libstdc++/4.7/libs/armeabi/include \
+
+LOCAL_LDFLAGS := -L$(ANDROIDNDK_PATH)/sources/cxx-stl/gnu-libstdc++/4.7/libs/armeabi
+
+LOCAL_LDLIBS := -lgnustl_static
+
+LOCAL_SRC_FILES := openpeer/core/tools/core_BinaryLogDecoder.cpp
+
+include $(BUILD_EXECUTABLE)
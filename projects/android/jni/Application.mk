@@ -1,5 +1,5 @@
 NDK_TOOLCHAIN_VERSION=4.7
 APP_PROJECT_PATH := $(shell pwd)
 APP_BUILD_SCRIPT := $(APP_PROJECT_PATH)/Android.mk
-APP_MODULES := hfcore_android
+APP_MODULES := hfcore_android core_BinaryLogDecoder
 
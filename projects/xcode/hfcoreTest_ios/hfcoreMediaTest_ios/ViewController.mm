@@ -55,7 +55,7 @@
     
     testMediaEngineInternal->setReceiverAddress("127.0.0.1");
     
-    openpeer::core::internal::IMediaEngineForCallTransport::singleton()->startVoice();
+    openpeer::core::internal::IMediaEngineForCallTransport::singleton()->startVoice(0, openpeer::core::internal::IMediaEngineForCall::VoiceCodecInfo());
     openpeer::core::internal::IMediaEngineForCallTransport::singleton()->startVideoChannel();
 }
 